@@ -1,7 +1,8 @@
 //--------------------------------------------------------------------------------------
 // Light Model Vertex Shader
 //--------------------------------------------------------------------------------------
-// Basic matrix transformations only
+// Basic matrix transformations only. Reads only positions, so the meshes bind their position stream (see
+// Model::RenderDepth)
 
 #include "Common.hlsli" // Shaders can also use include files - note the extension
 
@@ -12,12 +13,12 @@
 
 // Vertex shader gets vertices from the mesh one at a time. It transforms their positions
 // from 3D into 2D (see lectures) and passes that position down the pipeline so pixels can be rendered. 
-SimplePixelShaderInput main(BasicVertex modelVertex)
+SimplePixelShaderInput main(PositionVertex modelVertex)
 {
     SimplePixelShaderInput output; // This is the data the pixel shader requires from this vertex shader
 
     // Input position is x,y,z only - need a 4th element to multiply by a 4x4 matrix. Use 1 for a point (0 for a vector) - recall lectures
-    float4 modelPosition = float4(modelVertex.position, 1);
+    float4 modelPosition = float4(DecodePosition(modelVertex.position), 1);
 
     // Multiply by the world matrix passed from C++ to transform the model vertex position into world space. 
     // In a similar way use the view matrix to transform the vertex from world space into view space (camera's point of view)
@@ -26,8 +27,8 @@ SimplePixelShaderInput main(BasicVertex modelVertex)
     float4 viewPosition = mul(gViewMatrix, worldPosition);
     output.projectedPosition = mul(gProjectionMatrix, viewPosition);
 
-    // Pass texture coordinates (UVs) on to the pixel shader, the vertex shader doesn't need them
-    output.uv = modelVertex.uv;
+    // The position stream has no texture coordinates (UVs), the depth-only pixel shader doesn't use them
+    output.uv = float2(0, 0);
 
     return output; // Ouput data sent down the pipeline (to the pixel shader)
 }
@@ -0,0 +1,301 @@
+//--------------------------------------------------------------------------------------
+// Benchmarks for the maths library
+//--------------------------------------------------------------------------------------
+// Standalone console program, only needs the files in the Math folder (no Windows or DirectX headers)
+// Build from the project folder with optimisations on, e.g.
+//     make -C Benchmarks                 (Linux, see Benchmarks/Makefile)
+//     g++ -std=c++14 -O2 -IMath Benchmarks/MathBenchmark.cpp Math/*.cpp -o MathBenchmark
+//     cl /std:c++14 /O2 /EHsc /IMath Benchmarks\MathBenchmark.cpp Math\*.cpp
+// Usage: MathBenchmark [results.json]
+// Times each function on batches of different sizes (small batches stay in the L1 cache, large ones come from
+// memory) and prints ns per operation and operations per second. The results are also written as JSON (default
+// MathBenchmark.json) so runs before and after a change, or with different SIMD settings, can be diffed
+
+#include "CVector3.h"
+#include "CMatrix4x4.h"
+#include "MathHelpers.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+
+//--------------------------------------------------------------------------------------
+// Test data
+//--------------------------------------------------------------------------------------
+
+// Simple repeatable pseudo-random floats in the range min to max
+float RandomFloat(float min, float max)
+{
+    static unsigned int seed = 12345;
+    seed = seed * 1664525u + 1013904223u;
+    return min + (max - min) * static_cast<float>(seed >> 8) / 16777216.0f;
+}
+
+CVector3 RandomVector(float min, float max)
+{
+    return { RandomFloat(min, max), RandomFloat(min, max), RandomFloat(min, max) };
+}
+
+// Position, rotation and scale of a model, as held in the Model class
+struct Transform
+{
+    CVector3 position;
+    CVector3 rotation;
+    CVector3 scale;
+};
+
+
+//--------------------------------------------------------------------------------------
+// Timing
+//--------------------------------------------------------------------------------------
+
+using Clock = std::chrono::steady_clock;
+
+// Seconds between two times
+double Seconds(Clock::time_point start, Clock::time_point end)
+{
+    return std::chrono::duration<double>(end - start).count();
+}
+
+// Sum of all the elements in a matrix, used to stop the compiler removing calculations whose results are unused
+float Checksum(const CMatrix4x4& m)
+{
+    const float* p = &m.e00;
+    float sum = 0;
+    for (int i = 0; i < 16; ++i)  sum += p[i];
+    return sum;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Benchmarks
+//--------------------------------------------------------------------------------------
+
+// Compare building world matrices from a chain of five matrices (the original Model::UpdateWorldMatrix) against MatrixTRS
+void BenchmarkWorldMatrix()
+{
+    const int numTransforms = 1000000;
+    std::vector<Transform> transforms(numTransforms);
+    for (auto& transform : transforms)
+    {
+        transform.position = RandomVector(-500.0f, 500.0f);
+        transform.rotation = RandomVector(-PI, PI);
+        transform.scale    = RandomVector(0.5f, 8.0f);
+    }
+
+    float checksum = 0;
+    float maxError = 0;
+
+    auto start = Clock::now();
+    for (auto& t : transforms)
+    {
+        CMatrix4x4 m = MatrixScaling(t.scale) * MatrixRotationZ(t.rotation.z) * MatrixRotationX(t.rotation.x) *
+                       MatrixRotationY(t.rotation.y) * MatrixTranslation(t.position);
+        checksum += Checksum(m);
+    }
+    auto chainEnd = Clock::now();
+    for (auto& t : transforms)
+    {
+        CMatrix4x4 m = MatrixTRS(t.position, t.rotation, t.scale);
+        checksum += Checksum(m);
+    }
+    auto fusedEnd = Clock::now();
+
+    // Check the two methods agree (relative to the size of the values involved)
+    for (int i = 0; i < numTransforms; i += 97)
+    {
+        auto& t = transforms[i];
+        CMatrix4x4 chain = MatrixScaling(t.scale) * MatrixRotationZ(t.rotation.z) * MatrixRotationX(t.rotation.x) *
+                           MatrixRotationY(t.rotation.y) * MatrixTranslation(t.position);
+        CMatrix4x4 fused = MatrixTRS(t.position, t.rotation, t.scale);
+        for (int e = 0; e < 16; ++e)
+        {
+            float error = std::abs((&chain.e00)[e] - (&fused.e00)[e]) / (1.0f + std::abs((&chain.e00)[e]));
+            if (error > maxError)  maxError = error;
+        }
+    }
+
+    double chainTime = Seconds(start, chainEnd);
+    double fusedTime = Seconds(chainEnd, fusedEnd);
+    std::printf("World matrix (%d transforms, %s)\n", numTransforms, MATH_SIMD_NAME);
+    std::printf("  Five matrix chain : %8.2f ms per million  (%6.2f ns each)\n", chainTime * 1e3 * 1e6 / numTransforms, chainTime * 1e9 / numTransforms);
+    std::printf("  MatrixTRS         : %8.2f ms per million  (%6.2f ns each)\n", fusedTime * 1e3 * 1e6 / numTransforms, fusedTime * 1e9 / numTransforms);
+    std::printf("  Speedup           : %8.2fx\n", chainTime / fusedTime);
+    std::printf("  Max relative error: %g  (checksum %g)\n\n", maxError, checksum);
+}
+
+
+//--------------------------------------------------------------------------------------
+// Function suite
+//--------------------------------------------------------------------------------------
+
+// Timing of one function on one batch size
+struct Result
+{
+    std::string name;
+    std::size_t batchSize;
+    double      nsPerOp;
+    double      opsPerSecond;
+};
+
+std::vector<Result> gResults;
+volatile float gSink; // Checksums are written here so the compiler cannot remove the work being timed
+
+// Time a kernel that performs batchSize operations and returns a checksum. The kernel is repeated until a sample has
+// run for long enough to time accurately, and the fastest of several samples is kept (the least disturbed by other
+// processes)
+template <class Kernel>
+void Run(const char* name, std::size_t batchSize, Kernel kernel)
+{
+    const double minSampleTime = 0.02;
+    const int numSamples = 5;
+
+    // Find how many repeats of the batch fill a sample, warming caches at the same time
+    std::size_t repeats = 1;
+    for (;;)
+    {
+        auto start = Clock::now();
+        for (std::size_t r = 0; r < repeats; ++r)  gSink = kernel(batchSize);
+        if (Seconds(start, Clock::now()) >= minSampleTime)  break;
+        repeats *= 2;
+    }
+
+    double best = 1e30;
+    for (int sample = 0; sample < numSamples; ++sample)
+    {
+        auto start = Clock::now();
+        for (std::size_t r = 0; r < repeats; ++r)  gSink = kernel(batchSize);
+        best = std::min(best, Seconds(start, Clock::now()));
+    }
+
+    double ops = static_cast<double>(repeats) * batchSize;
+    Result result = { name, batchSize, best * 1e9 / ops, ops / best };
+    std::printf("  %-24s %8zu  %10.2f ns/op  %12.0f ops/s\n", name, batchSize, result.nsPerOp, result.opsPerSecond);
+    gResults.push_back(result);
+}
+
+// Direct Euler angles facing a target, as used in Model::FaceTarget (Model.h needs DirectX so is not included here)
+CVector3 FaceTargetAngles(const CVector3& position, const CVector3& target)
+{
+    CVector3 direction = target - position;
+    float horizontalLength = std::sqrt(direction.x * direction.x + direction.z * direction.z);
+    if (IsZero(horizontalLength))  return { 0, 0, 0 };
+    return { std::atan2(-direction.y, horizontalLength), std::atan2(direction.x, direction.z), 0.0f };
+}
+
+// Time the core maths functions on batches of different sizes
+void BenchmarkSuite()
+{
+    const std::size_t batchSizes[] = { 16, 1024, 65536 }; // In L1 cache, in L2 cache, from memory
+    const std::size_t maxBatch = 65536;
+
+    // Random affine matrices (as used for world matrices) and vectors
+    std::vector<CMatrix4x4> matrices(maxBatch), others(maxBatch), outputs(maxBatch);
+    std::vector<CVector3> vectors(maxBatch), targets(maxBatch), vectorOutputs(maxBatch);
+    for (std::size_t i = 0; i < maxBatch; ++i)
+    {
+        matrices[i] = MatrixTRS(RandomVector(-500.0f, 500.0f), RandomVector(-PI, PI), RandomVector(0.5f, 8.0f));
+        others[i]   = MatrixTRS(RandomVector(-500.0f, 500.0f), RandomVector(-PI, PI), RandomVector(0.5f, 8.0f));
+        vectors[i]  = RandomVector(-100.0f, 100.0f);
+        targets[i]  = RandomVector(-100.0f, 100.0f);
+    }
+
+    std::printf("Function suite (%s)\n", MATH_SIMD_NAME);
+    std::printf("  %-24s %8s  %16s  %18s\n", "Function", "Batch", "Time", "Throughput");
+    for (std::size_t n : batchSizes)
+    {
+        Run("Matrix multiply", n, [&](std::size_t count)
+        {
+            for (std::size_t i = 0; i < count; ++i)  outputs[i] = matrices[i] * others[i];
+            return outputs[count - 1].e30;
+        });
+        Run("MatrixMultiplyScalar", n, [&](std::size_t count)
+        {
+            for (std::size_t i = 0; i < count; ++i)  outputs[i] = MatrixMultiplyScalar(matrices[i], others[i]);
+            return outputs[count - 1].e30;
+        });
+        Run("InverseAffine", n, [&](std::size_t count)
+        {
+            for (std::size_t i = 0; i < count; ++i)  outputs[i] = InverseAffine(matrices[i]);
+            return outputs[count - 1].e30;
+        });
+        Run("InverseAffineArray", n, [&](std::size_t count)
+        {
+            InverseAffineArray(&matrices[0], &outputs[0], count);
+            return outputs[count - 1].e30;
+        });
+        Run("GetEulerAngles", n, [&](std::size_t count)
+        {
+            for (std::size_t i = 0; i < count; ++i)  vectorOutputs[i] = matrices[i].GetEulerAngles();
+            return vectorOutputs[count - 1].x;
+        });
+        Run("FaceTarget (matrix)", n, [&](std::size_t count)
+        {
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                CMatrix4x4 m = matrices[i];
+                m.FaceTarget(targets[i]);
+                vectorOutputs[i] = m.GetEulerAngles();
+            }
+            return vectorOutputs[count - 1].x;
+        });
+        Run("FaceTarget (angles)", n, [&](std::size_t count)
+        {
+            for (std::size_t i = 0; i < count; ++i)  vectorOutputs[i] = FaceTargetAngles(matrices[i].GetPosition(), targets[i]);
+            return vectorOutputs[count - 1].x;
+        });
+        Run("Normalise", n, [&](std::size_t count)
+        {
+            for (std::size_t i = 0; i < count; ++i)  vectorOutputs[i] = Normalise(vectors[i]);
+            return vectorOutputs[count - 1].x;
+        });
+        Run("Cross", n, [&](std::size_t count)
+        {
+            for (std::size_t i = 0; i < count; ++i)  vectorOutputs[i] = Cross(vectors[i], targets[i]);
+            return vectorOutputs[count - 1].x;
+        });
+    }
+    std::printf("\n");
+}
+
+// Write the suite results as JSON, returns false if the file cannot be written
+bool WriteJSON(const char* fileName)
+{
+    FILE* file = std::fopen(fileName, "w");
+    if (file == nullptr)  return false;
+
+    std::fprintf(file, "{\n  \"simd\": \"%s\",\n  \"results\": [\n", MATH_SIMD_NAME);
+    for (std::size_t i = 0; i < gResults.size(); ++i)
+    {
+        const Result& r = gResults[i];
+        std::fprintf(file, "    { \"name\": \"%s\", \"batch\": %zu, \"ns_per_op\": %.4f, \"ops_per_second\": %.0f }%s\n",
+                     r.name.c_str(), r.batchSize, r.nsPerOp, r.opsPerSecond, i + 1 < gResults.size() ? "," : "");
+    }
+    std::fprintf(file, "  ]\n}\n");
+    return std::fclose(file) == 0;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Main
+//--------------------------------------------------------------------------------------
+
+int main(int argc, char* argv[])
+{
+    const char* jsonFile = argc > 1 ? argv[1] : "MathBenchmark.json";
+
+    BenchmarkWorldMatrix();
+    BenchmarkSuite();
+
+    if (!WriteJSON(jsonFile))
+    {
+        std::printf("Cannot write %s\n", jsonFile);
+        return EXIT_FAILURE;
+    }
+    std::printf("Results written to %s\n", jsonFile);
+    return 0;
+}
@@ -0,0 +1,341 @@
+//--------------------------------------------------------------------------------------
+// Report on the mesh pipeline stages applied to the project's meshes
+//--------------------------------------------------------------------------------------
+// Standalone console program, needs the files in the Math folder and the Geometry stages it reports on (no Windows,
+// DirectX or assimp). Run from the project folder so the meshes are found, e.g.
+//     make -C Benchmarks && Benchmarks/bin/MeshReport
+//     g++ -std=c++14 -O2 -IMath -IGeometry Benchmarks/MeshReport.cpp Math/*.cpp Geometry/MeshData.cpp Geometry/MeshCompact.cpp Geometry/MeshIndices.cpp Geometry/MeshSimplify.cpp Geometry/MeshClusters.cpp Geometry/MeshOptimise.cpp Geometry/MeshTangents.cpp Geometry/MeshDepth.cpp Geometry/MeshBatch.cpp -pthread -o MeshReport
+// Usage: MeshReport [mesh.x ...]     (defaults to the meshes used in the scene)
+
+#include "TestMesh.h"
+#include "MeshCompact.h"
+#include "MeshIndices.h"
+#include "MeshSimplify.h"
+#include "MeshClusters.h"
+#include "MeshOptimise.h"
+#include "MeshTangents.h"
+#include "MeshDepth.h"
+#include "MeshBatch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+//--------------------------------------------------------------------------------------
+// Vertex cache, overdraw and vertex fetch optimisation
+//--------------------------------------------------------------------------------------
+
+// Statistics before and after optimising. The test meshes keep the triangle and vertex order of the files, so "before"
+// is the order the files were written in
+void ReportOptimisation(const std::string& name, const TestMesh& mesh)
+{
+    MeshData data = MakeTestMeshData(mesh, false);
+    MeshOptimisationReport report = OptimiseMesh(data);
+
+    std::printf("%-18s %9zu %6.3f %6.3f %6.3f %6.3f %7.3f %7.3f %7.3f %7.3f\n", name.c_str(), data.indices.size() / 3,
+                report.before.vertexCache.acmr, report.after.vertexCache.acmr, report.before.vertexCache.atvr,
+                report.after.vertexCache.atvr, report.before.overdraw.overdraw, report.after.overdraw.overdraw,
+                report.before.vertexFetch.overfetch, report.after.vertexFetch.overfetch);
+}
+
+
+//--------------------------------------------------------------------------------------
+// Vertex compaction
+//--------------------------------------------------------------------------------------
+
+// Sizes before and after compacting the vertices, and the largest errors. The position error is also given as a
+// fraction of the mesh size, since the quantisation step depends on the bounds
+void ReportVertexCompaction(const std::string& name, const TestMesh& mesh, bool hasTangents)
+{
+    MeshData data = MakeTestMeshData(mesh, hasTangents);
+    float meshSize = Length(data.bounds.max - data.bounds.min);
+    VertexCompactionReport report = CompactVertices(data);
+
+    std::printf("%-18s %-8s %8zu %10zu %10zu %6.1f%% %11.2e %11.2e %9.2e %8.4f %8.4f %9.2e\n",
+                name.c_str(), hasTangents ? "tangents" : "", report.numVertices, report.bytesBefore, report.bytesAfter,
+                100.0 * report.bytesAfter / report.bytesBefore, report.maxPositionError, report.rmsPositionError,
+                meshSize > 0.0f ? report.maxPositionError / meshSize : 0.0f, report.maxNormalError,
+                report.maxTangentError, report.maxUVError);
+}
+
+
+//--------------------------------------------------------------------------------------
+// 16-bit indices
+//--------------------------------------------------------------------------------------
+
+// Index bytes with 32 and 16-bit indices. The project's meshes are all small enough to pack without splitting, so the
+// splitting is also shown with a small vertex limit, giving the extra sub-meshes and copied vertices it costs
+void ReportShortIndices(const std::string& name, const TestMesh& mesh, std::uint32_t splitLimit)
+{
+    MeshData data = MakeTestMeshData(mesh, false);
+    std::size_t numVertices = data.NumVertices();
+    std::size_t bytesBefore = data.indices.size() * sizeof(std::uint32_t);
+    bool packed = PackShortIndices(data);
+    std::size_t bytesAfter = packed ? data.shortIndices.size() * sizeof(std::uint16_t) : bytesBefore;
+
+    MeshData split = MakeTestMeshData(mesh, false);
+    std::uint32_t added = SplitSubMeshes(split, splitLimit);
+    std::size_t copied = split.NumVertices() - numVertices;
+
+    std::printf("%-18s %8zu %8zu %10zu %10zu %6.1f%% %9u %8u %8zu %6.1f%%\n", name.c_str(), numVertices,
+                data.NumIndices(), bytesBefore, bytesAfter, 100.0 * bytesAfter / bytesBefore, splitLimit, added + 1,
+                copied, 100.0 * copied / numVertices);
+}
+
+
+//--------------------------------------------------------------------------------------
+// Levels of detail
+//--------------------------------------------------------------------------------------
+
+// Triangles and error of each level of detail, the error also as a fraction of the mesh diagonal. Levels stop early
+// where simplifying further would damage the mesh
+void ReportLods(const std::string& name, const TestMesh& mesh, std::uint32_t numLods)
+{
+    MeshData data = MakeTestMeshData(mesh, false);
+    float meshSize = Length(data.bounds.max - data.bounds.min);
+    std::size_t numTriangles = data.indices.size() / 3;
+    std::uint32_t added = GenerateLods(data, numLods);
+
+    std::printf("%-18s %9zu", name.c_str(), numTriangles);
+    for (std::uint32_t lod = 0; lod < added; ++lod)
+    {
+        const SubMesh& subMesh = data.lodSubMeshes[data.lods[lod].firstSubMesh];
+        std::printf("  %6u %8.2e", subMesh.numIndices / 3, meshSize > 0.0f ? data.lods[lod].error / meshSize : 0.0f);
+    }
+    std::printf("\n");
+}
+
+
+//--------------------------------------------------------------------------------------
+// Clusters
+//--------------------------------------------------------------------------------------
+
+// Cluster sizes, and the triangles skipped as back-facing by cluster culling compared with the triangles that really
+// face away, averaged over views from the 6 axis directions and 8 diagonals. Also the vertex cache ACMR after
+// optimising within the clusters, to compare with the optimisation section
+void ReportClusters(const std::string& name, const TestMesh& mesh)
+{
+    MeshData data = MakeTestMeshData(mesh, false);
+    std::uint32_t numClusters = BuildClusters(data);
+    MeshOptimisationReport report = OptimiseMesh(data);
+    if (numClusters == 0)  return;
+
+    auto position = [&](std::uint32_t index)
+    {
+        CVector3 p;
+        std::memcpy(&p, data.vertices.data() + static_cast<std::size_t>(data.indices[index]) * data.format.vertexSize, sizeof(p));
+        return p;
+    };
+
+    std::size_t numVertices = 0;
+    for (auto& cluster : data.clusters)
+    {
+        std::vector<std::uint32_t> used(data.indices.begin() + cluster.firstIndex,
+                                        data.indices.begin() + cluster.firstIndex + cluster.numIndices);
+        std::sort(used.begin(), used.end());
+        numVertices += std::unique(used.begin(), used.end()) - used.begin();
+    }
+
+    CVector3 centre = data.bounds.Centre();
+    float distance = Length(data.bounds.max - data.bounds.min);
+    std::size_t triangles = 0, backFacing = 0, culled = 0;
+    for (int view = 0; view < 14; ++view)
+    {
+        CVector3 direction = view < 6 ? CVector3{ 0, 0, 0 } : Normalise({ view & 1 ? 1.0f : -1.0f, view & 2 ? 1.0f : -1.0f, view & 4 ? 1.0f : -1.0f });
+        if (view < 6)  (&direction.x)[view / 2] = view & 1 ? 1.0f : -1.0f;
+        CVector3 viewPoint = centre + direction * distance;
+        for (auto& cluster : data.clusters)
+        {
+            bool clusterCulled = IsClusterBackFacing(cluster, viewPoint);
+            for (std::uint32_t i = cluster.firstIndex; i < cluster.firstIndex + cluster.numIndices; i += 3)
+            {
+                CVector3 p0 = position(i);
+                ++triangles;
+                if (Dot(Cross(position(i + 1) - p0, position(i + 2) - p0), viewPoint - p0) <= 0.0f)  ++backFacing;
+                if (clusterCulled)  ++culled;
+            }
+        }
+    }
+
+    std::printf("%-18s %9zu %8u %9.1f %9.1f %10.1f%% %7.1f%% %8.3f\n", name.c_str(), data.indices.size() / 3, numClusters,
+                static_cast<float>(data.indices.size()) / 3 / numClusters, static_cast<float>(numVertices) / numClusters,
+                100.0 * backFacing / triangles, 100.0 * culled / triangles, report.after.vertexCache.acmr);
+}
+
+
+//--------------------------------------------------------------------------------------
+// Tangent generation
+//--------------------------------------------------------------------------------------
+
+// Vertices split where mirrored UVs meet, the time taken with one thread and with every hardware thread, and whether
+// the two results are identical
+void ReportTangents(const std::string& name, const TestMesh& mesh, unsigned int numThreads)
+{
+    using Clock = std::chrono::steady_clock;
+    MeshData single = MakeTestMeshData(mesh, true);
+    MeshData multiple = single;
+
+    auto start = Clock::now();
+    std::uint32_t numSplit = GenerateTangents(single, 1);
+    double singleTime = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    start = Clock::now();
+    GenerateTangents(multiple, numThreads);
+    double multipleTime = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    bool same = single.vertices == multiple.vertices && single.indices == multiple.indices;
+    std::printf("%-18s %8zu %8u %10.3f %10.3f %9s\n", name.c_str(), mesh.positions.size(), numSplit, singleTime,
+                multipleTime, same ? "yes" : "NO");
+}
+
+
+//--------------------------------------------------------------------------------------
+// Depth version
+//--------------------------------------------------------------------------------------
+
+// Vertices and vertex shader runs for depth-only passes, with the full vertices and with the welded depth version.
+// The mesh goes through the import's stages first (clusters, optimisation, 16-bit indices)
+void ReportDepthMesh(const std::string& name, const TestMesh& mesh)
+{
+    MeshData data = MakeTestMeshData(mesh, false);
+    BuildClusters(data);
+    OptimiseMesh(data);
+    PackShortIndices(data);
+    DepthMeshReport report = BuildDepthMesh(data);
+
+    std::printf("%-18s %8zu %8zu %6.1f%% %11zu %11zu %6.1f%%\n", name.c_str(), report.numVertices, report.numDepthVertices,
+                100.0 * report.numDepthVertices / report.numVertices, report.verticesTransformed,
+                report.depthVerticesTransformed, 100.0 * report.depthVerticesTransformed / report.verticesTransformed);
+}
+
+
+//--------------------------------------------------------------------------------------
+// Static batching
+//--------------------------------------------------------------------------------------
+
+// Draw calls and vertices for copies of a mesh placed on a grid, drawn one at a time and merged into a batch, and the
+// time taken to merge them (which is paid again, on a worker thread, whenever a member moves)
+void ReportBatch(const std::string& name, const TestMesh& mesh, std::uint32_t numCopies)
+{
+    // Members are prepared as the import would, with their depth versions built
+    auto data = std::make_shared<MeshData>(MakeTestMeshData(mesh, false));
+    SplitSubMeshes(*data);
+    OptimiseMesh(*data);
+    PackShortIndices(*data);
+    BuildDepthMesh(*data);
+    MeshSource source = MakeMeshSource(data);
+    std::uint32_t gridSize = static_cast<std::uint32_t>(std::ceil(std::sqrt(static_cast<float>(numCopies))));
+    std::vector<BatchMember> members(numCopies);
+    for (std::uint32_t i = 0; i < numCopies; ++i)
+    {
+        CVector3 position = { static_cast<float>(i % gridSize) * 10.0f, 0.0f, static_cast<float>(i / gridSize) * 10.0f };
+        members[i] = { source, MatrixTRS(position, { 0.0f, static_cast<float>(i), 0.0f }, { 1.0f, 1.0f, 1.0f }) };
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    MeshData batch;
+    BuildBatch(members.data(), members.size(), batch);
+    double buildTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::printf("%-18s %7u %9u %9zu %10zu %10zu %9.3f\n", name.c_str(), numCopies, numCopies * static_cast<std::uint32_t>(data->subMeshes.size()),
+                batch.subMeshes.size(), batch.NumVertices(), batch.depthVertices.size() / PositionSize(batch.format), buildTime);
+}
+
+
+//--------------------------------------------------------------------------------------
+// Main
+//--------------------------------------------------------------------------------------
+
+int main(int argc, char* argv[])
+{
+    std::vector<std::string> meshFiles;
+    for (int i = 1; i < argc; ++i)  meshFiles.push_back(argv[i]);
+    if (meshFiles.empty())
+    {
+        meshFiles = { "Cube.x", "Decal.x", "CargoContainer.x", "Sphere.x", "Floor.x", "Light.x", "Teapot.x", "Troll.x",
+                      "Hills.x" };
+    }
+
+    std::vector<TestMesh> meshes(meshFiles.size());
+    for (std::size_t i = 0; i < meshFiles.size(); ++i)
+    {
+        if (!LoadXMesh(meshFiles[i], meshes[i]))
+        {
+            std::printf("Cannot load %s, run from the project folder\n", meshFiles[i].c_str());
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::printf("Vertex cache, overdraw and vertex fetch optimisation (before -> after)\n");
+    std::printf("%-18s %9s %13s %13s %15s %15s\n", "Mesh", "Triangles", "ACMR", "ATVR", "Overdraw", "Overfetch");
+    for (std::size_t i = 0; i < meshes.size(); ++i)
+    {
+        ReportOptimisation(meshFiles[i], meshes[i]);
+    }
+
+    std::printf("\nVertex compaction (position error in mesh units and as a fraction of the mesh diagonal, normal and "
+                "tangent errors in degrees)\n");
+    std::printf("%-18s %-8s %8s %10s %10s %7s %11s %11s %9s %8s %8s %9s\n", "Mesh", "", "Vertices", "Bytes", "Compact",
+                "Size", "Max pos", "RMS pos", "Rel pos", "Normal", "Tangent", "UV");
+    for (std::size_t i = 0; i < meshes.size(); ++i)
+    {
+        ReportVertexCompaction(meshFiles[i], meshes[i], false);
+        ReportVertexCompaction(meshFiles[i], meshes[i], true);
+    }
+
+    std::printf("\n16-bit indices (and splitting with a small vertex limit to show its cost)\n");
+    std::printf("%-18s %8s %8s %10s %10s %7s %9s %8s %8s %7s\n", "Mesh", "Vertices", "Indices", "Bytes", "16-bit",
+                "Size", "Split at", "Pieces", "Copied", "Extra");
+    for (std::size_t i = 0; i < meshes.size(); ++i)
+    {
+        std::uint32_t numVertices = static_cast<std::uint32_t>(meshes[i].positions.size());
+        ReportShortIndices(meshFiles[i], meshes[i], std::max(numVertices / 4, 3u));
+    }
+
+    std::printf("\nClusters (triangles facing away from views around the mesh, and those skipped by cluster culling)\n");
+    std::printf("%-18s %9s %8s %9s %9s %11s %8s %8s\n", "Mesh", "Triangles", "Clusters", "Triangles", "Vertices",
+                "Back-facing", "Culled", "ACMR");
+    for (std::size_t i = 0; i < meshes.size(); ++i)
+    {
+        ReportClusters(meshFiles[i], meshes[i]);
+    }
+
+    std::printf("\nDepth version (vertices welded by position, and vertex shader runs drawing the full detail mesh)\n");
+    std::printf("%-18s %8s %8s %7s %11s %11s %7s\n", "Mesh", "Vertices", "Welded", "", "VS runs", "Welded", "");
+    for (std::size_t i = 0; i < meshes.size(); ++i)
+    {
+        ReportDepthMesh(meshFiles[i], meshes[i]);
+    }
+
+    std::printf("\nStatic batching (copies merged into one mesh, draw calls before and after, build milliseconds)\n");
+    std::printf("%-18s %7s %9s %9s %10s %10s %9s\n", "Mesh", "Copies", "Draws", "Batched", "Vertices", "Depth", "Build");
+    for (std::size_t i = 0; i < meshes.size(); ++i)
+    {
+        ReportBatch(meshFiles[i], meshes[i], 100);
+    }
+
+    unsigned int numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    std::printf("\nTangent generation (milliseconds with 1 and %u threads)\n", numThreads);
+    std::printf("%-18s %8s %8s %10s %10s %9s\n", "Mesh", "Vertices", "Split", "1 thread", "Threads", "Identical");
+    for (std::size_t i = 0; i < meshes.size(); ++i)
+    {
+        ReportTangents(meshFiles[i], meshes[i], numThreads);
+    }
+
+    const std::uint32_t kNumLods = 5;
+    std::printf("\nLevels of detail (triangles and relative error of each level)\n");
+    std::printf("%-18s %9s", "Mesh", "Triangles");
+    for (std::uint32_t lod = 1; lod <= kNumLods; ++lod)  std::printf("  %9s %-5u", "LOD", lod);
+    std::printf("\n");
+    for (std::size_t i = 0; i < meshes.size(); ++i)
+    {
+        ReportLods(meshFiles[i], meshes[i], kNumLods);
+    }
+    return 0;
+}
@@ -0,0 +1,356 @@
+//--------------------------------------------------------------------------------------
+// Benchmarks for the ray intersection functions
+//--------------------------------------------------------------------------------------
+// Standalone console program, only needs the files in the Math folder, MeshData and MeshBVH (no Windows or DirectX
+// headers). Build from the project folder with optimisations on, and run from the project folder so the meshes are found, e.g.
+//     g++ -std=c++14 -O2 -mavx -pthread -IMath -IGeometry Benchmarks/RayBenchmark.cpp Math/*.cpp Geometry/MeshData.cpp Geometry/MeshBVH.cpp -o RayBenchmark
+//     cl /std:c++14 /O2 /arch:AVX /EHsc /IMath /IGeometry Benchmarks\RayBenchmark.cpp Math\*.cpp Geometry\MeshData.cpp Geometry\MeshBVH.cpp
+// Leave out -mavx / /arch:AVX to test the SSE versions, or add -DMATH_NO_SIMD to test the scalar versions
+
+#include "TestMesh.h"
+#include "RayIntersection.h"
+#include "MeshBVH.h"
+#include "BoundingVolumes.h"
+#include "CVector3.h"
+#include "MathHelpers.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+
+//--------------------------------------------------------------------------------------
+// Test data
+//--------------------------------------------------------------------------------------
+
+// Simple repeatable pseudo-random floats in the range min to max
+float RandomFloat(float min, float max)
+{
+    static unsigned int seed = 12345;
+    seed = seed * 1664525u + 1013904223u;
+    return min + (max - min) * static_cast<float>(seed >> 8) / 16777216.0f;
+}
+
+CVector3 RandomVector(float min, float max)
+{
+    return { RandomFloat(min, max), RandomFloat(min, max), RandomFloat(min, max) };
+}
+
+
+//--------------------------------------------------------------------------------------
+// Timing
+//--------------------------------------------------------------------------------------
+
+using Clock = std::chrono::steady_clock;
+
+// Seconds between two times
+double Seconds(Clock::time_point start, Clock::time_point end)
+{
+    return std::chrono::duration<double>(end - start).count();
+}
+
+
+//--------------------------------------------------------------------------------------
+// Benchmarks
+//--------------------------------------------------------------------------------------
+
+const float kNoHit = 1e30f;
+
+// Rays from random points around a mesh's bounding sphere aimed at random points inside its bounding box, so most hit
+std::vector<CRay> MakeRays(const CAABB& bounds, int numRays)
+{
+    CVector3 centre = bounds.Centre();
+    float radius = Length(bounds.Extent()) * 2.0f;
+
+    std::vector<CRay> rays(numRays);
+    for (auto& ray : rays)
+    {
+        ray.origin = centre + Normalise(RandomVector(-1.0f, 1.0f)) * radius;
+        CVector3 target = { RandomFloat(bounds.min.x, bounds.max.x), RandomFloat(bounds.min.y, bounds.max.y),
+                            RandomFloat(bounds.min.z, bounds.max.z) };
+        ray.direction = Normalise(target - ray.origin);
+    }
+    return rays;
+}
+
+// Nearest hit of each ray against every triangle of a mesh, one triangle at a time and 8 at a time
+void BenchmarkMeshRays(const char* name, const TestMesh& mesh)
+{
+    const int numRays = 2000;
+    std::size_t numTriangles = mesh.indices.size() / 3;
+    CAABB bounds = AABBFromPoints(&mesh.positions[0], sizeof(CVector3), mesh.positions.size());
+    std::vector<CRay> rays = MakeRays(bounds, numRays);
+
+    std::vector<CTriangleBlock8> blocks;
+    BuildTriangleBlocks(&mesh.positions[0], sizeof(CVector3), &mesh.indices[0], numTriangles, blocks);
+
+    std::vector<float> singleT(numRays, kNoHit), blockT(numRays, kNoHit);
+    std::vector<std::ptrdiff_t> singleHit(numRays, -1), blockHit(numRays, -1);
+
+    auto start = Clock::now();
+    for (int r = 0; r < numRays; ++r)
+    {
+        for (std::size_t i = 0; i < numTriangles; ++i)
+        {
+            const CVector3& v0 = mesh.positions[mesh.indices[i * 3]];
+            const CVector3& v1 = mesh.positions[mesh.indices[i * 3 + 1]];
+            const CVector3& v2 = mesh.positions[mesh.indices[i * 3 + 2]];
+            if (RayTriangle(rays[r], v0, v1, v2, singleT[r]))  singleHit[r] = static_cast<std::ptrdiff_t>(i);
+        }
+    }
+    auto singleEnd = Clock::now();
+    for (int r = 0; r < numRays; ++r)
+    {
+        blockHit[r] = RayTriangleBlocks(rays[r], blocks, blockT[r]);
+    }
+    auto blockEnd = Clock::now();
+
+    // Both versions should find exactly the same triangle at exactly the same distance
+    int mismatches = 0, hits = 0;
+    for (int r = 0; r < numRays; ++r)
+    {
+        if (singleHit[r] != blockHit[r] || singleT[r] != blockT[r])  ++mismatches;
+        if (singleHit[r] >= 0)  ++hits;
+    }
+
+    double singleTests = static_cast<double>(numRays) * numTriangles;
+    double singleTime = Seconds(start, singleEnd);
+    double blockTime  = Seconds(singleEnd, blockEnd);
+    std::printf("%s - %d rays against %zu triangles (%s)\n", name, numRays, numTriangles, MATH_SIMD_NAME);
+    std::printf("  RayTriangle       : %8.1f million ray-triangle tests/s  (%8.0f rays/s)\n", singleTests / singleTime * 1e-6, numRays / singleTime);
+    std::printf("  RayTriangleBlocks : %8.1f million ray-triangle tests/s  (%8.0f rays/s)\n", singleTests / blockTime  * 1e-6, numRays / blockTime);
+    std::printf("  Speedup           : %8.2fx\n", singleTime / blockTime);
+    std::printf("  Hits %d of %d, mismatches %d\n\n", hits, numRays, mismatches);
+}
+
+// 8 rays at a time against every triangle of a mesh, compared with the same rays one at a time
+void BenchmarkRayPackets(const char* name, const TestMesh& mesh)
+{
+    const int numPackets = 250;
+    std::size_t numTriangles = mesh.indices.size() / 3;
+    CAABB bounds = AABBFromPoints(&mesh.positions[0], sizeof(CVector3), mesh.positions.size());
+    std::vector<CRay> rays = MakeRays(bounds, numPackets * 8);
+
+    std::vector<CRayPacket8> packets(numPackets);
+    for (int p = 0; p < numPackets; ++p)
+    {
+        for (int i = 0; i < 8; ++i)
+        {
+            const CRay& ray = rays[p * 8 + i];
+            packets[p].originX[i]    = ray.origin.x;     packets[p].originY[i]    = ray.origin.y;     packets[p].originZ[i]    = ray.origin.z;
+            packets[p].directionX[i] = ray.direction.x;  packets[p].directionY[i] = ray.direction.y;  packets[p].directionZ[i] = ray.direction.z;
+        }
+    }
+
+    std::vector<float> singleT(numPackets * 8, kNoHit), packetT(numPackets * 8, kNoHit);
+
+    auto start = Clock::now();
+    for (std::size_t r = 0; r < rays.size(); ++r)
+    {
+        for (std::size_t i = 0; i < numTriangles; ++i)
+        {
+            RayTriangle(rays[r], mesh.positions[mesh.indices[i * 3]], mesh.positions[mesh.indices[i * 3 + 1]],
+                        mesh.positions[mesh.indices[i * 3 + 2]], singleT[r]);
+        }
+    }
+    auto singleEnd = Clock::now();
+    for (int p = 0; p < numPackets; ++p)
+    {
+        for (std::size_t i = 0; i < numTriangles; ++i)
+        {
+            RayPacketTriangle(packets[p], mesh.positions[mesh.indices[i * 3]], mesh.positions[mesh.indices[i * 3 + 1]],
+                              mesh.positions[mesh.indices[i * 3 + 2]], &packetT[p * 8]);
+        }
+    }
+    auto packetEnd = Clock::now();
+
+    int mismatches = 0;
+    for (std::size_t r = 0; r < rays.size(); ++r)
+    {
+        if (singleT[r] != packetT[r])  ++mismatches;
+    }
+
+    double singleTime = Seconds(start, singleEnd);
+    double packetTime = Seconds(singleEnd, packetEnd);
+    std::printf("%s - %d packets of 8 rays (%s)\n", name, numPackets, MATH_SIMD_NAME);
+    std::printf("  RayTriangle       : %8.0f rays/s\n", rays.size() / singleTime);
+    std::printf("  RayPacketTriangle : %8.0f rays/s\n", rays.size() / packetTime);
+    std::printf("  Speedup           : %8.2fx\n", singleTime / packetTime);
+    std::printf("  Mismatches %d\n\n", mismatches);
+}
+
+// Rays against a grid of random boxes, one box at a time and 8 at a time
+void BenchmarkRayBoxes()
+{
+    const int numBlocks = 4096;
+    const int numRays = 1000;
+
+    std::vector<CAABB> boxes(numBlocks * 8);
+    std::vector<CAABBBlock8> blocks(numBlocks);
+    for (int i = 0; i < numBlocks * 8; ++i)
+    {
+        CVector3 centre = RandomVector(-100.0f, 100.0f);
+        CVector3 extent = RandomVector(0.5f, 5.0f);
+        boxes[i] = { centre - extent, centre + extent };
+        SetAABBBlockLane(blocks[i / 8], i % 8, boxes[i]);
+    }
+    CAABB bounds = { { -100.0f, -100.0f, -100.0f }, { 100.0f, 100.0f, 100.0f } };
+    std::vector<CRay> rays = MakeRays(bounds, numRays);
+
+    int singleHits = 0, blockHits = 0, mismatches = 0;
+    std::vector<std::uint8_t> singleResults(boxes.size());
+
+    auto start = Clock::now();
+    for (auto& ray : rays)
+    {
+        CVector3 invD = RayInverseDirection(ray);
+        for (std::size_t i = 0; i < boxes.size(); ++i)
+        {
+            float tEntry;
+            bool hit = RayAABB(ray, invD, boxes[i], kNoHit, tEntry);
+            singleResults[i] = hit;
+            singleHits += hit;
+        }
+    }
+    auto singleEnd = Clock::now();
+    for (auto& ray : rays)
+    {
+        CVector3 invD = RayInverseDirection(ray);
+        for (int b = 0; b < numBlocks; ++b)
+        {
+            float tEntry[8];
+            int mask = RayAABBs8(ray, invD, blocks[b], kNoHit, tEntry);
+            for (; mask; mask &= mask - 1)  ++blockHits;
+        }
+    }
+    auto blockEnd = Clock::now();
+
+    // Check the last ray's results box by box
+    CVector3 invD = RayInverseDirection(rays.back());
+    for (int b = 0; b < numBlocks; ++b)
+    {
+        float tEntry[8];
+        int mask = RayAABBs8(rays.back(), invD, blocks[b], kNoHit, tEntry);
+        for (int i = 0; i < 8; ++i)
+        {
+            float singleEntry = 0;
+            bool singleHit = RayAABB(rays.back(), invD, boxes[b * 8 + i], kNoHit, singleEntry);
+            if (singleHit != ((mask >> i) & 1) || (singleHit && singleEntry != tEntry[i]))  ++mismatches;
+        }
+    }
+    if (singleHits != blockHits)  ++mismatches;
+
+    double tests = static_cast<double>(numRays) * boxes.size();
+    double singleTime = Seconds(start, singleEnd);
+    double blockTime  = Seconds(singleEnd, blockEnd);
+    std::printf("Boxes - %d rays against %zu boxes (%s)\n", numRays, boxes.size(), MATH_SIMD_NAME);
+    std::printf("  RayAABB           : %8.1f million ray-box tests/s\n", tests / singleTime * 1e-6);
+    std::printf("  RayAABBs8         : %8.1f million ray-box tests/s\n", tests / blockTime  * 1e-6);
+    std::printf("  Speedup           : %8.2fx\n", singleTime / blockTime);
+    std::printf("  Hits %d, mismatches %d\n\n", blockHits, mismatches);
+}
+
+
+// Nearest hit of each ray using a BVH over the mesh, compared with testing every triangle. Also times the build and
+// the any-hit test used for line of sight
+void BenchmarkBVH(const char* name, const TestMesh& mesh, int numRays)
+{
+    std::size_t numTriangles = mesh.indices.size() / 3;
+    CAABB bounds = AABBFromPoints(&mesh.positions[0], sizeof(CVector3), mesh.positions.size());
+    std::vector<CRay> rays = MakeRays(bounds, numRays);
+
+    auto data = std::make_shared<MeshData>(MakeTestMeshData(mesh, false));
+    auto buildStart = Clock::now();
+    std::uint32_t numNodes = BuildBVH(*data);
+    auto buildEnd = Clock::now();
+    MeshBVH bvh(MakeMeshSource(data));
+
+    std::vector<float> bvhT(numRays, kNoHit);
+    auto start = Clock::now();
+    for (int r = 0; r < numRays; ++r)  bvh.Raycast(rays[r], bvhT[r]);
+    auto bvhEnd = Clock::now();
+    int blocked = 0;
+    for (int r = 0; r < numRays; ++r)  blocked += bvh.IsBlocked(rays[r], kNoHit);
+    auto blockedEnd = Clock::now();
+
+    // Every triangle, for fewer rays on large meshes since it is so much slower
+    std::vector<CTriangleBlock8> blocks;
+    BuildTriangleBlocks(&mesh.positions[0], sizeof(CVector3), &mesh.indices[0], numTriangles, blocks);
+    int numBruteRays = std::min(numRays, static_cast<int>(2e8 / numTriangles) + 1);
+    int mismatches = 0, hits = 0;
+    auto bruteStart = Clock::now();
+    for (int r = 0; r < numBruteRays; ++r)
+    {
+        float t = kNoHit;
+        RayTriangleBlocks(rays[r], blocks, t);
+        if (t != bvhT[r])  ++mismatches;
+    }
+    auto bruteEnd = Clock::now();
+    for (int r = 0; r < numRays; ++r)
+    {
+        if (bvhT[r] < kNoHit)  ++hits;
+    }
+    if (blocked != hits)  ++mismatches;
+
+    double bvhTime = Seconds(start, bvhEnd);
+    double bruteTime = Seconds(bruteStart, bruteEnd) * numRays / numBruteRays;
+    std::printf("%s - BVH over %zu triangles (%s)\n", name, numTriangles, MATH_SIMD_NAME);
+    std::printf("  Build             : %8.1f ms, %u nodes, %.1f MB\n", Seconds(buildStart, buildEnd) * 1e3, numNodes, bvh.Bytes() / 1048576.0);
+    std::printf("  Raycast           : %8.2f us/ray  (%8.0f rays/s)\n", bvhTime / numRays * 1e6, numRays / bvhTime);
+    std::printf("  IsBlocked         : %8.2f us/ray\n", Seconds(bvhEnd, blockedEnd) / numRays * 1e6);
+    std::printf("  RayTriangleBlocks : %8.2f us/ray\n", bruteTime / numRays * 1e6);
+    std::printf("  Speedup           : %8.0fx\n", bruteTime / bvhTime);
+    std::printf("  Hits %d of %d, mismatches %d (of %d rays checked)\n\n", hits, numRays, mismatches, numBruteRays);
+}
+
+// Bumpy grid with the given number of squares along each side, to test meshes much larger than the project's
+TestMesh MakeGridMesh(int size)
+{
+    TestMesh mesh;
+    for (int z = 0; z <= size; ++z)
+    {
+        for (int x = 0; x <= size; ++x)
+        {
+            mesh.positions.push_back({ static_cast<float>(x), RandomFloat(0.0f, 2.0f), static_cast<float>(z) });
+        }
+    }
+    for (int z = 0; z < size; ++z)
+    {
+        for (int x = 0; x < size; ++x)
+        {
+            std::uint32_t v = z * (size + 1) + x;
+            std::uint32_t quad[6] = { v, v + size + 1, v + 1, v + 1, v + size + 1, v + size + 2 };
+            mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+        }
+    }
+    return mesh;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Main
+//--------------------------------------------------------------------------------------
+
+int main()
+{
+    const char* meshFiles[] = { "Teapot.x", "Troll.x" };
+    for (const char* meshFile : meshFiles)
+    {
+        TestMesh mesh;
+        if (!LoadXMesh(meshFile, mesh))
+        {
+            std::printf("Cannot load %s, run from the project folder\n", meshFile);
+            return EXIT_FAILURE;
+        }
+        BenchmarkMeshRays(meshFile, mesh);
+        BenchmarkRayPackets(meshFile, mesh);
+        BenchmarkBVH(meshFile, mesh, 10000);
+    }
+    BenchmarkRayBoxes();
+    BenchmarkBVH("Grid", MakeGridMesh(1000), 100000);
+    return 0;
+}
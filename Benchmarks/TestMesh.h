@@ -0,0 +1,169 @@
+//--------------------------------------------------------------------------------------
+// Test meshes for the benchmarks and reports
+//--------------------------------------------------------------------------------------
+// Reads the project's text .x files without assimp, so the standalone programs need no Windows or DirectX code, and
+// builds MeshData from them for testing the mesh pipeline stages. Normals are calculated from the faces and tangents
+// from the UVs, which is close enough to what assimp produces for measuring the stages
+
+#ifndef _TEST_MESH_H_INCLUDED_
+#define _TEST_MESH_H_INCLUDED_
+
+#include "MeshData.h"
+#include "BoundingVolumes.h"
+#include "CVector3.h"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+// Positions, UVs and triangle indices of a mesh
+struct TestMesh
+{
+    std::vector<CVector3>      positions;
+    std::vector<float>         uvs;     // Two per vertex, empty if the mesh has none
+    std::vector<std::uint32_t> indices;
+};
+
+
+// Read the first mesh in a text .x file - just enough of the format for the meshes in this project. The vertex
+// positions, faces and texture coordinates are read, faces with more than 3 corners are split into a fan of triangles
+inline bool LoadXMesh(const std::string& fileName, TestMesh& mesh)
+{
+    std::ifstream file(fileName);
+    if (!file)  return false;
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    std::string text = buffer.str();
+
+    // Find the first mesh, skipping the definition of the Mesh type that some files start with
+    std::size_t start = text.find("Mesh ");
+    while (start != std::string::npos && start >= 9 && text.compare(start - 9, 9, "template ") == 0)
+    {
+        start = text.find("Mesh ", start + 1);
+    }
+    if (start == std::string::npos)  return false;
+    start = text.find('{', start);
+    if (start == std::string::npos)  return false;
+
+    // Treat separators and comments (// or # to the end of the line) as spaces after the opening bracket
+    bool inComment = false;
+    for (std::size_t i = start + 1; i < text.size(); ++i)
+    {
+        if (text[i] == '\n')  inComment = false;
+        else if (text[i] == '#' || (text[i] == '/' && i + 1 < text.size() && text[i + 1] == '/'))  inComment = true;
+        if (inComment || text[i] == ';' || text[i] == ',')  text[i] = ' ';
+    }
+    std::istringstream stream(text.substr(start + 1));
+
+    std::size_t numVertices;
+    if (!(stream >> numVertices))  return false;
+    mesh.positions.resize(numVertices);
+    for (auto& position : mesh.positions)
+    {
+        if (!(stream >> position.x >> position.y >> position.z))  return false;
+    }
+
+    std::size_t numFaces;
+    if (!(stream >> numFaces))  return false;
+    mesh.indices.clear();
+    for (std::size_t face = 0; face < numFaces; ++face)
+    {
+        std::size_t numCorners;
+        if (!(stream >> numCorners) || numCorners < 3)  return false;
+        std::vector<std::uint32_t> corners(numCorners);
+        for (auto& corner : corners)
+        {
+            if (!(stream >> corner) || corner >= numVertices)  return false;
+        }
+        for (std::size_t i = 2; i < numCorners; ++i)
+        {
+            mesh.indices.push_back(corners[0]);
+            mesh.indices.push_back(corners[i - 1]);
+            mesh.indices.push_back(corners[i]);
+        }
+    }
+
+    // Texture coordinates, one per vertex, if this mesh has them (before the next mesh starts)
+    mesh.uvs.clear();
+    std::size_t meshEnd = text.find("Mesh ", start);
+    std::size_t uvStart = text.find("MeshTextureCoords", start);
+    if (uvStart != std::string::npos && (meshEnd == std::string::npos || uvStart < meshEnd))
+    {
+        std::istringstream uvStream(text.substr(text.find('{', uvStart) + 1));
+        std::size_t numUVs;
+        if (!(uvStream >> numUVs) || numUVs != numVertices)  return false;
+        mesh.uvs.resize(numVertices * 2);
+        for (auto& uv : mesh.uvs)
+        {
+            if (!(uvStream >> uv))  return false;
+        }
+    }
+    return true;
+}
+
+
+// Make mesh data with float vertices from a test mesh, as a single sub-mesh and node. Normals are the area-weighted
+// average of the face normals around each vertex. Tangents, if requested, are calculated from the UVs (or made up
+// if there are none)
+inline MeshData MakeTestMeshData(const TestMesh& mesh, bool hasTangents)
+{
+    const std::size_t numVertices = mesh.positions.size();
+    const bool hasUVs = !mesh.uvs.empty();
+
+    std::vector<CVector3> normals(numVertices, CVector3(0.0f, 0.0f, 0.0f));
+    std::vector<CVector3> tangents(numVertices, CVector3(0.0f, 0.0f, 0.0f));
+    for (std::size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+    {
+        std::uint32_t v[3] = { mesh.indices[i], mesh.indices[i + 1], mesh.indices[i + 2] };
+        CVector3 edge1 = mesh.positions[v[1]] - mesh.positions[v[0]];
+        CVector3 edge2 = mesh.positions[v[2]] - mesh.positions[v[0]];
+        CVector3 faceNormal = Cross(edge1, edge2);
+
+        CVector3 faceTangent = edge1;
+        if (hasUVs)
+        {
+            float du1 = mesh.uvs[v[1] * 2] - mesh.uvs[v[0] * 2], dv1 = mesh.uvs[v[1] * 2 + 1] - mesh.uvs[v[0] * 2 + 1];
+            float du2 = mesh.uvs[v[2] * 2] - mesh.uvs[v[0] * 2], dv2 = mesh.uvs[v[2] * 2 + 1] - mesh.uvs[v[0] * 2 + 1];
+            float det = du1 * dv2 - du2 * dv1;
+            if (det != 0.0f)  faceTangent = (edge1 * dv2 - edge2 * dv1) * (1.0f / det);
+        }
+        for (auto corner : v)
+        {
+            normals[corner] += faceNormal;
+            tangents[corner] += faceTangent;
+        }
+    }
+
+    MeshData data;
+    data.format = MakeVertexFormat(hasTangents, hasUVs);
+    data.vertices.resize(numVertices * data.format.vertexSize);
+    for (std::size_t i = 0; i < numVertices; ++i)
+    {
+        std::uint8_t* vertex = data.vertices.data() + i * data.format.vertexSize;
+        CVector3 normal = Length(normals[i]) > 0.0f ? Normalise(normals[i]) : CVector3(0.0f, 1.0f, 0.0f);
+        std::memcpy(vertex, &mesh.positions[i], sizeof(CVector3));
+        std::memcpy(vertex + data.format.normalOffset, &normal, sizeof(CVector3));
+        if (hasTangents)
+        {
+            // Make the tangent perpendicular to the normal
+            CVector3 tangent = tangents[i] - normal * Dot(normal, tangents[i]);
+            tangent = Length(tangent) > 0.0f ? Normalise(tangent) : Normalise(Cross(normal, CVector3(0.3f, 1.0f, 0.1f)));
+            std::memcpy(vertex + data.format.tangentOffset, &tangent, sizeof(CVector3));
+        }
+        if (hasUVs)  std::memcpy(vertex + data.format.uvOffset, &mesh.uvs[i * 2], sizeof(float) * 2);
+    }
+
+    data.indices = mesh.indices;
+    data.subMeshes.push_back({ 0, static_cast<std::uint32_t>(numVertices), 0, static_cast<std::uint32_t>(mesh.indices.size()) });
+    data.nodes.push_back({ MatrixIdentity(), 0, 0, 1 });
+    data.nodeSubMeshes.push_back(0);
+    data.bounds = AABBFromPoints(data.vertices.data(), data.format.vertexSize, numVertices);
+    return data;
+}
+
+
+#endif //_TEST_MESH_H_INCLUDED_
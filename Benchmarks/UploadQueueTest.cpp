@@ -0,0 +1,337 @@
+//--------------------------------------------------------------------------------------
+// Tests for the upload queue
+//--------------------------------------------------------------------------------------
+// Standalone console program, only needs UploadQueue from the Utility folder (no Windows or DirectX headers). The queue
+// is driven by a device that records each buffer it is asked to create instead of creating it. Build from the project
+// folder, e.g.
+//     g++ -std=c++14 -O2 -IUtility Benchmarks/UploadQueueTest.cpp Utility/UploadQueue.cpp -o UploadQueueTest
+//     cl /std:c++14 /O2 /EHsc /IUtility Benchmarks\UploadQueueTest.cpp Utility\UploadQueue.cpp
+// Prints each failed check and returns non-zero if there were any
+
+#include "UploadQueue.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <set>
+#include <vector>
+
+
+//--------------------------------------------------------------------------------------
+// Recording device
+//--------------------------------------------------------------------------------------
+
+// Device that records each buffer creation. The "buffers" it returns are pointers to its records, so a receiver can
+// tell which creation it was handed
+class RecordingDevice : public UploadDevice
+{
+public:
+    struct Creation
+    {
+        unsigned int bindFlags;
+        const void*  data;
+        std::size_t  size;
+    };
+
+    ID3D11Buffer* CreateBuffer(unsigned int bindFlags, const void* data, std::size_t size) override
+    {
+        // Spin rather than sleep so each creation takes at least the given time
+        auto start = std::chrono::steady_clock::now();
+        while (std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() < secondsPerCreation) {}
+
+        std::size_t call = numCalls++;
+        if (failCalls.count(call) != 0)  return nullptr;
+        creations.push_back({ bindFlags, data, size });
+        return reinterpret_cast<ID3D11Buffer*>(&creations.back());
+    }
+
+    std::deque<Creation>  creations;                // Successful creations in order, a deque so records don't move
+    std::set<std::size_t> failCalls;                // Calls (counting from 0) that fail
+    std::size_t           numCalls = 0;
+    double                secondsPerCreation = 0;
+};
+
+
+//--------------------------------------------------------------------------------------
+// Helpers
+//--------------------------------------------------------------------------------------
+
+int gNumFailed = 0;
+
+void Check(bool passed, const char* condition, int line)
+{
+    if (passed)  return;
+    std::printf("Failed line %d: %s\n", line, condition);
+    ++gNumFailed;
+}
+#define CHECK(condition) Check((condition), #condition, __LINE__)
+
+// Source data for uploads, only its address and the sizes queued matter
+const std::uint8_t gData[4096] = {};
+
+UploadQueue::Budget MakeBudget(std::size_t maxBytes, double maxSeconds)
+{
+    UploadQueue::Budget budget;
+    budget.maxBytes = maxBytes;
+    budget.maxSeconds = maxSeconds;
+    return budget;
+}
+
+const double kNoTimeLimit = 1000.0;
+
+
+//--------------------------------------------------------------------------------------
+// Tests
+//--------------------------------------------------------------------------------------
+
+void TestByteBudget()
+{
+    RecordingDevice device;
+    UploadQueue queue(device);
+    for (int i = 0; i < 4; ++i)  queue.Enqueue(1, gData, 100, nullptr, [](ID3D11Buffer*) {});
+    CHECK(queue.PendingUploads() == 4);
+    CHECK(queue.PendingBytes() == 400);
+
+    // Stops before the upload that would go over
+    UploadQueue::Stats stats = queue.Process(MakeBudget(250, kNoTimeLimit));
+    CHECK(stats.uploads == 2);
+    CHECK(stats.bytes == 200);
+    CHECK(queue.PendingUploads() == 2);
+    CHECK(queue.PendingBytes() == 200);
+
+    // An exact fit is allowed
+    stats = queue.Process(MakeBudget(200, kNoTimeLimit));
+    CHECK(stats.uploads == 2);
+    CHECK(queue.PendingUploads() == 0);
+    CHECK(queue.PendingBytes() == 0);
+    CHECK(device.creations.size() == 4);
+
+    // Nothing to do
+    stats = queue.Process(MakeBudget(250, kNoTimeLimit));
+    CHECK(stats.uploads == 0 && stats.failures == 0 && stats.bytes == 0);
+}
+
+void TestOversizedFirstUpload()
+{
+    RecordingDevice device;
+    UploadQueue queue(device);
+    queue.Enqueue(1, gData, 1000, nullptr, [](ID3D11Buffer*) {});
+    queue.Enqueue(1, gData, 10, nullptr, [](ID3D11Buffer*) {});
+
+    // The first upload of a call always happens, even over the budget, and nothing follows it
+    UploadQueue::Stats stats = queue.Process(MakeBudget(100, kNoTimeLimit));
+    CHECK(stats.uploads == 1);
+    CHECK(stats.bytes == 1000);
+    CHECK(device.creations.size() == 1 && device.creations[0].size == 1000);
+    CHECK(queue.PendingUploads() == 1);
+
+    stats = queue.Process(MakeBudget(100, kNoTimeLimit));
+    CHECK(stats.uploads == 1);
+    CHECK(stats.bytes == 10);
+    CHECK(queue.PendingUploads() == 0);
+
+    // Even a budget of nothing makes progress
+    queue.Enqueue(1, gData, 10, nullptr, [](ID3D11Buffer*) {});
+    queue.Enqueue(1, gData, 10, nullptr, [](ID3D11Buffer*) {});
+    stats = queue.Process(MakeBudget(0, kNoTimeLimit));
+    CHECK(stats.uploads == 1);
+    CHECK(queue.PendingUploads() == 1);
+}
+
+void TestTimeBudget()
+{
+    RecordingDevice device;
+    device.secondsPerCreation = 0.002;
+    UploadQueue queue(device);
+    for (int i = 0; i < 3; ++i)  queue.Enqueue(1, gData, 10, nullptr, [](ID3D11Buffer*) {});
+
+    // The time is checked after each upload, so one creation that takes longer than the budget ends the call
+    UploadQueue::Stats stats = queue.Process(MakeBudget(1000, 0.001));
+    CHECK(stats.uploads == 1);
+    CHECK(stats.seconds >= 0.002);
+    CHECK(queue.PendingUploads() == 2);
+
+    // A time budget of nothing still makes progress
+    stats = queue.Process(MakeBudget(1000, 0.0));
+    CHECK(stats.uploads == 1);
+    CHECK(queue.PendingUploads() == 1);
+
+    // Flush ignores the budgets
+    device.secondsPerCreation = 0;
+    for (int i = 0; i < 3; ++i)  queue.Enqueue(1, gData, 1000, nullptr, [](ID3D11Buffer*) {});
+    stats = queue.Flush();
+    CHECK(stats.uploads == 4);
+    CHECK(stats.bytes == 3010);
+    CHECK(queue.PendingUploads() == 0);
+}
+
+void TestOrder()
+{
+    RecordingDevice device;
+    UploadQueue queue(device);
+    std::vector<int> received;
+    UploadQueue::Ticket lastTicket = 0;
+    for (int i = 0; i < 8; ++i)
+    {
+        UploadQueue::Ticket ticket = queue.Enqueue(i, gData + i, 16 + i, nullptr,
+                                                   [&received, i](ID3D11Buffer*) { received.push_back(i); });
+        CHECK(ticket != 0);
+        CHECK(ticket > lastTicket);
+        lastTicket = ticket;
+    }
+
+    // Over several calls, buffers are created and handed over first in first out, with the data they were queued with
+    while (queue.PendingUploads() > 0)  queue.Process(MakeBudget(40, kNoTimeLimit));
+    CHECK(device.creations.size() == 8);
+    CHECK(received.size() == 8);
+    for (int i = 0; i < static_cast<int>(device.creations.size()); ++i)
+    {
+        CHECK(device.creations[i].bindFlags == static_cast<unsigned int>(i));
+        CHECK(device.creations[i].data == gData + i);
+        CHECK(device.creations[i].size == static_cast<std::size_t>(16 + i));
+        CHECK(received[i] == i);
+    }
+}
+
+void TestCancel()
+{
+    RecordingDevice device;
+    UploadQueue queue(device);
+    int numReceived[3] = {};
+    UploadQueue::Ticket tickets[3];
+    for (int i = 0; i < 3; ++i)
+    {
+        tickets[i] = queue.Enqueue(1, gData + i, 100, nullptr, [&numReceived, i](ID3D11Buffer*) { ++numReceived[i]; });
+    }
+
+    // Cancelling a pending upload removes it and its bytes, and its receiver is never called
+    queue.Cancel(tickets[1]);
+    CHECK(queue.PendingUploads() == 2);
+    CHECK(queue.PendingBytes() == 200);
+    queue.Cancel(tickets[1]); // Again does nothing
+    CHECK(queue.PendingUploads() == 2);
+
+    UploadQueue::Stats stats = queue.Process(MakeBudget(100, kNoTimeLimit));
+    CHECK(stats.uploads == 1);
+    CHECK(numReceived[0] == 1);
+
+    // Cancelling an upload that has already happened does nothing, to it or to the others
+    queue.Cancel(tickets[0]);
+    CHECK(queue.PendingUploads() == 1);
+    CHECK(queue.PendingBytes() == 100);
+    CHECK(numReceived[0] == 1);
+
+    // Unknown tickets are ignored
+    queue.Cancel(0);
+    queue.Cancel(tickets[2] + 100);
+    CHECK(queue.PendingUploads() == 1);
+
+    queue.Flush();
+    CHECK(numReceived[0] == 1 && numReceived[1] == 0 && numReceived[2] == 1);
+    CHECK(device.creations.size() == 2);
+    CHECK(device.creations[0].data == gData && device.creations[1].data == gData + 2);
+}
+
+void TestFailures()
+{
+    RecordingDevice device;
+    device.failCalls = { 1, 3 };
+    UploadQueue queue(device);
+    std::vector<ID3D11Buffer*> received(4, nullptr);
+    std::vector<int> numReceived(4, 0);
+    for (int i = 0; i < 4; ++i)
+    {
+        queue.Enqueue(1, gData, 100, nullptr, [&received, &numReceived, i](ID3D11Buffer* buffer)
+        {
+            received[i] = buffer;
+            ++numReceived[i];
+        });
+    }
+
+    // Failures are counted separately and their bytes are not, and every receiver is called once either way
+    UploadQueue::Stats stats = queue.Flush();
+    CHECK(stats.uploads == 2);
+    CHECK(stats.failures == 2);
+    CHECK(stats.bytes == 200);
+    CHECK(queue.PendingUploads() == 0);
+    CHECK(queue.PendingBytes() == 0);
+    for (int i = 0; i < 4; ++i)  CHECK(numReceived[i] == 1);
+
+    // Successful receivers are handed the buffer the device created, failed ones nullptr
+    CHECK(device.creations.size() == 2);
+    CHECK(received[0] == reinterpret_cast<ID3D11Buffer*>(&device.creations[0]));
+    CHECK(received[1] == nullptr);
+    CHECK(received[2] == reinterpret_cast<ID3D11Buffer*>(&device.creations[1]));
+    CHECK(received[3] == nullptr);
+
+    // A failed upload counts as the call's first, so the byte budget applies to the one after it
+    device.failCalls = { device.numCalls };
+    queue.Enqueue(1, gData, 100, nullptr, [](ID3D11Buffer*) {});
+    queue.Enqueue(1, gData, 100, nullptr, [](ID3D11Buffer*) {});
+    stats = queue.Process(MakeBudget(50, kNoTimeLimit));
+    CHECK(stats.uploads == 0);
+    CHECK(stats.failures == 1);
+    CHECK(queue.PendingUploads() == 1);
+}
+
+void TestReceivers()
+{
+    RecordingDevice device;
+    UploadQueue queue(device);
+
+    // The queue keeps the storage alive until the upload is done, then lets it go
+    auto storage = std::make_shared<std::vector<std::uint8_t>>(64);
+    std::weak_ptr<std::vector<std::uint8_t>> weakStorage = storage;
+    queue.Enqueue(1, storage->data(), storage->size(), storage, [](ID3D11Buffer*) {});
+    storage.reset();
+    CHECK(!weakStorage.expired());
+
+    // A receiver may queue and cancel other uploads
+    int numReceived = 0;
+    UploadQueue::Ticket cancelled = 0;
+    queue.Enqueue(1, gData, 10, nullptr, [&](ID3D11Buffer*)
+    {
+        ++numReceived;
+        queue.Cancel(cancelled);
+        queue.Enqueue(1, gData, 20, nullptr, [&](ID3D11Buffer*) { ++numReceived; });
+    });
+    cancelled = queue.Enqueue(1, gData, 30, nullptr, [&](ID3D11Buffer*) { numReceived += 100; });
+
+    UploadQueue::Stats stats = queue.Process(MakeBudget(74, kNoTimeLimit));
+    CHECK(stats.uploads == 2);
+    CHECK(weakStorage.expired());
+    CHECK(numReceived == 1);
+    CHECK(queue.PendingUploads() == 1);
+    CHECK(queue.PendingBytes() == 20);
+
+    stats = queue.Flush();
+    CHECK(stats.uploads == 1);
+    CHECK(numReceived == 2);
+    CHECK(device.creations.size() == 3 && device.creations[2].size == 20);
+}
+
+
+//--------------------------------------------------------------------------------------
+// Main
+//--------------------------------------------------------------------------------------
+
+int main()
+{
+    TestByteBudget();
+    TestOversizedFirstUpload();
+    TestTimeBudget();
+    TestOrder();
+    TestCancel();
+    TestFailures();
+    TestReceivers();
+
+    if (gNumFailed > 0)
+    {
+        std::printf("UploadQueue: %d checks failed\n", gNumFailed);
+        return 1;
+    }
+    std::printf("UploadQueue: all checks passed\n");
+    return 0;
+}
@@ -59,22 +59,13 @@ void Camera::Control(float frameTime, KeyCode turnUp, KeyCode turnDown, KeyCode
 void Camera::UpdateMatrices()
 {
     // "World" matrix for the camera - treat it like a model at first
-    mWorldMatrix = MatrixRotationZ(mRotation.z) * MatrixRotationX(mRotation.x) * MatrixRotationY(mRotation.y) * MatrixTranslation(mPosition);
+    mWorldMatrix = MatrixTRS(mPosition, mRotation); // Rotation Z, X then Y followed by translation, built directly
 
     // View matrix is the usual matrix used for the camera in shaders, it is the inverse of the world matrix (see lectures)
     mViewMatrix = InverseAffine(mWorldMatrix);
 
     // Projection matrix, how to flatten the 3D world onto the screen (needs field of view, near and far clip, aspect ratio)
-    float tanFOVx = std::tan(mFOVx * 0.5f);
-    float scaleX = 1.0f / tanFOVx;
-    float scaleY = mAspectRatio / tanFOVx;
-    float scaleZa = mFarClip / (mFarClip - mNearClip);
-    float scaleZb = -mNearClip * scaleZa;
-
-    mProjectionMatrix = CMatrix4x4{ scaleX,   0.0f,    0.0f,   0.0f,
-                                      0.0f, scaleY,    0.0f,   0.0f,
-                                      0.0f,   0.0f, scaleZa,   1.0f,
-                                      0.0f,   0.0f, scaleZb,   0.0f };
+    mProjectionMatrix = MatrixPerspective(mAspectRatio, std::tan(mFOVx * 0.5f), mNearClip, mFarClip);
 
     // The view-projection matrix combines the two matrices usually used for the camera into one, which can save a multiply in the shaders (optional)
     mViewProjectionMatrix = mViewMatrix * mProjectionMatrix;
@@ -17,7 +17,7 @@ BasicPixelShaderInput main(BasicVertex modelVertex)
     BasicPixelShaderInput output; // This is the data the pixel shader requires from this vertex shader
 
     // Transform model vertex position to world space using the world matrix passed from C++
-    float4 modelPosition = float4(modelVertex.position, 1);
+    float4 modelPosition = float4(DecodePosition(modelVertex.position), 1);
     float4 worldPosition = mul(gWorldMatrix, modelPosition);
 
 	// Next the usual transform from world space to camera space - but we don't go any further here - this will be used to help expand the outline
@@ -25,7 +25,7 @@ BasicPixelShaderInput main(BasicVertex modelVertex)
     float4 viewPosition = mul(gViewMatrix, worldPosition);
 
 	// Transform model normal to world space. We will use the normal to expand the geometry, not for lighting
-    float4 modelNormal = float4(modelVertex.normal, 0.0f); // Set 4th element to 0.0 this time as normals are vectors
+    float4 modelNormal = float4(DecodeNormal(modelVertex.normal), 0.0f); // Set 4th element to 0.0 this time as normals are vectors
     float4 worldNormal = normalize(mul(gWorldMatrix, modelNormal)); // Normalise in case of world matrix scaling
 
 	// Now we return to the world position of this vertex and expand it along the world normal - that will expand the geometry outwards.
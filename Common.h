@@ -179,6 +179,12 @@ struct PerModelConstants
     CMatrix4x4 worldMatrix;
     CVector3   objectColour; // Allows each light model to be tinted to match the light colour they cast
     float      padding22;
+
+    // How the mesh being rendered stores its vertices, set by the mesh (see Mesh::SetVertexDecoding)
+    CVector3   positionOffset;  // Positions are decoded as positionOffset + position * positionScale
+    float      compactVertices; // 1 if normals and tangents are octahedral encoded (compact vertices), 0 if floats
+    CVector3   positionScale;
+    float      padding29;
 };
 extern PerModelConstants gPerModelConstants;      // This variable holds the CPU-side constant buffer described above
 extern ID3D11Buffer*     gPerModelConstantBuffer; // This variable controls the GPU-side constant buffer related to the above structure
@@ -16,6 +16,13 @@ struct BasicVertex
     float2 uv       : uv;
 };
 
+// Vertex with only a position, read from a mesh's separate position stream by passes that need nothing else (e.g.
+// depth-only rendering for shadow maps). Decoded with DecodePosition like the full vertices
+struct PositionVertex
+{
+    float3 position : position;
+};
+
 // This structure describes what data the lighting pixel shader receives from the vertex shader.
 // The projected position is a required output from all vertex shaders - where the vertex is on the screen
 // The world position and normal at the vertex are sent to the pixel shader for the lighting equations.
@@ -259,4 +266,36 @@ cbuffer PerModelConstants : register(b1) // The b1 gives this constant buffer th
 
     float3   gObjectColour;
     float    padding22;  // See notes on padding in structure above
+
+    float3   gPositionOffset;  // How the mesh being rendered stores its vertices - use the decode functions below
+    float    gCompactVertices;
+    float3   gPositionScale;
+    float    padding29;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Vertex decoding
+//--------------------------------------------------------------------------------------
+// Meshes can store vertices as floats or in a compact layout (see MeshData.h in the C++ code). The input layout
+// unpacks each element of a compact vertex to 0->1 (position) or -1->1 (octahedral normal and tangent, in x and y),
+// these functions finish the decoding. Vertex shaders should always pass their input through them, for float
+// vertices they change nothing
+
+// Decode a model space position
+float3 DecodePosition(float3 position)
+{
+    return gPositionOffset + position * gPositionScale;
+}
+
+// Decode a model space normal or tangent. Octahedral encoding maps the unit sphere onto a square, with the lower
+// hemisphere folded over the diagonals (matches UnpackOctahedral in the C++ code)
+float3 DecodeNormal(float3 normal)
+{
+    if (gCompactVertices == 0)  return normal;
+
+    float3 n = float3(normal.xy, 1 - abs(normal.x) - abs(normal.y));
+    float t = saturate(-n.z);
+    n.xy += (n.xy >= 0) ? -t : t;
+    return normalize(n);
 }
\ No newline at end of file
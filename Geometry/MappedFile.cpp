@@ -0,0 +1,102 @@
+//--------------------------------------------------------------------------------------
+// Read-only memory-mapped file
+//--------------------------------------------------------------------------------------
+
+#include "MappedFile.h"
+
+#if defined(_WIN32)
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+
+#if defined(_WIN32)
+
+// Map the given file, closing any file already mapped. Returns false if the file does not exist, cannot be mapped or is empty
+bool MappedFile::Open(const std::string& fileName)
+{
+    Close();
+
+    HANDLE file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)  return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    // The view keeps the file open, so the handles can be closed straight away
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (mapping == nullptr)  return false;
+    mData = static_cast<const std::uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    CloseHandle(mapping);
+    if (mData == nullptr)  return false;
+
+    mSize = static_cast<std::size_t>(size.QuadPart);
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (mData != nullptr)  UnmapViewOfFile(mData);
+    mData = nullptr;
+    mSize = 0;
+}
+
+// Create a folder if it doesn't already exist. Returns false on failure
+bool CreateFolder(const std::string& folderName)
+{
+    return CreateDirectoryA(folderName.c_str(), nullptr) || GetLastError() == ERROR_ALREADY_EXISTS;
+}
+
+#else
+
+// Map the given file, closing any file already mapped. Returns false if the file does not exist, cannot be mapped or is empty
+bool MappedFile::Open(const std::string& fileName)
+{
+    Close();
+
+    int file = open(fileName.c_str(), O_RDONLY);
+    if (file < 0)  return false;
+
+    struct stat info;
+    if (fstat(file, &info) != 0 || info.st_size == 0)
+    {
+        close(file);
+        return false;
+    }
+
+    // The mapping keeps the file open, so the descriptor can be closed straight away
+    void* data = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (data == MAP_FAILED)  return false;
+
+    mData = static_cast<const std::uint8_t*>(data);
+    mSize = static_cast<std::size_t>(info.st_size);
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (mData != nullptr)  munmap(const_cast<std::uint8_t*>(mData), mSize);
+    mData = nullptr;
+    mSize = 0;
+}
+
+// Create a folder if it doesn't already exist. Returns false on failure
+bool CreateFolder(const std::string& folderName)
+{
+    return mkdir(folderName.c_str(), 0755) == 0 || errno == EEXIST;
+}
+
+#endif
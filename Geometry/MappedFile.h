@@ -0,0 +1,44 @@
+//--------------------------------------------------------------------------------------
+// Read-only memory-mapped file
+//--------------------------------------------------------------------------------------
+// Code in .cpp file
+// The file contents appear in memory without being read up front, the operating system pages them in as they are
+// used and shares them with the file cache. Works on Windows and POSIX systems
+
+#ifndef _MAPPED_FILE_H_DEFINED_
+#define _MAPPED_FILE_H_DEFINED_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+
+class MappedFile
+{
+public:
+    MappedFile() {}
+    ~MappedFile()  { Close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Map the given file, closing any file already mapped. Returns false if the file does not exist, cannot be
+    // mapped or is empty
+    bool Open(const std::string& fileName);
+
+    void Close();
+
+    const std::uint8_t* Data() const  { return mData; }
+    std::size_t         Size() const  { return mSize; }
+
+private:
+    const std::uint8_t* mData = nullptr;
+    std::size_t         mSize = 0;
+};
+
+
+// Create a folder if it doesn't already exist (not any missing parent folders). Returns false on failure
+bool CreateFolder(const std::string& folderName);
+
+
+#endif // _MAPPED_FILE_H_DEFINED_
@@ -0,0 +1,423 @@
+//--------------------------------------------------------------------------------------
+// Bounding volume hierarchy for ray casts against a mesh
+//--------------------------------------------------------------------------------------
+
+#include "MeshBVH.h"
+#include "VectorStream.h" // Gathering positions out of the vertices
+
+#include <algorithm>
+#include <cstring>
+#include <future>
+#include <limits>
+
+
+namespace
+{
+    const int   kNumBins = 16;
+    const float kTraversalCost = 1.0f;    // Cost of testing a node's children relative to testing one triangle
+    const int   kMaxSAHDepth = 64;        // Deeper nodes are split at the median so the depth stays bounded
+    const int   kMaxTraversalDepth = 128; // Entries in the traversal stack, more than the depth the build can reach
+
+    // Subtrees with more triangles than this are built on a thread of their own
+    const std::uint32_t kParallelTriangles = 65536;
+
+    float Axis(const CVector3& v, int axis)  { return axis == 0 ? v.x : (axis == 1 ? v.y : v.z); }
+
+    CAABB EmptyBox()
+    {
+        const float big = std::numeric_limits<float>::max();
+        return { { big, big, big }, { -big, -big, -big } };
+    }
+
+    void Grow(CAABB& box, const CVector3& p)
+    {
+        box.min = { std::min(box.min.x, p.x), std::min(box.min.y, p.y), std::min(box.min.z, p.z) };
+        box.max = { std::max(box.max.x, p.x), std::max(box.max.y, p.y), std::max(box.max.z, p.z) };
+    }
+
+    void Grow(CAABB& box, const CAABB& other)
+    {
+        box.min = { std::min(box.min.x, other.min.x), std::min(box.min.y, other.min.y), std::min(box.min.z, other.min.z) };
+        box.max = { std::max(box.max.x, other.max.x), std::max(box.max.y, other.max.y), std::max(box.max.z, other.max.z) };
+    }
+
+    // Half the surface area, which is all the heuristic needs since only ratios of areas matter
+    float HalfArea(const CAABB& box)
+    {
+        CVector3 size = box.max - box.min;
+        return size.x * size.y + size.y * size.z + size.z * size.x;
+    }
+
+
+    // Triangle being sorted into the hierarchy
+    struct BuildTriangle
+    {
+        CAABB         bounds;
+        CVector3      centre;      // Of the bounds, the triangles are binned by these
+        std::uint32_t triangle;    // Index into the unsorted triangles
+    };
+
+    // Builds the nodes for a range of triangles. Each thread building a subtree has its own builder, the triangle
+    // ranges of separate subtrees don't overlap so they can be sorted in place in one shared array
+    class Builder
+    {
+    public:
+        explicit Builder(BuildTriangle* triangles) : mTriangles(triangles) {}
+
+        // Build the subtree for a range of triangles with its root at the given node, which must already exist
+        void Build(std::uint32_t nodeIndex, std::uint32_t begin, std::uint32_t end, int depth)
+        {
+            CAABB bounds = EmptyBox();
+            CAABB centreBounds = EmptyBox();
+            for (std::uint32_t i = begin; i < end; ++i)
+            {
+                Grow(bounds, mTriangles[i].bounds);
+                Grow(centreBounds, mTriangles[i].centre);
+            }
+            mNodes[nodeIndex].bounds = bounds;
+
+            std::uint32_t count = end - begin;
+            std::uint32_t middle = count > 1 ? Split(begin, end, bounds, centreBounds, depth) : begin;
+            if (middle == begin)
+            {
+                mNodes[nodeIndex].first = begin;
+                mNodes[nodeIndex].count = count;
+                return;
+            }
+
+            // Children are next to each other. Large halves are built on another thread into a separate node array
+            // then moved into this one, with their child indices moved to match
+            std::uint32_t children = static_cast<std::uint32_t>(mNodes.size());
+            mNodes[nodeIndex].first = children;
+            mNodes[nodeIndex].count = 0;
+            mNodes.resize(mNodes.size() + 2);
+            if (middle - begin > kParallelTriangles && end - middle > kParallelTriangles)
+            {
+                std::future<std::vector<BVHNode>> left = std::async(std::launch::async, [=]()
+                {
+                    Builder builder(mTriangles);
+                    builder.mNodes.resize(1);
+                    builder.Build(0, begin, middle, depth + 1);
+                    return std::move(builder.mNodes);
+                });
+                Build(children + 1, middle, end, depth + 1);
+                Attach(children, left.get());
+            }
+            else
+            {
+                Build(children, begin, middle, depth + 1);
+                Build(children + 1, middle, end, depth + 1);
+            }
+        }
+
+        std::vector<BVHNode> mNodes;
+
+    private:
+        // Sort a range of triangles into two and return the start of the second part, or begin to make a leaf
+        std::uint32_t Split(std::uint32_t begin, std::uint32_t end, const CAABB& bounds, const CAABB& centreBounds, int depth)
+        {
+            std::uint32_t count = end - begin;
+            CVector3 centreSize = centreBounds.max - centreBounds.min;
+            int widest = (centreSize.x >= centreSize.y && centreSize.x >= centreSize.z) ? 0 : (centreSize.y >= centreSize.z ? 1 : 2);
+            if (Axis(centreSize, widest) <= 0.0f)
+            {
+                // All the centres are at the same place, so no plane separates them
+                return count > kMaxBVHLeafTriangles ? begin + count / 2 : begin;
+            }
+            if (depth > kMaxSAHDepth)  return count > kMaxBVHLeafTriangles ? MedianSplit(begin, end, widest) : begin;
+
+            // Count the triangles and grow the box of each bin along each axis
+            struct Bin
+            {
+                CAABB         bounds = EmptyBox();
+                std::uint32_t count = 0;
+            };
+            Bin bins[3][kNumBins];
+            CVector3 binScale = { centreSize.x > 0.0f ? kNumBins / centreSize.x : 0.0f,
+                                  centreSize.y > 0.0f ? kNumBins / centreSize.y : 0.0f,
+                                  centreSize.z > 0.0f ? kNumBins / centreSize.z : 0.0f };
+            auto binIndex = [&](const CVector3& centre, int axis)
+            {
+                int bin = static_cast<int>((Axis(centre, axis) - Axis(centreBounds.min, axis)) * Axis(binScale, axis));
+                return std::min(bin, kNumBins - 1);
+            };
+            for (std::uint32_t i = begin; i < end; ++i)
+            {
+                const BuildTriangle& triangle = mTriangles[i];
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    Bin& bin = bins[axis][binIndex(triangle.centre, axis)];
+                    Grow(bin.bounds, triangle.bounds);
+                    ++bin.count;
+                }
+            }
+
+            // Cost of splitting after each bin, sweeping from both ends to get the boxes and counts of either side
+            float bestCost = static_cast<float>(count);
+            int bestAxis = -1, bestBin = 0;
+            float parentArea = HalfArea(bounds);
+            for (int axis = 0; axis < 3 && parentArea > 0.0f; ++axis)
+            {
+                if (Axis(centreSize, axis) <= 0.0f)  continue;
+
+                float rightCost[kNumBins];
+                CAABB rightBounds = EmptyBox();
+                std::uint32_t rightCount = 0;
+                for (int b = kNumBins - 1; b > 0; --b)
+                {
+                    Grow(rightBounds, bins[axis][b].bounds);
+                    rightCount += bins[axis][b].count;
+                    rightCost[b] = rightCount > 0 ? HalfArea(rightBounds) * rightCount : 0.0f;
+                }
+                CAABB leftBounds = EmptyBox();
+                std::uint32_t leftCount = 0;
+                for (int b = 0; b < kNumBins - 1; ++b)
+                {
+                    Grow(leftBounds, bins[axis][b].bounds);
+                    leftCount += bins[axis][b].count;
+                    if (leftCount == 0 || leftCount == count)  continue;
+                    float cost = kTraversalCost + (HalfArea(leftBounds) * leftCount + rightCost[b + 1]) / parentArea;
+                    if (cost < bestCost)
+                    {
+                        bestCost = cost;
+                        bestAxis = axis;
+                        bestBin = b;
+                    }
+                }
+            }
+
+            // Small ranges become leaves unless splitting is cheaper, larger ones are always split to keep leaves small
+            if (bestAxis < 0)
+            {
+                return count > kMaxBVHLeafTriangles ? MedianSplit(begin, end, widest) : begin;
+            }
+            BuildTriangle* middle = std::partition(mTriangles + begin, mTriangles + end, [&](const BuildTriangle& triangle)
+            {
+                return binIndex(triangle.centre, bestAxis) <= bestBin;
+            });
+            return static_cast<std::uint32_t>(middle - mTriangles);
+        }
+
+        // Sort a range of triangles into halves along an axis
+        std::uint32_t MedianSplit(std::uint32_t begin, std::uint32_t end, int axis)
+        {
+            std::uint32_t middle = begin + (end - begin) / 2;
+            std::nth_element(mTriangles + begin, mTriangles + middle, mTriangles + end, [axis](const BuildTriangle& a, const BuildTriangle& b)
+            {
+                return Axis(a.centre, axis) < Axis(b.centre, axis);
+            });
+            return middle;
+        }
+
+        // Move the nodes of a subtree built separately into this array, its root becoming the given node
+        void Attach(std::uint32_t nodeIndex, const std::vector<BVHNode>& subtree)
+        {
+            // Subtree nodes after the root are appended, so a child index i becomes offset + i - 1
+            std::uint32_t offset = static_cast<std::uint32_t>(mNodes.size()) - 1;
+            mNodes.insert(mNodes.end(), subtree.begin() + 1, subtree.end());
+            mNodes[nodeIndex] = subtree[0];
+            if (mNodes[nodeIndex].count == 0)  mNodes[nodeIndex].first += offset;
+            for (std::size_t i = offset + 1; i < mNodes.size(); ++i)
+            {
+                if (mNodes[i].count == 0)  mNodes[i].first += offset;
+            }
+        }
+
+        BuildTriangle* mTriangles;
+    };
+}
+
+
+/*-----------------------------------------------------------------------------------------
+    Building
+-----------------------------------------------------------------------------------------*/
+
+std::uint32_t BuildBVH(MeshData& data)
+{
+    data.bvhNodes.clear();
+    data.bvhTriangles.clear();
+    data.bvhPositions.clear();
+    if (data.format.compact || !data.shortIndices.empty())  return 0;
+
+    // Gather the positions of every vertex, then store each distinct position once (vertices are often split by UV
+    // seams and hard edges, and sub-meshes may share positions too)
+    std::size_t numVertices = data.NumVertices();
+    std::vector<CVector3> positions(numVertices);
+    if (numVertices > 0)
+    {
+        StreamCopyVector3(data.vertices.data(), data.format.vertexSize, positions.data(), sizeof(CVector3), numVertices);
+    }
+    std::vector<std::uint32_t> sorted(numVertices);
+    for (std::uint32_t i = 0; i < numVertices; ++i)  sorted[i] = i;
+    auto less = [&](std::uint32_t a, std::uint32_t b) { return std::memcmp(&positions[a], &positions[b], sizeof(CVector3)) < 0; };
+    std::sort(sorted.begin(), sorted.end(), less);
+    std::vector<std::uint32_t> welded(numVertices);
+    for (std::size_t i = 0; i < numVertices; ++i)
+    {
+        if (i == 0 || less(sorted[i - 1], sorted[i]))  data.bvhPositions.push_back(positions[sorted[i]]);
+        welded[sorted[i]] = static_cast<std::uint32_t>(data.bvhPositions.size() - 1);
+    }
+
+    // Triangles of the full detail sub-meshes, leaving out those with no area after welding, which rays can't hit
+    std::vector<BVHTriangle> triangles;
+    std::vector<BuildTriangle> buildTriangles;
+    for (auto& subMesh : data.subMeshes)
+    {
+        const std::uint32_t* indices = data.indices.data() + subMesh.firstIndex;
+        for (std::uint32_t t = 0; t < subMesh.numIndices / 3; ++t)
+        {
+            BVHTriangle triangle;
+            for (int c = 0; c < 3; ++c)  triangle.corners[c] = welded[subMesh.firstVertex + indices[t * 3 + c]];
+            if (triangle.corners[0] == triangle.corners[1] || triangle.corners[1] == triangle.corners[2] ||
+                triangle.corners[2] == triangle.corners[0])  continue;
+            triangle.triangle = subMesh.firstIndex / 3 + t;
+
+            BuildTriangle buildTriangle;
+            buildTriangle.bounds = EmptyBox();
+            for (auto corner : triangle.corners)  Grow(buildTriangle.bounds, data.bvhPositions[corner]);
+            buildTriangle.centre = buildTriangle.bounds.Centre();
+            buildTriangle.triangle = static_cast<std::uint32_t>(triangles.size());
+            triangles.push_back(triangle);
+            buildTriangles.push_back(buildTriangle);
+        }
+    }
+    if (triangles.empty())
+    {
+        data.bvhPositions.clear();
+        return 0;
+    }
+
+    Builder builder(buildTriangles.data());
+    builder.mNodes.reserve(triangles.size());
+    builder.mNodes.resize(1);
+    builder.Build(0, 0, static_cast<std::uint32_t>(buildTriangles.size()), 0);
+    data.bvhNodes = std::move(builder.mNodes);
+
+    // Store the triangles in the order the leaves refer to them
+    data.bvhTriangles.reserve(triangles.size());
+    for (auto& buildTriangle : buildTriangles)  data.bvhTriangles.push_back(triangles[buildTriangle.triangle]);
+    return static_cast<std::uint32_t>(data.bvhNodes.size());
+}
+
+
+/*-----------------------------------------------------------------------------------------
+    Queries
+-----------------------------------------------------------------------------------------*/
+
+MeshBVH::MeshBVH(const MeshSource& source)
+    : mNodes(source.bvhNodes.begin(), source.bvhNodes.end()),
+      mTriangles(source.bvhTriangles.begin(), source.bvhTriangles.end()),
+      mPositions(source.bvhPositions.begin(), source.bvhPositions.end())
+{
+    for (auto& subMesh : source.subMeshes)  mSubMeshFirstTriangles.push_back(subMesh.firstIndex / 3);
+}
+
+
+template <class LeafTest>
+void MeshBVH::Traverse(const CRay& ray, float& t, LeafTest leafTest) const
+{
+    if (mNodes.empty())  return;
+    CVector3 inverseDirection = RayInverseDirection(ray);
+    float entry;
+    if (!RayAABB(ray, inverseDirection, mNodes[0].bounds, t, entry))  return;
+
+    // Farther children wait on the stack with their entry distance, and are skipped if a nearer hit is found first
+    struct StackEntry
+    {
+        std::uint32_t node;
+        float         entry;
+    };
+    StackEntry stack[kMaxTraversalDepth];
+    int stackSize = 0;
+    std::uint32_t nodeIndex = 0;
+    for (;;)
+    {
+        const BVHNode& node = mNodes[nodeIndex];
+        bool descended = false;
+        if (node.count > 0)
+        {
+            if (leafTest(node, t))  return;
+        }
+        else
+        {
+            float entries[2];
+            bool hits[2] = { RayAABB(ray, inverseDirection, mNodes[node.first].bounds, t, entries[0]),
+                             RayAABB(ray, inverseDirection, mNodes[node.first + 1].bounds, t, entries[1]) };
+            if (hits[0] || hits[1])
+            {
+                int nearer = (hits[0] && (!hits[1] || entries[0] <= entries[1])) ? 0 : 1;
+                if (hits[1 - nearer] && stackSize < kMaxTraversalDepth)
+                {
+                    stack[stackSize++] = { node.first + 1 - nearer, entries[1 - nearer] };
+                }
+                nodeIndex = node.first + nearer;
+                descended = true;
+            }
+        }
+        if (!descended)
+        {
+            do
+            {
+                if (stackSize == 0)  return;
+                --stackSize;
+            } while (stack[stackSize].entry > t);
+            nodeIndex = stack[stackSize].node;
+        }
+    }
+}
+
+
+bool MeshBVH::Raycast(const CRay& ray, float& t, MeshRayHit* hit /*= nullptr*/) const
+{
+    const BVHTriangle* nearest = nullptr;
+    Traverse(ray, t, [&](const BVHNode& leaf, float& maxT)
+    {
+        for (std::uint32_t i = leaf.first; i < leaf.first + leaf.count; ++i)
+        {
+            const BVHTriangle& triangle = mTriangles[i];
+            if (RayTriangle(ray, mPositions[triangle.corners[0]], mPositions[triangle.corners[1]], mPositions[triangle.corners[2]], maxT))
+            {
+                nearest = &triangle;
+            }
+        }
+        return false;
+    });
+    if (nearest == nullptr)  return false;
+
+    if (hit != nullptr)
+    {
+        // The sub-mesh holding the triangle is the last one starting at or before it
+        auto subMesh = std::upper_bound(mSubMeshFirstTriangles.begin(), mSubMeshFirstTriangles.end(), nearest->triangle) - 1;
+        hit->t = t;
+        hit->subMesh = static_cast<std::uint32_t>(subMesh - mSubMeshFirstTriangles.begin());
+        hit->triangle = nearest->triangle - *subMesh;
+    }
+    return true;
+}
+
+
+bool MeshBVH::IsBlocked(const CRay& ray, float maxT) const
+{
+    bool blocked = false;
+    Traverse(ray, maxT, [&](const BVHNode& leaf, float& t)
+    {
+        for (std::uint32_t i = leaf.first; i < leaf.first + leaf.count; ++i)
+        {
+            const BVHTriangle& triangle = mTriangles[i];
+            if (RayTriangle(ray, mPositions[triangle.corners[0]], mPositions[triangle.corners[1]], mPositions[triangle.corners[2]], t))
+            {
+                blocked = true;
+                return true;
+            }
+        }
+        return false;
+    });
+    return blocked;
+}
+
+
+std::size_t MeshBVH::Bytes() const
+{
+    return mNodes.size() * sizeof(BVHNode) + mTriangles.size() * sizeof(BVHTriangle) +
+           mPositions.size() * sizeof(CVector3) + mSubMeshFirstTriangles.size() * sizeof(std::uint32_t);
+}
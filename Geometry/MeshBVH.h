@@ -0,0 +1,83 @@
+//--------------------------------------------------------------------------------------
+// Bounding volume hierarchy for ray casts against a mesh
+//--------------------------------------------------------------------------------------
+// Code in .cpp file
+// Picking and line-of-sight checks need the triangles of a mesh on the CPU, but the vertex buffers live on the GPU. The
+// build stage keeps a compact copy of the full detail triangles (positions only, each position stored once) and builds
+// a hierarchy of boxes over them, so a ray only tests the few triangles near its path rather than all of them
+//
+// The hierarchy is built top-down with the surface area heuristic (SAH), which estimates the cost of a split from the
+// chance of a ray entering each side (proportional to the surface area of its box) times the triangles it holds. Splits
+// are chosen among 16 bins along each axis rather than every triangle position ("binned SAH", Wald, "On fast
+// construction of SAH-based bounding volume hierarchies"). Large meshes build separate subtrees on separate threads
+
+#ifndef _MESH_BVH_H_DEFINED_
+#define _MESH_BVH_H_DEFINED_
+
+#include "MeshData.h"
+#include "RayIntersection.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+/*-----------------------------------------------------------------------------------------
+    Building
+-----------------------------------------------------------------------------------------*/
+
+const std::uint32_t kMaxBVHLeafTriangles = 4;
+
+// Build the ray cast hierarchy over the full detail sub-meshes of mesh data with float vertices and 32-bit indices,
+// replacing any already built. Must come after every stage that changes the full detail triangles (including
+// optimisation, MeshOptimise.h), since the hierarchy refers to triangles by their place in the index list. Returns the
+// number of nodes
+std::uint32_t BuildBVH(MeshData& data);
+
+
+/*-----------------------------------------------------------------------------------------
+    Queries
+-----------------------------------------------------------------------------------------*/
+
+// Where a ray hit a mesh
+struct MeshRayHit
+{
+    float         t;            // Distance along the ray, in units of the ray direction's length
+    std::uint32_t subMesh;
+    std::uint32_t triangle;     // Within the sub-mesh, its first index is the sub-mesh's firstIndex + triangle * 3
+};
+
+// Ray cast hierarchy kept for a mesh after its other data is released. All rays are in the mesh's own space, and like
+// the tests in RayIntersection.h triangles are hit from either side
+class MeshBVH
+{
+public:
+    MeshBVH() {}
+
+    // Copy the hierarchy out of mesh source (empty if it has none)
+    explicit MeshBVH(const MeshSource& source);
+
+    // Find the nearest triangle hit. On input t is the furthest distance to look for hits, on a hit t is updated with
+    // the hit distance. Returns false if nothing is hit closer than t
+    bool Raycast(const CRay& ray, float& t, MeshRayHit* hit = nullptr) const;
+
+    // Return true if the ray hits any triangle closer than maxT, stopping at the first found (for line-of-sight checks)
+    bool IsBlocked(const CRay& ray, float maxT) const;
+
+    bool        Empty() const  { return mNodes.empty(); }
+    std::size_t Bytes() const; // Memory used by the hierarchy and its triangles
+
+private:
+    // Traverse nearest child first, calling the leaf test for each leaf the ray enters closer than t. Stops early if
+    // the leaf test returns true
+    template <class LeafTest>
+    void Traverse(const CRay& ray, float& t, LeafTest leafTest) const;
+
+    std::vector<BVHNode>       mNodes;
+    std::vector<BVHTriangle>   mTriangles;
+    std::vector<CVector3>      mPositions;
+    std::vector<std::uint32_t> mSubMeshFirstTriangles; // Full detail triangle number of the start of each sub-mesh
+};
+
+
+#endif // _MESH_BVH_H_DEFINED_
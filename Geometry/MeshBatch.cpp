@@ -0,0 +1,157 @@
+//--------------------------------------------------------------------------------------
+// Merging several placed meshes into one (static batching)
+//--------------------------------------------------------------------------------------
+
+#include "MeshBatch.h"
+#include "MeshIndices.h"  // Vertex limit and packing for 16-bit indices
+#include "VectorStream.h" // Transforming the vertex elements in place
+
+#include <algorithm>
+#include <vector>
+
+
+// Merge the given meshes into one in world space
+bool BuildBatch(const BatchMember* members, std::size_t numMembers, MeshData& batch)
+{
+    batch = MeshData();
+    if (numMembers == 0)  return false;
+
+    const VertexFormat& format = members[0].source.format;
+    for (std::size_t m = 0; m < numMembers; ++m)
+    {
+        const VertexFormat& memberFormat = members[m].source.format;
+        if (memberFormat.compact || memberFormat.vertexSize != format.vertexSize ||
+            memberFormat.hasTangents != format.hasTangents || memberFormat.hasUVs != format.hasUVs)  return false;
+    }
+    batch.format = MakeVertexFormat(format.hasTangents != 0, format.hasUVs != 0);
+    const std::uint32_t vertexSize = batch.format.vertexSize;
+    const std::uint32_t positionSize = PositionSize(batch.format);
+
+    std::size_t numVertices = 0, numPositions = 0, numIndices = 0;
+    for (std::size_t m = 0; m < numMembers; ++m)
+    {
+        const MeshSource& source = members[m].source;
+        numVertices += source.vertices.size / vertexSize;
+        numPositions += source.depthVertices.empty() ? source.vertices.size / vertexSize : source.depthVertices.size / positionSize;
+        numIndices += source.NumIndices();
+    }
+    batch.vertices.reserve(numVertices * vertexSize);
+    batch.depthVertices.reserve(numPositions * positionSize);
+    batch.indices.reserve(numIndices);
+    batch.depthIndices.reserve(numIndices);
+
+    for (std::size_t m = 0; m < numMembers; ++m)
+    {
+        const MeshSource& source = members[m].source;
+        const CMatrix4x4& world = members[m].worldMatrix;
+
+        CMatrix4x4 normalMatrix = InverseAffine(world);
+        normalMatrix.Transpose();
+        bool mirrored = Dot(Cross(world.GetRow(0), world.GetRow(1)), world.GetRow(2)) < 0.0f;
+        bool hasDepth = !source.depthSubMeshes.empty();
+
+        for (std::size_t s = 0; s < source.subMeshes.size; ++s)
+        {
+            // Member sub-meshes are added whole to the last merged sub-mesh, starting another when it would go over
+            // the vertex limit for 16-bit indices
+            const SubMesh& subMesh = source.subMeshes[s];
+            if (batch.subMeshes.empty() || (batch.subMeshes.back().numVertices > 0 &&
+                                            batch.subMeshes.back().numVertices + subMesh.numVertices > kMaxShortIndexVertices))
+            {
+                std::uint32_t firstIndex = static_cast<std::uint32_t>(batch.indices.size());
+                batch.subMeshes.push_back({ static_cast<std::uint32_t>(batch.NumVertices()), 0, firstIndex, 0 });
+                batch.depthSubMeshes.push_back({ static_cast<std::uint32_t>(batch.depthVertices.size() / positionSize), 0, firstIndex, 0 });
+            }
+            SubMesh& merged = batch.subMeshes.back();
+            SubMesh& depthMerged = batch.depthSubMeshes.back();
+
+            //-----------------------------------
+            // Vertices
+
+            std::size_t firstVertex = batch.vertices.size();
+            const std::uint8_t* vertices = source.vertices.data + static_cast<std::size_t>(subMesh.firstVertex) * vertexSize;
+            batch.vertices.insert(batch.vertices.end(), vertices, vertices + static_cast<std::size_t>(subMesh.numVertices) * vertexSize);
+
+            std::uint8_t* added = batch.vertices.data() + firstVertex;
+            StreamTransformPoints(added, vertexSize, added, vertexSize, subMesh.numVertices, world);
+            StreamTransformVectors(added + batch.format.normalOffset, vertexSize, added + batch.format.normalOffset, vertexSize,
+                                   subMesh.numVertices, normalMatrix);
+            StreamNormalise(added + batch.format.normalOffset, vertexSize, added + batch.format.normalOffset, vertexSize,
+                            subMesh.numVertices);
+            if (batch.format.hasTangents)
+            {
+                StreamTransformVectors(added + batch.format.tangentOffset, vertexSize, added + batch.format.tangentOffset,
+                                       vertexSize, subMesh.numVertices, world);
+                StreamNormalise(added + batch.format.tangentOffset, vertexSize, added + batch.format.tangentOffset, vertexSize,
+                                subMesh.numVertices);
+            }
+
+            // The member's welded depth positions are transformed the same way. A member without a depth version uses
+            // the positions of its transformed vertices with its main indices
+            std::size_t firstPosition = batch.depthVertices.size();
+            std::uint32_t numPositions = subMesh.numVertices;
+            if (hasDepth)
+            {
+                const SubMesh& depthSubMesh = source.depthSubMeshes[s];
+                numPositions = depthSubMesh.numVertices;
+                const std::uint8_t* positions = source.depthVertices.data + static_cast<std::size_t>(depthSubMesh.firstVertex) * positionSize;
+                batch.depthVertices.insert(batch.depthVertices.end(), positions, positions + static_cast<std::size_t>(numPositions) * positionSize);
+                StreamTransformPoints(batch.depthVertices.data() + firstPosition, positionSize,
+                                      batch.depthVertices.data() + firstPosition, positionSize, numPositions, world);
+            }
+            else
+            {
+                std::vector<std::uint8_t> positions = ExtractPositions(added, subMesh.numVertices, batch.format);
+                batch.depthVertices.insert(batch.depthVertices.end(), positions.begin(), positions.end());
+            }
+
+            //-----------------------------------
+            // Indices
+
+            // Offset to the member's place in the merged sub-mesh, and reverse the triangles of mirrored members so
+            // their front faces stay clockwise
+            auto index = [](const ArrayView<std::uint32_t>& indices, const ArrayView<std::uint16_t>& shortIndices, std::size_t i)
+            {
+                return shortIndices.empty() ? indices[i] : static_cast<std::uint32_t>(shortIndices[i]);
+            };
+            for (std::uint32_t i = 0; i < subMesh.numIndices / 3 * 3; i += 3)
+            {
+                std::uint32_t corners[3], depthCorners[3];
+                for (int c = 0; c < 3; ++c)
+                {
+                    std::size_t corner = subMesh.firstIndex + i + c;
+                    corners[c] = merged.numVertices + index(source.indices, source.shortIndices, corner);
+                    depthCorners[c] = depthMerged.numVertices + (hasDepth ? index(source.depthIndices, source.depthShortIndices, corner)
+                                                                          : index(source.indices, source.shortIndices, corner));
+                }
+                if (mirrored)
+                {
+                    std::swap(corners[1], corners[2]);
+                    std::swap(depthCorners[1], depthCorners[2]);
+                }
+                batch.indices.insert(batch.indices.end(), corners, corners + 3);
+                batch.depthIndices.insert(batch.depthIndices.end(), depthCorners, depthCorners + 3);
+            }
+
+            merged.numVertices += subMesh.numVertices;
+            merged.numIndices = static_cast<std::uint32_t>(batch.indices.size()) - merged.firstIndex;
+            depthMerged.numVertices += numPositions;
+            depthMerged.numIndices = merged.numIndices;
+        }
+    }
+
+    std::uint32_t numSubMeshes = static_cast<std::uint32_t>(batch.subMeshes.size());
+    batch.nodes.push_back({ MatrixIdentity(), 0, 0, numSubMeshes });
+    for (std::uint32_t s = 0; s < numSubMeshes; ++s)  batch.nodeSubMeshes.push_back(s);
+    batch.bounds = AABBFromPoints(batch.vertices.data(), vertexSize, batch.NumVertices());
+
+    // The depth indices use the same size as the main ones. A member sub-mesh with more than 65536 vertices leaves
+    // them all 32-bit
+    if (PackShortIndices(batch))
+    {
+        batch.depthShortIndices.assign(batch.depthIndices.begin(), batch.depthIndices.end());
+        batch.depthIndices.clear();
+        batch.depthIndices.shrink_to_fit();
+    }
+    return true;
+}
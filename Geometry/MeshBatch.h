@@ -0,0 +1,40 @@
+//--------------------------------------------------------------------------------------
+// Merging several placed meshes into one (static batching)
+//--------------------------------------------------------------------------------------
+// Code in .cpp file
+// Every model drawn costs a constant buffer update and a change of vertex and index buffers, however few triangles it
+// has. Models that never move and are drawn with the same shaders and textures can instead be merged into a single
+// mesh with their world matrices already applied to the vertices, then drawn with one world matrix (the identity) in
+// one or a few draw calls. The merged mesh must be rebuilt if any of its members moves (see StaticBatch.h)
+//
+// Each member's full detail sub-meshes are added in order, transformed into world space: positions by the world
+// matrix, normals by its inverse transpose (so non-uniform scaling keeps them perpendicular to the surface), tangents
+// by the matrix itself. Mirroring matrices reverse the triangles so they still face the same way. Each member's depth
+// version (see MeshDepth.h) is transformed and added in the same way rather than welding and optimising the merged
+// mesh again, so a rebuild costs little more than copying the members. Levels of detail and clusters are not carried
+// over, the members are expected to be small
+
+#ifndef _MESH_BATCH_H_DEFINED_
+#define _MESH_BATCH_H_DEFINED_
+
+#include "MeshData.h"
+
+#include <cstddef>
+
+
+// A mesh placed in the world
+struct BatchMember
+{
+    MeshSource source;
+    CMatrix4x4 worldMatrix;
+};
+
+// Merge the given meshes into one in world space, replacing the contents of batch. The members must have float
+// vertices (not compact) with the same elements. Member sub-meshes are grouped whole into merged sub-meshes of at most
+// 65536 vertices so they can use 16-bit indices. The depth version comes from the members' depth versions, or from
+// their vertex positions for members without one. Can be called on any thread. Returns false (leaving batch empty) if
+// the members can't be merged
+bool BuildBatch(const BatchMember* members, std::size_t numMembers, MeshData& batch);
+
+
+#endif // _MESH_BATCH_H_DEFINED_
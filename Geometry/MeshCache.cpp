@@ -0,0 +1,301 @@
+//--------------------------------------------------------------------------------------
+// Binary mesh cache
+//--------------------------------------------------------------------------------------
+// File layout: a CacheHeader, followed by each array of the MeshSource in the order given by VisitArrays. Arrays start
+// on 16 byte boundaries so they can be used in place. Files are only read on the machine that wrote them, so values
+// are stored in the machine's own byte order
+
+#include "MeshCache.h"
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+
+
+/*-----------------------------------------------------------------------------------------
+    File format
+-----------------------------------------------------------------------------------------*/
+
+namespace
+{
+    const std::uint32_t kCacheMagic   = 0x4348534D; // "MSHC"
+    const std::uint32_t kCacheVersion = 7;          // Increase whenever the file layout or any stored type changes
+    const std::uint32_t kNumArrays    = 16;
+    const std::size_t   kArrayAlign   = 16;
+
+    struct CacheArray
+    {
+        std::uint64_t offset;      // From the start of the file
+        std::uint64_t count;
+        std::uint32_t elementSize; // Checked against the type being read
+        std::uint32_t padding;
+    };
+
+    struct CacheHeader
+    {
+        std::uint32_t magic;
+        std::uint32_t version;
+        std::uint64_t key;
+        std::uint64_t fileSize;
+        VertexFormat  format;
+        CAABB         bounds;
+        CacheArray    arrays[kNumArrays];
+    };
+
+    // Every array of a MeshSource, in file order. Add new arrays at the end, and increase kNumArrays and kCacheVersion
+    template <class Source, class Visitor>
+    void VisitArrays(Source& source, Visitor&& visit)
+    {
+        visit(source.vertices);
+        visit(source.indices);
+        visit(source.subMeshes);
+        visit(source.nodes);
+        visit(source.nodeSubMeshes);
+        visit(source.shortIndices);
+        visit(source.lods);
+        visit(source.lodSubMeshes);
+        visit(source.clusters);
+        visit(source.bvhNodes);
+        visit(source.bvhTriangles);
+        visit(source.bvhPositions);
+        visit(source.depthVertices);
+        visit(source.depthSubMeshes);
+        visit(source.depthIndices);
+        visit(source.depthShortIndices);
+    }
+
+    std::uint64_t AlignUp(std::uint64_t offset)
+    {
+        return (offset + kArrayAlign - 1) & ~static_cast<std::uint64_t>(kArrayAlign - 1);
+    }
+
+    // 64-bit FNV-1a hash of a block of memory
+    std::uint64_t HashBytes(const std::uint8_t* data, std::size_t size, std::uint64_t hash = 14695981039346656037ull)
+    {
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            hash = (hash ^ data[i]) * 1099511628211ull;
+        }
+        return hash;
+    }
+
+    // Cache file name for a mesh file, e.g. MeshCache/Troll.x.0123456789abcdef.mesh
+    std::string CacheFileName(const std::string& fileName, std::uint64_t key, const std::string& cacheFolder)
+    {
+        std::string name = fileName;
+        for (auto& c : name)
+        {
+            if (c == '/' || c == '\\' || c == ':')  c = '_';
+        }
+        char keyText[17];
+        std::snprintf(keyText, sizeof(keyText), "%016llx", static_cast<unsigned long long>(key));
+        return cacheFolder + "/" + name + "." + keyText + ".mesh";
+    }
+
+    // Check the ranges in the tables of a loaded mesh lie inside its arrays, so a damaged file can't cause reads
+    // outside the GPU buffers
+    bool RangesValid(const MeshSource& source)
+    {
+        if (source.format.vertexSize == 0 || source.vertices.size % source.format.vertexSize != 0)  return false;
+        std::size_t numVertices = source.vertices.size / source.format.vertexSize;
+        auto subMeshValid = [&](const SubMesh& subMesh)
+        {
+            return subMesh.firstVertex + static_cast<std::uint64_t>(subMesh.numVertices) <= numVertices &&
+                   subMesh.firstIndex + static_cast<std::uint64_t>(subMesh.numIndices) <= source.NumIndices();
+        };
+        if (!std::all_of(source.subMeshes.begin(), source.subMeshes.end(), subMeshValid) ||
+            !std::all_of(source.lodSubMeshes.begin(), source.lodSubMeshes.end(), subMeshValid))  return false;
+        for (auto& lod : source.lods)
+        {
+            if (lod.firstSubMesh + static_cast<std::uint64_t>(source.subMeshes.size) > source.lodSubMeshes.size)  return false;
+        }
+        std::uint32_t previousSubMesh = 0;
+        for (auto& cluster : source.clusters)
+        {
+            if (cluster.subMesh >= source.subMeshes.size || cluster.subMesh < previousSubMesh)  return false;
+            previousSubMesh = cluster.subMesh;
+            const SubMesh& subMesh = source.subMeshes[cluster.subMesh];
+            std::uint64_t clusterEnd = cluster.firstIndex + static_cast<std::uint64_t>(cluster.numIndices);
+            std::uint64_t subMeshEnd = subMesh.firstIndex + static_cast<std::uint64_t>(subMesh.numIndices);
+            if (cluster.firstIndex < subMesh.firstIndex || clusterEnd > subMeshEnd)  return false;
+        }
+        for (std::size_t i = 0; i < source.bvhNodes.size; ++i)
+        {
+            // Children must come after their parent so a damaged file can't make the hierarchy loop
+            const BVHNode& node = source.bvhNodes[i];
+            std::uint64_t end = node.first + static_cast<std::uint64_t>(node.count == 0 ? 2 : node.count);
+            if (node.count == 0 && node.first <= i)  return false;
+            if (end > (node.count == 0 ? source.bvhNodes.size : source.bvhTriangles.size))  return false;
+        }
+        for (auto& triangle : source.bvhTriangles)
+        {
+            for (auto corner : triangle.corners)
+            {
+                if (corner >= source.bvhPositions.size)  return false;
+            }
+        }
+        if (!source.depthSubMeshes.empty())
+        {
+            // The depth version has a sub-mesh for each sub-mesh, with the same index ranges
+            std::uint32_t positionSize = PositionSize(source.format);
+            std::size_t numDepthIndices = source.depthShortIndices.empty() ? source.depthIndices.size : source.depthShortIndices.size;
+            if (positionSize == 0 || source.depthVertices.size % positionSize != 0 ||
+                source.depthSubMeshes.size != source.subMeshes.size || numDepthIndices != source.NumIndices())  return false;
+            for (std::size_t s = 0; s < source.subMeshes.size; ++s)
+            {
+                const SubMesh& depthSubMesh = source.depthSubMeshes[s];
+                if (depthSubMesh.firstVertex + static_cast<std::uint64_t>(depthSubMesh.numVertices) > source.depthVertices.size / positionSize ||
+                    depthSubMesh.firstIndex != source.subMeshes[s].firstIndex || depthSubMesh.numIndices != source.subMeshes[s].numIndices)  return false;
+            }
+        }
+        for (auto& node : source.nodes)
+        {
+            if (node.firstSubMesh + static_cast<std::uint64_t>(node.numSubMeshes) > source.nodeSubMeshes.size)  return false;
+        }
+        for (auto subMesh : source.nodeSubMeshes)
+        {
+            if (subMesh >= source.subMeshes.size)  return false;
+        }
+        return true;
+    }
+}
+
+
+/*-----------------------------------------------------------------------------------------
+    Loading
+-----------------------------------------------------------------------------------------*/
+
+// Return mesh data for the given file ready for creating GPU buffers, from the cache if possible
+MeshSource LoadMeshSource(const std::string& fileName, const MeshImportOptions& options, const std::string& cacheFolder /*= "MeshCache"*/)
+{
+    std::uint64_t key = 0;
+    std::string cacheFileName;
+    if (!cacheFolder.empty())
+    {
+        key = MeshCacheKey(fileName, options);
+        if (key != 0)
+        {
+            cacheFileName = CacheFileName(fileName, key, cacheFolder);
+            MeshSource source;
+            if (LoadMeshCache(cacheFileName, key, source))  return source;
+        }
+    }
+
+    MeshSource source = MakeMeshSource(std::make_shared<MeshData>(ImportMesh(fileName, options)));
+    if (!cacheFileName.empty() && CreateFolder(cacheFolder))
+    {
+        SaveMeshCache(cacheFileName, key, source);
+    }
+    return source;
+}
+
+
+// Return the cache key for a mesh file and import options, or 0 if the file cannot be read
+std::uint64_t MeshCacheKey(const std::string& fileName, const MeshImportOptions& options)
+{
+    MappedFile file;
+    if (!file.Open(fileName))  return 0;
+
+    std::uint64_t settings[2] = { MeshImportKey(options), kCacheVersion };
+    std::uint64_t key = HashBytes(file.Data(), file.Size());
+    key = HashBytes(reinterpret_cast<const std::uint8_t*>(settings), sizeof(settings), key);
+    return key != 0 ? key : 1;
+}
+
+
+// Write mesh data to a cache file with the given key. Returns false on failure
+bool SaveMeshCache(const std::string& cacheFileName, std::uint64_t key, const MeshSource& source)
+{
+    CacheHeader header = {};
+    header.magic   = kCacheMagic;
+    header.version = kCacheVersion;
+    header.key     = key;
+    header.format  = source.format;
+    header.bounds  = source.bounds;
+
+    // Lay out the arrays after the header
+    std::uint64_t offset = sizeof(CacheHeader);
+    std::uint32_t arrayIndex = 0;
+    VisitArrays(source, [&](const auto& array)
+    {
+        CacheArray& entry = header.arrays[arrayIndex++];
+        entry.offset      = AlignUp(offset);
+        entry.count       = array.size;
+        entry.elementSize = sizeof(*array.data);
+        offset = entry.offset + entry.count * entry.elementSize;
+    });
+    header.fileSize = offset;
+
+    // Write to a temporary file first so an interrupted write never leaves a damaged cache file behind
+    std::string tempFileName = cacheFileName + ".tmp";
+    {
+        std::ofstream file(tempFileName, std::ios::binary | std::ios::trunc);
+        if (!file)  return false;
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        const char zeros[kArrayAlign] = {};
+        std::uint64_t position = sizeof(CacheHeader);
+        arrayIndex = 0;
+        VisitArrays(source, [&](const auto& array)
+        {
+            const CacheArray& entry = header.arrays[arrayIndex++];
+            file.write(zeros, static_cast<std::streamsize>(entry.offset - position));
+            file.write(reinterpret_cast<const char*>(array.data), static_cast<std::streamsize>(entry.count * entry.elementSize));
+            position = entry.offset + entry.count * entry.elementSize;
+        });
+        if (!file.flush())
+        {
+            file.close();
+            std::remove(tempFileName.c_str());
+            return false;
+        }
+    }
+
+    std::remove(cacheFileName.c_str());
+    if (std::rename(tempFileName.c_str(), cacheFileName.c_str()) != 0)
+    {
+        std::remove(tempFileName.c_str());
+        return false;
+    }
+    return true;
+}
+
+
+// Map a cache file and point the arrays of a MeshSource into it. Returns false if missing, out of date or damaged
+bool LoadMeshCache(const std::string& cacheFileName, std::uint64_t key, MeshSource& source)
+{
+    auto file = std::make_shared<MappedFile>();
+    if (!file->Open(cacheFileName) || file->Size() < sizeof(CacheHeader))  return false;
+
+    CacheHeader header;
+    std::memcpy(&header, file->Data(), sizeof(header));
+    if (header.magic != kCacheMagic || header.version != kCacheVersion || header.key != key ||
+        header.fileSize != file->Size())  return false;
+
+    MeshSource loaded;
+    loaded.format = header.format;
+    loaded.bounds = header.bounds;
+
+    bool valid = true;
+    std::uint32_t arrayIndex = 0;
+    VisitArrays(loaded, [&](auto& array)
+    {
+        using Element = std::remove_const_t<std::remove_pointer_t<decltype(array.data)>>;
+        const CacheArray& entry = header.arrays[arrayIndex++];
+        if (entry.elementSize != sizeof(Element) || entry.offset % kArrayAlign != 0 || entry.offset > header.fileSize ||
+            entry.count > (header.fileSize - entry.offset) / sizeof(Element))
+        {
+            valid = false;
+            return;
+        }
+        array = ArrayView<Element>(reinterpret_cast<const Element*>(file->Data() + entry.offset), static_cast<std::size_t>(entry.count));
+    });
+    if (!valid || !RangesValid(loaded))  return false;
+
+    loaded.storage = std::move(file);
+    source = std::move(loaded);
+    return true;
+}
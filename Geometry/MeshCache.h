@@ -0,0 +1,39 @@
+//--------------------------------------------------------------------------------------
+// Binary mesh cache
+//--------------------------------------------------------------------------------------
+// Code in .cpp file
+// Importing a mesh with assimp is slow, so after the first import the mesh data is written to a binary cache file. On
+// later runs the cache file is memory-mapped and its arrays are used in place to create the GPU buffers - nothing is
+// parsed or copied. Cache files are named after the mesh file and a key made from a hash of the mesh file's contents,
+// the import options and the cache version, so editing the mesh or changing any import setting gives a new cache file
+// and the old one is simply not used again. The cache folder can be deleted at any time
+
+#ifndef _MESH_CACHE_H_DEFINED_
+#define _MESH_CACHE_H_DEFINED_
+
+#include "MeshData.h"
+#include "MeshImport.h"
+
+#include <cstdint>
+#include <string>
+
+
+// Return mesh data for the given file ready for creating GPU buffers. Uses an up to date cache file from the cache
+// folder if there is one, otherwise imports the mesh file and writes a cache file for next time (ignoring failures to
+// write it). Pass an empty cache folder to always import. Can be called from several threads at once, as long as they
+// aren't loading the same file with the same options. Will throw a std::runtime_error exception on failure
+MeshSource LoadMeshSource(const std::string& fileName, const MeshImportOptions& options, const std::string& cacheFolder = "MeshCache");
+
+
+// Return the cache key for a mesh file and import options, or 0 if the file cannot be read
+std::uint64_t MeshCacheKey(const std::string& fileName, const MeshImportOptions& options);
+
+// Write mesh data to a cache file with the given key. Returns false on failure
+bool SaveMeshCache(const std::string& cacheFileName, std::uint64_t key, const MeshSource& source);
+
+// Map a cache file and point the arrays of a MeshSource into it. Returns false if the file doesn't exist, was written
+// with a different key or cache version, or is damaged
+bool LoadMeshCache(const std::string& cacheFileName, std::uint64_t key, MeshSource& source);
+
+
+#endif // _MESH_CACHE_H_DEFINED_
@@ -0,0 +1,327 @@
+//--------------------------------------------------------------------------------------
+// Mesh clusters (meshlets) for culling parts of a mesh
+//--------------------------------------------------------------------------------------
+
+#include "MeshClusters.h"
+#include "VectorStream.h" // Gathering positions out of the vertices
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+
+namespace
+{
+    // Smallest dot product between a triangle normal and the average normal of the cluster it is added to. Clusters
+    // with wider cones are rarely entirely back-facing
+    const float kMinConeDot = 0.3f;
+
+    // Clusters smaller than this take neighbours of any direction, or the nearest separate part of the mesh, rather
+    // than end, since many tiny clusters (e.g. on boxy meshes with few triangles per face) cost more in draw calls
+    // than their culling saves
+    const std::uint32_t kMinClusterTriangles = 16;
+
+    // Weight of a triangle's angle from the cluster's average normal against the number of new vertices it needs
+    const float kConeWeight = 2.0f;
+
+    const float kNoCone = 2.0f; // Cone cutoff for clusters that can't be culled as back-facing
+
+    // Unit normal of the front of a triangle (clockwise as seen from the front), zero for degenerate triangles
+    CVector3 TriangleNormal(const CVector3& p0, const CVector3& p1, const CVector3& p2)
+    {
+        CVector3 normal = Cross(p1 - p0, p2 - p0);
+        float length = Length(normal);
+        return length > 0.0f ? normal * (1.0f / length) : CVector3{ 0, 0, 0 };
+    }
+
+    // Fill in the bounding sphere and normal cone of a cluster
+    void SetClusterBounds(MeshCluster& cluster, const std::uint32_t* indices, const CVector3* positions)
+    {
+        // Sphere around the box of the cluster's vertices, with the radius reaching the furthest vertex
+        CVector3 boxMin = positions[indices[0]];
+        CVector3 boxMax = boxMin;
+        for (std::uint32_t i = 1; i < cluster.numIndices; ++i)
+        {
+            const CVector3& p = positions[indices[i]];
+            boxMin = { std::min(boxMin.x, p.x), std::min(boxMin.y, p.y), std::min(boxMin.z, p.z) };
+            boxMax = { std::max(boxMax.x, p.x), std::max(boxMax.y, p.y), std::max(boxMax.z, p.z) };
+        }
+        cluster.bounds.centre = (boxMin + boxMax) * 0.5f;
+        cluster.bounds.radius = 0.0f;
+        for (std::uint32_t i = 0; i < cluster.numIndices; ++i)
+        {
+            cluster.bounds.radius = std::max(cluster.bounds.radius, Length(positions[indices[i]] - cluster.bounds.centre));
+        }
+
+        // Cone axis is the average triangle normal, the cone is as wide as the normal furthest from it
+        CVector3 normalSum = { 0, 0, 0 };
+        for (std::uint32_t i = 0; i + 2 < cluster.numIndices; i += 3)
+        {
+            normalSum += TriangleNormal(positions[indices[i]], positions[indices[i + 1]], positions[indices[i + 2]]);
+        }
+        cluster.coneApex = cluster.bounds.centre;
+        cluster.coneAxis = { 0, 0, 0 };
+        cluster.coneCutoff = kNoCone;
+        float sumLength = Length(normalSum);
+        if (sumLength <= 0.0f)  return;
+        CVector3 axis = normalSum * (1.0f / sumLength);
+
+        float minDot = 1.0f;
+        for (std::uint32_t i = 0; i + 2 < cluster.numIndices; i += 3)
+        {
+            CVector3 normal = TriangleNormal(positions[indices[i]], positions[indices[i + 1]], positions[indices[i + 2]]);
+            if (normal.x != 0.0f || normal.y != 0.0f || normal.z != 0.0f)  minDot = std::min(minDot, Dot(normal, axis));
+        }
+        if (minDot <= 0.0f)  return; // Normals in more than a hemisphere, the cluster always has some front faces
+
+        // Move the apex back along the axis until it is behind the plane of every triangle. Then a viewer inside the
+        // cone from the apex is behind all the planes. The cone's half angle is 90 degrees less that of the normals,
+        // given as the cosine of the angle between the axis and the direction from the viewer to the apex
+        float apexDistance = 0.0f;
+        for (std::uint32_t i = 0; i + 2 < cluster.numIndices; i += 3)
+        {
+            const CVector3& p0 = positions[indices[i]];
+            CVector3 normal = TriangleNormal(p0, positions[indices[i + 1]], positions[indices[i + 2]]);
+            float normalDot = Dot(normal, axis);
+            if (normalDot > 0.0f)  apexDistance = std::max(apexDistance, Dot(cluster.bounds.centre - p0, normal) / normalDot);
+        }
+        cluster.coneApex = cluster.bounds.centre - axis * apexDistance;
+        cluster.coneAxis = axis;
+        cluster.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+    }
+}
+
+
+// Build the clusters of mesh data with float vertices and 32-bit indices
+std::uint32_t BuildClusters(MeshData& data, std::uint32_t maxVertices /*= kMaxClusterVertices*/,
+                            std::uint32_t maxTriangles /*= kMaxClusterTriangles*/)
+{
+    data.clusters.clear();
+    if (data.format.compact || !data.shortIndices.empty() || maxVertices < 3 || maxTriangles < 1)  return 0;
+
+    const std::uint32_t kNone = ~0u;
+    for (std::uint32_t s = 0; s < data.subMeshes.size(); ++s)
+    {
+        const SubMesh& subMesh = data.subMeshes[s];
+        const std::uint32_t numTriangles = subMesh.numIndices / 3;
+        if (numTriangles == 0)  continue;
+        std::uint32_t* indices = data.indices.data() + subMesh.firstIndex;
+
+        std::vector<CVector3> positions(subMesh.numVertices);
+        StreamCopyVector3(data.vertices.data() + static_cast<std::size_t>(subMesh.firstVertex) * data.format.vertexSize,
+                          data.format.vertexSize, positions.data(), sizeof(CVector3), subMesh.numVertices);
+        std::vector<CVector3> normals(numTriangles);
+        std::vector<CVector3> centres(numTriangles);
+        for (std::uint32_t t = 0; t < numTriangles; ++t)
+        {
+            const CVector3& p0 = positions[indices[t * 3]];
+            const CVector3& p1 = positions[indices[t * 3 + 1]];
+            const CVector3& p2 = positions[indices[t * 3 + 2]];
+            normals[t] = TriangleNormal(p0, p1, p2);
+            centres[t] = (p0 + p1 + p2) * (1.0f / 3.0f);
+        }
+
+        // Triangles using each position. Vertices at the same position (split by hard edges or UV seams) are treated
+        // as one here, so triangles either side of a seam are still neighbours
+        std::vector<std::uint32_t> position(subMesh.numVertices);
+        {
+            std::vector<std::uint32_t> sorted(subMesh.numVertices);
+            for (std::uint32_t v = 0; v < subMesh.numVertices; ++v)  sorted[v] = v;
+            auto less = [&](std::uint32_t a, std::uint32_t b) { return std::memcmp(&positions[a], &positions[b], sizeof(CVector3)) < 0; };
+            std::sort(sorted.begin(), sorted.end(), less);
+            for (std::uint32_t i = 0; i < subMesh.numVertices; ++i)
+            {
+                position[sorted[i]] = (i > 0 && !less(sorted[i - 1], sorted[i])) ? position[sorted[i - 1]] : sorted[i];
+            }
+        }
+        std::vector<std::uint32_t> firstPositionTriangle(subMesh.numVertices + 1, 0);
+        for (std::uint32_t i = 0; i < numTriangles * 3; ++i)  ++firstPositionTriangle[position[indices[i]] + 1];
+        for (std::uint32_t v = 0; v < subMesh.numVertices; ++v)  firstPositionTriangle[v + 1] += firstPositionTriangle[v];
+        std::vector<std::uint32_t> positionTriangles(numTriangles * 3);
+        {
+            std::vector<std::uint32_t> next(firstPositionTriangle.begin(), firstPositionTriangle.end() - 1);
+            for (std::uint32_t i = 0; i < numTriangles * 3; ++i)  positionTriangles[next[position[indices[i]]]++] = i / 3;
+        }
+
+        // Grow each cluster from a seed triangle, adding the neighbouring triangle that needs fewest new vertices and
+        // keeps the normal cone narrowest, until a limit is reached or no neighbour fits. Each cluster is seeded
+        // next to where the last one ended, so the clusters cover the mesh in strips like a vertex cache order
+        std::vector<std::uint8_t>  emitted(numTriangles, 0);
+        std::vector<std::uint32_t> clusterVertex(subMesh.numVertices, kNone); // Cluster each vertex was last used by
+        std::vector<std::uint32_t> candidateOf(numTriangles, kNone);          // Cluster each triangle was last a candidate for
+        std::vector<std::uint32_t> candidates;
+        std::vector<std::uint32_t> order;           // Triangles in cluster order
+        std::vector<std::uint32_t> clusterStarts;   // Position in order of the start of each cluster
+        order.reserve(numTriangles);
+        std::uint32_t firstUnemitted = 0;
+        CVector3 lastCentre = centres[0];
+        while (order.size() < numTriangles)
+        {
+            const std::uint32_t cluster = static_cast<std::uint32_t>(clusterStarts.size());
+            clusterStarts.push_back(static_cast<std::uint32_t>(order.size()));
+            candidates.clear();
+            std::uint32_t numVertices = 0;
+            std::uint32_t clusterTriangles = 0;
+            CVector3 normalSum = { 0, 0, 0 };
+
+            auto addTriangle = [&](std::uint32_t t)
+            {
+                emitted[t] = 1;
+                order.push_back(t);
+                ++clusterTriangles;
+                normalSum += normals[t];
+                lastCentre = centres[t];
+                for (std::uint32_t corner = 0; corner < 3; ++corner)
+                {
+                    std::uint32_t v = indices[t * 3 + corner];
+                    if (clusterVertex[v] != cluster)
+                    {
+                        clusterVertex[v] = cluster;
+                        ++numVertices;
+                    }
+                    for (std::uint32_t i = firstPositionTriangle[position[v]]; i < firstPositionTriangle[position[v] + 1]; ++i)
+                    {
+                        std::uint32_t neighbour = positionTriangles[i];
+                        if (!emitted[neighbour] && candidateOf[neighbour] != cluster)
+                        {
+                            candidateOf[neighbour] = cluster;
+                            candidates.push_back(neighbour);
+                        }
+                    }
+                }
+            };
+
+            // Remaining triangle nearest the last one added
+            auto nearestRemaining = [&]()
+            {
+                while (emitted[firstUnemitted])  ++firstUnemitted;
+                std::uint32_t nearest = firstUnemitted;
+                float nearestDistance = Length(centres[nearest] - lastCentre);
+                for (std::uint32_t t = firstUnemitted + 1; t < numTriangles && nearestDistance > 0.0f; ++t)
+                {
+                    if (emitted[t])  continue;
+                    float distance = Length(centres[t] - lastCentre);
+                    if (distance < nearestDistance)
+                    {
+                        nearest = t;
+                        nearestDistance = distance;
+                    }
+                }
+                return nearest;
+            };
+
+            // Seed next to the end of the last cluster
+            addTriangle(nearestRemaining());
+
+            while (clusterTriangles < maxTriangles)
+            {
+                float sumLength = Length(normalSum);
+                CVector3 axis = sumLength > 0.0f ? normalSum * (1.0f / sumLength) : CVector3{ 0, 0, 0 };
+                std::uint32_t best = kNone;     // Best neighbour keeping the cone narrow enough
+                std::uint32_t bestWide = kNone; // Best neighbour of any direction
+                float bestScore = 0.0f;
+                float bestWideScore = 0.0f;
+                for (auto t : candidates)
+                {
+                    if (emitted[t])  continue;
+                    std::uint32_t newVertices = 0;
+                    for (std::uint32_t corner = 0; corner < 3; ++corner)
+                    {
+                        if (clusterVertex[indices[t * 3 + corner]] != cluster)  ++newVertices;
+                    }
+                    if (numVertices + newVertices > maxVertices)  continue;
+
+                    float normalDot = Dot(normals[t], axis);
+                    float score = newVertices + (1.0f - normalDot) * kConeWeight;
+                    if (bestWide == kNone || score < bestWideScore)
+                    {
+                        bestWide = t;
+                        bestWideScore = score;
+                    }
+                    if ((sumLength == 0.0f || normalDot >= kMinConeDot) && (best == kNone || score < bestScore))
+                    {
+                        best = t;
+                        bestScore = score;
+                    }
+                }
+                if (best == kNone && clusterTriangles < kMinClusterTriangles)
+                {
+                    best = bestWide;
+
+                    // Also carry on to the nearest separate part of the mesh if this one is finished
+                    if (best == kNone && order.size() < numTriangles && numVertices + 3 <= maxVertices)  best = nearestRemaining();
+                }
+                if (best == kNone)  break;
+                addTriangle(best);
+            }
+        }
+        clusterStarts.push_back(numTriangles);
+        const std::size_t numClusters = clusterStarts.size() - 1;
+
+        // Draw clusters facing outwards from the centre of the mesh first, as the overdraw optimisation does with its
+        // clusters (see OptimiseOverdraw), so nearer surfaces tend to hide the ones behind
+        CVector3 meshCentre = { 0, 0, 0 };
+        for (auto& centre : centres)  meshCentre += centre;
+        meshCentre = meshCentre * (1.0f / numTriangles);
+        std::vector<float> sortKeys(numClusters, 0.0f);
+        for (std::size_t c = 0; c < numClusters; ++c)
+        {
+            CVector3 centre = { 0, 0, 0 };
+            CVector3 normal = { 0, 0, 0 };
+            for (std::uint32_t i = clusterStarts[c]; i < clusterStarts[c + 1]; ++i)
+            {
+                centre += centres[order[i]];
+                normal += normals[order[i]];
+            }
+            centre = centre * (1.0f / (clusterStarts[c + 1] - clusterStarts[c]));
+            if (Length(normal) > 0.0f)  sortKeys[c] = Dot(centre - meshCentre, Normalise(normal));
+        }
+        std::vector<std::uint32_t> clusterOrder(numClusters);
+        for (std::uint32_t c = 0; c < numClusters; ++c)  clusterOrder[c] = c;
+        std::stable_sort(clusterOrder.begin(), clusterOrder.end(), [&](std::uint32_t a, std::uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+
+        // Put the triangles in cluster order
+        std::vector<std::uint32_t> original(indices, indices + numTriangles * 3);
+        std::uint32_t* destination = indices;
+        for (auto c : clusterOrder)
+        {
+            MeshCluster cluster = {};
+            cluster.subMesh = s;
+            cluster.firstIndex = subMesh.firstIndex + static_cast<std::uint32_t>(destination - indices);
+            cluster.numIndices = (clusterStarts[c + 1] - clusterStarts[c]) * 3;
+            for (std::uint32_t i = clusterStarts[c]; i < clusterStarts[c + 1]; ++i)
+            {
+                for (std::uint32_t corner = 0; corner < 3; ++corner)  *destination++ = original[order[i] * 3 + corner];
+            }
+            SetClusterBounds(cluster, data.indices.data() + cluster.firstIndex, positions.data());
+            data.clusters.push_back(cluster);
+        }
+    }
+    return static_cast<std::uint32_t>(data.clusters.size());
+}
+
+
+// Return true if every triangle of a cluster faces away from a viewer at the given point
+bool IsClusterBackFacing(const MeshCluster& cluster, const CVector3& viewPoint)
+{
+    if (cluster.coneCutoff > 1.0f)  return false;
+    CVector3 toApex = cluster.coneApex - viewPoint;
+    return Dot(toApex, cluster.coneAxis) >= cluster.coneCutoff * Length(toApex);
+}
+
+
+// Test clusters against a frustum and viewer given in mesh space
+std::size_t CullClusters(const MeshCluster* clusters, std::size_t count, const CFrustum& frustum,
+                         const CVector3& viewPoint, bool cullBackFaces, std::uint8_t* visible)
+{
+    std::size_t numVisible = 0;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        bool isVisible = IsVisible(frustum, clusters[i].bounds) &&
+                         !(cullBackFaces && IsClusterBackFacing(clusters[i], viewPoint));
+        visible[i] = isVisible ? 1 : 0;
+        numVisible += visible[i];
+    }
+    return numVisible;
+}
@@ -0,0 +1,44 @@
+//--------------------------------------------------------------------------------------
+// Mesh clusters (meshlets) for culling parts of a mesh
+//--------------------------------------------------------------------------------------
+// Code in .cpp file
+// Divides each full detail sub-mesh into small clusters of neighbouring triangles, each with a bounding sphere and a
+// normal cone, so clusters outside the view or facing away from the viewer can be skipped on the CPU. A large mesh is
+// then drawn in part rather than all or nothing. The triangles are reordered so each cluster is a range of its
+// sub-mesh's indices, so clusters need no indices of their own, and visible clusters next to each other can be drawn
+// together in one call
+//
+// The normal cone holds the normals of all the cluster's triangles. Its apex is placed so that a viewer inside the
+// cone (opening away from the cluster) is behind the plane of every triangle, so the whole cluster faces away
+
+#ifndef _MESH_CLUSTERS_H_DEFINED_
+#define _MESH_CLUSTERS_H_DEFINED_
+
+#include "MeshData.h"
+
+#include <cstddef>
+#include <cstdint>
+
+
+const std::uint32_t kMaxClusterVertices  = 64;  // Limits suiting GPU mesh shaders, which keeps the clusters small
+const std::uint32_t kMaxClusterTriangles = 124; // enough to cull usefully
+
+// Build the clusters of mesh data with float vertices and 32-bit indices. Clusters are grown over neighbouring
+// triangles, preferring those that share vertices and face the same way, and end early rather than take a triangle
+// that would make the normal cone too wide to be culled. Must come before optimisation (MeshOptimise.h), which then
+// keeps each cluster's triangles together. Levels of detail are not clustered. Returns the number of clusters
+std::uint32_t BuildClusters(MeshData& data, std::uint32_t maxVertices = kMaxClusterVertices,
+                            std::uint32_t maxTriangles = kMaxClusterTriangles);
+
+// Return true if every triangle of a cluster faces away from a viewer at the given point, in mesh space. Front faces
+// are clockwise as seen by the viewer (the Direct3D default)
+bool IsClusterBackFacing(const MeshCluster& cluster, const CVector3& viewPoint);
+
+// Test clusters against a frustum and viewer given in mesh space (see FrustumFromMatrix for a frustum in a model's
+// space). Sets visible[i] to 1 if cluster i may be seen, 0 if not. Back-facing clusters are only culled if requested,
+// so leave that off when rendering with back face culling disabled or reversed. Returns the number visible
+std::size_t CullClusters(const MeshCluster* clusters, std::size_t count, const CFrustum& frustum,
+                         const CVector3& viewPoint, bool cullBackFaces, std::uint8_t* visible);
+
+
+#endif // _MESH_CLUSTERS_H_DEFINED_
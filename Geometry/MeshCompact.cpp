@@ -0,0 +1,150 @@
+//--------------------------------------------------------------------------------------
+// Compact vertex format
+//--------------------------------------------------------------------------------------
+
+#include "MeshCompact.h"
+#include "Packing.h"      // Converting elements to 16-bit formats
+#include "VectorStream.h" // Gathering elements out of the float vertices
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+
+namespace
+{
+    // Angle in degrees between an original unit vector and a decoded one, 0 for zero length originals
+    float AngleError(const CVector3& original, const CVector3& decoded)
+    {
+        float length = Length(original);
+        if (length == 0.0f)  return 0.0f;
+        float cosAngle = std::min(std::max(Dot(original, decoded) / length, -1.0f), 1.0f);
+        return ToDegrees(std::acos(cosAngle));
+    }
+}
+
+
+// Convert mesh data with float vertices to the compact layout, returning the sizes and errors
+VertexCompactionReport CompactVertices(MeshData& data)
+{
+    VertexCompactionReport report;
+    const std::size_t numVertices = data.NumVertices();
+    report.numVertices = numVertices;
+    report.bytesBefore = data.vertices.size();
+    report.bytesAfter  = data.vertices.size();
+    if (data.format.compact || numVertices == 0)  return report;
+
+    const VertexFormat& in = data.format;
+    const VertexFormat out = MakeCompactVertexFormat(in.hasTangents != 0, in.hasUVs != 0, data.bounds);
+    const std::uint8_t* source = data.vertices.data();
+
+
+    //-----------------------------------
+    // Pack each element into its own array
+
+    // Positions are scaled to 0->1 over the bounds, then packed with an unused 4th component (there is no 3 component
+    // 16-bit DXGI format). Axes where the mesh is flat have a scale of 0 and store 0
+    std::vector<CVector3> positions(numVertices);
+    StreamCopyVector3(source, in.vertexSize, positions.data(), sizeof(CVector3), numVertices);
+
+    const float invScale[3] = { out.positionScale[0] > 0.0f ? 1.0f / out.positionScale[0] : 0.0f,
+                                out.positionScale[1] > 0.0f ? 1.0f / out.positionScale[1] : 0.0f,
+                                out.positionScale[2] > 0.0f ? 1.0f / out.positionScale[2] : 0.0f };
+    std::vector<float> unitPositions(numVertices * 4);
+    for (std::size_t v = 0; v < numVertices; ++v)
+    {
+        unitPositions[v * 4 + 0] = (positions[v].x - out.positionOffset[0]) * invScale[0];
+        unitPositions[v * 4 + 1] = (positions[v].y - out.positionOffset[1]) * invScale[1];
+        unitPositions[v * 4 + 2] = (positions[v].z - out.positionOffset[2]) * invScale[2];
+        unitPositions[v * 4 + 3] = 0.0f;
+    }
+    std::vector<std::uint16_t> packedPositions(numVertices * 4);
+    PackUnorm16(unitPositions.data(), packedPositions.data(), unitPositions.size());
+
+    std::vector<std::int16_t> packedNormals(numVertices * 2);
+    PackOctahedral(source + in.normalOffset, in.vertexSize, packedNormals.data(), numVertices);
+
+    std::vector<std::int16_t> packedTangents;
+    if (in.hasTangents)
+    {
+        packedTangents.resize(numVertices * 2);
+        PackOctahedral(source + in.tangentOffset, in.vertexSize, packedTangents.data(), numVertices);
+    }
+
+    std::vector<float> uvs;
+    std::vector<std::uint16_t> packedUVs;
+    if (in.hasUVs)
+    {
+        uvs.resize(numVertices * 2);
+        StreamCopyVector2(source + in.uvOffset, in.vertexSize, uvs.data(), sizeof(float) * 2, numVertices);
+        packedUVs.resize(numVertices * 2);
+        PackHalf(uvs.data(), packedUVs.data(), uvs.size());
+    }
+
+
+    //-----------------------------------
+    // Measure the error by decoding again, the same way the GPU will
+
+    std::vector<float> decodedPositions(numVertices * 4);
+    UnpackUnorm16(packedPositions.data(), decodedPositions.data(), decodedPositions.size());
+    double sumSquaredError = 0.0;
+    for (std::size_t v = 0; v < numVertices; ++v)
+    {
+        CVector3 decoded = { out.positionOffset[0] + decodedPositions[v * 4 + 0] * out.positionScale[0],
+                             out.positionOffset[1] + decodedPositions[v * 4 + 1] * out.positionScale[1],
+                             out.positionOffset[2] + decodedPositions[v * 4 + 2] * out.positionScale[2] };
+        float error = Length(decoded - positions[v]);
+        report.maxPositionError = std::max(report.maxPositionError, error);
+        sumSquaredError += static_cast<double>(error) * error;
+    }
+    report.rmsPositionError = static_cast<float>(std::sqrt(sumSquaredError / numVertices));
+
+    std::vector<CVector3> originals(numVertices);
+    std::vector<CVector3> decoded(numVertices);
+    StreamCopyVector3(source + in.normalOffset, in.vertexSize, originals.data(), sizeof(CVector3), numVertices);
+    UnpackOctahedral(packedNormals.data(), decoded.data(), sizeof(CVector3), numVertices);
+    for (std::size_t v = 0; v < numVertices; ++v)
+    {
+        report.maxNormalError = std::max(report.maxNormalError, AngleError(originals[v], decoded[v]));
+    }
+
+    if (in.hasTangents)
+    {
+        StreamCopyVector3(source + in.tangentOffset, in.vertexSize, originals.data(), sizeof(CVector3), numVertices);
+        UnpackOctahedral(packedTangents.data(), decoded.data(), sizeof(CVector3), numVertices);
+        for (std::size_t v = 0; v < numVertices; ++v)
+        {
+            report.maxTangentError = std::max(report.maxTangentError, AngleError(originals[v], decoded[v]));
+        }
+    }
+
+    if (in.hasUVs)
+    {
+        std::vector<float> decodedUVs(uvs.size());
+        UnpackHalf(packedUVs.data(), decodedUVs.data(), decodedUVs.size());
+        for (std::size_t i = 0; i < uvs.size(); ++i)
+        {
+            report.maxUVError = std::max(report.maxUVError, std::abs(decodedUVs[i] - uvs[i]));
+        }
+    }
+
+
+    //-----------------------------------
+    // Interleave the packed elements into the compact vertices
+
+    std::vector<std::uint8_t> vertices(numVertices * out.vertexSize);
+    for (std::size_t v = 0; v < numVertices; ++v)
+    {
+        std::uint8_t* vertex = vertices.data() + v * out.vertexSize;
+        std::memcpy(vertex, &packedPositions[v * 4], 8);
+        std::memcpy(vertex + out.normalOffset, &packedNormals[v * 2], 4);
+        if (out.hasTangents)  std::memcpy(vertex + out.tangentOffset, &packedTangents[v * 2], 4);
+        if (out.hasUVs)       std::memcpy(vertex + out.uvOffset, &packedUVs[v * 2], 4);
+    }
+
+    data.vertices.swap(vertices);
+    data.format = out;
+    report.bytesAfter = data.vertices.size();
+    return report;
+}
@@ -0,0 +1,39 @@
+//--------------------------------------------------------------------------------------
+// Compact vertex format
+//--------------------------------------------------------------------------------------
+// Code in .cpp file
+// Converts mesh data from float vertices to the compact layout described with VertexFormat (MeshData.h), which halves
+// the vertex memory and the bandwidth used to fetch vertices. Positions are quantised to 16 bits over the mesh bounds,
+// normals and tangents are octahedral encoded (Packing.h) and UVs become half floats. The GPU unpacks each element
+// in the input assembler, the vertex shaders then decode the positions and normals (DecodePosition / DecodeNormal in
+// Common.hlsli) using values the mesh sets in the per-model constants
+
+#ifndef _MESH_COMPACT_H_DEFINED_
+#define _MESH_COMPACT_H_DEFINED_
+
+#include "MeshData.h"
+
+#include <cstddef>
+
+
+// Sizes and precision lost when compacting a mesh's vertices
+struct VertexCompactionReport
+{
+    std::size_t numVertices = 0;
+    std::size_t bytesBefore = 0;        // Size of the vertex array
+    std::size_t bytesAfter  = 0;
+
+    float maxPositionError  = 0.0f;     // Largest distance from a position to its decoded compact position, in mesh units
+    float rmsPositionError  = 0.0f;     // Root mean square of the same distances
+    float maxNormalError    = 0.0f;     // Largest angle between a normal and its decoded normal, in degrees
+    float maxTangentError   = 0.0f;     // --"-- for tangents
+    float maxUVError        = 0.0f;     // Largest difference in a UV component
+};
+
+
+// Convert mesh data with float vertices to the compact layout, returning the sizes and errors. Mesh data that is
+// already compact is left unchanged. Must be the last stage to work on the vertices
+VertexCompactionReport CompactVertices(MeshData& data);
+
+
+#endif // _MESH_COMPACT_H_DEFINED_
@@ -0,0 +1,105 @@
+//--------------------------------------------------------------------------------------
+// CPU-side mesh data
+//--------------------------------------------------------------------------------------
+
+#include "MeshData.h"
+
+#include <cstring>
+
+
+// Return a vertex format with the given optional elements, with offsets and size calculated
+VertexFormat MakeVertexFormat(bool hasTangents, bool hasUVs)
+{
+    VertexFormat format = {};
+    std::uint32_t offset = 12; // Position
+
+    format.normalOffset = offset;
+    offset += 12;
+
+    format.hasTangents = hasTangents ? 1 : 0;
+    format.tangentOffset = offset;
+    if (hasTangents)  offset += 12;
+
+    format.hasUVs = hasUVs ? 1 : 0;
+    format.uvOffset = offset;
+    if (hasUVs)  offset += 8;
+
+    format.vertexSize = offset;
+    format.compact = 0;
+    for (int i = 0; i < 3; ++i)
+    {
+        format.positionOffset[i] = 0.0f;
+        format.positionScale[i] = 1.0f;
+    }
+    return format;
+}
+
+
+// Return a compact vertex format with the given optional elements, with positions quantised over the given bounds
+VertexFormat MakeCompactVertexFormat(bool hasTangents, bool hasUVs, const CAABB& positionBounds)
+{
+    VertexFormat format = {};
+    std::uint32_t offset = 8; // Position
+
+    format.normalOffset = offset;
+    offset += 4;
+
+    format.hasTangents = hasTangents ? 1 : 0;
+    format.tangentOffset = offset;
+    if (hasTangents)  offset += 4;
+
+    format.hasUVs = hasUVs ? 1 : 0;
+    format.uvOffset = offset;
+    if (hasUVs)  offset += 4;
+
+    format.vertexSize = offset;
+    format.compact = 1;
+    CVector3 size = positionBounds.max - positionBounds.min;
+    format.positionOffset[0] = positionBounds.min.x;
+    format.positionOffset[1] = positionBounds.min.y;
+    format.positionOffset[2] = positionBounds.min.z;
+    format.positionScale[0] = size.x;
+    format.positionScale[1] = size.y;
+    format.positionScale[2] = size.z;
+    return format;
+}
+
+
+// Copy the position out of each vertex into a tightly packed array
+std::vector<std::uint8_t> ExtractPositions(const std::uint8_t* vertices, std::size_t numVertices, const VertexFormat& format)
+{
+    const std::uint32_t positionSize = PositionSize(format);
+    std::vector<std::uint8_t> positions(numVertices * positionSize);
+    for (std::size_t v = 0; v < numVertices; ++v)
+    {
+        std::memcpy(positions.data() + v * positionSize, vertices + v * format.vertexSize, positionSize);
+    }
+    return positions;
+}
+
+
+// Return a MeshSource viewing the arrays of the given mesh data (which it keeps alive)
+MeshSource MakeMeshSource(std::shared_ptr<const MeshData> data)
+{
+    MeshSource source;
+    source.format        = data->format;
+    source.bounds        = data->bounds;
+    source.vertices      = data->vertices;
+    source.indices       = data->indices;
+    source.subMeshes     = data->subMeshes;
+    source.nodes         = data->nodes;
+    source.nodeSubMeshes = data->nodeSubMeshes;
+    source.shortIndices  = data->shortIndices;
+    source.lods          = data->lods;
+    source.lodSubMeshes  = data->lodSubMeshes;
+    source.clusters      = data->clusters;
+    source.bvhNodes      = data->bvhNodes;
+    source.bvhTriangles  = data->bvhTriangles;
+    source.bvhPositions  = data->bvhPositions;
+    source.depthVertices     = data->depthVertices;
+    source.depthSubMeshes    = data->depthSubMeshes;
+    source.depthIndices      = data->depthIndices;
+    source.depthShortIndices = data->depthShortIndices;
+    source.storage       = std::move(data);
+    return source;
+}
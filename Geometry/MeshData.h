@@ -0,0 +1,205 @@
+//--------------------------------------------------------------------------------------
+// CPU-side mesh data
+//--------------------------------------------------------------------------------------
+// Code in .cpp file
+// The mesh pipeline imports a file into a MeshData, which holds all the geometry of the mesh in arrays that the later
+// stages (and the mesh cache) can work on without any DirectX involvement. The Mesh and MeshAnimation classes then
+// create GPU buffers from a MeshSource, a read-only view of the same arrays that may point into a MeshData or straight
+// into a memory-mapped cache file (see MeshCache.h)
+//
+// All sub-meshes share one vertex array and one index array. Each sub-mesh owns a range of each, and its indices are
+// relative to the first vertex of its range (so they can be drawn with a base vertex). The indices are 32-bit while the
+// stages work on them, and are usually packed to 16 bits at the end of the pipeline (see MeshIndices.h)
+
+#ifndef _MESH_DATA_H_DEFINED_
+#define _MESH_DATA_H_DEFINED_
+
+#include "CMatrix4x4.h"
+#include "BoundingVolumes.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+
+/*-----------------------------------------------------------------------------------------
+    Types
+-----------------------------------------------------------------------------------------*/
+// These types are stored directly in mesh cache files, so only use fixed size members and no pointers. Changing any
+// of them requires the cache version (MeshCache.cpp) to be increased
+
+// Content of each vertex. The position is always first, followed by the normal, then the optional tangent and UV.
+// There are two layouts of the same elements:
+// - Float:   position 3 floats, normal 3 floats, tangent 3 floats, UV 2 floats (32 bytes, 44 with tangents)
+// - Compact: position 4 Unorm16 (4th unused), normal and tangent octahedral 2 Snorm16 each, UV 2 half floats
+//            (16 bytes, 20 with tangents). Positions are decoded as positionOffset + position * positionScale
+struct VertexFormat
+{
+    std::uint32_t vertexSize;        // Size in bytes of a single vertex
+    std::uint32_t normalOffset;      // Offset in bytes of each element within a vertex
+    std::uint32_t tangentOffset;
+    std::uint32_t uvOffset;
+    std::uint32_t hasTangents;       // 1 if the vertices contain the element, 0 if not
+    std::uint32_t hasUVs;
+    std::uint32_t compact;           // 1 for the compact layout, 0 for floats
+    float         positionOffset[3]; // Decoding of compact positions, 0 and 1 for float positions
+    float         positionScale[3];
+};
+
+// Range of the vertex and index arrays used by one sub-mesh (a part of the mesh using a single material)
+struct SubMesh
+{
+    std::uint32_t firstVertex;
+    std::uint32_t numVertices;
+    std::uint32_t firstIndex;
+    std::uint32_t numIndices;
+};
+
+// Node in the mesh hierarchy (a separately animatable part). Its sub-meshes are a range of MeshData::nodeSubMeshes
+struct MeshNode
+{
+    CMatrix4x4    defaultMatrix;  // Starting position/rotation/scale for this node, relative to its parent
+    std::uint32_t parentIndex;    // Root node (always node 0) refers to itself
+    std::uint32_t firstSubMesh;
+    std::uint32_t numSubMeshes;
+};
+
+// Simplified version of the whole mesh (a level of detail). It has a sub-mesh for each of MeshData::subMeshes, in the same
+// order and using the same vertex ranges, but with its own fewer indices. These are a range of MeshData::lodSubMeshes
+struct MeshLod
+{
+    std::uint32_t firstSubMesh;
+    float         error;        // Furthest the simplified surface may be from the original, in mesh units
+};
+
+// Small part of a full detail sub-mesh (a meshlet) with the bounds to test whether it can be seen, so the parts of a
+// mesh outside the view or facing away can be skipped (see MeshClusters.h). Its triangles are a range of the sub-mesh's
+// indices, using the sub-mesh's vertices
+struct MeshCluster
+{
+    std::uint32_t subMesh;
+    std::uint32_t firstIndex;
+    std::uint32_t numIndices;
+    CSphere       bounds;
+    CVector3      coneApex;     // Normal cone, the cluster faces away from viewers in the cone with this apex and axis
+    CVector3      coneAxis;     // (see IsClusterBackFacing)
+    float         coneCutoff;   // Greater than 1 if the cluster faces too many ways to be back-facing as a whole
+};
+
+// Node of a bounding volume hierarchy over the full detail triangles, for ray casts (see MeshBVH.h). The two children
+// of an inner node are next to each other in the node array. Node 0 is the root
+struct BVHNode
+{
+    CAABB         bounds;
+    std::uint32_t first;        // Inner nodes: the first child, leaves: the first triangle in MeshData::bvhTriangles
+    std::uint32_t count;        // Number of triangles in a leaf, 0 for inner nodes
+};
+
+// Triangle held by a BVH leaf, with its corners in MeshData::bvhPositions
+struct BVHTriangle
+{
+    std::uint32_t corners[3];
+    std::uint32_t triangle;     // Number of the triangle in the full detail index list (its first index is triangle * 3)
+};
+
+// Mesh geometry as imported, editable by the stages of the mesh pipeline. Stages work on float vertices and 32-bit
+// indices, so index packing (MeshIndices.h) and vertex compaction (MeshCompact.h) must be the last stages
+struct MeshData
+{
+    VertexFormat               format;
+    CAABB                      bounds;        // Of all vertex positions, in the mesh's own space
+    std::vector<std::uint8_t>  vertices;      // Interleaved vertices, format.vertexSize bytes each
+    std::vector<std::uint32_t> indices;       // Triangle list
+    std::vector<SubMesh>       subMeshes;
+    std::vector<MeshNode>      nodes;         // Hierarchy in depth-first order, parents before children
+    std::vector<std::uint32_t> nodeSubMeshes; // Sub-mesh indices used by each node, in node order
+    std::vector<std::uint16_t> shortIndices;  // Triangle list packed to 16 bits, used instead of indices if not empty
+    std::vector<MeshLod>       lods;          // Levels of detail after the full mesh, least simplified first
+    std::vector<SubMesh>       lodSubMeshes;  // Sub-meshes of all the levels of detail
+    std::vector<MeshCluster>   clusters;      // Clusters of the full detail sub-meshes, in sub-mesh order
+    std::vector<BVHNode>       bvhNodes;      // Ray cast hierarchy and the geometry it uses, a copy of the triangles
+    std::vector<BVHTriangle>   bvhTriangles;  // with only the positions, each position stored once
+    std::vector<CVector3>      bvhPositions;
+    std::vector<std::uint8_t>  depthVertices;     // Welded positions for depth-only passes (see MeshDepth.h), each
+    std::vector<SubMesh>       depthSubMeshes;    // PositionSize(format) bytes. Sub-meshes matching subMeshes but with
+    std::vector<std::uint32_t> depthIndices;      // ranges of depthVertices, and indices matching indices or
+    std::vector<std::uint16_t> depthShortIndices; // shortIndices (whichever is used)
+
+    std::size_t NumVertices() const  { return vertices.size() / format.vertexSize; }
+    std::size_t NumIndices() const   { return shortIndices.empty() ? indices.size() : shortIndices.size(); }
+};
+
+
+/*-----------------------------------------------------------------------------------------
+    Read-only views
+-----------------------------------------------------------------------------------------*/
+
+// Read-only view of an array held elsewhere
+template <class T>
+struct ArrayView
+{
+    const T*    data = nullptr;
+    std::size_t size = 0;
+
+    ArrayView() {}
+    ArrayView(const T* dataIn, std::size_t sizeIn) : data(dataIn), size(sizeIn) {}
+    ArrayView(const std::vector<T>& v) : data(v.data()), size(v.size()) {}
+
+    const T* begin() const  { return data; }
+    const T* end() const    { return data + size; }
+    bool empty() const      { return size == 0; }
+    const T& operator[](std::size_t i) const  { return data[i]; }
+};
+
+// Mesh data ready for creating GPU buffers. The arrays point either into a MeshData or into a memory-mapped cache
+// file, and storage keeps whichever it is alive for as long as the MeshSource (or a copy of it) exists
+struct MeshSource
+{
+    VertexFormat                format;
+    CAABB                       bounds;
+    ArrayView<std::uint8_t>     vertices;
+    ArrayView<std::uint32_t>    indices;
+    ArrayView<SubMesh>          subMeshes;
+    ArrayView<MeshNode>         nodes;
+    ArrayView<std::uint32_t>    nodeSubMeshes;
+    ArrayView<std::uint16_t>    shortIndices;  // Used instead of indices if not empty
+    ArrayView<MeshLod>          lods;
+    ArrayView<SubMesh>          lodSubMeshes;
+    ArrayView<MeshCluster>      clusters;
+    ArrayView<BVHNode>          bvhNodes;
+    ArrayView<BVHTriangle>      bvhTriangles;
+    ArrayView<CVector3>         bvhPositions;
+    ArrayView<std::uint8_t>     depthVertices;
+    ArrayView<SubMesh>          depthSubMeshes;
+    ArrayView<std::uint32_t>    depthIndices;
+    ArrayView<std::uint16_t>    depthShortIndices;
+
+    std::size_t NumIndices() const  { return shortIndices.empty() ? indices.size : shortIndices.size; }
+
+    std::shared_ptr<const void> storage;
+};
+
+
+/*-----------------------------------------------------------------------------------------
+    Functions
+-----------------------------------------------------------------------------------------*/
+
+// Return a vertex format with the given optional elements, with offsets and size calculated
+VertexFormat MakeVertexFormat(bool hasTangents, bool hasUVs);
+
+// Return a compact vertex format with the given optional elements, with positions quantised over the given bounds
+VertexFormat MakeCompactVertexFormat(bool hasTangents, bool hasUVs, const CAABB& positionBounds);
+
+// Size in bytes of the position at the start of each vertex of the given format
+inline std::uint32_t PositionSize(const VertexFormat& format)  { return format.normalOffset; }
+
+// Copy the position out of each vertex into a tightly packed array, PositionSize bytes each in the vertices' own
+// encoding. Used for a separate position stream for passes that need nothing else (e.g. depth-only rendering)
+std::vector<std::uint8_t> ExtractPositions(const std::uint8_t* vertices, std::size_t numVertices, const VertexFormat& format);
+
+// Return a MeshSource viewing the arrays of the given mesh data (which it keeps alive)
+MeshSource MakeMeshSource(std::shared_ptr<const MeshData> data);
+
+
+#endif // _MESH_DATA_H_DEFINED_
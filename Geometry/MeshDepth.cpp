@@ -0,0 +1,143 @@
+//--------------------------------------------------------------------------------------
+// Welded positions and indices for depth-only rendering
+//--------------------------------------------------------------------------------------
+
+#include "MeshDepth.h"
+#include "MeshOptimise.h" // Vertex cache and vertex fetch steps
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <vector>
+
+
+namespace
+{
+    // Reorder the triangles of a range of a triangle list for the vertex cache, keeping the order it has if that was
+    // already better. Returns the vertices transformed drawing the range
+    std::size_t OptimiseRange(std::uint32_t* indices, std::size_t numIndices, std::size_t numVertices)
+    {
+        std::size_t before = AnalyseVertexCache(indices, numIndices, numVertices).verticesTransformed;
+        std::vector<std::uint32_t> optimised(indices, indices + numIndices);
+        OptimiseVertexCache(optimised.data(), numIndices, numVertices);
+        std::size_t after = AnalyseVertexCache(optimised.data(), numIndices, numVertices).verticesTransformed;
+        if (after >= before)  return before;
+        std::copy(optimised.begin(), optimised.end(), indices);
+        return after;
+    }
+}
+
+
+// Build the depth version of mesh data
+DepthMeshReport BuildDepthMesh(MeshData& data)
+{
+    DepthMeshReport report;
+    data.depthVertices.clear();
+    data.depthSubMeshes.clear();
+    data.depthIndices.clear();
+    data.depthShortIndices.clear();
+
+    // Work on 32-bit indices whether or not the mesh's have been packed
+    const bool shortIndices = !data.shortIndices.empty();
+    std::vector<std::uint32_t> indices = data.indices;
+    if (shortIndices)  indices.assign(data.shortIndices.begin(), data.shortIndices.end());
+    const std::vector<std::uint32_t> originalIndices = indices;
+
+    const std::uint32_t vertexSize = data.format.vertexSize;
+    const std::uint32_t positionSize = PositionSize(data.format);
+    const std::uint8_t* vertices = data.vertices.data();
+
+    data.depthSubMeshes = data.subMeshes;
+    for (std::uint32_t s = 0; s < data.subMeshes.size(); ++s)
+    {
+        const SubMesh& subMesh = data.subMeshes[s];
+        SubMesh& depthSubMesh = data.depthSubMeshes[s];
+
+        // The full sub-mesh and its levels of detail share the sub-mesh's vertices, so all their index ranges are welded
+        std::vector<SubMesh> ranges(1, subMesh);
+        for (auto& lod : data.lods)  ranges.push_back(data.lodSubMeshes[lod.firstSubMesh + s]);
+
+        //-----------------------------------
+        // Weld
+
+        // Sort the sub-mesh's vertices by their position bytes, equal positions end up together (the vertex number
+        // breaks ties so the result doesn't depend on the sort)
+        const std::uint8_t* subMeshVertices = vertices + static_cast<std::size_t>(subMesh.firstVertex) * vertexSize;
+        auto position = [&](std::uint32_t v) { return subMeshVertices + static_cast<std::size_t>(v) * vertexSize; };
+        std::vector<std::uint32_t> order(subMesh.numVertices);
+        std::iota(order.begin(), order.end(), 0u);
+        std::sort(order.begin(), order.end(), [&](std::uint32_t a, std::uint32_t b)
+        {
+            int compare = std::memcmp(position(a), position(b), positionSize);
+            return compare != 0 ? compare < 0 : a < b;
+        });
+
+        std::vector<std::uint32_t> weld(subMesh.numVertices);
+        std::vector<std::uint8_t> positions;
+        std::uint32_t numWelded = 0;
+        for (std::size_t i = 0; i < order.size(); ++i)
+        {
+            if (i == 0 || std::memcmp(position(order[i]), position(order[i - 1]), positionSize) != 0)
+            {
+                positions.insert(positions.end(), position(order[i]), position(order[i]) + positionSize);
+                ++numWelded;
+            }
+            weld[order[i]] = numWelded - 1;
+        }
+        for (auto& range : ranges)
+        {
+            for (std::uint32_t i = range.firstIndex; i < range.firstIndex + range.numIndices; ++i)
+            {
+                indices[i] = weld[indices[i]];
+            }
+        }
+
+        //-----------------------------------
+        // Vertex cache
+
+        // Clustered sub-meshes are reordered a cluster at a time so each cluster keeps its triangles
+        std::uint32_t* subMeshIndices = indices.data() + subMesh.firstIndex;
+        report.verticesTransformed += AnalyseVertexCache(originalIndices.data() + subMesh.firstIndex, subMesh.numIndices,
+                                                         subMesh.numVertices).verticesTransformed;
+        bool clustered = false;
+        for (auto& cluster : data.clusters)
+        {
+            if (cluster.subMesh != s)  continue;
+            OptimiseRange(indices.data() + cluster.firstIndex, cluster.numIndices, numWelded);
+            clustered = true;
+        }
+        if (!clustered)  OptimiseRange(subMeshIndices, subMesh.numIndices, numWelded);
+        for (std::size_t r = 1; r < ranges.size(); ++r)
+        {
+            OptimiseRange(indices.data() + ranges[r].firstIndex, ranges[r].numIndices, numWelded);
+        }
+        report.depthVerticesTransformed +=
+            AnalyseVertexCache(subMeshIndices, subMesh.numIndices, numWelded).verticesTransformed;
+
+        //-----------------------------------
+        // Vertex fetch
+
+        // Number the welded vertices in the order the full detail triangles use them. The levels of detail only use
+        // vertices of the full detail mesh, so are just renumbered
+        std::vector<std::uint32_t> remap = OptimiseVertexFetch(subMeshIndices, subMesh.numIndices, positions.data(),
+                                                               positionSize, numWelded);
+        for (std::size_t r = 1; r < ranges.size(); ++r)
+        {
+            for (std::uint32_t i = ranges[r].firstIndex; i < ranges[r].firstIndex + ranges[r].numIndices; ++i)
+            {
+                indices[i] = remap[indices[i]];
+            }
+        }
+
+        depthSubMesh.firstVertex = static_cast<std::uint32_t>(data.depthVertices.size() / positionSize);
+        depthSubMesh.numVertices = numWelded;
+        data.depthVertices.insert(data.depthVertices.end(), positions.begin(), positions.end());
+        report.numVertices += subMesh.numVertices;
+        report.numDepthVertices += numWelded;
+    }
+
+    // Same index size as the full mesh. Welding never adds vertices to a sub-mesh, so 16-bit indices still fit
+    if (shortIndices)  data.depthShortIndices.assign(indices.begin(), indices.end());
+    else               data.depthIndices.swap(indices);
+    return report;
+}
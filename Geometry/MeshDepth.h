@@ -0,0 +1,40 @@
+//--------------------------------------------------------------------------------------
+// Welded positions and indices for depth-only rendering
+//--------------------------------------------------------------------------------------
+// Code in .cpp file
+// Vertices are copied wherever the normal or UVs change across the surface (seams, hard edges), so passes that only
+// need positions (shadow maps and other depth-only rendering) transform the same position several times. This stage
+// makes a second version of each sub-mesh for those passes: vertices with the same position are welded into one, the
+// triangles are reordered for the vertex cache again (welding changes which vertices they share), and the welded
+// vertices are renumbered in the order the triangles use them
+//
+// The depth version keeps the same index ranges as the full mesh, so levels of detail and clusters work with it
+// unchanged - the triangles of each cluster stay inside the cluster. Only the vertex ranges of the sub-meshes differ
+// (MeshData::depthSubMeshes). The positions are compared exactly as stored, so on compact meshes positions that
+// quantise to the same value are welded too
+
+#ifndef _MESH_DEPTH_H_DEFINED_
+#define _MESH_DEPTH_H_DEFINED_
+
+#include "MeshData.h"
+
+#include <cstddef>
+
+
+// Vertices and vertex shader runs (with the simulated vertex cache, see MeshOptimise.h) for drawing the full detail
+// sub-meshes, with the full vertices and with the depth version
+struct DepthMeshReport
+{
+    std::size_t numVertices         = 0;
+    std::size_t numDepthVertices    = 0;
+    std::size_t verticesTransformed = 0;
+    std::size_t depthVerticesTransformed = 0;
+};
+
+// Build the depth version of mesh data (depthVertices, depthSubMeshes and depthIndices or depthShortIndices, matching
+// the size of the full mesh's indices). Must be the last stage, after index packing and vertex compaction, so it works
+// on the final positions. Returns the counts for the full detail mesh before and after
+DepthMeshReport BuildDepthMesh(MeshData& data);
+
+
+#endif // _MESH_DEPTH_H_DEFINED_
@@ -0,0 +1,346 @@
+//--------------------------------------------------------------------------------------
+// Importing mesh files into MeshData
+//--------------------------------------------------------------------------------------
+
+#include "MeshImport.h"
+#include "MeshTangents.h" // Optional processing stages
+#include "MeshIndices.h"
+#include "MeshSimplify.h"
+#include "MeshClusters.h"
+#include "MeshOptimise.h"
+#include "MeshBVH.h"
+#include "MeshCompact.h"
+#include "MeshDepth.h"
+#include "VectorStream.h" // Copying vertex elements into the vertex array
+
+#include <assimp/Importer.hpp>
+#include <assimp/DefaultLogger.hpp>
+#include <assimp/LogStream.hpp>
+#include <assimp/postprocess.h>
+#include <assimp/scene.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+
+/*-----------------------------------------------------------------------------------------
+    Importer settings
+-----------------------------------------------------------------------------------------*/
+
+namespace
+{
+    // Flags for processing the mesh. Assimp provides a huge amount of control - right click any of these
+    // and "Peek Definition" to see documention above each constant
+    unsigned int AssimpFlags(const MeshImportOptions& options)
+    {
+        unsigned int assimpFlags = aiProcess_MakeLeftHanded |
+            aiProcess_GenSmoothNormals |
+            aiProcess_FixInfacingNormals |
+            aiProcess_GenUVCoords |
+            aiProcess_TransformUVCoords |
+            aiProcess_FlipUVs |
+            aiProcess_FlipWindingOrder |
+            aiProcess_Triangulate |
+            aiProcess_JoinIdenticalVertices |
+            aiProcess_SortByPType |
+            aiProcess_FindInvalidData |
+            aiProcess_OptimizeMeshes |
+            aiProcess_FindInstances |
+            aiProcess_FindDegenerates |
+            aiProcess_RemoveRedundantMaterials |
+            aiProcess_Debone |
+            aiProcess_RemoveComponent;
+
+        if (options.flattenHierarchy)  assimpFlags |= aiProcess_PreTransformVertices;
+        if (options.requireTangents && !options.generateTangents)  assimpFlags |= aiProcess_CalcTangentSpace;
+        if (!options.optimiseMesh)     assimpFlags |= aiProcess_ImproveCacheLocality; // Otherwise done by OptimiseMesh
+        return assimpFlags;
+    }
+
+    // Flags to specify what mesh data to ignore
+    int RemoveComponents(const MeshImportOptions& options)
+    {
+        int removeComponents = aiComponent_LIGHTS | aiComponent_CAMERAS | aiComponent_TEXTURES | aiComponent_COLORS |
+            aiComponent_BONEWEIGHTS | aiComponent_ANIMATIONS | aiComponent_MATERIALS;
+
+        if (!options.requireTangents || options.generateTangents)  removeComponents |= aiComponent_TANGENTS_AND_BITANGENTS;
+        return removeComponents;
+    }
+
+    const float kSmoothingAngle = 80.0f; // Smoothing angle for normals
+
+
+    /*-------------------------------------------------------------------------------------
+        Logging
+    -------------------------------------------------------------------------------------*/
+
+    // Assimp's DefaultLogger is a single global object that is not safe to create, destroy or write to from several
+    // threads at once, so meshes can't each create and kill it around their import. Instead this logger is installed
+    // once and kept, and it serialises all messages. By default messages go to the debugger's output window
+    class ImportLogger : public Assimp::Logger
+    {
+    public:
+        ImportLogger() : Assimp::Logger(VERBOSE)
+        {
+            Assimp::LogStream* debugger = Assimp::LogStream::createDefaultStream(aiDefaultLogStream_DEBUGGER);
+            if (debugger != nullptr)  mStreams.push_back({ debugger, Debugging | Info | Warn | Err });
+        }
+
+        ~ImportLogger()
+        {
+            for (auto& stream : mStreams)  delete stream.stream;
+        }
+
+        bool attachStream(Assimp::LogStream* stream, unsigned int severity) override
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (stream == nullptr)  return false;
+            mStreams.push_back({ stream, severity != 0 ? severity : Debugging | Info | Warn | Err });
+            return true;
+        }
+
+        bool detatchStream(Assimp::LogStream* stream, unsigned int /*severity*/) override
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            auto found = std::find_if(mStreams.begin(), mStreams.end(), [stream](const Stream& s) { return s.stream == stream; });
+            if (found == mStreams.end())  return false;
+            mStreams.erase(found);
+            return true;
+        }
+
+    protected:
+        void OnDebug(const char* message) override  { Write(Debugging, "Debug, ", message); }
+        void OnInfo (const char* message) override  { Write(Info,      "Info,  ", message); }
+        void OnWarn (const char* message) override  { Write(Warn,      "Warn,  ", message); }
+        void OnError(const char* message) override  { Write(Err,       "Error, ", message); }
+
+    private:
+        struct Stream
+        {
+            Assimp::LogStream* stream;
+            unsigned int       severity;
+        };
+
+        void Write(unsigned int severity, const char* prefix, const char* message)
+        {
+            std::string line = std::string(prefix) + message + "\n";
+            std::lock_guard<std::mutex> lock(mMutex);
+            for (auto& stream : mStreams)
+            {
+                if (stream.severity & severity)  stream.stream->write(line.c_str());
+            }
+        }
+
+        std::vector<Stream> mStreams;
+        std::mutex          mMutex;
+    };
+
+    // Install the import logger the first time it is needed
+    void InstallLogger()
+    {
+        static std::once_flag installed;
+        std::call_once(installed, []() { Assimp::DefaultLogger::set(new ImportLogger); });
+    }
+
+
+    /*-------------------------------------------------------------------------------------
+        Node hierarchy
+    -------------------------------------------------------------------------------------*/
+
+    // Count the number of nodes with given assimp node as root - recursive
+    unsigned int CountNodes(const aiNode* assimpNode)
+    {
+        unsigned int count = 1;
+        for (unsigned int child = 0; child < assimpNode->mNumChildren; ++child)
+            count += CountNodes(assimpNode->mChildren[child]);
+        return count;
+    }
+
+    // Add the given node and its children to the mesh data in depth-first order - recursive
+    void ReadNodes(aiNode* assimpNode, std::uint32_t parentIndex, MeshData& data)
+    {
+        std::uint32_t thisIndex = static_cast<std::uint32_t>(data.nodes.size());
+        data.nodes.emplace_back();
+        MeshNode& node = data.nodes.back();
+
+        node.defaultMatrix.SetValues(&assimpNode->mTransformation.a1);
+        node.defaultMatrix.Transpose(); // Assimp stores matrices differently to this app
+        node.parentIndex = parentIndex;
+        node.firstSubMesh = static_cast<std::uint32_t>(data.nodeSubMeshes.size());
+        node.numSubMeshes = assimpNode->mNumMeshes;
+        for (unsigned int i = 0; i < assimpNode->mNumMeshes; ++i)
+        {
+            data.nodeSubMeshes.push_back(assimpNode->mMeshes[i]);
+        }
+
+        for (unsigned int i = 0; i < assimpNode->mNumChildren; ++i)
+        {
+            ReadNodes(assimpNode->mChildren[i], thisIndex, data);
+        }
+    }
+}
+
+
+/*-----------------------------------------------------------------------------------------
+    Import
+-----------------------------------------------------------------------------------------*/
+
+// Import a mesh file. Will throw a std::runtime_error exception on failure
+MeshData ImportMesh(const std::string& fileName, const MeshImportOptions& options)
+{
+    Assimp::Importer importer;
+
+    // Other miscellaneous settings
+    importer.SetPropertyFloat(AI_CONFIG_PP_GSN_MAX_SMOOTHING_ANGLE, kSmoothingAngle);
+    importer.SetPropertyInteger(AI_CONFIG_PP_SBP_REMOVE, aiPrimitiveType_POINT | aiPrimitiveType_LINE);  // Remove points and lines (keep triangles only)
+    importer.SetPropertyBool(AI_CONFIG_PP_FD_REMOVE, true);                 // Remove degenerate triangles
+    importer.SetPropertyBool(AI_CONFIG_PP_DB_ALL_OR_NONE, true);            // Default to removing bones/weights from meshes that don't need skinning
+
+    importer.SetPropertyInteger(AI_CONFIG_PP_RVC_FLAGS, RemoveComponents(options));
+
+    // Import mesh with assimp given above requirements - log output. Safe to call from several threads at once
+    InstallLogger();
+    const aiScene* scene = importer.ReadFile(fileName, AssimpFlags(options));
+    if (scene == nullptr)  throw std::runtime_error("Error loading mesh (" + fileName + "). " + importer.GetErrorString());
+    if (scene->mNumMeshes == 0)  throw std::runtime_error("No usable geometry in mesh: " + fileName);
+
+
+    //-----------------------------------
+
+    // Check for presence of position and normal data. Tangents and UVs are optional. All sub-meshes share a
+    // vertex format, so if any sub-mesh has UVs they all get them (zero where missing)
+    bool hasUVs = false;
+    std::size_t numVertices = 0;
+    std::size_t numIndices = 0;
+    for (unsigned int m = 0; m < scene->mNumMeshes; ++m)
+    {
+        const aiMesh* assimpMesh = scene->mMeshes[m];
+        std::string subMeshName = assimpMesh->mName.C_Str();
+
+        if (!assimpMesh->HasPositions())  throw std::runtime_error("No position data for sub-mesh " + subMeshName + " in " + fileName);
+        if (!assimpMesh->HasNormals())  throw std::runtime_error("No normal data for sub-mesh " + subMeshName + " in " + fileName);
+        if (options.requireTangents && !options.generateTangents && !assimpMesh->HasTangentsAndBitangents())
+        {
+            throw std::runtime_error("No tangent data for sub-mesh " + subMeshName + " in " + fileName);
+        }
+        if (assimpMesh->GetNumUVChannels() > 0 && assimpMesh->HasTextureCoords(0))
+        {
+            if (assimpMesh->mNumUVComponents[0] != 2)  throw std::runtime_error("Unsupported texture coordinates in " + subMeshName + " in " + fileName);
+            hasUVs = true;
+        }
+        if (!assimpMesh->HasFaces())  throw std::runtime_error("No face data in " + subMeshName + " in " + fileName);
+
+        numVertices += assimpMesh->mNumVertices;
+        numIndices += assimpMesh->mNumFaces * 3;
+    }
+
+    MeshData data;
+    data.format = MakeVertexFormat(options.requireTangents, hasUVs);
+    data.vertices.resize(numVertices * data.format.vertexSize);
+    data.indices.resize(numIndices);
+    data.subMeshes.resize(scene->mNumMeshes);
+
+
+    //-----------------------------------
+
+    // Copy each sub-mesh from assimp into its range of the vertex and index arrays
+    std::uint32_t firstVertex = 0;
+    std::uint32_t firstIndex = 0;
+    const std::uint32_t vertexSize = data.format.vertexSize;
+    for (unsigned int m = 0; m < scene->mNumMeshes; ++m)
+    {
+        const aiMesh* assimpMesh = scene->mMeshes[m];
+        SubMesh& subMesh = data.subMeshes[m];
+        subMesh.firstVertex = firstVertex;
+        subMesh.numVertices = assimpMesh->mNumVertices;
+        subMesh.firstIndex  = firstIndex;
+        subMesh.numIndices  = assimpMesh->mNumFaces * 3;
+
+        // Each element is gathered from assimp's separate arrays and scattered into the interleaved vertices
+        std::uint8_t* vertices = data.vertices.data() + firstVertex * vertexSize;
+        StreamCopyVector3(assimpMesh->mVertices, sizeof(aiVector3D), vertices,                            vertexSize, subMesh.numVertices);
+        StreamCopyVector3(assimpMesh->mNormals,  sizeof(aiVector3D), vertices + data.format.normalOffset, vertexSize, subMesh.numVertices);
+        if (data.format.hasTangents && !options.generateTangents)
+        {
+            StreamCopyVector3(assimpMesh->mTangents, sizeof(aiVector3D), vertices + data.format.tangentOffset, vertexSize, subMesh.numVertices);
+        }
+        if (assimpMesh->GetNumUVChannels() > 0 && assimpMesh->HasTextureCoords(0))
+        {
+            // Assimp UVs are 3D, only the first two components are used
+            StreamConvertVector3ToVector2(assimpMesh->mTextureCoords[0], sizeof(aiVector3D), vertices + data.format.uvOffset, vertexSize, subMesh.numVertices);
+        }
+
+        // Copy face data from assimp to the index array
+        std::uint32_t* index = data.indices.data() + firstIndex;
+        for (unsigned int face = 0; face < assimpMesh->mNumFaces; ++face)
+        {
+            *index++ = assimpMesh->mFaces[face].mIndices[0];
+            *index++ = assimpMesh->mFaces[face].mIndices[1];
+            *index++ = assimpMesh->mFaces[face].mIndices[2];
+        }
+
+        firstVertex += subMesh.numVertices;
+        firstIndex  += subMesh.numIndices;
+    }
+
+    data.bounds = AABBFromPoints(data.vertices.data(), vertexSize, numVertices);
+
+
+    //-----------------------------------
+
+    // Read node hierachy - each node has a matrix and contains sub-meshes
+    data.nodes.reserve(CountNodes(scene->mRootNode));
+    ReadNodes(scene->mRootNode, 0, data);
+
+
+    //-----------------------------------
+
+    // Optional processing stages, in this order: tangents may add vertices so come first, sub-meshes are split before
+    // anything refers to their ranges, levels of detail and clusters are made before optimising so the optimiser can
+    // work within them, the ray cast hierarchy refers to the final triangle order, the packing stages work on the
+    // results, and the depth version welds the final positions
+    if (options.requireTangents && options.generateTangents)  GenerateTangents(data);
+    if (options.shortIndices)  SplitSubMeshes(data);
+    if (options.numLods > 0)   GenerateLods(data, options.numLods, options.lodReduction);
+    if (options.buildClusters) BuildClusters(data);
+    if (options.optimiseMesh)
+    {
+        MeshOptimisationReport report = OptimiseMesh(data);
+        char message[256];
+        std::snprintf(message, sizeof(message), "%s optimised: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f, overdraw %.3f -> %.3f, "
+                      "overfetch %.3f -> %.3f", fileName.c_str(), report.before.vertexCache.acmr, report.after.vertexCache.acmr,
+                      report.before.vertexCache.atvr, report.after.vertexCache.atvr, report.before.overdraw.overdraw,
+                      report.after.overdraw.overdraw, report.before.vertexFetch.overfetch, report.after.vertexFetch.overfetch);
+        Assimp::DefaultLogger::get()->info(message);
+    }
+    if (options.retainGeometry)   BuildBVH(data);
+    if (options.shortIndices)     PackShortIndices(data);
+    if (options.compactVertices)  CompactVertices(data); // Must come after the stages that need float vertices
+    if (options.buildDepthMesh)   BuildDepthMesh(data);
+
+    return data;
+}
+
+
+// Return a value that changes whenever the import options, or the importer settings used for them, change
+std::uint64_t MeshImportKey(const MeshImportOptions& options)
+{
+    std::uint64_t key = AssimpFlags(options);
+    key = key * 1000003u + static_cast<std::uint32_t>(RemoveComponents(options));
+    key = key * 1000003u + static_cast<std::uint64_t>(kSmoothingAngle * 1000.0f);
+    key = key * 1000003u + (options.requireTangents ? 1u : 0u);
+    key = key * 1000003u + (options.generateTangents ? 1u : 0u);
+    key = key * 1000003u + (options.flattenHierarchy ? 1u : 0u);
+    key = key * 1000003u + options.numLods;
+    key = key * 1000003u + static_cast<std::uint64_t>(options.lodReduction * 1000.0f);
+    key = key * 1000003u + (options.buildClusters ? 1u : 0u);
+    key = key * 1000003u + (options.optimiseMesh ? 1u : 0u);
+    key = key * 1000003u + (options.retainGeometry ? 1u : 0u);
+    key = key * 1000003u + (options.compactVertices ? 1u : 0u);
+    key = key * 1000003u + (options.shortIndices ? 1u : 0u);
+    key = key * 1000003u + (options.buildDepthMesh ? 1u : 0u);
+    return key;
+}
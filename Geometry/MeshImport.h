@@ -0,0 +1,43 @@
+//--------------------------------------------------------------------------------------
+// Importing mesh files into MeshData
+//--------------------------------------------------------------------------------------
+// Code in .cpp file
+// Uses assimp (http://www.assimp.org/) to support many file types. Normally called through LoadMeshSource
+// (MeshCache.h), which only imports a file when there is no up to date cached copy
+
+#ifndef _MESH_IMPORT_H_DEFINED_
+#define _MESH_IMPORT_H_DEFINED_
+
+#include "MeshData.h"
+
+#include <cstdint>
+#include <string>
+
+
+// Options controlling what is imported. Different options give different mesh data, so they are part of the cache key
+struct MeshImportOptions
+{
+    bool requireTangents  = false; // Calculate tangents (for normal and parallax mapping)
+    bool generateTangents = true;  // Calculate them with GenerateTangents (MikkTSpace compatible and multi-threaded, see
+                                   // MeshTangents.h) rather than assimp
+    bool flattenHierarchy = true;  // Transform all parts into the space of the root node and use a single node (for
+                                   // static meshes). Keep the hierarchy for meshes whose parts are animated
+    std::uint32_t numLods = 0;     // Levels of detail to generate after the full mesh (see MeshSimplify.h)
+    float lodReduction    = 0.5f;  // Fraction of the triangles of the level before that each level of detail aims for
+    bool buildClusters    = true;  // Divide sub-meshes into clusters that can be culled separately (see MeshClusters.h)
+    bool optimiseMesh     = true;  // Reorder triangles and vertices for the GPU's caches and less overdraw (see MeshOptimise.h)
+    bool retainGeometry   = false; // Keep a copy of the triangles with a hierarchy for ray casts (see MeshBVH.h)
+    bool compactVertices  = false; // Store vertices in the compact layout (see MeshCompact.h)
+    bool shortIndices     = true;  // Store 16-bit indices, splitting sub-meshes with too many vertices (see MeshIndices.h)
+    bool buildDepthMesh   = true;  // Weld the positions into a separate version for depth-only passes (see MeshDepth.h)
+};
+
+
+// Import a mesh file. Can be called from several threads at once. Will throw a std::runtime_error exception on failure
+MeshData ImportMesh(const std::string& fileName, const MeshImportOptions& options);
+
+// Return a value that changes whenever the import options, or the importer settings used for them, change
+std::uint64_t MeshImportKey(const MeshImportOptions& options);
+
+
+#endif // _MESH_IMPORT_H_DEFINED_
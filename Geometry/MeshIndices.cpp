@@ -0,0 +1,143 @@
+//--------------------------------------------------------------------------------------
+// 16-bit index buffers
+//--------------------------------------------------------------------------------------
+
+#include "MeshIndices.h"
+
+#include <cstring>
+#include <vector>
+
+
+// Split sub-meshes using more than the given number of vertices into several sub-meshes
+std::uint32_t SplitSubMeshes(MeshData& data, std::uint32_t maxVertices /*= kMaxShortIndexVertices*/)
+{
+    bool needSplit = false;
+    for (auto& subMesh : data.subMeshes)
+    {
+        if (subMesh.numVertices > maxVertices)  needSplit = true;
+    }
+    if (!needSplit || maxVertices < 3)  return 0;
+
+    const std::uint32_t vertexSize = data.format.vertexSize;
+    std::vector<std::uint8_t>  vertices;
+    std::vector<std::uint32_t> indices;
+    std::vector<SubMesh>       subMeshes;
+    std::vector<std::uint32_t> firstPiece(data.subMeshes.size() + 1); // Sub-mesh index of each original's first piece
+    vertices.reserve(data.vertices.size());
+    indices.reserve(data.indices.size());
+
+    for (std::size_t s = 0; s < data.subMeshes.size(); ++s)
+    {
+        const SubMesh& original = data.subMeshes[s];
+        const std::uint8_t* originalVertices = data.vertices.data() + static_cast<std::size_t>(original.firstVertex) * vertexSize;
+        const std::uint32_t* originalIndices = data.indices.data() + original.firstIndex;
+        firstPiece[s] = static_cast<std::uint32_t>(subMeshes.size());
+
+        if (original.numVertices <= maxVertices)
+        {
+            // Small enough, copy as it is
+            SubMesh piece = { static_cast<std::uint32_t>(vertices.size() / vertexSize), original.numVertices,
+                              static_cast<std::uint32_t>(indices.size()), original.numIndices };
+            vertices.insert(vertices.end(), originalVertices, originalVertices + static_cast<std::size_t>(original.numVertices) * vertexSize);
+            indices.insert(indices.end(), originalIndices, originalIndices + original.numIndices);
+            subMeshes.push_back(piece);
+            continue;
+        }
+
+        // Add triangles to the current piece until the next one would take it over the vertex limit. Each piece maps
+        // the original vertices it uses to its own new ones
+        const std::uint32_t kUnused = ~0u;
+        std::vector<std::uint32_t> pieceVertex(original.numVertices, kUnused);
+        std::vector<std::uint32_t> pieceVertices; // Original vertices used by the current piece, in new vertex order
+        SubMesh piece = {};
+
+        auto finishPiece = [&]()
+        {
+            piece.firstVertex = static_cast<std::uint32_t>(vertices.size() / vertexSize);
+            piece.numVertices = static_cast<std::uint32_t>(pieceVertices.size());
+            vertices.resize(vertices.size() + pieceVertices.size() * vertexSize);
+            std::uint8_t* destination = vertices.data() + static_cast<std::size_t>(piece.firstVertex) * vertexSize;
+            for (auto v : pieceVertices)
+            {
+                std::memcpy(destination, originalVertices + static_cast<std::size_t>(v) * vertexSize, vertexSize);
+                destination += vertexSize;
+                pieceVertex[v] = kUnused;
+            }
+            subMeshes.push_back(piece);
+            pieceVertices.clear();
+        };
+
+        piece.firstIndex = static_cast<std::uint32_t>(indices.size());
+        for (std::uint32_t i = 0; i + 2 < original.numIndices; i += 3)
+        {
+            std::uint32_t newVertices = 0;
+            for (std::uint32_t corner = 0; corner < 3; ++corner)
+            {
+                if (pieceVertex[originalIndices[i + corner]] == kUnused)  ++newVertices;
+            }
+            if (pieceVertices.size() + newVertices > maxVertices)
+            {
+                piece.numIndices = static_cast<std::uint32_t>(indices.size()) - piece.firstIndex;
+                finishPiece();
+                piece.firstIndex = static_cast<std::uint32_t>(indices.size());
+            }
+
+            for (std::uint32_t corner = 0; corner < 3; ++corner)
+            {
+                std::uint32_t v = originalIndices[i + corner];
+                if (pieceVertex[v] == kUnused)
+                {
+                    pieceVertex[v] = static_cast<std::uint32_t>(pieceVertices.size());
+                    pieceVertices.push_back(v);
+                }
+                indices.push_back(pieceVertex[v]);
+            }
+        }
+        piece.numIndices = static_cast<std::uint32_t>(indices.size()) - piece.firstIndex;
+        finishPiece();
+    }
+    firstPiece[data.subMeshes.size()] = static_cast<std::uint32_t>(subMeshes.size());
+
+    // Nodes now use every piece of each of their original sub-meshes
+    std::vector<std::uint32_t> nodeSubMeshes;
+    for (auto& node : data.nodes)
+    {
+        std::uint32_t firstSubMesh = static_cast<std::uint32_t>(nodeSubMeshes.size());
+        for (std::uint32_t i = 0; i < node.numSubMeshes; ++i)
+        {
+            std::uint32_t original = data.nodeSubMeshes[node.firstSubMesh + i];
+            for (std::uint32_t p = firstPiece[original]; p < firstPiece[original + 1]; ++p)
+            {
+                nodeSubMeshes.push_back(p);
+            }
+        }
+        node.firstSubMesh = firstSubMesh;
+        node.numSubMeshes = static_cast<std::uint32_t>(nodeSubMeshes.size()) - firstSubMesh;
+    }
+
+    std::uint32_t added = static_cast<std::uint32_t>(subMeshes.size() - data.subMeshes.size());
+    data.vertices.swap(vertices);
+    data.indices.swap(indices);
+    data.subMeshes.swap(subMeshes);
+    data.nodeSubMeshes.swap(nodeSubMeshes);
+    return added;
+}
+
+
+// Move the indices into shortIndices if every sub-mesh can use 16-bit indices
+bool PackShortIndices(MeshData& data)
+{
+    for (auto& subMesh : data.subMeshes)
+    {
+        if (subMesh.numVertices > kMaxShortIndexVertices)  return false;
+    }
+
+    data.shortIndices.resize(data.indices.size());
+    for (std::size_t i = 0; i < data.indices.size(); ++i)
+    {
+        data.shortIndices[i] = static_cast<std::uint16_t>(data.indices[i]);
+    }
+    data.indices.clear();
+    data.indices.shrink_to_fit();
+    return true;
+}
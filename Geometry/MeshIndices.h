@@ -0,0 +1,30 @@
+//--------------------------------------------------------------------------------------
+// 16-bit index buffers
+//--------------------------------------------------------------------------------------
+// Code in .cpp file
+// Sub-meshes are drawn with a base vertex, so their indices only need to reach the vertices of their own sub-mesh. When
+// every sub-mesh has at most 65536 vertices the indices can be stored in 16 bits, halving the index memory and the
+// bandwidth used to read them. Larger sub-meshes are first split into chunks that each use at most 65536 vertices
+
+#ifndef _MESH_INDICES_H_DEFINED_
+#define _MESH_INDICES_H_DEFINED_
+
+#include "MeshData.h"
+
+#include <cstdint>
+
+
+const std::uint32_t kMaxShortIndexVertices = 65536; // Most vertices a sub-mesh can use with 16-bit indices
+
+
+// Split sub-meshes using more than the given number of vertices into several sub-meshes (keeping their triangles in
+// order), and update the nodes to use all the pieces. Vertices used by triangles in more than one piece are copied
+// into each. Must come before levels of detail are generated (MeshSimplify.h). Returns the number of sub-meshes added
+std::uint32_t SplitSubMeshes(MeshData& data, std::uint32_t maxVertices = kMaxShortIndexVertices);
+
+// Move the indices into shortIndices if every sub-mesh can use 16-bit indices, leaving indices empty. Returns false
+// (changing nothing) if a sub-mesh has too many vertices. Must come after all stages that work on the indices
+bool PackShortIndices(MeshData& data);
+
+
+#endif // _MESH_INDICES_H_DEFINED_
@@ -0,0 +1,606 @@
+//--------------------------------------------------------------------------------------
+// Vertex cache, overdraw and vertex fetch optimisation
+//--------------------------------------------------------------------------------------
+
+#include "MeshOptimise.h"
+#include "Packing.h"      // Decoding compact positions
+#include "VectorStream.h" // Gathering positions and normals out of the vertices
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+
+namespace
+{
+    /*-------------------------------------------------------------------------------------
+        Simulation helpers
+    -------------------------------------------------------------------------------------*/
+
+    const unsigned int kForsythCacheSize   = 32;  // Size of the LRU cache used for scoring by the vertex cache step
+    const std::size_t  kMemoryLineSize     = 64;  // Bytes read from memory at once when fetching vertices
+    const unsigned int kMemoryCacheLines   = 256; // Lines in the simulated vertex fetch cache (16KB)
+    const int          kOverdrawResolution = 256; // Width and height in pixels of each view used to measure overdraw
+
+    // FIFO cache of numbered items (vertices or memory lines). Each item records when it was added, it is still in the
+    // cache if fewer than size items have been added since
+    class FifoCache
+    {
+    public:
+        FifoCache(std::size_t numItems, unsigned int size) : mAdded(numItems, 0), mTime(size + 1), mSize(size) {}
+
+        // Use an item, adding it to the cache if it is not there. Returns true if it was not in the cache (a miss)
+        bool Access(std::size_t item)
+        {
+            if (mTime - mAdded[item] <= mSize)  return false;
+            mAdded[item] = mTime++;
+            return true;
+        }
+
+        // Remove everything from the cache
+        void Clear()  { mTime += mSize + 1; }
+
+    private:
+        std::vector<std::size_t> mAdded;
+        std::size_t              mTime;
+        std::size_t              mSize;
+    };
+
+    float Component(const CVector3& v, int axis)
+    {
+        return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+    }
+
+    // Positions of all the vertices of mesh data, decoding compact ones
+    std::vector<CVector3> ReadPositions(const MeshData& data)
+    {
+        const std::size_t numVertices = data.NumVertices();
+        const VertexFormat& format = data.format;
+        std::vector<CVector3> positions(numVertices);
+        if (!format.compact)
+        {
+            StreamCopyVector3(data.vertices.data(), format.vertexSize, positions.data(), sizeof(CVector3), numVertices);
+            return positions;
+        }
+        for (std::size_t v = 0; v < numVertices; ++v)
+        {
+            std::uint16_t packed[4];
+            float unit[4];
+            std::memcpy(packed, data.vertices.data() + v * format.vertexSize, sizeof(packed));
+            UnpackUnorm16(packed, unit, 4);
+            positions[v] = CVector3(format.positionOffset[0] + unit[0] * format.positionScale[0],
+                                    format.positionOffset[1] + unit[1] * format.positionScale[1],
+                                    format.positionOffset[2] + unit[2] * format.positionScale[2]);
+        }
+        return positions;
+    }
+
+
+    /*-------------------------------------------------------------------------------------
+        Overdraw measurement
+    -------------------------------------------------------------------------------------*/
+
+    // Twice the signed area of triangle a, b, p in x and y. Positive if p is to the left of a->b
+    float EdgeFunction(const CVector3& a, const CVector3& b, float px, float py)
+    {
+        return (b.x - a.x) * (py - a.y) - (b.y - a.y) * (px - a.x);
+    }
+
+    // Whether a pixel centre lying exactly on edge a->b belongs to the triangle. Of two triangles sharing an edge, each
+    // goes along it in a different direction, so exactly one of them gets the pixel
+    bool OwnsEdge(const CVector3& a, const CVector3& b)
+    {
+        return b.y < a.y || (b.y == a.y && b.x < a.x);
+    }
+
+    // Rasterise a triangle with positive area (corners in pixels, depth in z) into a depth buffer, counting the pixels
+    // that pass the depth test, i.e. the pixels that would be shaded with early depth testing
+    void RasteriseTriangle(const CVector3 corners[3], std::vector<float>& depthBuffer, std::size_t& pixelsShaded)
+    {
+        const CVector3& a = corners[0];
+        const CVector3& b = corners[1];
+        const CVector3& c = corners[2];
+        const float area = EdgeFunction(a, b, c.x, c.y);
+        const bool ownsBC = OwnsEdge(b, c), ownsCA = OwnsEdge(c, a), ownsAB = OwnsEdge(a, b);
+
+        int minX = std::max(static_cast<int>(std::floor(std::min({ a.x, b.x, c.x }))), 0);
+        int maxX = std::min(static_cast<int>(std::ceil (std::max({ a.x, b.x, c.x }))), kOverdrawResolution - 1);
+        int minY = std::max(static_cast<int>(std::floor(std::min({ a.y, b.y, c.y }))), 0);
+        int maxY = std::min(static_cast<int>(std::ceil (std::max({ a.y, b.y, c.y }))), kOverdrawResolution - 1);
+        for (int y = minY; y <= maxY; ++y)
+        {
+            for (int x = minX; x <= maxX; ++x)
+            {
+                float px = x + 0.5f, py = y + 0.5f;
+                float wa = EdgeFunction(b, c, px, py); // Weight of each corner
+                float wb = EdgeFunction(c, a, px, py);
+                float wc = EdgeFunction(a, b, px, py);
+                if (wa < 0.0f || wb < 0.0f || wc < 0.0f)  continue;
+                if ((wa == 0.0f && !ownsBC) || (wb == 0.0f && !ownsCA) || (wc == 0.0f && !ownsAB))  continue;
+
+                float depth = (wa * a.z + wb * b.z + wc * c.z) / area;
+                float& stored = depthBuffer[y * kOverdrawResolution + x];
+                if (depth < stored)
+                {
+                    stored = depth;
+                    ++pixelsShaded;
+                }
+            }
+        }
+    }
+
+    // Render the mesh from the 6 axis directions with back face culling, counting pixels covered and shaded. Front
+    // faces wind clockwise as seen by the viewer, as for the rest of the app. Each axis is drawn twice on the same
+    // screen axes: looking along the axis, keeping clockwise triangles, then looking back the other way, which mirrors
+    // the screen so anticlockwise triangles are kept and depth is reversed
+    OverdrawStatistics AnalyseOverdraw(const MeshData& data, const std::vector<std::uint32_t>& indices,
+                                       const std::vector<CVector3>& positions)
+    {
+        OverdrawStatistics statistics;
+        const CVector3 size = data.bounds.max - data.bounds.min;
+        const float extent = std::max({ size.x, size.y, size.z });
+        if (!(extent > 0.0f))  return statistics;
+        const float scale = kOverdrawResolution / extent; // Same scale on both screen axes to keep triangle shapes
+
+        std::vector<float> depthBuffer(kOverdrawResolution * kOverdrawResolution);
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            const int screenX = (axis + 1) % 3;
+            const int screenY = (axis + 2) % 3;
+            for (int side = 0; side < 2; ++side)
+            {
+                std::fill(depthBuffer.begin(), depthBuffer.end(), std::numeric_limits<float>::infinity());
+                for (auto& subMesh : data.subMeshes)
+                {
+                    for (std::uint32_t i = 0; i + 2 < subMesh.numIndices; i += 3)
+                    {
+                        CVector3 corners[3];
+                        for (int corner = 0; corner < 3; ++corner)
+                        {
+                            const CVector3& p = positions[subMesh.firstVertex + indices[subMesh.firstIndex + i + corner]];
+                            corners[corner] = CVector3((Component(p, screenX) - Component(data.bounds.min, screenX)) * scale,
+                                                       (Component(p, screenY) - Component(data.bounds.min, screenY)) * scale,
+                                                       side == 0 ? Component(p, axis) : -Component(p, axis));
+                        }
+                        float area = EdgeFunction(corners[0], corners[1], corners[2].x, corners[2].y);
+                        if (side == 0)
+                        {
+                            area = -area; // Clockwise triangles have negative area, swap two corners to rasterise them
+                            std::swap(corners[1], corners[2]);
+                        }
+                        if (area > 0.0f)  RasteriseTriangle(corners, depthBuffer, statistics.pixelsShaded);
+                    }
+                }
+                for (auto depth : depthBuffer)
+                {
+                    if (depth != std::numeric_limits<float>::infinity())  ++statistics.pixelsCovered;
+                }
+            }
+        }
+        if (statistics.pixelsCovered > 0)
+        {
+            statistics.overdraw = static_cast<float>(statistics.pixelsShaded) / statistics.pixelsCovered;
+        }
+        return statistics;
+    }
+
+
+    /*-------------------------------------------------------------------------------------
+        Vertex fetch measurement
+    -------------------------------------------------------------------------------------*/
+
+    // Count the memory read fetching the vertices that miss the post-transform cache. The vertex cache is emptied
+    // between sub-meshes (separate draw calls) but the memory cache is not
+    VertexFetchStatistics AnalyseVertexFetch(const MeshData& data, const std::vector<std::uint32_t>& indices)
+    {
+        VertexFetchStatistics statistics;
+        if (data.vertices.empty())  return statistics;
+
+        const std::size_t vertexSize = data.format.vertexSize;
+        FifoCache vertexCache(data.NumVertices(), kVertexCacheSize);
+        FifoCache memoryCache(data.vertices.size() / kMemoryLineSize + 1, kMemoryCacheLines);
+        for (auto& subMesh : data.subMeshes)
+        {
+            vertexCache.Clear();
+            for (std::uint32_t i = 0; i < subMesh.numIndices; ++i)
+            {
+                std::size_t vertex = subMesh.firstVertex + indices[subMesh.firstIndex + i];
+                if (!vertexCache.Access(vertex))  continue;
+
+                std::size_t firstLine = vertex * vertexSize / kMemoryLineSize;
+                std::size_t lastLine = ((vertex + 1) * vertexSize - 1) / kMemoryLineSize;
+                for (std::size_t line = firstLine; line <= lastLine; ++line)
+                {
+                    if (memoryCache.Access(line))  statistics.bytesFetched += kMemoryLineSize;
+                }
+            }
+        }
+        statistics.overfetch = static_cast<float>(statistics.bytesFetched) / data.vertices.size();
+        return statistics;
+    }
+
+
+    /*-------------------------------------------------------------------------------------
+        Vertex cache optimisation
+    -------------------------------------------------------------------------------------*/
+
+    // Score of a vertex in Forsyth's algorithm. Vertices used by the last triangle get a fixed score (so the next
+    // triangle doesn't just reuse the same edge), others in the cache score higher the more recently they were used.
+    // Vertices with few triangles left get a boost so they are finished off rather than left behind
+    float VertexScore(int cachePosition, std::uint32_t remainingTriangles)
+    {
+        if (remainingTriangles == 0)  return -1.0f;
+
+        float score = 0.0f;
+        if (cachePosition >= 0)
+        {
+            if (cachePosition < 3)  score = 0.75f;
+            else                    score = std::pow(1.0f - (cachePosition - 3) / static_cast<float>(kForsythCacheSize - 3), 1.5f);
+        }
+        return score + 2.0f / std::sqrt(static_cast<float>(remainingTriangles));
+    }
+}
+
+
+/*-----------------------------------------------------------------------------------------
+    Analysis
+-----------------------------------------------------------------------------------------*/
+
+// Measure the vertex shader work for a triangle list using the given number of vertices
+VertexCacheStatistics AnalyseVertexCache(const std::uint32_t* indices, std::size_t numIndices, std::size_t numVertices,
+                                         unsigned int cacheSize /*= kVertexCacheSize*/)
+{
+    VertexCacheStatistics statistics;
+    FifoCache cache(numVertices, cacheSize);
+    for (std::size_t i = 0; i < numIndices; ++i)
+    {
+        if (cache.Access(indices[i]))  ++statistics.verticesTransformed;
+    }
+    if (numIndices >= 3)   statistics.acmr = static_cast<float>(statistics.verticesTransformed) / (numIndices / 3);
+    if (numVertices > 0)   statistics.atvr = static_cast<float>(statistics.verticesTransformed) / numVertices;
+    return statistics;
+}
+
+
+// Measure all the statistics for mesh data
+MeshAnalysis AnalyseMesh(const MeshData& data)
+{
+    MeshAnalysis analysis;
+    std::vector<std::uint32_t> indices(data.indices);
+    if (!data.shortIndices.empty())  indices.assign(data.shortIndices.begin(), data.shortIndices.end());
+
+    // Each sub-mesh starts with an empty post-transform cache
+    std::size_t numTriangles = 0;
+    std::size_t numVertices = 0;
+    for (auto& subMesh : data.subMeshes)
+    {
+        VertexCacheStatistics subMeshStatistics = AnalyseVertexCache(indices.data() + subMesh.firstIndex, subMesh.numIndices,
+                                                                     subMesh.numVertices);
+        analysis.vertexCache.verticesTransformed += subMeshStatistics.verticesTransformed;
+        numTriangles += subMesh.numIndices / 3;
+        numVertices += subMesh.numVertices;
+    }
+    if (numTriangles > 0)  analysis.vertexCache.acmr = static_cast<float>(analysis.vertexCache.verticesTransformed) / numTriangles;
+    if (numVertices > 0)   analysis.vertexCache.atvr = static_cast<float>(analysis.vertexCache.verticesTransformed) / numVertices;
+
+    analysis.overdraw = AnalyseOverdraw(data, indices, ReadPositions(data));
+    analysis.vertexFetch = AnalyseVertexFetch(data, indices);
+    return analysis;
+}
+
+
+/*-----------------------------------------------------------------------------------------
+    Optimisation
+-----------------------------------------------------------------------------------------*/
+
+// Reorder the triangles of a triangle list for the post-transform cache. Repeatedly outputs the triangle with the
+// highest score (the sum of its vertices' scores), looking only at triangles using vertices in a simulated LRU cache.
+// When none of those are left, the first triangle not yet output is used
+void OptimiseVertexCache(std::uint32_t* indices, std::size_t numIndices, std::size_t numVertices)
+{
+    const std::size_t numTriangles = numIndices / 3;
+    if (numTriangles < 2 || numVertices == 0)  return;
+
+    // Triangles using each vertex. The triangles not yet output are kept at the start of each vertex's range
+    std::vector<std::uint32_t> firstAdjacent(numVertices + 1, 0);
+    std::vector<std::uint32_t> numRemaining(numVertices, 0);
+    std::vector<std::uint32_t> adjacent(numTriangles * 3);
+    for (std::size_t i = 0; i < numTriangles * 3; ++i)  ++firstAdjacent[indices[i] + 1];
+    for (std::size_t v = 0; v < numVertices; ++v)  firstAdjacent[v + 1] += firstAdjacent[v];
+    for (std::size_t i = 0; i < numTriangles * 3; ++i)
+    {
+        std::uint32_t v = indices[i];
+        adjacent[firstAdjacent[v] + numRemaining[v]++] = static_cast<std::uint32_t>(i / 3);
+    }
+
+    std::vector<int>   cachePosition(numVertices, -1);
+    std::vector<float> vertexScore(numVertices);
+    for (std::size_t v = 0; v < numVertices; ++v)  vertexScore[v] = VertexScore(-1, numRemaining[v]);
+    auto triangleScore = [&](std::size_t t)
+    {
+        return vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+    };
+
+    // Start with the best triangle of all
+    std::size_t best = 0;
+    float bestScore = triangleScore(0);
+    for (std::size_t t = 1; t < numTriangles; ++t)
+    {
+        float score = triangleScore(t);
+        if (score > bestScore)
+        {
+            best = t;
+            bestScore = score;
+        }
+    }
+
+    std::vector<std::uint32_t> output(numTriangles * 3);
+    std::vector<bool> isOutput(numTriangles, false);
+    std::vector<std::uint32_t> cache, newCache;
+    cache.reserve(kForsythCacheSize + 3);
+    newCache.reserve(kForsythCacheSize + 3);
+    std::size_t firstNotOutput = 0;
+    for (std::size_t out = 0; out < numTriangles; ++out)
+    {
+        // Output the best triangle and remove it from its vertices' lists
+        const std::uint32_t* corners = indices + best * 3;
+        isOutput[best] = true;
+        newCache.clear();
+        for (int corner = 0; corner < 3; ++corner)
+        {
+            std::uint32_t v = corners[corner];
+            output[out * 3 + corner] = v;
+            auto begin = adjacent.begin() + firstAdjacent[v];
+            auto end = begin + numRemaining[v];
+            std::iter_swap(std::find(begin, end, static_cast<std::uint32_t>(best)), end - 1);
+            --numRemaining[v];
+            if (std::find(newCache.begin(), newCache.end(), v) == newCache.end())  newCache.push_back(v);
+        }
+
+        // Its vertices move to the front of the cache, pushing others back
+        const auto triangleEnd = newCache.size();
+        for (auto v : cache)
+        {
+            if (std::find(newCache.begin(), newCache.begin() + triangleEnd, v) == newCache.begin() + triangleEnd)
+            {
+                newCache.push_back(v);
+            }
+        }
+        for (std::size_t i = 0; i < newCache.size(); ++i)
+        {
+            std::uint32_t v = newCache[i];
+            cachePosition[v] = i < kForsythCacheSize ? static_cast<int>(i) : -1;
+            vertexScore[v] = VertexScore(cachePosition[v], numRemaining[v]);
+        }
+
+        // The next triangle is the best of those using a vertex whose score has changed
+        bestScore = -1.0f;
+        for (auto v : newCache)
+        {
+            for (std::uint32_t i = 0; i < numRemaining[v]; ++i)
+            {
+                std::size_t t = adjacent[firstAdjacent[v] + i];
+                float score = triangleScore(t);
+                if (score > bestScore)
+                {
+                    best = t;
+                    bestScore = score;
+                }
+            }
+        }
+        if (bestScore < 0.0f)
+        {
+            while (firstNotOutput < numTriangles && isOutput[firstNotOutput])  ++firstNotOutput;
+            best = firstNotOutput;
+        }
+
+        if (newCache.size() > kForsythCacheSize)  newCache.resize(kForsythCacheSize);
+        cache.swap(newCache);
+    }
+
+    std::copy(output.begin(), output.end(), indices);
+}
+
+
+// Reorder clusters of triangles in a vertex cache optimised triangle list to reduce overdraw
+void OptimiseOverdraw(std::uint32_t* indices, std::size_t numIndices, const std::uint8_t* vertices,
+                      const VertexFormat& format, std::size_t numVertices, float threshold /*= 1.05f*/)
+{
+    const std::size_t numTriangles = numIndices / 3;
+    if (numTriangles < 2 || numVertices == 0 || format.compact)  return;
+
+    std::vector<CVector3> positions(numVertices);
+    std::vector<CVector3> normals(numVertices);
+    StreamCopyVector3(vertices, format.vertexSize, positions.data(), sizeof(CVector3), numVertices);
+    StreamCopyVector3(vertices + format.normalOffset, format.vertexSize, normals.data(), sizeof(CVector3), numVertices);
+
+    // Hard cluster boundaries are where all three vertices of a triangle miss the cache, i.e. the vertex cache order
+    // starts afresh, so reordering there costs nothing
+    FifoCache cache(numVertices, kVertexCacheSize);
+    auto triangleMisses = [&](std::size_t t)
+    {
+        return (cache.Access(indices[t * 3]) ? 1u : 0u) + (cache.Access(indices[t * 3 + 1]) ? 1u : 0u) +
+               (cache.Access(indices[t * 3 + 2]) ? 1u : 0u);
+    };
+    std::vector<std::size_t> hardStarts;
+    std::size_t originalMisses = 0;
+    for (std::size_t t = 0; t < numTriangles; ++t)
+    {
+        std::uint32_t misses = triangleMisses(t);
+        if (misses == 3)  hardStarts.push_back(t);
+        originalMisses += misses;
+    }
+    if (hardStarts.empty() || hardStarts[0] != 0)  hardStarts.insert(hardStarts.begin(), 0);
+    hardStarts.push_back(numTriangles);
+
+    // Soft boundaries split hard clusters where the part so far already has an ACMR within the threshold of the whole
+    // cluster's, so starting again with an empty cache there costs little
+    std::vector<std::size_t> clusterStarts;
+    for (std::size_t h = 0; h + 1 < hardStarts.size(); ++h)
+    {
+        const std::size_t start = hardStarts[h];
+        const std::size_t end = hardStarts[h + 1];
+        cache.Clear();
+        std::size_t clusterMisses = 0;
+        for (std::size_t t = start; t < end; ++t)  clusterMisses += triangleMisses(t);
+        const float limit = threshold * clusterMisses / (end - start);
+
+        cache.Clear();
+        clusterStarts.push_back(start);
+        std::size_t softStart = start;
+        std::size_t misses = 0;
+        for (std::size_t t = start; t + 1 < end; ++t)
+        {
+            misses += triangleMisses(t);
+            if (misses <= limit * (t + 1 - softStart))
+            {
+                clusterStarts.push_back(t + 1);
+                softStart = t + 1;
+                misses = 0;
+                cache.Clear();
+            }
+        }
+    }
+    clusterStarts.push_back(numTriangles);
+
+    // Sort the clusters so those facing furthest out from the centre of the mesh come first. The centre of each
+    // cluster is the average of its triangle centres, its direction the average of its vertex normals (which don't
+    // depend on the winding order)
+    const std::size_t numClusters = clusterStarts.size() - 1;
+    std::vector<CVector3> clusterCentres(numClusters);
+    std::vector<CVector3> clusterNormals(numClusters);
+    CVector3 meshCentre = { 0.0f, 0.0f, 0.0f };
+    for (std::size_t c = 0; c < numClusters; ++c)
+    {
+        CVector3 centre = { 0.0f, 0.0f, 0.0f };
+        CVector3 normal = { 0.0f, 0.0f, 0.0f };
+        for (std::size_t i = clusterStarts[c] * 3; i < clusterStarts[c + 1] * 3; ++i)
+        {
+            centre += positions[indices[i]];
+            normal += normals[indices[i]];
+        }
+        meshCentre += centre;
+        clusterCentres[c] = centre * (1.0f / ((clusterStarts[c + 1] - clusterStarts[c]) * 3));
+        clusterNormals[c] = normal;
+    }
+    meshCentre = meshCentre * (1.0f / (numTriangles * 3));
+
+    std::vector<float> sortKeys(numClusters, 0.0f);
+    for (std::size_t c = 0; c < numClusters; ++c)
+    {
+        if (Length(clusterNormals[c]) > 0.0f)  sortKeys[c] = Dot(clusterCentres[c] - meshCentre, Normalise(clusterNormals[c]));
+    }
+    std::vector<std::size_t> order(numClusters);
+    for (std::size_t c = 0; c < numClusters; ++c)  order[c] = c;
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return sortKeys[a] > sortKeys[b]; });
+
+    std::vector<std::uint32_t> output;
+    output.reserve(numTriangles * 3);
+    for (auto c : order)
+    {
+        output.insert(output.end(), indices + clusterStarts[c] * 3, indices + clusterStarts[c + 1] * 3);
+    }
+
+    // Cluster boundaries only limit the cost within each cluster, so check the whole list stays within the threshold
+    std::size_t outputMisses = AnalyseVertexCache(output.data(), output.size(), numVertices).verticesTransformed;
+    if (outputMisses <= threshold * originalMisses)  std::copy(output.begin(), output.end(), indices);
+}
+
+
+// Renumber the vertices in the order the triangle list first uses them, moving the vertices to match
+std::vector<std::uint32_t> OptimiseVertexFetch(std::uint32_t* indices, std::size_t numIndices, std::uint8_t* vertices,
+                                               std::uint32_t vertexSize, std::size_t numVertices)
+{
+    const std::uint32_t kUnused = ~0u;
+    std::vector<std::uint32_t> newNumber(numVertices, kUnused);
+    std::uint32_t next = 0;
+    for (std::size_t i = 0; i < numIndices; ++i)
+    {
+        std::uint32_t& number = newNumber[indices[i]];
+        if (number == kUnused)  number = next++;
+        indices[i] = number;
+    }
+    for (auto& number : newNumber)
+    {
+        if (number == kUnused)  number = next++;
+    }
+
+    std::vector<std::uint8_t> reordered(numVertices * vertexSize);
+    for (std::size_t v = 0; v < numVertices; ++v)
+    {
+        std::memcpy(reordered.data() + static_cast<std::size_t>(newNumber[v]) * vertexSize, vertices + v * vertexSize, vertexSize);
+    }
+    std::copy(reordered.begin(), reordered.end(), vertices);
+    return newNumber;
+}
+
+
+// Run all the optimisation steps on each sub-mesh of mesh data with float vertices and 32-bit indices
+MeshOptimisationReport OptimiseMesh(MeshData& data)
+{
+    MeshOptimisationReport report;
+    report.before = AnalyseMesh(data);
+    if (data.format.compact || !data.shortIndices.empty())
+    {
+        report.after = report.before;
+        return report;
+    }
+
+    const std::uint32_t vertexSize = data.format.vertexSize;
+    auto optimiseTriangles = [&](const SubMesh& subMesh, std::uint32_t firstIndex, std::uint32_t numIndices, bool reduceOverdraw)
+    {
+        std::uint32_t* indices = data.indices.data() + firstIndex;
+        const std::uint8_t* vertices = data.vertices.data() + static_cast<std::size_t>(subMesh.firstVertex) * vertexSize;
+
+        // Keep the original order if it was already better for the cache (e.g. ordered by the modelling tool)
+        std::vector<std::uint32_t> original(indices, indices + numIndices);
+        float originalACMR = AnalyseVertexCache(indices, numIndices, subMesh.numVertices).acmr;
+        OptimiseVertexCache(indices, numIndices, subMesh.numVertices);
+        if (AnalyseVertexCache(indices, numIndices, subMesh.numVertices).acmr > originalACMR)
+        {
+            std::copy(original.begin(), original.end(), indices);
+        }
+
+        if (reduceOverdraw)  OptimiseOverdraw(indices, numIndices, vertices, data.format, subMesh.numVertices);
+    };
+
+    std::size_t cluster = 0;
+    for (std::uint32_t s = 0; s < data.subMeshes.size(); ++s)
+    {
+        // Clustered sub-meshes are optimised a cluster at a time, so each cluster keeps its triangles. Clusters are
+        // already in overdraw order (see BuildClusters)
+        const SubMesh& subMesh = data.subMeshes[s];
+        if (cluster < data.clusters.size() && data.clusters[cluster].subMesh == s)
+        {
+            for (; cluster < data.clusters.size() && data.clusters[cluster].subMesh == s; ++cluster)
+            {
+                optimiseTriangles(subMesh, data.clusters[cluster].firstIndex, data.clusters[cluster].numIndices, false);
+            }
+        }
+        else
+        {
+            optimiseTriangles(subMesh, subMesh.firstIndex, subMesh.numIndices, true);
+        }
+        for (auto& lod : data.lods)
+        {
+            const SubMesh& lodSubMesh = data.lodSubMeshes[lod.firstSubMesh + s];
+            optimiseTriangles(lodSubMesh, lodSubMesh.firstIndex, lodSubMesh.numIndices, true);
+        }
+
+        // The vertices are put in the order the full detail triangles use them, the levels of detail are renumbered
+        std::vector<std::uint32_t> newNumbers = OptimiseVertexFetch(data.indices.data() + subMesh.firstIndex, subMesh.numIndices,
+                                                                    data.vertices.data() + static_cast<std::size_t>(subMesh.firstVertex) * vertexSize,
+                                                                    vertexSize, subMesh.numVertices);
+        for (auto& lod : data.lods)
+        {
+            const SubMesh& lodSubMesh = data.lodSubMeshes[lod.firstSubMesh + s];
+            std::uint32_t* indices = data.indices.data() + lodSubMesh.firstIndex;
+            for (std::uint32_t i = 0; i < lodSubMesh.numIndices; ++i)  indices[i] = newNumbers[indices[i]];
+        }
+    }
+
+    report.after = AnalyseMesh(data);
+    return report;
+}
@@ -0,0 +1,113 @@
+//--------------------------------------------------------------------------------------
+// Vertex cache, overdraw and vertex fetch optimisation
+//--------------------------------------------------------------------------------------
+// Code in .cpp file
+// Reorders the triangles and vertices of each sub-mesh so the GPU does less work drawing them, without changing what is
+// drawn. Three steps, each keeping most of the benefit of the one before:
+// - Vertex cache: triangles are ordered so they reuse recently transformed vertices (Forsyth's "Linear-speed vertex
+//   cache optimisation"), reducing the number of times the vertex shader runs
+// - Overdraw: the vertex cache order is cut into clusters where the cache would start afresh anyway, and clusters
+//   facing outwards from the centre of the mesh are drawn first, so from most viewpoints the nearer surfaces hide the
+//   ones behind before they are shaded (Sander, Nehab & Barczak, "Fast triangle reordering for vertex locality and
+//   reduced overdraw")
+// - Vertex fetch: vertices are renumbered in the order the triangles first use them, so fetching them reads memory in
+//   order
+//
+// The analysis functions measure the same things, so the gain can be seen for each mesh:
+// - ACMR (average cache miss ratio), vertices transformed per triangle. 0.5 is ideal for large regular meshes, 3 is
+//   the worst
+// - ATVR (average transformed vertex ratio), vertices transformed per vertex in the mesh. 1 is ideal
+// - Overdraw, pixels shaded per pixel covered, averaged over views from the 6 axis directions. 1 is ideal
+// - Overfetch, bytes of vertex memory read per byte in the vertex array. 1 is ideal
+// These simulate typical hardware (a FIFO post-transform cache and 64 byte memory lines), so they are estimates
+
+#ifndef _MESH_OPTIMISE_H_DEFINED_
+#define _MESH_OPTIMISE_H_DEFINED_
+
+#include "MeshData.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+/*-----------------------------------------------------------------------------------------
+    Analysis
+-----------------------------------------------------------------------------------------*/
+
+const unsigned int kVertexCacheSize = 16; // Entries in the simulated post-transform cache
+
+struct VertexCacheStatistics
+{
+    std::size_t verticesTransformed = 0;
+    float       acmr = 0.0f;
+    float       atvr = 0.0f;
+};
+
+struct OverdrawStatistics
+{
+    std::size_t pixelsCovered = 0;
+    std::size_t pixelsShaded  = 0;
+    float       overdraw = 0.0f;
+};
+
+struct VertexFetchStatistics
+{
+    std::size_t bytesFetched = 0;
+    float       overfetch = 0.0f;
+};
+
+// All the statistics for a mesh, each sub-mesh is drawn separately
+struct MeshAnalysis
+{
+    VertexCacheStatistics vertexCache;
+    OverdrawStatistics    overdraw;
+    VertexFetchStatistics vertexFetch;
+};
+
+// Measure the vertex shader work for a triangle list using the given number of vertices
+VertexCacheStatistics AnalyseVertexCache(const std::uint32_t* indices, std::size_t numIndices, std::size_t numVertices,
+                                         unsigned int cacheSize = kVertexCacheSize);
+
+// Measure all the statistics for mesh data (float or compact vertices, 16 or 32-bit indices)
+MeshAnalysis AnalyseMesh(const MeshData& data);
+
+
+/*-----------------------------------------------------------------------------------------
+    Optimisation
+-----------------------------------------------------------------------------------------*/
+// The individual steps work on one triangle list and its vertices (e.g. a sub-mesh), and should be used in this order
+
+// Reorder the triangles of a triangle list using the given number of vertices for the post-transform cache
+void OptimiseVertexCache(std::uint32_t* indices, std::size_t numIndices, std::size_t numVertices);
+
+// Reorder clusters of triangles in a vertex cache optimised triangle list to reduce overdraw. The vertices must be
+// float. Clusters are made as large as possible while their ACMR stays within threshold times its original value,
+// larger thresholds allow smaller clusters and so better sorting at some cost to the vertex cache. The order is left
+// unchanged if the ACMR of the whole list would rise by more than the threshold
+void OptimiseOverdraw(std::uint32_t* indices, std::size_t numIndices, const std::uint8_t* vertices,
+                      const VertexFormat& format, std::size_t numVertices, float threshold = 1.05f);
+
+// Renumber the vertices in the order the triangle list first uses them, moving the vertices to match. Vertices the
+// triangles don't use are moved to the end. Returns the new number of each vertex, for renumbering other triangle lists
+// using the same vertices (e.g. levels of detail)
+std::vector<std::uint32_t> OptimiseVertexFetch(std::uint32_t* indices, std::size_t numIndices, std::uint8_t* vertices,
+                                               std::uint32_t vertexSize, std::size_t numVertices);
+
+
+// Statistics before and after optimising a mesh
+struct MeshOptimisationReport
+{
+    MeshAnalysis before;
+    MeshAnalysis after;
+};
+
+// Run all the optimisation steps on each sub-mesh of mesh data with float vertices and 32-bit indices, i.e. before
+// index packing and vertex compaction. A sub-mesh keeps its triangle order if that was already better for the vertex
+// cache. Sub-meshes divided into clusters (MeshClusters.h) are optimised a cluster at a time without the overdraw step,
+// so each cluster keeps its triangles. The levels of detail are optimised too, but the statistics are for the full
+// detail mesh. Returns the statistics before and after
+MeshOptimisationReport OptimiseMesh(MeshData& data);
+
+
+#endif // _MESH_OPTIMISE_H_DEFINED_
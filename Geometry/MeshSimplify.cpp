@@ -0,0 +1,376 @@
+//--------------------------------------------------------------------------------------
+// Mesh simplification and levels of detail
+//--------------------------------------------------------------------------------------
+
+#include "MeshSimplify.h"
+#include "VectorStream.h" // Gathering positions out of the vertices
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+
+
+namespace
+{
+    const double kBorderWeight = 10.0; // Weight of the planes keeping borders and seams in place, relative to faces
+
+    // Error quadric: the weighted sum of squared distances of a point from a set of planes, stored as the symmetric
+    // 4x4 matrix sum(weight * plane * plane^T). Doubles as the sums lose too much precision in floats
+    struct Quadric
+    {
+        double aa = 0, ab = 0, ac = 0, ad = 0, bb = 0, bc = 0, bd = 0, cc = 0, cd = 0, dd = 0;
+        double weight = 0;
+
+        // Add the plane through a point with the given unit normal
+        void AddPlane(const CVector3& normal, const CVector3& point, double planeWeight)
+        {
+            double a = normal.x, b = normal.y, c = normal.z, d = -Dot(normal, point);
+            aa += planeWeight * a * a;  ab += planeWeight * a * b;  ac += planeWeight * a * c;  ad += planeWeight * a * d;
+            bb += planeWeight * b * b;  bc += planeWeight * b * c;  bd += planeWeight * b * d;
+            cc += planeWeight * c * c;  cd += planeWeight * c * d;
+            dd += planeWeight * d * d;
+            weight += planeWeight;
+        }
+
+        void Add(const Quadric& q)
+        {
+            aa += q.aa;  ab += q.ab;  ac += q.ac;  ad += q.ad;  bb += q.bb;  bc += q.bc;  bd += q.bd;
+            cc += q.cc;  cd += q.cd;  dd += q.dd;  weight += q.weight;
+        }
+
+        // Weighted sum of squared distances of a point from the planes
+        double Error(const CVector3& p) const
+        {
+            double x = p.x, y = p.y, z = p.z;
+            double error = aa * x * x + bb * y * y + cc * z * z + 2.0 * (ab * x * y + ac * x * z + bc * y * z) +
+                           2.0 * (ad * x + bd * y + cd * z) + dd;
+            return std::max(error, 0.0);
+        }
+    };
+
+    std::uint64_t EdgeKey(std::uint32_t a, std::uint32_t b)
+    {
+        return a < b ? (static_cast<std::uint64_t>(a) << 32) | b : (static_cast<std::uint64_t>(b) << 32) | a;
+    }
+
+    struct Collapse
+    {
+        std::uint32_t from;  // Position groups, see below
+        std::uint32_t to;
+        double        cost;  // Mean squared distance moved
+    };
+}
+
+
+// Simplify a triangle list using float vertices until it has at most the target number of indices
+float SimplifyTriangles(const std::uint32_t* indices, std::size_t numIndices, const std::uint8_t* vertices,
+                        std::uint32_t vertexSize, std::size_t numVertices, std::size_t targetIndices,
+                        std::vector<std::uint32_t>& result)
+{
+    result.assign(indices, indices + numIndices - numIndices % 3);
+    if (result.size() <= targetIndices || numVertices == 0)  return 0.0f;
+
+    std::vector<CVector3> positions(numVertices);
+    StreamCopyVector3(vertices, vertexSize, positions.data(), sizeof(CVector3), numVertices);
+
+
+    //-----------------------------------
+    // Position groups
+
+    // Vertices with exactly the same position form a group, which collapses as one. A group is named by its first
+    // vertex, its vertices are a range of groupVertices
+    std::vector<std::uint32_t> sorted(numVertices);
+    for (std::uint32_t v = 0; v < numVertices; ++v)  sorted[v] = v;
+    std::sort(sorted.begin(), sorted.end(), [&](std::uint32_t a, std::uint32_t b)
+    {
+        int order = std::memcmp(&positions[a], &positions[b], sizeof(CVector3));
+        return order < 0 || (order == 0 && a < b);
+    });
+    std::vector<std::uint32_t> group(numVertices);
+    std::vector<std::uint32_t> firstGroupVertex(numVertices + 1, 0);
+    std::vector<std::uint32_t> groupVertices(numVertices);
+    for (std::size_t i = 0; i < numVertices; ++i)
+    {
+        bool newGroup = i == 0 || std::memcmp(&positions[sorted[i]], &positions[sorted[i - 1]], sizeof(CVector3)) != 0;
+        group[sorted[i]] = newGroup ? sorted[i] : group[sorted[i - 1]];
+        ++firstGroupVertex[group[sorted[i]] + 1];
+    }
+    for (std::size_t v = 0; v < numVertices; ++v)  firstGroupVertex[v + 1] += firstGroupVertex[v];
+    {
+        std::vector<std::uint32_t> count(numVertices, 0);
+        for (std::uint32_t v = 0; v < numVertices; ++v)
+        {
+            groupVertices[firstGroupVertex[group[v]] + count[group[v]]++] = v;
+        }
+    }
+
+
+    //-----------------------------------
+    // Error quadrics
+
+    // Each group's quadric holds the planes of the triangles around it, weighted by their area. Border and seam edges
+    // (used by only one triangle) also add a plane through the edge at right angles to its triangle, so they keep
+    // their shape
+    std::vector<Quadric> quadrics(numVertices);
+    std::unordered_map<std::uint64_t, std::uint32_t> edgeUse;
+    edgeUse.reserve(result.size());
+    for (std::size_t i = 0; i < result.size(); ++i)
+    {
+        ++edgeUse[EdgeKey(result[i], result[i - i % 3 + (i + 1) % 3])];
+    }
+    for (std::size_t t = 0; t < result.size(); t += 3)
+    {
+        const CVector3* p[3] = { &positions[result[t]], &positions[result[t + 1]], &positions[result[t + 2]] };
+        CVector3 normal = Cross(*p[1] - *p[0], *p[2] - *p[0]);
+        float length = Length(normal);
+        if (length == 0.0f)  continue;
+        normal = normal * (1.0f / length);
+
+        for (int corner = 0; corner < 3; ++corner)
+        {
+            quadrics[group[result[t + corner]]].AddPlane(normal, *p[0], 0.5 * length);
+        }
+        for (int edge = 0; edge < 3; ++edge)
+        {
+            std::uint32_t a = result[t + edge], b = result[t + (edge + 1) % 3];
+            if (edgeUse[EdgeKey(a, b)] != 1)  continue;
+            CVector3 direction = positions[b] - positions[a];
+            CVector3 borderNormal = Cross(direction, normal);
+            float borderLength = Length(borderNormal);
+            if (borderLength == 0.0f)  continue;
+            borderNormal = borderNormal * (1.0f / borderLength);
+            double borderWeight = kBorderWeight * Dot(direction, direction);
+            quadrics[group[a]].AddPlane(borderNormal, positions[a], borderWeight);
+            quadrics[group[b]].AddPlane(borderNormal, positions[a], borderWeight);
+        }
+    }
+
+
+    //-----------------------------------
+    // Collapse passes
+
+    // Each pass collapses the cheapest edges it can, but no two that share a triangle, so each collapse can be
+    // checked against the triangles as they are. Passes repeat until the target is reached or no edge can collapse
+    double maxCost = 0.0;
+    std::vector<std::uint32_t> firstTriangle(numVertices + 1);
+    std::vector<std::uint32_t> vertexTriangles;
+    std::vector<std::uint32_t> remap(numVertices);
+    std::vector<bool> locked(numVertices);
+    std::vector<bool> borderGroup(numVertices);
+    std::vector<std::uint64_t> groupEdges;
+    std::unordered_set<std::uint64_t> borderEdges;
+    std::vector<Collapse> collapses;
+    while (result.size() > targetIndices)
+    {
+        const std::size_t numTriangles = result.size() / 3;
+
+        // Triangles using each vertex
+        std::fill(firstTriangle.begin(), firstTriangle.end(), 0);
+        for (auto v : result)  ++firstTriangle[v + 1];
+        for (std::size_t v = 0; v < numVertices; ++v)  firstTriangle[v + 1] += firstTriangle[v];
+        vertexTriangles.resize(result.size());
+        {
+            std::vector<std::uint32_t> count(numVertices, 0);
+            for (std::size_t i = 0; i < result.size(); ++i)
+            {
+                std::uint32_t v = result[i];
+                vertexTriangles[firstTriangle[v] + count[v]++] = static_cast<std::uint32_t>(i / 3);
+            }
+        }
+
+        // Edges between groups, and which of them (and which groups) are on a border or seam
+        edgeUse.clear();
+        for (std::size_t i = 0; i < result.size(); ++i)
+        {
+            ++edgeUse[EdgeKey(result[i], result[i - i % 3 + (i + 1) % 3])];
+        }
+        groupEdges.clear();
+        borderEdges.clear();
+        std::fill(borderGroup.begin(), borderGroup.end(), false);
+        for (std::size_t i = 0; i < result.size(); ++i)
+        {
+            std::uint32_t a = result[i], b = result[i - i % 3 + (i + 1) % 3];
+            if (group[a] == group[b])  continue;
+            groupEdges.push_back(EdgeKey(group[a], group[b]));
+            if (edgeUse[EdgeKey(a, b)] == 1)
+            {
+                borderEdges.insert(EdgeKey(group[a], group[b]));
+                borderGroup[group[a]] = borderGroup[group[b]] = true;
+            }
+        }
+        std::sort(groupEdges.begin(), groupEdges.end());
+        groupEdges.erase(std::unique(groupEdges.begin(), groupEdges.end()), groupEdges.end());
+
+        // Cost of each edge, collapsing whichever way round is cheaper. Border and seam groups may only move along a
+        // border or seam edge
+        collapses.clear();
+        for (auto edge : groupEdges)
+        {
+            std::uint32_t g[2] = { static_cast<std::uint32_t>(edge >> 32), static_cast<std::uint32_t>(edge) };
+            Collapse best = { 0, 0, -1.0 };
+            for (int direction = 0; direction < 2; ++direction)
+            {
+                std::uint32_t from = g[direction], to = g[1 - direction];
+                if (borderGroup[from] && borderEdges.count(edge) == 0)  continue;
+                Quadric q = quadrics[from];
+                q.Add(quadrics[to]);
+                double cost = q.weight > 0.0 ? q.Error(positions[to]) / q.weight : 0.0;
+                if (best.cost < 0.0 || cost < best.cost)  best = { from, to, cost };
+            }
+            if (best.cost >= 0.0)  collapses.push_back(best);
+        }
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.cost < b.cost; });
+
+        // Apply the cheapest collapses until enough triangles are removed
+        for (std::uint32_t v = 0; v < numVertices; ++v)  remap[v] = v;
+        std::fill(locked.begin(), locked.end(), false);
+        const std::size_t trianglesToRemove = (result.size() - targetIndices + 2) / 3;
+        std::size_t trianglesRemoved = 0;
+        std::size_t numCollapsed = 0;
+        for (auto& collapse : collapses)
+        {
+            if (trianglesRemoved >= trianglesToRemove)  break;
+            if (locked[collapse.from] || locked[collapse.to])  continue;
+
+            // Each vertex of the moving group becomes the vertex of the target group it shares an edge with, so seams
+            // stay joined. Triangles that remain must not flip over
+            const CVector3& target = positions[collapse.to];
+            bool valid = true;
+            std::size_t removed = 0;
+            for (std::uint32_t i = firstGroupVertex[collapse.from]; valid && i < firstGroupVertex[collapse.from + 1]; ++i)
+            {
+                std::uint32_t v = groupVertices[i];
+                if (firstTriangle[v] == firstTriangle[v + 1])  continue; // No longer used
+                std::uint32_t newVertex = v;
+                for (std::uint32_t j = firstTriangle[v]; valid && j < firstTriangle[v + 1]; ++j)
+                {
+                    const std::uint32_t* corners = &result[vertexTriangles[j] * 3];
+                    int moving = -1;
+                    bool usesTarget = false;
+                    for (int corner = 0; corner < 3; ++corner)
+                    {
+                        if (corners[corner] == v)  moving = corner;
+                        if (group[corners[corner]] == collapse.to)
+                        {
+                            usesTarget = true;
+                            newVertex = corners[corner];
+                        }
+                    }
+                    if (usesTarget)
+                    {
+                        ++removed;
+                        continue;
+                    }
+
+                    CVector3 p[3] = { positions[corners[0]], positions[corners[1]], positions[corners[2]] };
+                    CVector3 normalBefore = Cross(p[1] - p[0], p[2] - p[0]);
+                    p[moving] = target;
+                    CVector3 normalAfter = Cross(p[1] - p[0], p[2] - p[0]);
+                    float lengthBefore = Length(normalBefore);
+                    if (lengthBefore > 0.0f && Dot(normalBefore, normalAfter) <= 0.25f * lengthBefore * Length(normalAfter))
+                    {
+                        valid = false; // Flipped, turned by more than about 75 degrees, or collapsed to a line
+                    }
+                }
+                if (newVertex == v)  valid = false; // No edge to the target group from this vertex
+                remap[v] = newVertex;
+            }
+            if (!valid)
+            {
+                for (std::uint32_t i = firstGroupVertex[collapse.from]; i < firstGroupVertex[collapse.from + 1]; ++i)
+                {
+                    remap[groupVertices[i]] = groupVertices[i];
+                }
+                continue;
+            }
+
+            // Lock everything around the collapse for the rest of this pass
+            for (std::uint32_t i = firstGroupVertex[collapse.from]; i < firstGroupVertex[collapse.from + 1]; ++i)
+            {
+                std::uint32_t v = groupVertices[i];
+                for (std::uint32_t j = firstTriangle[v]; j < firstTriangle[v + 1]; ++j)
+                {
+                    const std::uint32_t* corners = &result[vertexTriangles[j] * 3];
+                    locked[group[corners[0]]] = locked[group[corners[1]]] = locked[group[corners[2]]] = true;
+                }
+            }
+            quadrics[collapse.to].Add(quadrics[collapse.from]);
+            maxCost = std::max(maxCost, collapse.cost);
+            trianglesRemoved += removed;
+            ++numCollapsed;
+        }
+        if (numCollapsed == 0)  break;
+
+        // Move the collapsed vertices, removing triangles with two corners in one group
+        std::size_t out = 0;
+        for (std::size_t t = 0; t < numTriangles; ++t)
+        {
+            std::uint32_t a = remap[result[t * 3]], b = remap[result[t * 3 + 1]], c = remap[result[t * 3 + 2]];
+            if (group[a] == group[b] || group[b] == group[c] || group[c] == group[a])  continue;
+            result[out++] = a;
+            result[out++] = b;
+            result[out++] = c;
+        }
+        result.resize(out);
+    }
+
+    return static_cast<float>(std::sqrt(maxCost));
+}
+
+
+// Add up to the given number of levels of detail to mesh data with float vertices and 32-bit indices
+std::uint32_t GenerateLods(MeshData& data, std::uint32_t numLods, float reduction /*= 0.5f*/)
+{
+    data.lods.clear();
+    data.lodSubMeshes.clear();
+    if (numLods == 0 || data.format.compact || !data.shortIndices.empty())  return 0;
+
+    const float kMaxRelativeError = 0.25f; // Largest error of a level as a fraction of the mesh's diagonal
+    const float maxError = kMaxRelativeError * Length(data.bounds.max - data.bounds.min);
+
+    // Each level is simplified from the one before, so its error is at most the sum of the errors so far
+    std::vector<SubMesh> previous = data.subMeshes;
+    std::vector<float> errors(data.subMeshes.size(), 0.0f);
+    std::size_t previousIndices = data.indices.size();
+    std::vector<std::uint32_t> simplified;
+    for (std::uint32_t level = 0; level < numLods; ++level)
+    {
+        const std::size_t firstNewIndex = data.indices.size();
+        MeshLod lod = { 0, 0.0f };
+        std::vector<SubMesh> subMeshes(previous.size());
+        std::vector<float> newErrors(errors);
+        std::size_t numIndices = 0;
+        bool lostSubMesh = false;
+        for (std::size_t s = 0; s < previous.size(); ++s)
+        {
+            const SubMesh& from = previous[s];
+            std::size_t target = static_cast<std::size_t>(from.numIndices / 3 * reduction) * 3;
+            newErrors[s] += SimplifyTriangles(data.indices.data() + from.firstIndex, from.numIndices,
+                                              data.vertices.data() + static_cast<std::size_t>(from.firstVertex) * data.format.vertexSize,
+                                              data.format.vertexSize, from.numVertices, target, simplified);
+            subMeshes[s] = { from.firstVertex, from.numVertices, static_cast<std::uint32_t>(data.indices.size()),
+                             static_cast<std::uint32_t>(simplified.size()) };
+            data.indices.insert(data.indices.end(), simplified.begin(), simplified.end());
+            lod.error = std::max(lod.error, newErrors[s]);
+            numIndices += simplified.size();
+            if (from.numIndices > 0 && simplified.empty())  lostSubMesh = true;
+        }
+
+        // Stop when simplification has little left to remove, would make part of the mesh disappear, or would move the
+        // surface so far the level no longer looks like the mesh (a quad simplified to a triangle for instance)
+        if (numIndices > previousIndices * 9 / 10 || lostSubMesh || lod.error > maxError)
+        {
+            data.indices.resize(firstNewIndex);
+            break;
+        }
+        lod.firstSubMesh = static_cast<std::uint32_t>(data.lodSubMeshes.size());
+        data.lods.push_back(lod);
+        data.lodSubMeshes.insert(data.lodSubMeshes.end(), subMeshes.begin(), subMeshes.end());
+        previous.swap(subMeshes);
+        errors.swap(newErrors);
+        previousIndices = numIndices;
+    }
+    return static_cast<std::uint32_t>(data.lods.size());
+}
@@ -0,0 +1,37 @@
+//--------------------------------------------------------------------------------------
+// Mesh simplification and levels of detail
+//--------------------------------------------------------------------------------------
+// Code in .cpp file
+// Simplifies triangle lists by collapsing edges, choosing the collapses that move the surface least as measured by
+// error quadrics (Garland & Heckbert, "Surface simplification using quadric error metrics"). Each collapse moves one
+// vertex onto a neighbouring one, so the simplified triangles use a subset of the original vertices and only need new
+// indices. A chain of these, each simplified from the last, gives the levels of detail of a mesh
+//
+// Vertices at the same position with different normals or UVs (seams) are moved together, and only along the seam, so
+// simplification doesn't tear the mesh. Open borders also only move along themselves
+
+#ifndef _MESH_SIMPLIFY_H_DEFINED_
+#define _MESH_SIMPLIFY_H_DEFINED_
+
+#include "MeshData.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+// Simplify a triangle list using float vertices until it has at most the target number of indices, or can't be
+// simplified further without damaging the mesh. The simplified indices are put in result. Returns the furthest the
+// simplified surface may be from the original, in mesh units
+float SimplifyTriangles(const std::uint32_t* indices, std::size_t numIndices, const std::uint8_t* vertices,
+                        std::uint32_t vertexSize, std::size_t numVertices, std::size_t targetIndices,
+                        std::vector<std::uint32_t>& result);
+
+// Add up to the given number of levels of detail to mesh data with float vertices and 32-bit indices. Each level
+// aims for the given fraction of the triangles of the one before. The chain stops early if a level would remove
+// less than a tenth of the triangles, leave a sub-mesh with none, or have an error over a quarter of the mesh's size.
+// Must come after sub-mesh splitting (MeshIndices.h). Returns the number added
+std::uint32_t GenerateLods(MeshData& data, std::uint32_t numLods, float reduction = 0.5f);
+
+
+#endif // _MESH_SIMPLIFY_H_DEFINED_
@@ -0,0 +1,236 @@
+//--------------------------------------------------------------------------------------
+// Tangent generation for normal mapping
+//--------------------------------------------------------------------------------------
+
+#include "MeshTangents.h"
+#include "VectorStream.h" // Gathering vertex elements out of the vertices
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <future>
+#include <thread>
+#include <vector>
+
+
+namespace
+{
+    // Fewer triangles or vertices than this per thread aren't worth starting a thread for
+    const std::size_t kMinItemsPerThread = 16384;
+
+    // UV winding of a triangle, corners are only added together if their triangles wind the same way
+    enum Winding : std::uint8_t
+    {
+        kNoUVArea,   // Tangent unknown, the corner adds nothing
+        kPositiveUVArea,
+        kNegativeUVArea,
+    };
+
+    // Contribution of one triangle corner to its vertex's tangent
+    struct CornerTangent
+    {
+        CVector3 tangent;  // Perpendicular to the vertex normal, with length the corner angle
+        Winding  winding;
+    };
+
+    // Call function(begin, end) for ranges covering 0 to count, spread over up to the given number of threads
+    // (including this one)
+    template <class Function>
+    void ParallelFor(std::size_t count, unsigned int numThreads, Function function)
+    {
+        std::size_t numRanges = std::min<std::size_t>(numThreads, (count + kMinItemsPerThread - 1) / kMinItemsPerThread);
+        if (numRanges <= 1)
+        {
+            function(std::size_t(0), count);
+            return;
+        }
+        std::size_t rangeSize = (count + numRanges - 1) / numRanges;
+        std::vector<std::future<void>> others;
+        for (std::size_t begin = rangeSize; begin < count; begin += rangeSize)
+        {
+            others.push_back(std::async(std::launch::async, function, begin, std::min(count, begin + rangeSize)));
+        }
+        function(std::size_t(0), rangeSize);
+        for (auto& other : others)  other.get();
+    }
+
+    CVector3 ProjectOnPlane(const CVector3& v, const CVector3& normal)
+    {
+        return v - normal * Dot(normal, v);
+    }
+
+    // Normalise a vector in place, returns false (leaving it unchanged) if it has no length
+    bool NormaliseIfPossible(CVector3& v)
+    {
+        float length = Length(v);
+        if (!(length > 0.0f))  return false;
+        v = v * (1.0f / length);
+        return true;
+    }
+
+    // Some unit vector perpendicular to a normal, for vertices with no tangent from their UVs
+    CVector3 Perpendicular(const CVector3& normal)
+    {
+        CVector3 axis = std::abs(normal.y) < 0.99f ? CVector3{ 0.0f, 1.0f, 0.0f } : CVector3{ 1.0f, 0.0f, 0.0f };
+        CVector3 tangent = Cross(axis, normal);
+        return NormaliseIfPossible(tangent) ? tangent : CVector3{ 1.0f, 0.0f, 0.0f };
+    }
+
+    CVector3 FinalTangent(CVector3 sum, const CVector3& normal)
+    {
+        return NormaliseIfPossible(sum) ? sum : Perpendicular(normal);
+    }
+}
+
+
+std::uint32_t GenerateTangents(MeshData& data, unsigned int numThreads /*= 0*/)
+{
+    if (data.format.compact || !data.format.hasTangents || !data.shortIndices.empty())  return 0;
+    if (numThreads == 0)  numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+
+    // Gather the elements needed out of the vertices
+    const std::uint32_t vertexSize = data.format.vertexSize;
+    const std::size_t numVertices = data.NumVertices();
+    if (numVertices == 0)  return 0;
+    std::vector<CVector3> positions(numVertices);
+    std::vector<CVector3> normals(numVertices);
+    std::vector<float> uvs(numVertices * 2, 0.0f);
+    StreamCopyVector3(data.vertices.data(), vertexSize, positions.data(), sizeof(CVector3), numVertices);
+    StreamCopyVector3(data.vertices.data() + data.format.normalOffset, vertexSize, normals.data(), sizeof(CVector3), numVertices);
+    if (data.format.hasUVs)
+    {
+        StreamCopyVector2(data.vertices.data() + data.format.uvOffset, vertexSize, uvs.data(), 2 * sizeof(float), numVertices);
+    }
+
+    // Vertex used by each corner of the sub-mesh triangles, and the place of the corner in the index array
+    std::vector<std::uint32_t> cornerVertices;
+    std::vector<std::uint32_t> cornerIndices;
+    for (auto& subMesh : data.subMeshes)
+    {
+        for (std::uint32_t i = 0; i < subMesh.numIndices / 3 * 3; ++i)
+        {
+            cornerVertices.push_back(subMesh.firstVertex + data.indices[subMesh.firstIndex + i]);
+            cornerIndices.push_back(subMesh.firstIndex + i);
+        }
+    }
+    const std::size_t numCorners = cornerVertices.size();
+
+    // Each corner's share of its vertex's tangent, triangles are independent so they are shared out between threads
+    std::vector<CornerTangent> corners(numCorners);
+    ParallelFor(numCorners / 3, numThreads, [&](std::size_t begin, std::size_t end)
+    {
+        for (std::size_t t = begin; t < end; ++t)
+        {
+            const std::uint32_t* v = &cornerVertices[t * 3];
+            CVector3 edge1 = positions[v[1]] - positions[v[0]];
+            CVector3 edge2 = positions[v[2]] - positions[v[0]];
+            float s1 = uvs[v[1] * 2] - uvs[v[0] * 2], t1 = uvs[v[1] * 2 + 1] - uvs[v[0] * 2 + 1];
+            float s2 = uvs[v[2] * 2] - uvs[v[0] * 2], t2 = uvs[v[2] * 2 + 1] - uvs[v[0] * 2 + 1];
+
+            // Direction of increasing U, from solving edge = s * tangent + t * bitangent for both edges. The sign of
+            // the UV area is the winding
+            float uvArea = s1 * t2 - s2 * t1;
+            Winding winding = uvArea > 0.0f ? kPositiveUVArea : (uvArea < 0.0f ? kNegativeUVArea : kNoUVArea);
+            CVector3 faceTangent = (edge1 * t2 - edge2 * t1) * (uvArea < 0.0f ? -1.0f : 1.0f);
+
+            for (int c = 0; c < 3; ++c)
+            {
+                CornerTangent& corner = corners[t * 3 + c];
+                corner.tangent = { 0.0f, 0.0f, 0.0f };
+                corner.winding = winding;
+                if (winding == kNoUVArea)  continue;
+
+                const CVector3& normal = normals[v[c]];
+                CVector3 tangent = ProjectOnPlane(faceTangent, normal);
+                if (!NormaliseIfPossible(tangent))
+                {
+                    corner.winding = kNoUVArea;
+                    continue;
+                }
+
+                // Weight by the angle between the corner's edges in the plane of the normal. Degenerate corners keep
+                // their winding but add nothing
+                CVector3 side1 = ProjectOnPlane(positions[v[(c + 1) % 3]] - positions[v[c]], normal);
+                CVector3 side2 = ProjectOnPlane(positions[v[(c + 2) % 3]] - positions[v[c]], normal);
+                if (!NormaliseIfPossible(side1) || !NormaliseIfPossible(side2))  continue;
+                float angle = std::acos(std::min(std::max(Dot(side1, side2), -1.0f), 1.0f));
+                corner.tangent = tangent * angle;
+            }
+        }
+    });
+
+    // Corners of each vertex, in corner order
+    std::vector<std::uint32_t> firstCorner(numVertices + 1, 0);
+    for (auto vertex : cornerVertices)  ++firstCorner[vertex + 1];
+    for (std::size_t v = 0; v < numVertices; ++v)  firstCorner[v + 1] += firstCorner[v];
+    std::vector<std::uint32_t> vertexCorners(numCorners);
+    {
+        std::vector<std::uint32_t> next(firstCorner.begin(), firstCorner.end() - 1);
+        for (std::uint32_t c = 0; c < numCorners; ++c)  vertexCorners[next[cornerVertices[c]]++] = c;
+    }
+
+    // Add up each vertex's corners in order, so the sums don't depend on the threads. A vertex takes the winding of its
+    // first corner with UV area, corners of the other winding go to a copy of the vertex (splitWinding)
+    std::vector<CVector3> tangents(numVertices);
+    std::vector<CVector3> splitTangents(numVertices);
+    std::vector<Winding> splitWinding(numVertices, kNoUVArea);
+    ParallelFor(numVertices, numThreads, [&](std::size_t begin, std::size_t end)
+    {
+        for (std::size_t v = begin; v < end; ++v)
+        {
+            Winding winding = kNoUVArea;
+            CVector3 sum = { 0.0f, 0.0f, 0.0f };
+            CVector3 splitSum = { 0.0f, 0.0f, 0.0f };
+            for (std::uint32_t i = firstCorner[v]; i < firstCorner[v + 1]; ++i)
+            {
+                const CornerTangent& corner = corners[vertexCorners[i]];
+                if (corner.winding == kNoUVArea)  continue;
+                if (winding == kNoUVArea)  winding = corner.winding;
+                if (corner.winding == winding)
+                {
+                    sum += corner.tangent;
+                }
+                else
+                {
+                    splitSum += corner.tangent;
+                    splitWinding[v] = corner.winding;
+                }
+            }
+            tangents[v] = FinalTangent(sum, normals[v]);
+            if (splitWinding[v] != kNoUVArea)  splitTangents[v] = FinalTangent(splitSum, normals[v]);
+        }
+    });
+    StreamCopyVector3(tangents.data(), sizeof(CVector3), data.vertices.data() + data.format.tangentOffset, vertexSize, numVertices);
+
+    std::size_t numSplit = std::count_if(splitWinding.begin(), splitWinding.end(), [](Winding w) { return w != kNoUVArea; });
+    if (numSplit == 0)  return 0;
+
+    // Rebuild the vertex array with each sub-mesh's copied vertices after its own, and point the corners of the other
+    // winding at the copies
+    std::vector<std::uint8_t> vertices;
+    vertices.reserve((numVertices + numSplit) * vertexSize);
+    for (auto& subMesh : data.subMeshes)
+    {
+        std::uint32_t firstVertex = static_cast<std::uint32_t>(vertices.size() / vertexSize);
+        const std::uint8_t* range = data.vertices.data() + static_cast<std::size_t>(subMesh.firstVertex) * vertexSize;
+        vertices.insert(vertices.end(), range, range + static_cast<std::size_t>(subMesh.numVertices) * vertexSize);
+        for (std::uint32_t v = subMesh.firstVertex; v < subMesh.firstVertex + subMesh.numVertices; ++v)
+        {
+            if (splitWinding[v] == kNoUVArea)  continue;
+
+            std::uint32_t copy = static_cast<std::uint32_t>(vertices.size() / vertexSize) - firstVertex;
+            const std::uint8_t* vertex = data.vertices.data() + static_cast<std::size_t>(v) * vertexSize;
+            vertices.insert(vertices.end(), vertex, vertex + vertexSize);
+            std::memcpy(&vertices[vertices.size() - vertexSize + data.format.tangentOffset], &splitTangents[v], sizeof(CVector3));
+            for (std::uint32_t i = firstCorner[v]; i < firstCorner[v + 1]; ++i)
+            {
+                std::uint32_t c = vertexCorners[i];
+                if (corners[c].winding == splitWinding[v])  data.indices[cornerIndices[c]] = copy;
+            }
+        }
+        subMesh.firstVertex = firstVertex;
+        subMesh.numVertices = static_cast<std::uint32_t>(vertices.size() / vertexSize) - firstVertex;
+    }
+    data.vertices = std::move(vertices);
+    return static_cast<std::uint32_t>(numSplit);
+}
@@ -0,0 +1,34 @@
+//--------------------------------------------------------------------------------------
+// Tangent generation for normal mapping
+//--------------------------------------------------------------------------------------
+// Code in .cpp file
+// Calculates the tangent of each vertex the way MikkTSpace does (Mikkelsen, "Simulation of wrinkled surfaces
+// revisited"), the convention most tools bake normal maps with, so baked maps light correctly:
+// - Each triangle's tangent is the direction of increasing U across it, worked out from its positions and UVs
+// - At each corner that tangent is made perpendicular to the corner's vertex normal, and weighted by the angle of the
+//   triangle at that corner (measured in the plane of the normal)
+// - The weighted tangents of all the corners sharing a vertex are added up and normalised
+// Corners are only added together if their triangles have the same UV winding. Where triangles with mirrored UVs meet
+// at a vertex the vertex is split in two, one for each side, as MikkTSpace gives them different tangents. MikkTSpace
+// also keeps apart corners with the same winding that are not connected through the triangles around the vertex, which
+// only happens on non-manifold meshes; here they are added together
+//
+// The corner tangents are calculated in parallel, then each vertex adds up its corners in triangle order, so the result
+// is exactly the same whatever the number of threads
+
+#ifndef _MESH_TANGENTS_H_DEFINED_
+#define _MESH_TANGENTS_H_DEFINED_
+
+#include "MeshData.h"
+
+#include <cstdint>
+
+
+// Calculate the tangents of mesh data with float vertices that include tangents, writing over any already there. Must
+// be the first stage after import, since vertices may be added (at the end of their sub-mesh's range). Triangles with
+// no UV area, and meshes without UVs, get a tangent perpendicular to the normal. Uses the given number of threads, 0
+// for one per hardware thread (small meshes use one). Returns the number of vertices added
+std::uint32_t GenerateTangents(MeshData& data, unsigned int numThreads = 0);
+
+
+#endif // _MESH_TANGENTS_H_DEFINED_
@@ -0,0 +1,316 @@
+//--------------------------------------------------------------------------------------
+// Bounding volumes (axis-aligned boxes and spheres), planes and view frustums for culling
+//--------------------------------------------------------------------------------------
+
+#include "BoundingVolumes.h"
+#include "VectorStream.h"
+
+#include <algorithm>
+
+
+/*-----------------------------------------------------------------------------------------
+    Construction
+-----------------------------------------------------------------------------------------*/
+
+// Return the smallest axis-aligned box containing the given points
+CAABB AABBFromPoints(const void* points, std::size_t stride, std::size_t count)
+{
+    CAABB box;
+    StreamBounds(points, stride, count, box.min, box.max);
+    return box;
+}
+
+// Return a sphere containing the given axis-aligned box
+CSphere SphereFromAABB(const CAABB& box)
+{
+    return CSphere{ box.Centre(), Length(box.Extent()) };
+}
+
+// Return the axis-aligned box containing a box after it has been transformed by an affine matrix
+CAABB TransformAABB(const CAABB& box, const CMatrix4x4& m)
+{
+    // Transform the centre as a point. The new extent in each axis is the sum of the old extents projected onto
+    // that axis, which only needs the absolute values of the matrix elements
+    CVector3 c = box.Centre();
+    CVector3 e = box.Extent();
+    CVector3 centre = { c.x * m.e00 + c.y * m.e10 + c.z * m.e20 + m.e30,
+                        c.x * m.e01 + c.y * m.e11 + c.z * m.e21 + m.e31,
+                        c.x * m.e02 + c.y * m.e12 + c.z * m.e22 + m.e32 };
+    CVector3 extent = { e.x * std::abs(m.e00) + e.y * std::abs(m.e10) + e.z * std::abs(m.e20),
+                        e.x * std::abs(m.e01) + e.y * std::abs(m.e11) + e.z * std::abs(m.e21),
+                        e.x * std::abs(m.e02) + e.y * std::abs(m.e12) + e.z * std::abs(m.e22) };
+    return CAABB{ centre - extent, centre + extent };
+}
+
+// Return a sphere transformed by an affine matrix. The radius is scaled by the largest scale in the matrix
+CSphere TransformSphere(const CSphere& sphere, const CMatrix4x4& m)
+{
+    const CVector3& c = sphere.centre;
+    CVector3 centre = { c.x * m.e00 + c.y * m.e10 + c.z * m.e20 + m.e30,
+                        c.x * m.e01 + c.y * m.e11 + c.z * m.e21 + m.e31,
+                        c.x * m.e02 + c.y * m.e12 + c.z * m.e22 + m.e32 };
+    CVector3 scale = m.GetScale();
+    return CSphere{ centre, sphere.radius * std::max(scale.x, std::max(scale.y, scale.z)) };
+}
+
+// Return the view frustum for a view-projection matrix (Direct3D style, depth range 0 to 1)
+CFrustum FrustumFromMatrix(const CMatrix4x4& viewProj)
+{
+    // A point p is transformed to clip space as (p, 1) * viewProj, so each clip space coordinate is the dot product of
+    // (p, 1) with one column of the matrix. A point is inside the frustum when -w <= x <= w, -w <= y <= w and
+    // 0 <= z <= w, and each of these conditions is a plane made from a sum or difference of columns
+    const CMatrix4x4& m = viewProj;
+    CPlane column0 = { { m.e00, m.e10, m.e20 }, m.e30 };
+    CPlane column1 = { { m.e01, m.e11, m.e21 }, m.e31 };
+    CPlane column2 = { { m.e02, m.e12, m.e22 }, m.e32 };
+    CPlane column3 = { { m.e03, m.e13, m.e23 }, m.e33 };
+
+    CFrustum frustum;
+    frustum.planes[CFrustum::Left]   = { column3.normal + column0.normal, column3.d + column0.d };
+    frustum.planes[CFrustum::Right]  = { column3.normal - column0.normal, column3.d - column0.d };
+    frustum.planes[CFrustum::Bottom] = { column3.normal + column1.normal, column3.d + column1.d };
+    frustum.planes[CFrustum::Top]    = { column3.normal - column1.normal, column3.d - column1.d };
+    frustum.planes[CFrustum::Near]   = column2;
+    frustum.planes[CFrustum::Far]    = { column3.normal - column2.normal, column3.d - column2.d };
+
+    // Normalise planes so distances are in world units (needed for the sphere radius test)
+    for (auto& plane : frustum.planes)
+    {
+        float invLength = InvSqrt(Dot(plane.normal, plane.normal));
+        plane.normal = plane.normal * invLength;
+        plane.d *= invLength;
+    }
+    return frustum;
+}
+
+
+/*-----------------------------------------------------------------------------------------
+    Tests
+-----------------------------------------------------------------------------------------*/
+// The single object tests are written with the same operations in the same order as the batch versions below, so
+// both give exactly the same results
+
+// Return the signed distance from a plane to a point, positive on the side the normal faces
+float PlaneDistance(const CPlane& plane, const CVector3& point)
+{
+    return point.x * plane.normal.x + point.y * plane.normal.y + point.z * plane.normal.z + plane.d;
+}
+
+// Return true if a sphere is inside or crosses the frustum
+bool IsVisible(const CFrustum& frustum, const CSphere& sphere)
+{
+    for (auto& plane : frustum.planes)
+    {
+        if (!(PlaneDistance(plane, sphere.centre) >= -sphere.radius))  return false;
+    }
+    return true;
+}
+
+// Return true if a box, given as centre and extent, is inside or crosses the frustum
+static bool IsVisibleCentreExtent(const CFrustum& frustum, const CVector3& centre, const CVector3& extent)
+{
+    // The box is outside a plane if its centre is further behind the plane than the box reaches towards it
+    for (auto& plane : frustum.planes)
+    {
+        float reach = extent.x * std::abs(plane.normal.x) + extent.y * std::abs(plane.normal.y) + extent.z * std::abs(plane.normal.z);
+        if (!(PlaneDistance(plane, centre) >= -reach))  return false;
+    }
+    return true;
+}
+
+// Return true if a box is inside or crosses the frustum
+bool IsVisible(const CFrustum& frustum, const CAABB& box)
+{
+    return IsVisibleCentreExtent(frustum, box.Centre(), box.Extent());
+}
+
+
+/*-----------------------------------------------------------------------------------------
+    Batch tests
+-----------------------------------------------------------------------------------------*/
+// Each iteration tests 8 objects against all six planes, keeping a mask of which are still visible. The plane values
+// are broadcast across registers once before the loop. Objects left over at the end are done with the scalar tests
+
+namespace
+{
+#if defined(MATH_SIMD_AVX)
+    // Write the 8 lowest bits of a mask as 0/1 bytes
+    inline void StoreMask8(int mask, std::uint8_t* visible)
+    {
+        for (int i = 0; i < 8; ++i)  visible[i] = static_cast<std::uint8_t>((mask >> i) & 1);
+    }
+
+    // Six planes in a form ready for the SIMD code
+    struct FrustumLanes
+    {
+        __m256 nx[CFrustum::NumPlanes], ny[CFrustum::NumPlanes], nz[CFrustum::NumPlanes], d[CFrustum::NumPlanes];
+        __m256 absNx[CFrustum::NumPlanes], absNy[CFrustum::NumPlanes], absNz[CFrustum::NumPlanes];
+
+        FrustumLanes(const CFrustum& frustum)
+        {
+            for (int p = 0; p < CFrustum::NumPlanes; ++p)
+            {
+                const CPlane& plane = frustum.planes[p];
+                nx[p] = _mm256_set1_ps(plane.normal.x);
+                ny[p] = _mm256_set1_ps(plane.normal.y);
+                nz[p] = _mm256_set1_ps(plane.normal.z);
+                d[p]  = _mm256_set1_ps(plane.d);
+                absNx[p] = _mm256_set1_ps(std::abs(plane.normal.x));
+                absNy[p] = _mm256_set1_ps(std::abs(plane.normal.y));
+                absNz[p] = _mm256_set1_ps(std::abs(plane.normal.z));
+            }
+        }
+    };
+#elif defined(MATH_SIMD_SSE)
+    // Write the 4 lowest bits of a mask as 0/1 bytes
+    inline void StoreMask4(int mask, std::uint8_t* visible)
+    {
+        for (int i = 0; i < 4; ++i)  visible[i] = static_cast<std::uint8_t>((mask >> i) & 1);
+    }
+
+    // Six planes in a form ready for the SIMD code
+    struct FrustumLanes
+    {
+        __m128 nx[CFrustum::NumPlanes], ny[CFrustum::NumPlanes], nz[CFrustum::NumPlanes], d[CFrustum::NumPlanes];
+        __m128 absNx[CFrustum::NumPlanes], absNy[CFrustum::NumPlanes], absNz[CFrustum::NumPlanes];
+
+        FrustumLanes(const CFrustum& frustum)
+        {
+            for (int p = 0; p < CFrustum::NumPlanes; ++p)
+            {
+                const CPlane& plane = frustum.planes[p];
+                nx[p] = _mm_set1_ps(plane.normal.x);
+                ny[p] = _mm_set1_ps(plane.normal.y);
+                nz[p] = _mm_set1_ps(plane.normal.z);
+                d[p]  = _mm_set1_ps(plane.d);
+                absNx[p] = _mm_set1_ps(std::abs(plane.normal.x));
+                absNy[p] = _mm_set1_ps(std::abs(plane.normal.y));
+                absNz[p] = _mm_set1_ps(std::abs(plane.normal.z));
+            }
+        }
+    };
+
+    // Sphere test for 4 objects, returns a bit mask of the visible ones. Registers are passed by reference since 32-bit
+    // Visual Studio only passes three by value (error C2719)
+    inline int SpheresVisible4(const FrustumLanes& f, const __m128& x, const __m128& y, const __m128& z, const __m128& negRadius)
+    {
+        __m128 visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (int p = 0; p < CFrustum::NumPlanes; ++p)
+        {
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, f.nx[p]), _mm_mul_ps(y, f.ny[p])), _mm_mul_ps(z, f.nz[p])), f.d[p]);
+            visible = _mm_and_ps(visible, _mm_cmpge_ps(distance, negRadius));
+        }
+        return _mm_movemask_ps(visible);
+    }
+
+    // Box test for 4 objects, returns a bit mask of the visible ones
+    inline int AABBsVisible4(const FrustumLanes& f, const __m128& x, const __m128& y, const __m128& z,
+                             const __m128& ex, const __m128& ey, const __m128& ez)
+    {
+        __m128 visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        const __m128 signMask = _mm_set1_ps(-0.0f);
+        for (int p = 0; p < CFrustum::NumPlanes; ++p)
+        {
+            __m128 reach = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ex, f.absNx[p]), _mm_mul_ps(ey, f.absNy[p])), _mm_mul_ps(ez, f.absNz[p]));
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, f.nx[p]), _mm_mul_ps(y, f.ny[p])), _mm_mul_ps(z, f.nz[p])), f.d[p]);
+            visible = _mm_and_ps(visible, _mm_cmpge_ps(distance, _mm_xor_ps(reach, signMask)));
+        }
+        return _mm_movemask_ps(visible);
+    }
+#endif
+}
+
+
+// Test an array of spheres against a frustum
+void FrustumCullSpheres(const CFrustum& frustum, const float* centreX, const float* centreY, const float* centreZ,
+                        const float* radius, std::size_t count, std::uint8_t* visible)
+{
+    std::size_t i = 0;
+
+#if defined(MATH_SIMD_AVX)
+    const FrustumLanes f(frustum);
+    const __m256 signMask = _mm256_set1_ps(-0.0f);
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 x = _mm256_loadu_ps(centreX + i);
+        __m256 y = _mm256_loadu_ps(centreY + i);
+        __m256 z = _mm256_loadu_ps(centreZ + i);
+        __m256 negRadius = _mm256_xor_ps(_mm256_loadu_ps(radius + i), signMask);
+
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int p = 0; p < CFrustum::NumPlanes; ++p)
+        {
+            __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, f.nx[p]), _mm256_mul_ps(y, f.ny[p])),
+                                                          _mm256_mul_ps(z, f.nz[p])), f.d[p]);
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, negRadius, _CMP_GE_OQ));
+        }
+        StoreMask8(_mm256_movemask_ps(inside), visible + i);
+    }
+#elif defined(MATH_SIMD_SSE)
+    const FrustumLanes f(frustum);
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    for (; i + 8 <= count; i += 8)
+    {
+        for (std::size_t half = i; half < i + 8; half += 4)
+        {
+            __m128 negRadius = _mm_xor_ps(_mm_loadu_ps(radius + half), signMask);
+            int mask = SpheresVisible4(f, _mm_loadu_ps(centreX + half), _mm_loadu_ps(centreY + half), _mm_loadu_ps(centreZ + half), negRadius);
+            StoreMask4(mask, visible + half);
+        }
+    }
+#endif
+
+    for (; i < count; ++i)
+    {
+        visible[i] = IsVisible(frustum, CSphere{ { centreX[i], centreY[i], centreZ[i] }, radius[i] }) ? 1 : 0;
+    }
+}
+
+// Test an array of axis-aligned boxes against a frustum
+void FrustumCullAABBs(const CFrustum& frustum, const float* centreX, const float* centreY, const float* centreZ,
+                      const float* extentX, const float* extentY, const float* extentZ, std::size_t count, std::uint8_t* visible)
+{
+    std::size_t i = 0;
+
+#if defined(MATH_SIMD_AVX)
+    const FrustumLanes f(frustum);
+    const __m256 signMask = _mm256_set1_ps(-0.0f);
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 x  = _mm256_loadu_ps(centreX + i);
+        __m256 y  = _mm256_loadu_ps(centreY + i);
+        __m256 z  = _mm256_loadu_ps(centreZ + i);
+        __m256 ex = _mm256_loadu_ps(extentX + i);
+        __m256 ey = _mm256_loadu_ps(extentY + i);
+        __m256 ez = _mm256_loadu_ps(extentZ + i);
+
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int p = 0; p < CFrustum::NumPlanes; ++p)
+        {
+            __m256 reach = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ex, f.absNx[p]), _mm256_mul_ps(ey, f.absNy[p])), _mm256_mul_ps(ez, f.absNz[p]));
+            __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, f.nx[p]), _mm256_mul_ps(y, f.ny[p])),
+                                                          _mm256_mul_ps(z, f.nz[p])), f.d[p]);
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, _mm256_xor_ps(reach, signMask), _CMP_GE_OQ));
+        }
+        StoreMask8(_mm256_movemask_ps(inside), visible + i);
+    }
+#elif defined(MATH_SIMD_SSE)
+    const FrustumLanes f(frustum);
+    for (; i + 8 <= count; i += 8)
+    {
+        for (std::size_t half = i; half < i + 8; half += 4)
+        {
+            int mask = AABBsVisible4(f, _mm_loadu_ps(centreX + half), _mm_loadu_ps(centreY + half), _mm_loadu_ps(centreZ + half),
+                                        _mm_loadu_ps(extentX + half), _mm_loadu_ps(extentY + half), _mm_loadu_ps(extentZ + half));
+            StoreMask4(mask, visible + half);
+        }
+    }
+#endif
+
+    for (; i < count; ++i)
+    {
+        CVector3 centre = { centreX[i], centreY[i], centreZ[i] };
+        CVector3 extent = { extentX[i], extentY[i], extentZ[i] };
+        visible[i] = IsVisibleCentreExtent(frustum, centre, extent) ? 1 : 0;
+    }
+}
@@ -0,0 +1,113 @@
+//--------------------------------------------------------------------------------------
+// Bounding volumes (axis-aligned boxes and spheres), planes and view frustums for culling
+//--------------------------------------------------------------------------------------
+// Code in .cpp file
+// A frustum can be extracted from any view-projection matrix (e.g. Camera::ViewProjectionMatrix, or a spotlight's view
+// matrix multiplied by its projection matrix) and then used to find which objects can be seen.
+// For large numbers of objects use the batch functions at the end of the file, which test 8 objects per iteration
+
+#ifndef _BOUNDING_VOLUMES_H_DEFINED_
+#define _BOUNDING_VOLUMES_H_DEFINED_
+
+#include "CVector3.h"
+#include "CMatrix4x4.h"
+#include <cstddef>
+#include <cstdint>
+
+
+/*-----------------------------------------------------------------------------------------
+    Types
+-----------------------------------------------------------------------------------------*/
+
+// Axis-aligned bounding box, stored as minimum and maximum corners
+class CAABB
+{
+public:
+    CVector3 min;
+    CVector3 max;
+
+    CVector3 Centre() const  { return (min + max) * 0.5f; }
+    CVector3 Extent() const  { return (max - min) * 0.5f; } // Half the size in each axis
+};
+
+// Bounding sphere
+class CSphere
+{
+public:
+    CVector3 centre;
+    float    radius;
+};
+
+// Plane holding the points p where Dot(normal, p) + d = 0. Points on the side the normal faces have positive distance
+class CPlane
+{
+public:
+    CVector3 normal;
+    float    d;
+};
+
+// View frustum - six planes with normals facing inwards, so points inside the frustum have positive distance to all planes
+class CFrustum
+{
+public:
+    enum { Left, Right, Bottom, Top, Near, Far, NumPlanes };
+    CPlane planes[NumPlanes];
+};
+
+
+/*-----------------------------------------------------------------------------------------
+    Construction
+-----------------------------------------------------------------------------------------*/
+
+// Return the smallest axis-aligned box containing the given points (the stride is the number of bytes from one
+// point to the next, e.g. the vertex size in a vertex buffer). Count must be at least 1
+CAABB AABBFromPoints(const void* points, std::size_t stride, std::size_t count);
+
+// Return a sphere containing the given axis-aligned box (not necessarily the smallest sphere containing the original points)
+CSphere SphereFromAABB(const CAABB& box);
+
+// Return the axis-aligned box containing a box after it has been transformed by an affine matrix (e.g. model space
+// bounds to world space). The result can be larger than the tightest box around the transformed contents
+CAABB TransformAABB(const CAABB& box, const CMatrix4x4& m);
+
+// Return a sphere transformed by an affine matrix. The radius is scaled by the largest scale in the matrix
+CSphere TransformSphere(const CSphere& sphere, const CMatrix4x4& m);
+
+// Return the view frustum for a view-projection matrix (Direct3D style, depth range 0 to 1). Planes are normalised,
+// so plane distances are true distances. If the matrix includes a world matrix, the frustum is in that model's space
+CFrustum FrustumFromMatrix(const CMatrix4x4& viewProj);
+
+
+/*-----------------------------------------------------------------------------------------
+    Tests
+-----------------------------------------------------------------------------------------*/
+
+// Return the signed distance from a plane to a point, positive on the side the normal faces (if the plane is normalised)
+float PlaneDistance(const CPlane& plane, const CVector3& point);
+
+// Return true if a sphere is inside or crosses the frustum. Can return true for some spheres just outside near the
+// frustum corners, which is the usual trade-off for a fast test
+bool IsVisible(const CFrustum& frustum, const CSphere& sphere);
+
+// Return true if a box is inside or crosses the frustum. Can return true for some boxes just outside near the corners
+bool IsVisible(const CFrustum& frustum, const CAABB& box);
+
+
+/*-----------------------------------------------------------------------------------------
+    Batch tests
+-----------------------------------------------------------------------------------------*/
+// Objects are passed as separate arrays of each component (structure of arrays) so that 8 objects can be loaded into
+// SIMD registers together. Uses AVX (one register of 8) or SSE (two registers of 4) if available, see MathSIMD.h.
+// Sets visible[i] to 1 if object i passes the same test as IsVisible, 0 if not - results match IsVisible exactly
+
+// Test an array of spheres against a frustum
+void FrustumCullSpheres(const CFrustum& frustum, const float* centreX, const float* centreY, const float* centreZ,
+                        const float* radius, std::size_t count, std::uint8_t* visible);
+
+// Test an array of axis-aligned boxes against a frustum. Boxes are given as centres and extents (half sizes) - see
+// CAABB::Centre and CAABB::Extent
+void FrustumCullAABBs(const CFrustum& frustum, const float* centreX, const float* centreY, const float* centreZ,
+                      const float* extentX, const float* extentY, const float* extentZ, std::size_t count, std::uint8_t* visible);
+
+
+#endif // _BOUNDING_VOLUMES_H_DEFINED_
@@ -3,35 +3,82 @@
 //--------------------------------------------------------------------------------------
 
 #include "CMatrix4x4.h"
+#include "MathLanes.h"
 
 #include <algorithm>
+#include <cassert>
 
 /*-----------------------------------------------------------------------------------------
-    Member functions
+    SIMD multiplication
 -----------------------------------------------------------------------------------------*/
+// Each row of the result is a sum of the rows of m2 weighted by the elements of the matching row of m1.
+// Multiplies and adds are done in the same order as the scalar code, and without fused multiply-adds, so
+// results match the scalar version exactly. Loads all of m2 before writing any output and reads each row of
+// m1 before writing the same row of the output, so mOut can safely be the same object as m1 or m2
 
-// Set a single row (range 0-3) of the matrix using a CVector3. Fourth element left unchanged
-// Can be used to set position or x,y,z axes in a matrix
-void CMatrix4x4::SetRow(int iRow, const CVector3& v)
+#if defined(MATH_SIMD_AVX)
+
+// AVX version - two rows of the result per 256-bit register
+static void MatrixMultiplySIMD(const CMatrix4x4& m1, const CMatrix4x4& m2, CMatrix4x4& mOut)
 {
-    float* pfElts = &e00 + iRow * 4;
-    pfElts[0] = v.x;
-    pfElts[1] = v.y;
-    pfElts[2] = v.z;
+    const __m256 row0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&m2.e00));
+    const __m256 row1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&m2.e10));
+    const __m256 row2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&m2.e20));
+    const __m256 row3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&m2.e30));
+
+    float* out = &mOut.e00;
+    const float* in = &m1.e00;
+    for (int i = 0; i < 2; ++i)
+    {
+        __m256 a = _mm256_loadu_ps(in + i * 8); // Two rows of m1
+        __m256 r = _mm256_mul_ps(_mm256_shuffle_ps(a, a, _MM_SHUFFLE(0, 0, 0, 0)), row0);
+        r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_shuffle_ps(a, a, _MM_SHUFFLE(1, 1, 1, 1)), row1));
+        r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_shuffle_ps(a, a, _MM_SHUFFLE(2, 2, 2, 2)), row2));
+        r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_shuffle_ps(a, a, _MM_SHUFFLE(3, 3, 3, 3)), row3));
+        _mm256_storeu_ps(out + i * 8, r);
+    }
 }
 
-// Get a single row (range 0-3) of the matrix into a CVector3. Fourth element is ignored
-// Can be used to access position or x,y,z axes from a matrix
-CVector3 CMatrix4x4::GetRow(int iRow) const
+#elif defined(MATH_SIMD_SSE)
+
+// SSE version - one row of the result per 128-bit register
+static void MatrixMultiplySIMD(const CMatrix4x4& m1, const CMatrix4x4& m2, CMatrix4x4& mOut)
 {
-    const float* pfElts = &e00 + iRow * 4;
-    return CVector3(pfElts[0], pfElts[1], pfElts[2]);
+    const __m128 row0 = _mm_loadu_ps(&m2.e00);
+    const __m128 row1 = _mm_loadu_ps(&m2.e10);
+    const __m128 row2 = _mm_loadu_ps(&m2.e20);
+    const __m128 row3 = _mm_loadu_ps(&m2.e30);
+
+    float* out = &mOut.e00;
+    const float* in = &m1.e00;
+    for (int i = 0; i < 4; ++i)
+    {
+        __m128 a = _mm_loadu_ps(in + i * 4); // One row of m1
+        __m128 r = _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(0, 0, 0, 0)), row0);
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(1, 1, 1, 1)), row1));
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 2, 2, 2)), row2));
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 3, 3, 3)), row3));
+        _mm_storeu_ps(out + i * 4, r);
+    }
 }
 
+#endif
+
 
 // Post-multiply this matrix by the given one
 CMatrix4x4& CMatrix4x4::operator*=(const CMatrix4x4& m)
 {
+#if !defined(MATH_SIMD_NONE)
+    #if defined(MATH_VERIFY_SIMD)
+        CMatrix4x4 expected = MatrixMultiplyScalar(*this, m);
+    #endif
+
+    MatrixMultiplySIMD(*this, m, *this); // Safe to multiply in place, including multiplying by self
+
+    #if defined(MATH_VERIFY_SIMD)
+        assert(MatricesEqual(*this, expected, MATH_VERIFY_TOLERANCE) && "SIMD matrix multiply does not match scalar version");
+    #endif
+#else
     if (this == &m)
     {
         // Special case of multiplying by self - no copy optimisations so use binary version
@@ -73,6 +120,7 @@ CMatrix4x4& CMatrix4x4::operator*=(const CMatrix4x4& m)
         e31 = t1;
         e32 = t2;
     }
+#endif
     return *this;
 }
 
@@ -81,8 +129,32 @@ CMatrix4x4& CMatrix4x4::operator*=(const CMatrix4x4& m)
     Operators
 -----------------------------------------------------------------------------------------*/
 
-// Matrix-matrix multiplication
+// Matrix-matrix multiplication. Uses SSE or AVX when the build targets them (see MathSIMD.h), otherwise scalar code
 CMatrix4x4 operator*(const CMatrix4x4& m1, const CMatrix4x4& m2)
+{
+#if !defined(MATH_SIMD_NONE)
+    CMatrix4x4 mOut;
+    MatrixMultiplySIMD(m1, m2, mOut);
+
+    #if defined(MATH_VERIFY_SIMD)
+        assert(MatricesEqual(mOut, MatrixMultiplyScalar(m1, m2), MATH_VERIFY_TOLERANCE) && "SIMD matrix multiply does not match scalar version");
+    #endif
+
+    return mOut;
+#else
+    return MatrixMultiplyScalar(m1, m2);
+#endif
+}
+
+
+
+/*-----------------------------------------------------------------------------------------
+    Verification
+-----------------------------------------------------------------------------------------*/
+
+// Matrix-matrix multiplication using portable scalar code only, whatever SIMD support is available
+// This is the reference that the SIMD versions of operator* and operator*= are compared against
+CMatrix4x4 MatrixMultiplyScalar(const CMatrix4x4& m1, const CMatrix4x4& m2)
 {
     CMatrix4x4 mOut;
 
@@ -109,6 +181,18 @@ CMatrix4x4 operator*(const CMatrix4x4& m1, const CMatrix4x4& m2)
     return mOut;
 }
 
+// Returns true if every element of the two matrices differs by no more than the given tolerance (0 = bit-exact)
+bool MatricesEqual(const CMatrix4x4& m1, const CMatrix4x4& m2, float tolerance /*= 0.0f*/)
+{
+    const float* p1 = &m1.e00;
+    const float* p2 = &m2.e00;
+    for (int i = 0; i < 16; ++i)
+    {
+        if (!(std::abs(p1[i] - p2[i]) <= tolerance) && p1[i] != p2[i])  return false; // Second test allows matching infinities
+    }
+    return true;
+}
+
 
 
 /*-----------------------------------------------------------------------------------------
@@ -119,25 +203,6 @@ CMatrix4x4 operator*(const CMatrix4x4& m1, const CMatrix4x4& m2)
 // They can be used as temporaries in calculations, e.g.
 //     CMatrix4x4 m = MatrixScaling( 3.0f ) * MatrixTranslation( CVector3(10.0f, -10.0f, 20.0f) );
 
-// Return an identity matrix
-CMatrix4x4 MatrixIdentity()
-{
-    return CMatrix4x4{ 1, 0, 0, 0,
-                       0, 1, 0, 0,
-                       0, 0, 1, 0,
-                       0, 0, 0, 1 };
-}
-
-// Return a translation matrix of the given vector
-CMatrix4x4 MatrixTranslation(const CVector3& t)
-{
-    return CMatrix4x4  { 1,   0,   0,  0,
-                         0,   1,   0,  0,
-                         0,   0,   1,  0,
-                       t.x, t.y, t.z,  1 };
-}
-
-
 // Return an X-axis rotation matrix of the given angle (in radians)
 CMatrix4x4 MatrixRotationX(float x)
 {
@@ -175,24 +240,188 @@ CMatrix4x4 MatrixRotationZ(float z)
 }
 
 
-// Return a matrix that is a scaling in X,Y and Z of the values in the given vector
-CMatrix4x4 MatrixScaling(const CVector3& s)
+// Return a world matrix that scales, rotates (Euler angles in radians, Z then X then Y) and then translates. Same result as
+//     MatrixScaling(s) * MatrixRotationZ(r.z) * MatrixRotationX(r.x) * MatrixRotationY(r.y) * MatrixTranslation(t)
+// but the matrix is written out directly, saving four matrix multiplies and three of the sin/cos calculations
+CMatrix4x4 MatrixTRS(const CVector3& t, const CVector3& r, const CVector3& s /*= { 1, 1, 1 }*/)
+{
+    float sX, cX, sY, cY, sZ, cZ;
+    SinCos(r.x, &sX, &cX);
+    SinCos(r.y, &sY, &cY);
+    SinCos(r.z, &sZ, &cZ);
+
+    // Rotation rows multiplied out from Z * X * Y, then each row scaled by the matching scale component
+    float sXsY = sX * sY;
+    float sXcY = sX * cY;
+
+    return CMatrix4x4{ s.x * (cZ * cY + sZ * sXsY),  s.x * sZ * cX,  s.x * (sZ * sXcY - cZ * sY),  0,
+                       s.y * (cZ * sXsY - sZ * cY),  s.y * cZ * cX,  s.y * (sZ * sY + cZ * sXcY),  0,
+                       s.z * cX * sY,               -s.z * sX,       s.z * cX * cY,                0,
+                       t.x,                          t.y,            t.z,                          1 };
+}
+
+
+/*-----------------------------------------------------------------------------------------
+    Inverses
+-----------------------------------------------------------------------------------------*/
+// The inverse calculations are written once as templates over a "lane" type. Using float gives the usual single
+// matrix version. Using a SIMD lane type, where each lane holds the same element from a different matrix, inverts
+// 4 (SSE) or 8 (AVX) matrices at once with exactly the same sequence of operations. The templates take the 16
+// matrix elements in row order
+
+// Inverse of an affine matrix (right column 0,0,0,1)
+template <class T>
+static void InverseAffineLanes(const T* m, T* mOut)
+{
+    // Calculate determinant of upper left 3x3
+    T det0 = m[5]*m[10] - m[6]*m[9];
+    T det1 = m[6]*m[8]  - m[4]*m[10];
+    T det2 = m[4]*m[9]  - m[5]*m[8];
+    T det  = m[0]*det0 + m[1]*det1 + m[2]*det2;
+
+    // Calculate inverse of upper left 3x3
+    T invDet = T(1.0f) / det;
+    mOut[0] = invDet * det0;
+    mOut[4] = invDet * det1;
+    mOut[8] = invDet * det2;
+
+    mOut[1] = invDet * (m[9]*m[2]  - m[10]*m[1]);
+    mOut[5] = invDet * (m[10]*m[0] - m[8]*m[2]);
+    mOut[9] = invDet * (m[8]*m[1]  - m[9]*m[0]);
+
+    mOut[2]  = invDet * (m[1]*m[6] - m[2]*m[5]);
+    mOut[6]  = invDet * (m[2]*m[4] - m[0]*m[6]);
+    mOut[10] = invDet * (m[0]*m[5] - m[1]*m[4]);
+
+    // Transform negative translation by inverted 3x3 to get inverse
+    mOut[12] = T(0.0f) - m[12]*mOut[0] - m[13]*mOut[4] - m[14]*mOut[8];
+    mOut[13] = T(0.0f) - m[12]*mOut[1] - m[13]*mOut[5] - m[14]*mOut[9];
+    mOut[14] = T(0.0f) - m[12]*mOut[2] - m[13]*mOut[6] - m[14]*mOut[10];
+
+    // Fill in right column for affine matrix
+    mOut[3]  = T(0.0f);
+    mOut[7]  = T(0.0f);
+    mOut[11] = T(0.0f);
+    mOut[15] = T(1.0f);
+}
+
+// Inverse of a general matrix, using the 2x2 sub-determinants of the top two and bottom two rows (Laplace expansion)
+template <class T>
+static void InverseLanes(const T* m, T* mOut)
+{
+    T s0 = m[0]*m[5] - m[4]*m[1];
+    T s1 = m[0]*m[6] - m[4]*m[2];
+    T s2 = m[0]*m[7] - m[4]*m[3];
+    T s3 = m[1]*m[6] - m[5]*m[2];
+    T s4 = m[1]*m[7] - m[5]*m[3];
+    T s5 = m[2]*m[7] - m[6]*m[3];
+
+    T c5 = m[10]*m[15] - m[14]*m[11];
+    T c4 = m[9]*m[15]  - m[13]*m[11];
+    T c3 = m[9]*m[14]  - m[13]*m[10];
+    T c2 = m[8]*m[15]  - m[12]*m[11];
+    T c1 = m[8]*m[14]  - m[12]*m[10];
+    T c0 = m[8]*m[13]  - m[12]*m[9];
+
+    T det = s0*c5 - s1*c4 + s2*c3 + s3*c2 - s4*c1 + s5*c0;
+    T invDet = T(1.0f) / det;
+
+    mOut[0]  = (m[5]*c5  - m[6]*c4  + m[7]*c3)  * invDet;
+    mOut[1]  = (m[2]*c4  - m[1]*c5  - m[3]*c3)  * invDet;
+    mOut[2]  = (m[13]*s5 - m[14]*s4 + m[15]*s3) * invDet;
+    mOut[3]  = (m[10]*s4 - m[9]*s5  - m[11]*s3) * invDet;
+
+    mOut[4]  = (m[6]*c2  - m[4]*c5  - m[7]*c1)  * invDet;
+    mOut[5]  = (m[0]*c5  - m[2]*c2  + m[3]*c1)  * invDet;
+    mOut[6]  = (m[14]*s2 - m[12]*s5 - m[15]*s1) * invDet;
+    mOut[7]  = (m[8]*s5  - m[10]*s2 + m[11]*s1) * invDet;
+
+    mOut[8]  = (m[4]*c4  - m[5]*c2  + m[7]*c0)  * invDet;
+    mOut[9]  = (m[1]*c2  - m[0]*c4  - m[3]*c0)  * invDet;
+    mOut[10] = (m[12]*s4 - m[13]*s2 + m[15]*s0) * invDet;
+    mOut[11] = (m[9]*s2  - m[8]*s4  - m[11]*s0) * invDet;
+
+    mOut[12] = (m[5]*c1  - m[4]*c3  - m[6]*c0)  * invDet;
+    mOut[13] = (m[0]*c3  - m[1]*c1  + m[2]*c0)  * invDet;
+    mOut[14] = (m[13]*s1 - m[12]*s3 - m[14]*s0) * invDet;
+    mOut[15] = (m[8]*s3  - m[9]*s1  + m[10]*s0) * invDet;
+}
+
+
+#if !defined(MATH_SIMD_NONE)
+
+// Lane types are in MathLanes.h, here each lane holds an element from a different matrix
+
+// Transpose 4 matrices into 16 lanes, lane i holding element i of each matrix
+static void LoadLanes(const CMatrix4x4* m, Lanes4* lanes)
 {
-    return CMatrix4x4{ s.x,   0,   0,  0,
-                       0,   s.y,   0,  0,
-                       0,     0, s.z,  0,
-                       0,     0,   0,  1 };
+    for (int row = 0; row < 4; ++row)
+    {
+        __m128 m0 = _mm_loadu_ps(&m[0].e00 + row * 4);
+        __m128 m1 = _mm_loadu_ps(&m[1].e00 + row * 4);
+        __m128 m2 = _mm_loadu_ps(&m[2].e00 + row * 4);
+        __m128 m3 = _mm_loadu_ps(&m[3].e00 + row * 4);
+        _MM_TRANSPOSE4_PS(m0, m1, m2, m3);
+        lanes[row * 4 + 0] = m0;
+        lanes[row * 4 + 1] = m1;
+        lanes[row * 4 + 2] = m2;
+        lanes[row * 4 + 3] = m3;
+    }
 }
 
-// Return a matrix that is a uniform scaling of the given amount
-CMatrix4x4 MatrixScaling(const float s)
+// Reverse of LoadLanes, write 16 lanes back out as 4 matrices
+static void StoreLanes(const Lanes4* lanes, CMatrix4x4* m)
 {
-    return CMatrix4x4{ s, 0, 0, 0,
-                       0, s, 0, 0,
-                       0, 0, s, 0,
-                       0, 0, 0, 1 };
+    for (int row = 0; row < 4; ++row)
+    {
+        __m128 m0 = lanes[row * 4 + 0].v;
+        __m128 m1 = lanes[row * 4 + 1].v;
+        __m128 m2 = lanes[row * 4 + 2].v;
+        __m128 m3 = lanes[row * 4 + 3].v;
+        _MM_TRANSPOSE4_PS(m0, m1, m2, m3);
+        _mm_storeu_ps(&m[0].e00 + row * 4, m0);
+        _mm_storeu_ps(&m[1].e00 + row * 4, m1);
+        _mm_storeu_ps(&m[2].e00 + row * 4, m2);
+        _mm_storeu_ps(&m[3].e00 + row * 4, m3);
+    }
 }
 
+#endif
+
+#if defined(MATH_SIMD_AVX)
+
+// Transpose 8 matrices into 16 lanes - two groups of 4 transposed as for SSE then combined
+static void LoadLanes(const CMatrix4x4* m, Lanes8* lanes)
+{
+    Lanes4 low[16], high[16];
+    LoadLanes(m, low);
+    LoadLanes(m + 4, high);
+    for (int i = 0; i < 16; ++i)
+    {
+        lanes[i] = _mm256_insertf128_ps(_mm256_castps128_ps256(low[i].v), high[i].v, 1);
+    }
+}
+
+static void StoreLanes(const Lanes8* lanes, CMatrix4x4* m)
+{
+    Lanes4 low[16], high[16];
+    for (int i = 0; i < 16; ++i)
+    {
+        low[i]  = _mm256_castps256_ps128(lanes[i].v);
+        high[i] = _mm256_extractf128_ps(lanes[i].v, 1);
+    }
+    StoreLanes(low, m);
+    StoreLanes(high, m + 4);
+}
+
+using BatchLanes = Lanes8;
+
+#elif defined(MATH_SIMD_SSE)
+
+using BatchLanes = Lanes4;
+
+#endif
+
 
 // Return the inverse of given matrix assuming that it is an affine matrix
 // Advanced calulation needed to get the view matrix from the camera's positioning matrix
@@ -200,38 +429,95 @@ CMatrix4x4 InverseAffine(const CMatrix4x4& m)
 {
     CMatrix4x4 mOut;
 
-    // Calculate determinant of upper left 3x3
-    float det0 = m.e11*m.e22 - m.e12*m.e21;
-    float det1 = m.e12*m.e20 - m.e10*m.e22;
-    float det2 = m.e10*m.e21 - m.e11*m.e20;
-    float det = m.e00*det0 + m.e01*det1 + m.e02*det2;
+#if !defined(MATH_SIMD_NONE)
+    // The inverse of the upper 3x3 has columns that are cross products of its rows, divided by the determinant
+    const __m128 row0 = _mm_loadu_ps(&m.e00);
+    const __m128 row1 = _mm_loadu_ps(&m.e10);
+    const __m128 row2 = _mm_loadu_ps(&m.e20);
+    const __m128 translation = _mm_loadu_ps(&m.e30);
 
-    // Calculate inverse of upper left 3x3
-    float invDet = 1.0f / det;
-    mOut.e00 = invDet * det0;
-    mOut.e10 = invDet * det1;
-    mOut.e20 = invDet * det2;
+    // Cross product of xyz, w component of the result is always 0
+    auto cross = [](__m128 a, __m128 b)
+    {
+        __m128 aYZX = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+        __m128 bYZX = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+        __m128 c = _mm_sub_ps(_mm_mul_ps(a, bYZX), _mm_mul_ps(aYZX, b));
+        return _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1));
+    };
+    __m128 col0 = cross(row1, row2);
+    __m128 col1 = cross(row2, row0);
+    __m128 col2 = cross(row0, row1);
+    __m128 col3 = _mm_setzero_ps();
+
+    // Determinant is dot product of first row with first column - sum of products, w is zero
+    __m128 products = _mm_mul_ps(row0, col0);
+    __m128 sum = _mm_add_ps(products, _mm_shuffle_ps(products, products, _MM_SHUFFLE(2, 3, 0, 1)));
+    __m128 det = _mm_add_ps(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    __m128 invDet = _mm_div_ps(_mm_set1_ps(1.0f), det);
+
+    // Transpose columns into rows of the inverted 3x3, right column becomes 0
+    _MM_TRANSPOSE4_PS(col0, col1, col2, col3);
+    __m128 out0 = _mm_mul_ps(col0, invDet);
+    __m128 out1 = _mm_mul_ps(col1, invDet);
+    __m128 out2 = _mm_mul_ps(col2, invDet);
+
+    // Transform negative translation by inverted 3x3 and set the bottom-right element to 1
+    __m128 t = _mm_mul_ps(_mm_shuffle_ps(translation, translation, _MM_SHUFFLE(0, 0, 0, 0)), out0);
+    t = _mm_add_ps(t, _mm_mul_ps(_mm_shuffle_ps(translation, translation, _MM_SHUFFLE(1, 1, 1, 1)), out1));
+    t = _mm_add_ps(t, _mm_mul_ps(_mm_shuffle_ps(translation, translation, _MM_SHUFFLE(2, 2, 2, 2)), out2));
+    __m128 out3 = _mm_sub_ps(_mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f), t); // w of t is 0
+
+    _mm_storeu_ps(&mOut.e00, out0);
+    _mm_storeu_ps(&mOut.e10, out1);
+    _mm_storeu_ps(&mOut.e20, out2);
+    _mm_storeu_ps(&mOut.e30, out3);
+#else
+    InverseAffineLanes(&m.e00, &mOut.e00);
+#endif
 
-    mOut.e01 = invDet * (m.e21*m.e02 - m.e22*m.e01);
-    mOut.e11 = invDet * (m.e22*m.e00 - m.e20*m.e02);
-    mOut.e21 = invDet * (m.e20*m.e01 - m.e21*m.e00);
+    return mOut;
+}
 
-    mOut.e02 = invDet * (m.e01*m.e12 - m.e02*m.e11);
-    mOut.e12 = invDet * (m.e02*m.e10 - m.e00*m.e12);
-    mOut.e22 = invDet * (m.e00*m.e11 - m.e01*m.e10);
 
-    // Transform negative translation by inverted 3x3 to get inverse
-    mOut.e30 = -m.e30*mOut.e00 - m.e31*mOut.e10 - m.e32*mOut.e20;
-    mOut.e31 = -m.e30*mOut.e01 - m.e31*mOut.e11 - m.e32*mOut.e21;
-    mOut.e32 = -m.e30*mOut.e02 - m.e31*mOut.e12 - m.e32*mOut.e22;
+// Return the inverse of a general 4x4 matrix (e.g. a view-projection matrix). Result is undefined for singular matrices
+CMatrix4x4 Inverse(const CMatrix4x4& m)
+{
+    CMatrix4x4 mOut;
+    InverseLanes(&m.e00, &mOut.e00);
+    return mOut;
+}
 
-    // Fill in right column for affine matrix
-    mOut.e03 = 0.0f;
-    mOut.e13 = 0.0f;
-    mOut.e23 = 0.0f;
-    mOut.e33 = 1.0f;
 
-    return mOut;
+// Invert an array of affine matrices, e.g. to get view matrices from the world matrices of many lights or cameras.
+// The input and output arrays can be the same. Each matrix is inverted with the SIMD InverseAffine - it is too little
+// work for transposing groups of matrices into lanes (as InverseArray does) to pay for itself
+void InverseAffineArray(const CMatrix4x4* matrices, CMatrix4x4* inverses, std::size_t count)
+{
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        inverses[i] = InverseAffine(matrices[i]);
+    }
+}
+
+// Invert an array of general matrices, e.g. to get inverse view-projection matrices for many lights or cameras.
+// Processes 4 (SSE) or 8 (AVX) matrices at a time. The input and output arrays can be the same
+void InverseArray(const CMatrix4x4* matrices, CMatrix4x4* inverses, std::size_t count)
+{
+    std::size_t i = 0;
+#if !defined(MATH_SIMD_NONE)
+    const std::size_t batchSize = sizeof(BatchLanes) / sizeof(float);
+    for (; i + batchSize <= count; i += batchSize)
+    {
+        BatchLanes m[16], mOut[16];
+        LoadLanes(matrices + i, m);
+        InverseLanes(m, mOut);
+        StoreLanes(mOut, inverses + i);
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        inverses[i] = Inverse(matrices[i]);
+    }
 }
 
 
@@ -259,9 +545,9 @@ void CMatrix4x4::FaceTarget(const CVector3& target)
 CVector3 CMatrix4x4::GetEulerAngles()
 {
     // Calculate matrix scaling
-    float scaleX = sqrt(e00 * e00 + e01 * e01 + e02 * e02);
-    float scaleY = sqrt(e10 * e10 + e11 * e11 + e12 * e12);
-    float scaleZ = sqrt(e20 * e20 + e21 * e21 + e22 * e22);
+    float scaleX = std::sqrt(e00 * e00 + e01 * e01 + e02 * e02);
+    float scaleY = std::sqrt(e10 * e10 + e11 * e11 + e12 * e12);
+    float scaleZ = std::sqrt(e20 * e20 + e21 * e21 + e22 * e22);
 
     // Calculate inverse scaling to extract rotational values only
     float invScaleX = 1.0f / scaleX;
@@ -271,10 +557,10 @@ CVector3 CMatrix4x4::GetEulerAngles()
     float sX, cX, sY, cY, sZ, cZ;
 
     sX = -e21 * invScaleZ;
-    cX = sqrt(1.0f - sX * sX);
+    cX = std::sqrt(1.0f - sX * sX);
 
     // If no gimbal lock...
-    if (abs(cX) > 0.001f)
+    if (std::abs(cX) > 0.001f)
     {
         float invCX = 1.0f / cX;
         sZ = e01 * invCX * invScaleX;
@@ -291,7 +577,7 @@ CVector3 CMatrix4x4::GetEulerAngles()
         cY = e00 * invScaleX;
     }
 
-    return { atan2(sX, cX), atan2(sY, cY), atan2(sZ, cZ) };
+    return { std::atan2(sX, cX), std::atan2(sY, cY), std::atan2(sZ, cZ) };
 }
 
 // Transpose the matrix (rows become columns). There are two ways to store a matrix, by rows or by columns.
@@ -1,13 +1,16 @@
 //--------------------------------------------------------------------------------------
 // Matrix4x4 class (cut down version) to hold matrices for 3D
 //--------------------------------------------------------------------------------------
-// Code in .cpp file
+// Code in .cpp file, except for short functions that build simple matrices, which are constexpr so they can be used in
+// compile-time constants
 
 #ifndef _CMATRIX4X4_H_DEFINED_
 #define _CMATRIX4X4_H_DEFINED_
 
 #include "CVector3.h"
+#include "MathSIMD.h"
 #include <cmath>
+#include <cstddef>
 
 
 // Matrix class
@@ -28,11 +31,21 @@ public:
 
 	// Set a single row (range 0-3) of the matrix using a CVector3. Fourth element left unchanged
     // Can be used to set position or x,y,z axes in a matrix
-    void SetRow(int iRow, const CVector3& v);
+    void SetRow(int iRow, const CVector3& v)
+    {
+        float* pfElts = &e00 + iRow * 4;
+        pfElts[0] = v.x;
+        pfElts[1] = v.y;
+        pfElts[2] = v.z;
+    }
 
     // Get a single row (range 0-3) of the matrix into a CVector3. Fourth element is ignored
     // Can be used to access position or x,y,z axes from a matrix
-    CVector3 GetRow(int iRow) const;
+    CVector3 GetRow(int iRow) const
+    {
+        const float* pfElts = &e00 + iRow * 4;
+        return CVector3(pfElts[0], pfElts[1], pfElts[2]);
+    }
 
     void SetValues(float* matrixValues) { *this = *reinterpret_cast<CMatrix4x4*>(matrixValues); }
 
@@ -63,10 +76,30 @@ public:
     Operators
 -----------------------------------------------------------------------------------------*/
 
-// Matrix-matrix multiplication
+// Matrix-matrix multiplication. Uses SSE or AVX when the build targets them (see MathSIMD.h), otherwise scalar code
+// Define MATH_VERIFY_SIMD to check every SIMD multiply against the scalar version below (asserts on mismatch)
 CMatrix4x4 operator*(const CMatrix4x4& m1, const CMatrix4x4& m2);
 
 
+/*-----------------------------------------------------------------------------------------
+    Verification
+-----------------------------------------------------------------------------------------*/
+
+// Tolerance used by MATH_VERIFY_SIMD. The SIMD code does the same multiplies and adds in the same order as the
+// scalar code so results are normally bit-exact (0). Raise this if the compiler is allowed to contract the scalar
+// code into fused multiply-adds (e.g. gcc's -ffp-contract=fast)
+#ifndef MATH_VERIFY_TOLERANCE
+#define MATH_VERIFY_TOLERANCE 0.0f
+#endif
+
+// Matrix-matrix multiplication using portable scalar code only, whatever SIMD support is available
+// This is the reference that the SIMD versions of operator* and operator*= are compared against
+CMatrix4x4 MatrixMultiplyScalar(const CMatrix4x4& m1, const CMatrix4x4& m2);
+
+// Returns true if every element of the two matrices differs by no more than the given tolerance (0 = bit-exact)
+bool MatricesEqual(const CMatrix4x4& m1, const CMatrix4x4& m2, float tolerance = 0.0f);
+
+
 /*-----------------------------------------------------------------------------------------
   Non-member functions
 -----------------------------------------------------------------------------------------*/
@@ -76,10 +109,22 @@ CMatrix4x4 operator*(const CMatrix4x4& m1, const CMatrix4x4& m2);
 //     CMatrix4x4 m = MatrixScaling( 3.0f ) * MatrixTranslation( CVector3(10.0f, -10.0f, 20.0f) );
 
 // Return an identity matrix
-CMatrix4x4 MatrixIdentity();
+constexpr CMatrix4x4 MatrixIdentity()
+{
+    return CMatrix4x4{ 1, 0, 0, 0,
+                       0, 1, 0, 0,
+                       0, 0, 1, 0,
+                       0, 0, 0, 1 };
+}
 
 // Return a translation matrix of the given vector
-CMatrix4x4 MatrixTranslation(const CVector3& t);
+constexpr CMatrix4x4 MatrixTranslation(const CVector3& t)
+{
+    return CMatrix4x4  { 1,   0,   0,  0,
+                         0,   1,   0,  0,
+                         0,   0,   1,  0,
+                       t.x, t.y, t.z,  1 };
+}
 
 
 // Return an X-axis rotation matrix of the given angle (in radians)
@@ -93,10 +138,42 @@ CMatrix4x4 MatrixRotationZ(float z);
 
 
 // Return a matrix that is a scaling in X,Y and Z of the values in the given vector
-CMatrix4x4 MatrixScaling(const CVector3& s);
+constexpr CMatrix4x4 MatrixScaling(const CVector3& s)
+{
+    return CMatrix4x4{ s.x,   0,   0,  0,
+                       0,   s.y,   0,  0,
+                       0,     0, s.z,  0,
+                       0,     0,   0,  1 };
+}
 
 // Return a matrix that is a uniform scaling of the given amount
-CMatrix4x4 MatrixScaling(const float s);
+constexpr CMatrix4x4 MatrixScaling(const float s)
+{
+    return CMatrix4x4{ s, 0, 0, 0,
+                       0, s, 0, 0,
+                       0, 0, s, 0,
+                       0, 0, 0, 1 };
+}
+
+
+// Return a perspective projection matrix (Direct3D style, depth range 0 to 1). Pass the aspect ratio (width / height),
+// the tangent of half the horizontal field of view, and the near and far clip distances. Taking the tangent rather than
+// the angle keeps this constexpr - use ConstexprTan for compile-time constants, otherwise std::tan, e.g.
+//     constexpr CMatrix4x4 projection = MatrixPerspective(1.0f, ConstexprTan(ToRadians(90.0f) * 0.5f), 0.1f, 1000.0f);
+constexpr CMatrix4x4 MatrixPerspective(float aspectRatio, float tanHalfFOVx, float nearClip, float farClip)
+{
+    // Written as single expressions so the layout is visible, the compiler will share the common parts
+    return CMatrix4x4{ 1.0f / tanHalfFOVx,  0.0f,                       0.0f,                                          0.0f,
+                       0.0f,                aspectRatio / tanHalfFOVx,  0.0f,                                          0.0f,
+                       0.0f,                0.0f,                       farClip / (farClip - nearClip),                1.0f,
+                       0.0f,                0.0f,                       -nearClip * (farClip / (farClip - nearClip)),  0.0f };
+}
+
+
+// Return a world matrix that scales, rotates (Euler angles in radians, Z then X then Y) and then translates. Same result as
+//     MatrixScaling(s) * MatrixRotationZ(r.z) * MatrixRotationX(r.x) * MatrixRotationY(r.y) * MatrixTranslation(t)
+// but the matrix is written out directly, saving four matrix multiplies and three of the sin/cos calculations
+CMatrix4x4 MatrixTRS(const CVector3& t, const CVector3& r, const CVector3& s = { 1, 1, 1 });
 
 
 
@@ -104,5 +181,16 @@ CMatrix4x4 MatrixScaling(const float s);
 // Advanced calulation needed to get the view matrix from the camera's positioning matrix
 CMatrix4x4 InverseAffine(const CMatrix4x4& m);
 
+// Return the inverse of a general 4x4 matrix (e.g. a view-projection matrix). Result is undefined for singular matrices
+CMatrix4x4 Inverse(const CMatrix4x4& m);
+
+// Invert an array of affine matrices, e.g. to get view matrices from the world matrices of many lights or cameras.
+// The input and output arrays can be the same
+void InverseAffineArray(const CMatrix4x4* matrices, CMatrix4x4* inverses, std::size_t count);
+
+// Invert an array of general matrices, e.g. to get inverse view-projection matrices for many lights or cameras.
+// Processes 4 (SSE) or 8 (AVX) matrices at a time. The input and output arrays can be the same
+void InverseArray(const CMatrix4x4* matrices, CMatrix4x4* inverses, std::size_t count);
+
 
 #endif // _CMATRIX4X4_H_DEFINED_
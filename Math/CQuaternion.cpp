@@ -0,0 +1,214 @@
+//--------------------------------------------------------------------------------------
+// Quaternion class (cut down version) to hold rotations
+//--------------------------------------------------------------------------------------
+
+#include "CQuaternion.h"
+
+#include <algorithm>
+
+
+/*-----------------------------------------------------------------------------------------
+    Member functions
+-----------------------------------------------------------------------------------------*/
+
+// Combine another rotation with this one, i.e. rotate by this quaternion then by q
+CQuaternion& CQuaternion::operator*= (const CQuaternion& q)
+{
+    *this = *this * q;
+    return *this;
+}
+
+
+/*-----------------------------------------------------------------------------------------
+    Non-member operators
+-----------------------------------------------------------------------------------------*/
+
+// Combine two rotations - the result rotates by q1 then by q2 (same order as matrix multiplication)
+// This is the standard quaternion product q2q1, written in the reverse order to match the row-vector matrices
+CQuaternion operator* (const CQuaternion& q1, const CQuaternion& q2)
+{
+    return CQuaternion{ q2.w * q1.x + q2.x * q1.w + q2.y * q1.z - q2.z * q1.y,
+                        q2.w * q1.y - q2.x * q1.z + q2.y * q1.w + q2.z * q1.x,
+                        q2.w * q1.z + q2.x * q1.y - q2.y * q1.x + q2.z * q1.w,
+                        q2.w * q1.w - q2.x * q1.x - q2.y * q1.y - q2.z * q1.z };
+}
+
+
+/*-----------------------------------------------------------------------------------------
+    Non-member functions
+-----------------------------------------------------------------------------------------*/
+
+// Return the identity quaternion (no rotation)
+CQuaternion QuaternionIdentity()
+{
+    return CQuaternion{ 0, 0, 0, 1 };
+}
+
+// Return a quaternion rotating by the given angle (in radians) around the given axis (which must be unit length)
+CQuaternion QuaternionRotationAxis(const CVector3& axis, float angle)
+{
+    float s, c;
+    SinCos(angle * 0.5f, &s, &c);
+    return CQuaternion{ axis.x * s, axis.y * s, axis.z * s, c };
+}
+
+// Return a quaternion holding the same rotation as the given Euler angles (in radians, Z then X then Y)
+CQuaternion QuaternionFromEuler(const CVector3& r)
+{
+    float sX, cX, sY, cY, sZ, cZ;
+    SinCos(r.x * 0.5f, &sX, &cX);
+    SinCos(r.y * 0.5f, &sY, &cY);
+    SinCos(r.z * 0.5f, &sZ, &cZ);
+
+    // Rotations around each axis multiplied out in the order Z, X, Y
+    return CQuaternion{ cY * sX * cZ + sY * cX * sZ,
+                        sY * cX * cZ - cY * sX * sZ,
+                        cY * cX * sZ - sY * sX * cZ,
+                        cY * cX * cZ + sY * sX * sZ };
+}
+
+// Return the rotation held in a matrix as a quaternion. Scaling in the matrix is removed
+CQuaternion QuaternionFromMatrix(const CMatrix4x4& m)
+{
+    // Remove scaling from the rotation part of the matrix
+    CVector3 axisX = Normalise(m.GetXAxis());
+    CVector3 axisY = Normalise(m.GetYAxis());
+    CVector3 axisZ = Normalise(m.GetZAxis());
+
+    // Use the largest of w, x, y or z to calculate the others, for best accuracy
+    float trace = axisX.x + axisY.y + axisZ.z;
+    if (trace > 0.0f)
+    {
+        float s = 0.5f * InvSqrt(trace + 1.0f);
+        return CQuaternion{ (axisY.z - axisZ.y) * s, (axisZ.x - axisX.z) * s, (axisX.y - axisY.x) * s, 0.25f / s };
+    }
+    else if (axisX.x > axisY.y && axisX.x > axisZ.z)
+    {
+        float s = 2.0f * std::sqrt(1.0f + axisX.x - axisY.y - axisZ.z);
+        float invS = 1.0f / s;
+        return CQuaternion{ 0.25f * s, (axisX.y + axisY.x) * invS, (axisX.z + axisZ.x) * invS, (axisY.z - axisZ.y) * invS };
+    }
+    else if (axisY.y > axisZ.z)
+    {
+        float s = 2.0f * std::sqrt(1.0f + axisY.y - axisX.x - axisZ.z);
+        float invS = 1.0f / s;
+        return CQuaternion{ (axisX.y + axisY.x) * invS, 0.25f * s, (axisY.z + axisZ.y) * invS, (axisZ.x - axisX.z) * invS };
+    }
+    else
+    {
+        float s = 2.0f * std::sqrt(1.0f + axisZ.z - axisX.x - axisY.y);
+        float invS = 1.0f / s;
+        return CQuaternion{ (axisX.z + axisZ.x) * invS, (axisY.z + axisZ.y) * invS, 0.25f * s, (axisX.y - axisY.x) * invS };
+    }
+}
+
+// Return the rotation held in a quaternion as Euler angles (in radians, Z then X then Y). The quaternion must be unit length
+CVector3 EulerFromQuaternion(const CQuaternion& q)
+{
+    // Only the matrix elements needed are calculated, then the angles are found as in CMatrix4x4::GetEulerAngles
+    // (no scaling to remove here, and the divisions by cos X cancel out inside atan2)
+    float sX = std::min(std::max(-2.0f * (q.y * q.z - q.w * q.x), -1.0f), 1.0f); // -e21
+    float cX = std::sqrt(1.0f - sX * sX);
+
+    // If no gimbal lock...
+    if (cX > 0.001f)
+    {
+        return { std::atan2(sX, cX),
+                 std::atan2(2.0f * (q.x * q.z + q.w * q.y), 1.0f - 2.0f * (q.x * q.x + q.y * q.y)),   // e20, e22
+                 std::atan2(2.0f * (q.x * q.y + q.w * q.z), 1.0f - 2.0f * (q.x * q.x + q.z * q.z)) }; // e01, e11
+    }
+    else
+    {
+        // Gimbal lock - force Z angle to 0
+        return { std::atan2(sX, cX),
+                 std::atan2(-2.0f * (q.x * q.z - q.w * q.y), 1.0f - 2.0f * (q.y * q.y + q.z * q.z)),  // -e02, e00
+                 0.0f };
+    }
+}
+
+// Return a rotation matrix holding the same rotation as the given unit quaternion
+CMatrix4x4 MatrixFromQuaternion(const CQuaternion& q)
+{
+    return MatrixTRS({ 0, 0, 0 }, q);
+}
+
+// Return a world matrix that scales, rotates by the given unit quaternion then translates
+CMatrix4x4 MatrixTRS(const CVector3& t, const CQuaternion& q, const CVector3& s /*= { 1, 1, 1 }*/)
+{
+    float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+    float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+    float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+
+    return CMatrix4x4{ s.x * (1.0f - 2.0f * (yy + zz)),  s.x * 2.0f * (xy + wz),           s.x * 2.0f * (xz - wy),           0,
+                       s.y * 2.0f * (xy - wz),           s.y * (1.0f - 2.0f * (xx + zz)),  s.y * 2.0f * (yz + wx),           0,
+                       s.z * 2.0f * (xz + wy),           s.z * 2.0f * (yz - wx),           s.z * (1.0f - 2.0f * (xx + yy)),  0,
+                       t.x,                              t.y,                              t.z,                              1 };
+}
+
+
+// Dot product of two quaternions - for unit quaternions this is the cosine of half the angle between the rotations
+float Dot(const CQuaternion& q1, const CQuaternion& q2)
+{
+    return q1.x * q2.x + q1.y * q2.y + q1.z * q2.z + q1.w * q2.w;
+}
+
+// Return unit length quaternion in the same direction as given one (identity if the given one is zero length)
+CQuaternion Normalise(const CQuaternion& q)
+{
+    float lengthSq = Dot(q, q);
+    if (IsZero(lengthSq))
+    {
+        return QuaternionIdentity();
+    }
+    else
+    {
+        float invLength = InvSqrt(lengthSq);
+        return CQuaternion{ q.x * invLength, q.y * invLength, q.z * invLength, q.w * invLength };
+    }
+}
+
+// Return the inverse of a unit quaternion, the opposite rotation
+CQuaternion Conjugate(const CQuaternion& q)
+{
+    return CQuaternion{ -q.x, -q.y, -q.z, q.w };
+}
+
+// Rotate a vector by a unit quaternion
+CVector3 Rotate(const CVector3& v, const CQuaternion& q)
+{
+    // Expanded form of q * v * conjugate(q) that saves around half the multiplies
+    CVector3 u = { q.x, q.y, q.z };
+    CVector3 t = 2.0f * Cross(u, v);
+    return v + q.w * t + Cross(u, t);
+}
+
+
+// Interpolate between two unit quaternions (t = 0 to 1), taking the shortest route. Normalised linear interpolation
+CQuaternion Nlerp(const CQuaternion& q1, const CQuaternion& q2, float t)
+{
+    // q and -q are the same rotation, flip q2 if needed to go the short way round
+    float t1 = 1.0f - t;
+    float t2 = Dot(q1, q2) < 0.0f ? -t : t;
+    return Normalise(CQuaternion{ q1.x * t1 + q2.x * t2, q1.y * t1 + q2.y * t2, q1.z * t1 + q2.z * t2, q1.w * t1 + q2.w * t2 });
+}
+
+// Interpolate between two unit quaternions (t = 0 to 1), taking the shortest route. Spherical linear interpolation
+CQuaternion Slerp(const CQuaternion& q1, const CQuaternion& q2, float t)
+{
+    float cosAngle = Dot(q1, q2);
+    float sign = 1.0f;
+    if (cosAngle < 0.0f)
+    {
+        cosAngle = -cosAngle;
+        sign = -1.0f;
+    }
+
+    // Very close rotations - sin(angle) below is near zero so use Nlerp instead, which is practically identical here
+    if (cosAngle > 0.9995f)  return Nlerp(q1, q2, t);
+
+    float angle = std::acos(cosAngle);
+    float invSin = 1.0f / std::sin(angle);
+    float t1 = std::sin((1.0f - t) * angle) * invSin;
+    float t2 = std::sin(t * angle) * invSin * sign;
+    return CQuaternion{ q1.x * t1 + q2.x * t2, q1.y * t1 + q2.y * t2, q1.z * t1 + q2.z * t2, q1.w * t1 + q2.w * t2 };
+}
@@ -0,0 +1,112 @@
+//--------------------------------------------------------------------------------------
+// Quaternion class (cut down version) to hold rotations
+//--------------------------------------------------------------------------------------
+// Code in .cpp file
+// A unit quaternion holds a rotation in 4 floats (compared to 9 in a matrix) and rotations can be combined and
+// smoothly interpolated without the gimbal lock problems of Euler angles. Follows the same conventions as the
+// matrices in this library - combined rotations are applied left to right, so q1 * q2 rotates by q1 then by q2
+// and MatrixFromQuaternion(q1 * q2) == MatrixFromQuaternion(q1) * MatrixFromQuaternion(q2)
+
+#ifndef _CQUATERNION_H_DEFINED_
+#define _CQUATERNION_H_DEFINED_
+
+#include "CVector3.h"
+#include "CMatrix4x4.h"
+
+
+class CQuaternion
+{
+// Concrete class - public access
+public:
+    // Quaternion components - x, y, z is the vector part, w the scalar part
+    float x;
+    float y;
+    float z;
+    float w;
+
+    /*-----------------------------------------------------------------------------------------
+        Constructors
+    -----------------------------------------------------------------------------------------*/
+
+    // Default constructor - leaves values uninitialised (for performance)
+    CQuaternion() {}
+
+    // Construct with 4 values
+    CQuaternion(const float xIn, const float yIn, const float zIn, const float wIn)
+    {
+        x = xIn;
+        y = yIn;
+        z = zIn;
+        w = wIn;
+    }
+
+
+    /*-----------------------------------------------------------------------------------------
+        Member functions
+    -----------------------------------------------------------------------------------------*/
+
+    // Combine another rotation with this one, i.e. rotate by this quaternion then by q
+    CQuaternion& operator*= (const CQuaternion& q);
+};
+
+
+/*-----------------------------------------------------------------------------------------
+    Non-member operators
+-----------------------------------------------------------------------------------------*/
+
+// Combine two rotations - the result rotates by q1 then by q2 (same order as matrix multiplication)
+CQuaternion operator* (const CQuaternion& q1, const CQuaternion& q2);
+
+
+/*-----------------------------------------------------------------------------------------
+    Non-member functions
+-----------------------------------------------------------------------------------------*/
+
+// Return the identity quaternion (no rotation)
+CQuaternion QuaternionIdentity();
+
+// Return a quaternion rotating by the given angle (in radians) around the given axis (which must be unit length)
+CQuaternion QuaternionRotationAxis(const CVector3& axis, float angle);
+
+// Return a quaternion holding the same rotation as the given Euler angles (in radians, Z then X then Y)
+// i.e. the rotation part of MatrixRotationZ(r.z) * MatrixRotationX(r.x) * MatrixRotationY(r.y)
+CQuaternion QuaternionFromEuler(const CVector3& r);
+
+// Return the rotation held in a matrix as a quaternion. Scaling in the matrix is removed, but the matrix must not be
+// sheared or contain a reflection (negative scale)
+CQuaternion QuaternionFromMatrix(const CMatrix4x4& m);
+
+// Return the rotation held in a quaternion as Euler angles (in radians, Z then X then Y). The quaternion must be unit
+// length. Gives the same angles as CMatrix4x4::GetEulerAngles on the matching matrix
+CVector3 EulerFromQuaternion(const CQuaternion& q);
+
+// Return a rotation matrix holding the same rotation as the given unit quaternion
+CMatrix4x4 MatrixFromQuaternion(const CQuaternion& q);
+
+// Return a world matrix that scales, rotates by the given unit quaternion then translates
+CMatrix4x4 MatrixTRS(const CVector3& t, const CQuaternion& q, const CVector3& s = { 1, 1, 1 });
+
+
+// Dot product of two quaternions - for unit quaternions this is the cosine of half the angle between the rotations
+float Dot(const CQuaternion& q1, const CQuaternion& q2);
+
+// Return unit length quaternion in the same direction as given one (identity if the given one is zero length)
+CQuaternion Normalise(const CQuaternion& q);
+
+// Return the inverse of a unit quaternion, the opposite rotation
+CQuaternion Conjugate(const CQuaternion& q);
+
+// Rotate a vector by a unit quaternion
+CVector3 Rotate(const CVector3& v, const CQuaternion& q);
+
+
+// Interpolate between two unit quaternions (t = 0 to 1), taking the shortest route. Normalised linear interpolation -
+// fast, but the rotation speed is not quite constant (slightly faster in the middle). Fine for animation blending
+CQuaternion Nlerp(const CQuaternion& q1, const CQuaternion& q2, float t);
+
+// Interpolate between two unit quaternions (t = 0 to 1), taking the shortest route. Spherical linear interpolation -
+// constant rotation speed but more expensive (trig functions) than Nlerp
+CQuaternion Slerp(const CQuaternion& q1, const CQuaternion& q2, float t);
+
+
+#endif // _CQUATERNION_H_DEFINED_
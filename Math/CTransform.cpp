@@ -0,0 +1,85 @@
+//--------------------------------------------------------------------------------------
+// Transform class - compact position, rotation and scale
+//--------------------------------------------------------------------------------------
+
+#include "CTransform.h"
+
+
+/*-----------------------------------------------------------------------------------------
+    Member functions
+-----------------------------------------------------------------------------------------*/
+
+// Combine another transform with this one, i.e. apply this transform then t
+CTransform& CTransform::operator*= (const CTransform& t)
+{
+    *this = *this * t;
+    return *this;
+}
+
+
+/*-----------------------------------------------------------------------------------------
+    Non-member operators
+-----------------------------------------------------------------------------------------*/
+
+// Combine two transforms - the result applies t1 then t2 (same order as matrix multiplication)
+CTransform operator* (const CTransform& t1, const CTransform& t2)
+{
+    // t1's position is moved by all of t2, rotations are combined and scales multiplied
+    return CTransform{ TransformPoint(t1.position, t2),
+                       t1.rotation * t2.rotation,
+                       { t1.scale.x * t2.scale.x, t1.scale.y * t2.scale.y, t1.scale.z * t2.scale.z } };
+}
+
+
+/*-----------------------------------------------------------------------------------------
+    Non-member functions
+-----------------------------------------------------------------------------------------*/
+
+// Return the identity transform (no movement, rotation or scaling)
+CTransform TransformIdentity()
+{
+    return CTransform{ { 0, 0, 0 }, QuaternionIdentity(), { 1, 1, 1 } };
+}
+
+// Return a world matrix holding the same transform
+CMatrix4x4 MatrixFromTransform(const CTransform& t)
+{
+    return MatrixTRS(t.position, t.rotation, t.scale);
+}
+
+// Return the position, rotation and scale held in an affine matrix as a transform
+CTransform TransformFromMatrix(const CMatrix4x4& m)
+{
+    return CTransform{ m.GetPosition(), QuaternionFromMatrix(m), m.GetScale() };
+}
+
+// Return the inverse of a transform. Exact when the scale is uniform
+CTransform Inverse(const CTransform& t)
+{
+    CQuaternion invRotation = Conjugate(t.rotation);
+    CVector3 invScale = { 1.0f / t.scale.x, 1.0f / t.scale.y, 1.0f / t.scale.z };
+
+    // Undo the translation, then the rotation, then the scale
+    CVector3 p = Rotate(-1.0f * t.position, invRotation);
+    return CTransform{ { p.x * invScale.x, p.y * invScale.y, p.z * invScale.z }, invRotation, invScale };
+}
+
+// Apply a transform to a point (scale, rotation and translation)
+CVector3 TransformPoint(const CVector3& p, const CTransform& t)
+{
+    return TransformVector(p, t) + t.position;
+}
+
+// Apply a transform to a vector (scale and rotation only)
+CVector3 TransformVector(const CVector3& v, const CTransform& t)
+{
+    return Rotate({ v.x * t.scale.x, v.y * t.scale.y, v.z * t.scale.z }, t.rotation);
+}
+
+// Interpolate between two transforms (t = 0 to 1)
+CTransform Blend(const CTransform& t1, const CTransform& t2, float t)
+{
+    return CTransform{ t1.position + (t2.position - t1.position) * t,
+                       Nlerp(t1.rotation, t2.rotation, t),
+                       t1.scale + (t2.scale - t1.scale) * t };
+}
@@ -0,0 +1,87 @@
+//--------------------------------------------------------------------------------------
+// Transform class - compact position, rotation and scale
+//--------------------------------------------------------------------------------------
+// Code in .cpp file
+// Holds the same information as an affine world matrix (without shear) in 40 bytes rather than 64, using a quaternion
+// for the rotation. Transforms can be combined and blended directly without converting to or from Euler angles.
+// Convert to a matrix with MatrixFromTransform when one is needed for rendering.
+// Combination follows the matrix conventions: t1 * t2 applies t1 then t2 (e.g. child * parent = child's world transform)
+
+#ifndef _CTRANSFORM_H_DEFINED_
+#define _CTRANSFORM_H_DEFINED_
+
+#include "CVector3.h"
+#include "CQuaternion.h"
+#include "CMatrix4x4.h"
+
+
+class CTransform
+{
+// Concrete class - public access
+public:
+    CVector3    position;
+    CQuaternion rotation; // Must be unit length
+    CVector3    scale;
+
+    /*-----------------------------------------------------------------------------------------
+        Constructors
+    -----------------------------------------------------------------------------------------*/
+
+    // Default constructor - leaves values uninitialised (for performance)
+    CTransform() {}
+
+    // Construct with position, rotation and scale
+    CTransform(const CVector3& positionIn, const CQuaternion& rotationIn, const CVector3& scaleIn = { 1, 1, 1 })
+        : position(positionIn), rotation(rotationIn), scale(scaleIn)
+    {
+    }
+
+
+    /*-----------------------------------------------------------------------------------------
+        Member functions
+    -----------------------------------------------------------------------------------------*/
+
+    // Combine another transform with this one, i.e. apply this transform then t
+    CTransform& operator*= (const CTransform& t);
+};
+
+
+/*-----------------------------------------------------------------------------------------
+    Non-member operators
+-----------------------------------------------------------------------------------------*/
+
+// Combine two transforms - the result applies t1 then t2 (same order as matrix multiplication)
+// Exact when t2 has uniform scale. Otherwise the true result may contain shear, which a CTransform can't hold, and the
+// scales are simply multiplied together (as most animation systems do)
+CTransform operator* (const CTransform& t1, const CTransform& t2);
+
+
+/*-----------------------------------------------------------------------------------------
+    Non-member functions
+-----------------------------------------------------------------------------------------*/
+
+// Return the identity transform (no movement, rotation or scaling)
+CTransform TransformIdentity();
+
+// Return a world matrix holding the same transform
+CMatrix4x4 MatrixFromTransform(const CTransform& t);
+
+// Return the position, rotation and scale held in an affine matrix as a transform
+// The matrix must not be sheared or contain a reflection (negative scale)
+CTransform TransformFromMatrix(const CMatrix4x4& m);
+
+// Return the inverse of a transform. Exact when the scale is uniform (see comment on operator*)
+CTransform Inverse(const CTransform& t);
+
+// Apply a transform to a point (scale, rotation and translation)
+CVector3 TransformPoint(const CVector3& p, const CTransform& t);
+
+// Apply a transform to a vector (scale and rotation only)
+CVector3 TransformVector(const CVector3& v, const CTransform& t);
+
+// Interpolate between two transforms (t = 0 to 1). Position and scale are interpolated linearly and the rotation with
+// Nlerp, which is the usual way to blend animation keyframes
+CTransform Blend(const CTransform& t1, const CTransform& t2, float t);
+
+
+#endif // _CTRANSFORM_H_DEFINED_
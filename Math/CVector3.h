@@ -1,7 +1,7 @@
 //--------------------------------------------------------------------------------------
 // Vector3 class (cut down version), to hold points and vectors
 //--------------------------------------------------------------------------------------
-// Code in .cpp file
+// Short operators are inline (and constexpr so they can be used in compile-time constants), other code in .cpp file
 
 #ifndef _CVECTOR3_H_DEFINED_
 #define _CVECTOR3_H_DEFINED_
@@ -26,19 +26,15 @@ public:
 	CVector3() {}
 
 	// Construct with 3 values
-	CVector3(const float xIn, const float yIn, const float zIn)
+	constexpr CVector3(const float xIn, const float yIn, const float zIn)
+		: x(xIn), y(yIn), z(zIn)
 	{
-		x = xIn;
-		y = yIn;
-		z = zIn;
 	}
-	
+
     // Construct using a pointer to three floats
-    CVector3(const float* pfElts)
+    constexpr CVector3(const float* pfElts)
+        : x(pfElts[0]), y(pfElts[1]), z(pfElts[2])
     {
-        x = pfElts[0];
-        y = pfElts[1];
-        z = pfElts[2];
     }
 
 
@@ -47,45 +43,90 @@ public:
     -----------------------------------------------------------------------------------------*/
 
     // Addition of another vector to this one, e.g. Position += Velocity
-    CVector3& operator+= (const CVector3& v);
+    constexpr CVector3& operator+= (const CVector3& v)
+    {
+        x += v.x;
+        y += v.y;
+        z += v.z;
+        return *this;
+    }
 
     // Subtraction of another vector from this one, e.g. Velocity -= Gravity
-    CVector3& operator-= (const CVector3& v);
+    constexpr CVector3& operator-= (const CVector3& v)
+    {
+        x -= v.x;
+        y -= v.y;
+        z -= v.z;
+        return *this;
+    }
 
     // Negate this vector (e.g. Velocity = -Velocity)
-    CVector3& operator- ();
+    constexpr CVector3& operator- ()
+    {
+        x = -x;
+        y = -y;
+        z = -z;
+        return *this;
+    }
 
     // Plus sign in front of vector - called unary positive and usually does nothing. Included for completeness (e.g. Velocity = +Velocity)
-    CVector3& operator+ ();
+    constexpr CVector3& operator+ ()
+    {
+        return *this;
+    }
 
     // Multiply vector by scalar (scales vector);
-    CVector3& operator*= (const float s);
+    constexpr CVector3& operator*= (const float s)
+    {
+        x *= s;
+        y *= s;
+        z *= s;
+        return *this;
+    }
 };
-	
+
 
 /*-----------------------------------------------------------------------------------------
     Non-member operators
 -----------------------------------------------------------------------------------------*/
 
 // Vector-vector addition
-CVector3 operator+ (const CVector3& v, const CVector3& w);
+constexpr CVector3 operator+ (const CVector3& v, const CVector3& w)
+{
+    return CVector3{ v.x + w.x, v.y + w.y, v.z + w.z };
+}
 
 // Vector-vector subtraction
-CVector3 operator- (const CVector3& v, const CVector3& w);
+constexpr CVector3 operator- (const CVector3& v, const CVector3& w)
+{
+    return CVector3{ v.x - w.x, v.y - w.y, v.z - w.z };
+}
 
 // Vector-scalar multiplication
-CVector3 operator* (const CVector3& v, float s);
-CVector3 operator* (float s, const CVector3& v);
+constexpr CVector3 operator* (const CVector3& v, float s)
+{
+    return CVector3{ v.x * s, v.y * s, v.z * s };
+}
+constexpr CVector3 operator* (float s, const CVector3& v)
+{
+    return CVector3{ v.x * s, v.y * s, v.z * s };
+}
 
 /*-----------------------------------------------------------------------------------------
     Non-member functions
 -----------------------------------------------------------------------------------------*/
 
 // Dot product of two given vectors (order not important) - non-member version
-float Dot(const CVector3& v1, const CVector3& v2);
+constexpr float Dot(const CVector3& v1, const CVector3& v2)
+{
+    return v1.x * v2.x + v1.y * v2.y + v1.z * v2.z;
+}
 
 // Cross product of two given vectors (order is important) - non-member version
-CVector3 Cross(const CVector3& v1, const CVector3& v2);
+constexpr CVector3 Cross(const CVector3& v1, const CVector3& v2)
+{
+    return CVector3{ v1.y * v2.z - v1.z * v2.y, v1.z * v2.x - v1.x * v2.z, v1.x * v2.y - v1.y * v2.x };
+}
 
 // Return unit length vector in the same direction as given one
 CVector3 Normalise(const CVector3& v);
@@ -6,19 +6,21 @@
 #define _MATH_HELPERS_H_DEFINED_
 
 #include <cmath>
+#include <cstdint>
+#include <cstring>
 
 
 // Surprisingly, pi is not *officially* defined anywhere in C++
-const float PI = 3.14159265359f;
+constexpr float PI = 3.14159265359f;
 
 
 
 // Test if a float value is approximately 0
 // Epsilon value is the range around zero that is considered equal to zero
-const float EPSILON = 0.5e-6f; // For 32-bit floats, requires zero to 6 decimal places
-inline bool IsZero(const float x)
+constexpr float EPSILON = 0.5e-6f; // For 32-bit floats, requires zero to 6 decimal places
+constexpr bool IsZero(const float x)
 {
-    return std::abs(x) < EPSILON;
+    return x < EPSILON && x > -EPSILON;
 }
 
 
@@ -29,17 +31,76 @@ inline float InvSqrt(const float x)
 }
 
 
+// Calculate the sine and cosine of an angle (in radians) together. Shares the range reduction between the two, which
+// makes it around twice as fast as calling std::sin and std::cos separately. Accurate to within a couple of float ulps
+// for angles up to +/-8192 radians, larger angles fall back to the standard library
+inline void SinCos(const float angle, float* s, float* c)
+{
+    float absAngle = std::abs(angle);
+    if (absAngle > 8192.0f)
+    {
+        *s = std::sin(angle);
+        *c = std::cos(angle);
+        return;
+    }
+
+    // Reduce to range -PI/4 to PI/4 and find which octant pair (quadrant) the angle was in. Subtract PI/2 multiples in
+    // three parts (extended precision) to reduce rounding error
+    int quadrant = static_cast<int>(absAngle * 0.63661977236f + 0.5f); // 2/PI
+    float q = static_cast<float>(quadrant);
+    float x = ((absAngle - q * 1.5703125f) - q * 4.8375129699707031e-4f) - q * 7.5497899548918821e-8f;
+
+    // Minimax polynomials for sin and cos over -PI/4 to PI/4
+    float z = x * x;
+    float sinX = ((-1.9515295891e-4f * z + 8.3321608736e-3f) * z - 1.6666654611e-1f) * z * x + x;
+    float cosX = ((2.443315711809948e-5f * z - 1.388731625493765e-3f) * z + 4.166664568298827e-2f) * z * z - 0.5f * z + 1.0f;
+
+    // Rotate results to the correct quadrant and restore the sign of the sine (cosine is an even function)
+    // Done with bit operations rather than branches since the quadrant is unpredictable for general angles
+    std::uint32_t sinBits, cosBits, angleBits;
+    std::memcpy(&sinBits, &sinX, 4);
+    std::memcpy(&cosBits, &cosX, 4);
+    std::memcpy(&angleBits, &angle, 4);
+    std::uint32_t q32 = static_cast<std::uint32_t>(quadrant);
+    std::uint32_t swapMask = 0u - (q32 & 1u);
+    std::uint32_t sinResult = ((sinBits & ~swapMask) | (cosBits & swapMask)) ^ ((q32 & 2u) << 30) ^ (angleBits & 0x80000000u);
+    std::uint32_t cosResult = ((cosBits & ~swapMask) | (sinBits & swapMask)) ^ (((q32 + 1u) & 2u) << 30);
+    std::memcpy(s, &sinResult, 4);
+    std::memcpy(c, &cosResult, 4);
+}
+
+
 // Pass an angle in degrees, returns the angle in radians
-inline float ToRadians(float d)
+constexpr float ToRadians(float d)
 {
     return  d * PI / 180.0f;
 }
 
 // Pass an angle in radians, returns the angle in degrees
-inline float ToDegrees(float r)
+constexpr float ToDegrees(float r)
 {
     return  r * 180.0f / PI;
 }
 
 
+// Tangent of an angle (in radians, range -PI/2 to PI/2 exclusive) that can be evaluated by the compiler, e.g. to build
+// constant projection matrices. Slower than std::tan, so only use it for constants
+constexpr float ConstexprTan(const float angle)
+{
+    // Taylor series for sin and cos in double precision, converges fully within the range
+    double x = angle;
+    double z = x * x;
+    double sinTerm = x, cosTerm = 1.0;
+    double sinSum = x, cosSum = 1.0;
+    for (int n = 1; n < 20; ++n)
+    {
+        sinTerm *= -z / ((2 * n) * (2 * n + 1));
+        cosTerm *= -z / ((2 * n - 1) * (2 * n));
+        sinSum += sinTerm;
+        cosSum += cosTerm;
+    }
+    return static_cast<float>(sinSum / cosSum);
+}
+
+
 #endif // _MATH_HELPERS_H_DEFINED_
@@ -0,0 +1,105 @@
+//--------------------------------------------------------------------------------------
+// SIMD "lane" types, for writing calculations once as templates that work on 1, 4 or 8 values at a time
+//--------------------------------------------------------------------------------------
+// Used inside the maths library .cpp files, not needed by other code.
+// Lanes4 (SSE) and Lanes8 (AVX) hold 4 or 8 floats, each lane belonging to a different object (e.g. one element from
+// each of 8 matrices, or one coordinate from each of 8 triangles). They have the usual arithmetic operators, so a
+// template written with them also works with plain floats. Comparisons give a mask (all bits set in lanes where the
+// comparison is true), which can be combined with & and |, and used with Select or MoveMask. The float versions of
+// Min, Max and Select behave like the SSE instructions when given NaNs, so all versions give identical results.
+// Lanes are passed by const reference: 32-bit Visual Studio can't pass 16 or 32-byte aligned types by value (error
+// C2719), and the references disappear when the functions are inlined. Templates written with them should do the same
+
+#ifndef _MATH_LANES_H_DEFINED_
+#define _MATH_LANES_H_DEFINED_
+
+#include "MathSIMD.h"
+
+
+/*-----------------------------------------------------------------------------------------
+    Single float versions of the lane functions
+-----------------------------------------------------------------------------------------*/
+
+inline float Min(float a, float b) { return a < b ? a : b; } // Returns b if either is NaN, same as _mm_min_ps
+inline float Max(float a, float b) { return a > b ? a : b; } // Returns b if either is NaN, same as _mm_max_ps
+
+// Return a if mask is true, otherwise b
+inline float Select(bool mask, float a, float b) { return mask ? a : b; }
+
+
+#if !defined(MATH_SIMD_NONE)
+
+/*-----------------------------------------------------------------------------------------
+    Lanes4 - SSE
+-----------------------------------------------------------------------------------------*/
+
+struct Lanes4
+{
+    __m128 v;
+    Lanes4() {}
+    Lanes4(__m128 vIn) : v(vIn) {}
+    explicit Lanes4(float f) : v(_mm_set1_ps(f)) {}
+
+    static Lanes4 Load(const float* p) { return _mm_loadu_ps(p); }
+    void Store(float* p) const { _mm_storeu_ps(p, v); }
+};
+inline Lanes4 operator+(const Lanes4& a, const Lanes4& b) { return _mm_add_ps(a.v, b.v); }
+inline Lanes4 operator-(const Lanes4& a, const Lanes4& b) { return _mm_sub_ps(a.v, b.v); }
+inline Lanes4 operator*(const Lanes4& a, const Lanes4& b) { return _mm_mul_ps(a.v, b.v); }
+inline Lanes4 operator/(const Lanes4& a, const Lanes4& b) { return _mm_div_ps(a.v, b.v); }
+
+inline Lanes4 operator< (const Lanes4& a, const Lanes4& b) { return _mm_cmplt_ps(a.v, b.v); }
+inline Lanes4 operator<=(const Lanes4& a, const Lanes4& b) { return _mm_cmple_ps(a.v, b.v); }
+inline Lanes4 operator> (const Lanes4& a, const Lanes4& b) { return _mm_cmpgt_ps(a.v, b.v); }
+inline Lanes4 operator>=(const Lanes4& a, const Lanes4& b) { return _mm_cmpge_ps(a.v, b.v); }
+inline Lanes4 operator& (const Lanes4& a, const Lanes4& b) { return _mm_and_ps(a.v, b.v); }
+inline Lanes4 operator| (const Lanes4& a, const Lanes4& b) { return _mm_or_ps(a.v, b.v); }
+
+inline Lanes4 Min(const Lanes4& a, const Lanes4& b) { return _mm_min_ps(a.v, b.v); }
+inline Lanes4 Max(const Lanes4& a, const Lanes4& b) { return _mm_max_ps(a.v, b.v); }
+inline Lanes4 Select(const Lanes4& mask, const Lanes4& a, const Lanes4& b) { return _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v)); }
+
+// One bit per lane (bit 0 = lane 0) showing which lanes of a mask are set
+inline int MoveMask(const Lanes4& mask) { return _mm_movemask_ps(mask.v); }
+
+#endif
+
+
+#if defined(MATH_SIMD_AVX)
+
+/*-----------------------------------------------------------------------------------------
+    Lanes8 - AVX
+-----------------------------------------------------------------------------------------*/
+
+struct Lanes8
+{
+    __m256 v;
+    Lanes8() {}
+    Lanes8(__m256 vIn) : v(vIn) {}
+    explicit Lanes8(float f) : v(_mm256_set1_ps(f)) {}
+
+    static Lanes8 Load(const float* p) { return _mm256_loadu_ps(p); }
+    void Store(float* p) const { _mm256_storeu_ps(p, v); }
+};
+inline Lanes8 operator+(const Lanes8& a, const Lanes8& b) { return _mm256_add_ps(a.v, b.v); }
+inline Lanes8 operator-(const Lanes8& a, const Lanes8& b) { return _mm256_sub_ps(a.v, b.v); }
+inline Lanes8 operator*(const Lanes8& a, const Lanes8& b) { return _mm256_mul_ps(a.v, b.v); }
+inline Lanes8 operator/(const Lanes8& a, const Lanes8& b) { return _mm256_div_ps(a.v, b.v); }
+
+inline Lanes8 operator< (const Lanes8& a, const Lanes8& b) { return _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ); }
+inline Lanes8 operator<=(const Lanes8& a, const Lanes8& b) { return _mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ); }
+inline Lanes8 operator> (const Lanes8& a, const Lanes8& b) { return _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ); }
+inline Lanes8 operator>=(const Lanes8& a, const Lanes8& b) { return _mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ); }
+inline Lanes8 operator& (const Lanes8& a, const Lanes8& b) { return _mm256_and_ps(a.v, b.v); }
+inline Lanes8 operator| (const Lanes8& a, const Lanes8& b) { return _mm256_or_ps(a.v, b.v); }
+
+inline Lanes8 Min(const Lanes8& a, const Lanes8& b) { return _mm256_min_ps(a.v, b.v); }
+inline Lanes8 Max(const Lanes8& a, const Lanes8& b) { return _mm256_max_ps(a.v, b.v); }
+inline Lanes8 Select(const Lanes8& mask, const Lanes8& a, const Lanes8& b) { return _mm256_blendv_ps(b.v, a.v, mask.v); }
+
+inline int MoveMask(const Lanes8& mask) { return _mm256_movemask_ps(mask.v); }
+
+#endif
+
+
+#endif // _MATH_LANES_H_DEFINED_
@@ -0,0 +1,43 @@
+//--------------------------------------------------------------------------------------
+// Compile-time selection of the SIMD instruction set used by the maths library
+//--------------------------------------------------------------------------------------
+// After including this file either MATH_SIMD_NONE is defined, or MATH_SIMD_SSE is. AVX builds define MATH_SIMD_AVX as
+// well as MATH_SIMD_SSE, since AVX implies SSE: code with an AVX path tests MATH_SIMD_AVX first in its #if chain and
+// falls through to the SSE path otherwise, and code with only an SSE path uses it in AVX builds too. MATH_SIMD_F16C is
+// also defined in AVX builds if half-float conversion instructions are available.
+// The choice follows the compiler's target settings (e.g. /arch:AVX in Visual Studio, -mavx with gcc/clang).
+// Define MATH_NO_SIMD before including any maths header (or in the project settings) to force the portable
+// scalar code everywhere, which is useful when checking that the SIMD versions give the same results.
+
+#ifndef _MATH_SIMD_H_DEFINED_
+#define _MATH_SIMD_H_DEFINED_
+
+#if !defined(MATH_NO_SIMD) && defined(__AVX__)
+    #define MATH_SIMD_AVX
+    #define MATH_SIMD_SSE // AVX builds can also use all the SSE code paths
+    #include <immintrin.h>
+#elif !defined(MATH_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+    #define MATH_SIMD_SSE
+    #include <emmintrin.h>
+#else
+    #define MATH_SIMD_NONE
+#endif
+
+// Half-float conversion instructions (F16C) are separate from AVX but present on all processors with AVX2. gcc/clang
+// define __F16C__ with -mf16c or -march settings that include it, Visual Studio only has /arch:AVX2 to go by
+#if defined(MATH_SIMD_AVX) && (defined(__F16C__) || defined(__AVX2__))
+    #define MATH_SIMD_F16C
+#endif
+
+
+// Name of the selected instruction set - for display in benchmarks, logs etc.
+#if defined(MATH_SIMD_AVX)
+    #define MATH_SIMD_NAME "AVX"
+#elif defined(MATH_SIMD_SSE)
+    #define MATH_SIMD_NAME "SSE2"
+#else
+    #define MATH_SIMD_NAME "Scalar"
+#endif
+
+
+#endif // _MATH_SIMD_H_DEFINED_
@@ -0,0 +1,337 @@
+//--------------------------------------------------------------------------------------
+// Packing floats into smaller formats (half floats, normalised integers, octahedral normals)
+//--------------------------------------------------------------------------------------
+// Conversions to normalised integers follow the Direct3D rules: clamp to the range, scale and round to nearest even.
+// The SSE versions use the processor's default rounding mode (nearest even), the scalar versions use std::nearbyint,
+// which does the same, so both give identical results
+
+#include "Packing.h"
+
+#include <cmath>
+#include <cstring>
+
+
+/*-----------------------------------------------------------------------------------------
+    Helpers
+-----------------------------------------------------------------------------------------*/
+
+namespace
+{
+    // Reinterpret bits between floats and integers
+    inline std::uint32_t FloatBits(float f)
+    {
+        std::uint32_t u;
+        std::memcpy(&u, &f, 4);
+        return u;
+    }
+    inline float BitsFloat(std::uint32_t u)
+    {
+        float f;
+        std::memcpy(&f, &u, 4);
+        return f;
+    }
+
+    // Clamp a value to a range, written so that a NaN gives the minimum (same as the SSE min/max instructions below)
+    inline float Clamp(float x, float min, float max)
+    {
+        x = x > min ? x : min;
+        return x < max ? x : max;
+    }
+
+    inline std::int16_t ToSnorm16(float x)
+    {
+        return static_cast<std::int16_t>(std::nearbyint(Clamp(x, -1.0f, 1.0f) * 32767.0f));
+    }
+    inline float FromSnorm16(std::int16_t i)
+    {
+        // -32768 also maps to -1
+        float x = i * (1.0f / 32767.0f);
+        return x > -1.0f ? x : -1.0f;
+    }
+
+#ifdef MATH_SIMD_SSE
+    // Clamp 4 values and scale them, then round to integers. Registers are passed by reference since 32-bit Visual
+    // Studio only passes three by value (error C2719)
+    inline __m128i ScaleRound(const __m128& x, const __m128& min, const __m128& max, const __m128& scale)
+    {
+        return _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(x, min), max), scale));
+    }
+#endif
+}
+
+
+/*-----------------------------------------------------------------------------------------
+    Single values
+-----------------------------------------------------------------------------------------*/
+
+// Convert a float to a half float (round to nearest even). Gives the same results as the F16C instructions
+std::uint16_t FloatToHalf(float f)
+{
+    std::uint32_t bits = FloatBits(f);
+    std::uint32_t sign = (bits >> 16) & 0x8000u;
+    bits &= 0x7fffffffu;
+
+    std::uint32_t half;
+    if (bits >= 0x47800000u) // 65536 or more, infinity or NaN
+    {
+        // NaNs are made quiet and keep the top bits of their payload
+        half = bits > 0x7f800000u ? 0x7e00u | ((bits >> 13) & 0x3ffu) : 0x7c00u;
+    }
+    else if (bits < 0x38800000u) // Too small for a normalised half - becomes a denormal or zero
+    {
+        // Adding 0.5 lines the 10 half mantissa bits up at the bottom of the float mantissa, and the float addition
+        // does the rounding
+        half = FloatBits(BitsFloat(bits) + 0.5f) - 0x3f000000u;
+    }
+    else
+    {
+        // Rebias exponent and round the mantissa to nearest even. Values that round up past the largest half
+        // (65504) carry into the exponent and become infinity
+        std::uint32_t mantissaOdd = (bits >> 13) & 1u;
+        bits += (static_cast<std::uint32_t>(15 - 127) << 23) + 0xfffu + mantissaOdd;
+        half = bits >> 13;
+    }
+    return static_cast<std::uint16_t>(half | sign);
+}
+
+// Convert a half float to a float (exact)
+float HalfToFloat(std::uint16_t h)
+{
+    const std::uint32_t exponentMask = 0x7c00u << 13;
+    std::uint32_t bits = (h & 0x7fffu) << 13; // Exponent and mantissa in float positions
+    std::uint32_t exponent = bits & exponentMask;
+    bits += static_cast<std::uint32_t>(127 - 15) << 23; // Rebias exponent
+
+    if (exponent == exponentMask) // Infinity or NaN - exponent becomes all 1s, NaNs are made quiet
+    {
+        bits += static_cast<std::uint32_t>(128 - 16) << 23;
+        if (bits & 0x7fffffu)  bits |= 0x400000u;
+    }
+    else if (exponent == 0) // Zero or denormal - renormalise using float subtraction (exact)
+    {
+        bits += 1u << 23;
+        bits = FloatBits(BitsFloat(bits) - BitsFloat(113u << 23));
+    }
+    return BitsFloat(bits | (static_cast<std::uint32_t>(h & 0x8000u) << 16));
+}
+
+
+/*-----------------------------------------------------------------------------------------
+    Arrays
+-----------------------------------------------------------------------------------------*/
+
+void PackHalf(const float* values, std::uint16_t* packed, std::size_t count)
+{
+    std::size_t i = 0;
+#ifdef MATH_SIMD_F16C
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(values + i), _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(packed + i), h);
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        packed[i] = FloatToHalf(values[i]);
+    }
+}
+
+void UnpackHalf(const std::uint16_t* packed, float* values, std::size_t count)
+{
+    std::size_t i = 0;
+#ifdef MATH_SIMD_F16C
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(packed + i));
+        _mm256_storeu_ps(values + i, _mm256_cvtph_ps(h));
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        values[i] = HalfToFloat(packed[i]);
+    }
+}
+
+
+void PackSnorm16(const float* values, std::int16_t* packed, std::size_t count)
+{
+    std::size_t i = 0;
+#ifdef MATH_SIMD_SSE
+    const __m128 min = _mm_set1_ps(-1.0f);
+    const __m128 max = _mm_set1_ps(1.0f);
+    const __m128 scale = _mm_set1_ps(32767.0f);
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i low  = ScaleRound(_mm_loadu_ps(values + i),     min, max, scale);
+        __m128i high = ScaleRound(_mm_loadu_ps(values + i + 4), min, max, scale);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(packed + i), _mm_packs_epi32(low, high));
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        packed[i] = ToSnorm16(values[i]);
+    }
+}
+
+void UnpackSnorm16(const std::int16_t* packed, float* values, std::size_t count)
+{
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        values[i] = FromSnorm16(packed[i]);
+    }
+}
+
+
+void PackUnorm16(const float* values, std::uint16_t* packed, std::size_t count)
+{
+    std::size_t i = 0;
+#ifdef MATH_SIMD_SSE
+    const __m128 min = _mm_setzero_ps();
+    const __m128 max = _mm_set1_ps(1.0f);
+    const __m128 scale = _mm_set1_ps(65535.0f);
+    const __m128i bias = _mm_set1_epi32(32768);
+    const __m128i flip = _mm_set1_epi16(static_cast<short>(0x8000));
+    for (; i + 8 <= count; i += 8)
+    {
+        // SSE2 can only pack to signed 16-bit with saturation, so shift the range down to fit, then flip the top bit back
+        __m128i low  = _mm_sub_epi32(ScaleRound(_mm_loadu_ps(values + i),     min, max, scale), bias);
+        __m128i high = _mm_sub_epi32(ScaleRound(_mm_loadu_ps(values + i + 4), min, max, scale), bias);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(packed + i), _mm_xor_si128(_mm_packs_epi32(low, high), flip));
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        packed[i] = static_cast<std::uint16_t>(std::nearbyint(Clamp(values[i], 0.0f, 1.0f) * 65535.0f));
+    }
+}
+
+void UnpackUnorm16(const std::uint16_t* packed, float* values, std::size_t count)
+{
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        values[i] = packed[i] * (1.0f / 65535.0f);
+    }
+}
+
+
+void PackUnorm8(const float* values, std::uint8_t* packed, std::size_t count)
+{
+    std::size_t i = 0;
+#ifdef MATH_SIMD_SSE
+    const __m128 min = _mm_setzero_ps();
+    const __m128 max = _mm_set1_ps(1.0f);
+    const __m128 scale = _mm_set1_ps(255.0f);
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i a = ScaleRound(_mm_loadu_ps(values + i),      min, max, scale);
+        __m128i b = ScaleRound(_mm_loadu_ps(values + i + 4),  min, max, scale);
+        __m128i c = ScaleRound(_mm_loadu_ps(values + i + 8),  min, max, scale);
+        __m128i d = ScaleRound(_mm_loadu_ps(values + i + 12), min, max, scale);
+        __m128i bytes = _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(packed + i), bytes);
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        packed[i] = static_cast<std::uint8_t>(std::nearbyint(Clamp(values[i], 0.0f, 1.0f) * 255.0f));
+    }
+}
+
+void UnpackUnorm8(const std::uint8_t* packed, float* values, std::size_t count)
+{
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        values[i] = packed[i] * (1.0f / 255.0f);
+    }
+}
+
+
+/*-----------------------------------------------------------------------------------------
+    Octahedral normals
+-----------------------------------------------------------------------------------------*/
+
+// Pack a stream of unit vectors into pairs of Snorm16 values
+void PackOctahedral(const void* normals, std::size_t stride, std::int16_t* packed, std::size_t count)
+{
+    const unsigned char* normal = static_cast<const unsigned char*>(normals);
+    std::size_t i = 0;
+
+#ifdef MATH_SIMD_SSE
+    // Four normals at a time, same operations as the scalar code below
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    const __m128 min = _mm_set1_ps(-1.0f);
+    const __m128 scale = _mm_set1_ps(32767.0f);
+    for (; i + 4 <= count; i += 4)
+    {
+        const float* n0 = reinterpret_cast<const float*>(normal + (i + 0) * stride);
+        const float* n1 = reinterpret_cast<const float*>(normal + (i + 1) * stride);
+        const float* n2 = reinterpret_cast<const float*>(normal + (i + 2) * stride);
+        const float* n3 = reinterpret_cast<const float*>(normal + (i + 3) * stride);
+        __m128 x = _mm_setr_ps(n0[0], n1[0], n2[0], n3[0]);
+        __m128 y = _mm_setr_ps(n0[1], n1[1], n2[1], n3[1]);
+        __m128 z = _mm_setr_ps(n0[2], n1[2], n2[2], n3[2]);
+
+        __m128 absX = _mm_andnot_ps(signMask, x);
+        __m128 absY = _mm_andnot_ps(signMask, y);
+        __m128 absZ = _mm_andnot_ps(signMask, z);
+        __m128 sum = _mm_add_ps(_mm_add_ps(absX, absY), absZ);
+        __m128 invSum = _mm_and_ps(_mm_div_ps(one, sum), _mm_cmpgt_ps(sum, zero));
+        __m128 px = _mm_mul_ps(x, invSum);
+        __m128 py = _mm_mul_ps(y, invSum);
+
+        // Lower hemisphere is folded over the diagonals
+        __m128 absPx = _mm_andnot_ps(signMask, px);
+        __m128 absPy = _mm_andnot_ps(signMask, py);
+        __m128 foldX = _mm_mul_ps(_mm_sub_ps(one, absPy), _mm_or_ps(_mm_and_ps(px, signMask), one));
+        __m128 foldY = _mm_mul_ps(_mm_sub_ps(one, absPx), _mm_or_ps(_mm_and_ps(py, signMask), one));
+        __m128 lower = _mm_cmplt_ps(z, zero);
+        px = _mm_or_ps(_mm_and_ps(lower, foldX), _mm_andnot_ps(lower, px));
+        py = _mm_or_ps(_mm_and_ps(lower, foldY), _mm_andnot_ps(lower, py));
+
+        // Interleave x and y and pack to 16-bit
+        __m128i low  = ScaleRound(_mm_unpacklo_ps(px, py), min, one, scale);
+        __m128i high = ScaleRound(_mm_unpackhi_ps(px, py), min, one, scale);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(packed + i * 2), _mm_packs_epi32(low, high));
+    }
+#endif
+
+    for (; i < count; ++i)
+    {
+        const float* n = reinterpret_cast<const float*>(normal + i * stride);
+        float sum = std::abs(n[0]) + std::abs(n[1]) + std::abs(n[2]);
+        float invSum = sum > 0.0f ? 1.0f / sum : 0.0f;
+        float px = n[0] * invSum;
+        float py = n[1] * invSum;
+        if (n[2] < 0.0f)
+        {
+            float foldX = (1.0f - std::abs(py)) * std::copysign(1.0f, px);
+            float foldY = (1.0f - std::abs(px)) * std::copysign(1.0f, py);
+            px = foldX;
+            py = foldY;
+        }
+        packed[i * 2]     = ToSnorm16(px);
+        packed[i * 2 + 1] = ToSnorm16(py);
+    }
+}
+
+// Unpack pairs of Snorm16 values into a stream of unit vectors
+void UnpackOctahedral(const std::int16_t* packed, void* normals, std::size_t stride, std::size_t count)
+{
+    unsigned char* normal = static_cast<unsigned char*>(normals);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        CVector3 n;
+        n.x = FromSnorm16(packed[i * 2]);
+        n.y = FromSnorm16(packed[i * 2 + 1]);
+        n.z = 1.0f - std::abs(n.x) - std::abs(n.y);
+
+        // Unfold the lower hemisphere
+        float t = n.z < 0.0f ? -n.z : 0.0f;
+        n.x += n.x >= 0.0f ? -t : t;
+        n.y += n.y >= 0.0f ? -t : t;
+
+        *reinterpret_cast<CVector3*>(normal + i * stride) = Normalise(n);
+    }
+}
@@ -0,0 +1,65 @@
+//--------------------------------------------------------------------------------------
+// Packing floats into smaller formats (half floats, normalised integers, octahedral normals)
+//--------------------------------------------------------------------------------------
+// Code in .cpp file
+// Used to shrink vertex and instance data. Each format matches a DXGI format so the GPU unpacks it for free:
+//     Half          - DXGI_FORMAT_R16_FLOAT etc.   16-bit float, about 3 decimal digits, range +/-65504
+//     Snorm16       - DXGI_FORMAT_R16_SNORM etc.   -1 to 1 as -32767 to 32767
+//     Unorm16       - DXGI_FORMAT_R16_UNORM etc.    0 to 1 as 0 to 65535
+//     Unorm8        - DXGI_FORMAT_R8_UNORM etc.     0 to 1 as 0 to 255 (e.g. colours)
+//     Octahedral    - unit vector as two Snorm16 values (DXGI_FORMAT_R16G16_SNORM), decoded in the shader
+// The bulk functions convert arrays using SSE (or F16C for half floats) where available, giving exactly the same results
+// as the scalar code. Values outside a format's range are clamped, and NaNs become the lowest value for the
+// normalised formats. Each format has a matching unpack function, e.g. to check how much precision is lost
+
+#ifndef _PACKING_H_DEFINED_
+#define _PACKING_H_DEFINED_
+
+#include "CVector3.h"
+#include <cstddef>
+#include <cstdint>
+
+
+/*-----------------------------------------------------------------------------------------
+    Single values
+-----------------------------------------------------------------------------------------*/
+
+// Convert a float to a half float (round to nearest even). Too large values become infinity, NaNs stay NaN
+std::uint16_t FloatToHalf(float f);
+
+// Convert a half float to a float (exact)
+float HalfToFloat(std::uint16_t h);
+
+
+/*-----------------------------------------------------------------------------------------
+    Arrays
+-----------------------------------------------------------------------------------------*/
+
+void PackHalf(const float* values, std::uint16_t* packed, std::size_t count);
+void UnpackHalf(const std::uint16_t* packed, float* values, std::size_t count);
+
+void PackSnorm16(const float* values, std::int16_t* packed, std::size_t count);
+void UnpackSnorm16(const std::int16_t* packed, float* values, std::size_t count);
+
+void PackUnorm16(const float* values, std::uint16_t* packed, std::size_t count);
+void UnpackUnorm16(const std::uint16_t* packed, float* values, std::size_t count);
+
+void PackUnorm8(const float* values, std::uint8_t* packed, std::size_t count);
+void UnpackUnorm8(const std::uint8_t* packed, float* values, std::size_t count);
+
+
+/*-----------------------------------------------------------------------------------------
+    Octahedral normals
+-----------------------------------------------------------------------------------------*/
+// Unit vectors are mapped onto an octahedron and then flattened onto a square, giving two values from -1 to 1 that
+// are stored as Snorm16. Angular error is at most about 0.04 degrees, in 4 bytes rather than 12 for 3 floats
+
+// Pack a stream of unit vectors (the stride is the number of bytes from one vector to the next, e.g. the vertex size)
+// into pairs of Snorm16 values. Zero length vectors are packed as (0, 0)
+void PackOctahedral(const void* normals, std::size_t stride, std::int16_t* packed, std::size_t count);
+
+// Unpack pairs of Snorm16 values into a stream of unit vectors
+void UnpackOctahedral(const std::int16_t* packed, void* normals, std::size_t stride, std::size_t count);
+
+
+#endif // _PACKING_H_DEFINED_
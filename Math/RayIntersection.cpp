@@ -0,0 +1,262 @@
+//--------------------------------------------------------------------------------------
+// Ray intersection with triangles and axis-aligned boxes
+//--------------------------------------------------------------------------------------
+// The tests are written once as templates over a lane type (see MathLanes.h). Using float gives the single versions,
+// Lanes8 / Lanes4 give the 8-wide versions with exactly the same sequence of operations, so results are identical
+
+#include "RayIntersection.h"
+#include "MathLanes.h"
+
+#include <limits>
+
+
+/*-----------------------------------------------------------------------------------------
+    Templates
+-----------------------------------------------------------------------------------------*/
+
+namespace
+{
+    // Moller-Trumbore ray-triangle test. Calculates the distance along the ray to the triangle's plane (tHit) and
+    // returns a mask that is set where the hit is inside the triangle and between 0 and tMax. A triangle edge-on to the
+    // ray (including zero sized triangles) divides by zero, giving infinities or NaNs that fail the tests
+    template <class T>
+    auto RayTriangleLanes(const T& ox, const T& oy, const T& oz, const T& dx, const T& dy, const T& dz,
+                          const T& v0x, const T& v0y, const T& v0z, const T& e1x, const T& e1y, const T& e1z,
+                          const T& e2x, const T& e2y, const T& e2z, const T& tMax, T& tHit) -> decltype(ox < oy)
+    {
+        // Cross product of ray direction and edge 2, its dot product with edge 1 is the determinant
+        T px = dy * e2z - dz * e2y;
+        T py = dz * e2x - dx * e2z;
+        T pz = dx * e2y - dy * e2x;
+        T invDet = T(1.0f) / (e1x * px + e1y * py + e1z * pz);
+
+        // Barycentric coordinates u and v of the hit point
+        T sx = ox - v0x;
+        T sy = oy - v0y;
+        T sz = oz - v0z;
+        T u = (sx * px + sy * py + sz * pz) * invDet;
+
+        T qx = sy * e1z - sz * e1y;
+        T qy = sz * e1x - sx * e1z;
+        T qz = sx * e1y - sy * e1x;
+        T v = (dx * qx + dy * qy + dz * qz) * invDet;
+
+        tHit = (e2x * qx + e2y * qy + e2z * qz) * invDet;
+        return (u >= T(0.0f)) & (v >= T(0.0f)) & (u + v <= T(1.0f)) & (tHit >= T(0.0f)) & (tHit < tMax);
+    }
+
+    // Slab test - the distances where the ray crosses the two planes of each axis are found, the ray is inside the box
+    // between the largest entry distance and smallest exit distance. Returns a mask that is set where the ray enters
+    // the box between 0 and tMax
+    template <class T>
+    auto RayAABBLanes(const T& ox, const T& oy, const T& oz, const T& invDx, const T& invDy, const T& invDz,
+                      const T& minX, const T& minY, const T& minZ, const T& maxX, const T& maxY, const T& maxZ,
+                      const T& tMax, T& tEntry) -> decltype(ox < oy)
+    {
+        T tx1 = (minX - ox) * invDx;
+        T tx2 = (maxX - ox) * invDx;
+        T ty1 = (minY - oy) * invDy;
+        T ty2 = (maxY - oy) * invDy;
+        T tz1 = (minZ - oz) * invDz;
+        T tz2 = (maxZ - oz) * invDz;
+
+        tEntry = Max(Max(Max(Min(tx1, tx2), Min(ty1, ty2)), Min(tz1, tz2)), T(0.0f));
+        T tExit = Min(Min(Min(Max(tx1, tx2), Max(ty1, ty2)), Max(tz1, tz2)), tMax);
+        return tEntry <= tExit;
+    }
+
+
+    // Test one ray against lanes [first, first + lanes count) of a triangle block. Lane types with fewer than 8 lanes
+    // are used on part of the block at a time
+    template <class T>
+    int RayTriangleBlockLanes(const CRay& ray, const CTriangleBlock8& b, int first, float tMax, float* tHit)
+    {
+        T t;
+        auto hit = RayTriangleLanes(T(ray.origin.x), T(ray.origin.y), T(ray.origin.z),
+                                    T(ray.direction.x), T(ray.direction.y), T(ray.direction.z),
+                                    T::Load(b.v0x + first), T::Load(b.v0y + first), T::Load(b.v0z + first),
+                                    T::Load(b.e1x + first), T::Load(b.e1y + first), T::Load(b.e1z + first),
+                                    T::Load(b.e2x + first), T::Load(b.e2y + first), T::Load(b.e2z + first), T(tMax), t);
+        t.Store(tHit + first);
+        return MoveMask(hit) << first;
+    }
+
+    template <class T>
+    int RayPacketTriangleLanes(const CRayPacket8& r, const CVector3& v0, const CVector3& e1, const CVector3& e2, int first, float* t)
+    {
+        T tHit;
+        T tMax = T::Load(t + first);
+        auto hit = RayTriangleLanes(T::Load(r.originX + first), T::Load(r.originY + first), T::Load(r.originZ + first),
+                                    T::Load(r.directionX + first), T::Load(r.directionY + first), T::Load(r.directionZ + first),
+                                    T(v0.x), T(v0.y), T(v0.z), T(e1.x), T(e1.y), T(e1.z), T(e2.x), T(e2.y), T(e2.z), tMax, tHit);
+        Select(hit, tHit, tMax).Store(t + first);
+        return MoveMask(hit) << first;
+    }
+
+    template <class T>
+    int RayAABBBlockLanes(const CRay& ray, const CVector3& invD, const CAABBBlock8& b, int first, float maxT, float* tEntry)
+    {
+        T entry;
+        auto hit = RayAABBLanes(T(ray.origin.x), T(ray.origin.y), T(ray.origin.z), T(invD.x), T(invD.y), T(invD.z),
+                                T::Load(b.minX + first), T::Load(b.minY + first), T::Load(b.minZ + first),
+                                T::Load(b.maxX + first), T::Load(b.maxY + first), T::Load(b.maxZ + first), T(maxT), entry);
+        entry.Store(tEntry + first);
+        return MoveMask(hit) << first;
+    }
+}
+
+
+/*-----------------------------------------------------------------------------------------
+    Building blocks
+-----------------------------------------------------------------------------------------*/
+
+// Convert an indexed triangle list to blocks of 8 triangles
+void BuildTriangleBlocks(const void* positions, std::size_t stride, const std::uint32_t* indices, std::size_t numTriangles,
+                         std::vector<CTriangleBlock8>& blocks)
+{
+    blocks.assign((numTriangles + 7) / 8, CTriangleBlock8{});
+    const unsigned char* data = static_cast<const unsigned char*>(positions);
+    for (std::size_t i = 0; i < numTriangles; ++i)
+    {
+        CVector3 v0 = reinterpret_cast<const float*>(data + indices[i * 3]     * stride);
+        CVector3 v1 = reinterpret_cast<const float*>(data + indices[i * 3 + 1] * stride);
+        CVector3 v2 = reinterpret_cast<const float*>(data + indices[i * 3 + 2] * stride);
+        CVector3 e1 = v1 - v0;
+        CVector3 e2 = v2 - v0;
+
+        CTriangleBlock8& block = blocks[i / 8];
+        std::size_t lane = i % 8;
+        block.v0x[lane] = v0.x;  block.v0y[lane] = v0.y;  block.v0z[lane] = v0.z;
+        block.e1x[lane] = e1.x;  block.e1y[lane] = e1.y;  block.e1z[lane] = e1.z;
+        block.e2x[lane] = e2.x;  block.e2y[lane] = e2.y;  block.e2z[lane] = e2.z;
+    }
+}
+
+// Store a box in a lane (0-7) of a box block
+void SetAABBBlockLane(CAABBBlock8& block, int lane, const CAABB& box)
+{
+    block.minX[lane] = box.min.x;  block.minY[lane] = box.min.y;  block.minZ[lane] = box.min.z;
+    block.maxX[lane] = box.max.x;  block.maxY[lane] = box.max.y;  block.maxZ[lane] = box.max.z;
+}
+
+
+/*-----------------------------------------------------------------------------------------
+    Ray-triangle
+-----------------------------------------------------------------------------------------*/
+
+// Test a ray against one triangle, returns true and updates t if the triangle is hit closer than t
+bool RayTriangle(const CRay& ray, const CVector3& v0, const CVector3& v1, const CVector3& v2, float& t)
+{
+    CVector3 e1 = v1 - v0;
+    CVector3 e2 = v2 - v0;
+    float tHit;
+    if (!RayTriangleLanes(ray.origin.x, ray.origin.y, ray.origin.z, ray.direction.x, ray.direction.y, ray.direction.z,
+                          v0.x, v0.y, v0.z, e1.x, e1.y, e1.z, e2.x, e2.y, e2.z, t, tHit))  return false;
+    t = tHit;
+    return true;
+}
+
+// Test a ray against 8 triangles. Returns the lane of the nearest triangle hit closer than t and updates t, or -1
+int RayTriangles8(const CRay& ray, const CTriangleBlock8& block, float& t)
+{
+    float tHit[8];
+#if defined(MATH_SIMD_AVX)
+    int hits = RayTriangleBlockLanes<Lanes8>(ray, block, 0, t, tHit);
+#elif defined(MATH_SIMD_SSE)
+    int hits = RayTriangleBlockLanes<Lanes4>(ray, block, 0, t, tHit) | RayTriangleBlockLanes<Lanes4>(ray, block, 4, t, tHit);
+#else
+    int hits = 0;
+    for (int i = 0; i < 8; ++i)
+    {
+        if (RayTriangleLanes(ray.origin.x, ray.origin.y, ray.origin.z, ray.direction.x, ray.direction.y, ray.direction.z,
+                             block.v0x[i], block.v0y[i], block.v0z[i], block.e1x[i], block.e1y[i], block.e1z[i],
+                             block.e2x[i], block.e2y[i], block.e2z[i], t, tHit[i]))  hits |= 1 << i;
+    }
+#endif
+    if (hits == 0)  return -1;
+
+    // Nearest of the hits (first one if several are at the same distance)
+    int nearest = -1;
+    for (int i = 0; i < 8; ++i)
+    {
+        if ((hits & (1 << i)) && (nearest < 0 || tHit[i] < tHit[nearest]))  nearest = i;
+    }
+    t = tHit[nearest];
+    return nearest;
+}
+
+// Test 8 rays against one triangle, updating t[i] for the rays that hit. Returns a bit mask of the rays that hit
+int RayPacketTriangle(const CRayPacket8& rays, const CVector3& v0, const CVector3& v1, const CVector3& v2, float* t)
+{
+    CVector3 e1 = v1 - v0;
+    CVector3 e2 = v2 - v0;
+#if defined(MATH_SIMD_AVX)
+    return RayPacketTriangleLanes<Lanes8>(rays, v0, e1, e2, 0, t);
+#elif defined(MATH_SIMD_SSE)
+    return RayPacketTriangleLanes<Lanes4>(rays, v0, e1, e2, 0, t) | RayPacketTriangleLanes<Lanes4>(rays, v0, e1, e2, 4, t);
+#else
+    int hits = 0;
+    for (int i = 0; i < 8; ++i)
+    {
+        float tHit;
+        if (RayTriangleLanes(rays.originX[i], rays.originY[i], rays.originZ[i], rays.directionX[i], rays.directionY[i], rays.directionZ[i],
+                             v0.x, v0.y, v0.z, e1.x, e1.y, e1.z, e2.x, e2.y, e2.z, t[i], tHit))
+        {
+            t[i] = tHit;
+            hits |= 1 << i;
+        }
+    }
+    return hits;
+#endif
+}
+
+// Find the nearest hit of a ray with an array of triangle blocks. Returns the triangle index and updates t, or -1
+std::ptrdiff_t RayTriangleBlocks(const CRay& ray, const std::vector<CTriangleBlock8>& blocks, float& t)
+{
+    std::ptrdiff_t nearest = -1;
+    for (std::size_t i = 0; i < blocks.size(); ++i)
+    {
+        int lane = RayTriangles8(ray, blocks[i], t);
+        if (lane >= 0)  nearest = static_cast<std::ptrdiff_t>(i * 8 + lane);
+    }
+    return nearest;
+}
+
+
+/*-----------------------------------------------------------------------------------------
+    Ray-box
+-----------------------------------------------------------------------------------------*/
+
+// Return 1 / direction for each axis of a ray
+CVector3 RayInverseDirection(const CRay& ray)
+{
+    return { 1.0f / ray.direction.x, 1.0f / ray.direction.y, 1.0f / ray.direction.z };
+}
+
+// Test a ray against a box. Returns true if the ray enters the box between distance 0 and maxT, and sets tEntry
+bool RayAABB(const CRay& ray, const CVector3& inverseDirection, const CAABB& box, float maxT, float& tEntry)
+{
+    const CVector3& invD = inverseDirection;
+    return RayAABBLanes(ray.origin.x, ray.origin.y, ray.origin.z, invD.x, invD.y, invD.z,
+                        box.min.x, box.min.y, box.min.z, box.max.x, box.max.y, box.max.z, maxT, tEntry);
+}
+
+// Test a ray against 8 boxes. Returns a bit mask of the boxes entered between distance 0 and maxT
+int RayAABBs8(const CRay& ray, const CVector3& inverseDirection, const CAABBBlock8& block, float maxT, float* tEntry)
+{
+#if defined(MATH_SIMD_AVX)
+    return RayAABBBlockLanes<Lanes8>(ray, inverseDirection, block, 0, maxT, tEntry);
+#elif defined(MATH_SIMD_SSE)
+    return RayAABBBlockLanes<Lanes4>(ray, inverseDirection, block, 0, maxT, tEntry) |
+           RayAABBBlockLanes<Lanes4>(ray, inverseDirection, block, 4, maxT, tEntry);
+#else
+    const CVector3& invD = inverseDirection;
+    int hits = 0;
+    for (int i = 0; i < 8; ++i)
+    {
+        if (RayAABBLanes(ray.origin.x, ray.origin.y, ray.origin.z, invD.x, invD.y, invD.z,
+                         block.minX[i], block.minY[i], block.minZ[i], block.maxX[i], block.maxY[i], block.maxZ[i], maxT, tEntry[i]))  hits |= 1 << i;
+    }
+    return hits;
+#endif
+}
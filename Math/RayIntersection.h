@@ -0,0 +1,109 @@
+//--------------------------------------------------------------------------------------
+// Ray intersection with triangles and axis-aligned boxes
+//--------------------------------------------------------------------------------------
+// Code in .cpp file
+// Used for picking, line-of-sight checks and baking. Each test has a single version and 8-wide versions that test one
+// ray against 8 triangles or boxes (or 8 rays against one triangle). The 8-wide versions take data in blocks of 8 in
+// structure-of-arrays form and use AVX (one register of 8), SSE (two registers of 4) or scalar code, see MathSIMD.h.
+// All versions give exactly the same results as the single versions.
+// Distances along a ray are in units of the ray direction's length, so use a unit direction to get true distances
+
+#ifndef _RAY_INTERSECTION_H_DEFINED_
+#define _RAY_INTERSECTION_H_DEFINED_
+
+#include "CVector3.h"
+#include "BoundingVolumes.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+/*-----------------------------------------------------------------------------------------
+    Types
+-----------------------------------------------------------------------------------------*/
+
+// Ray starting at the origin and travelling in the given direction
+class CRay
+{
+public:
+    CVector3 origin;
+    CVector3 direction;
+};
+
+// 8 triangles, each stored as its first corner and the two edges from that corner to the other corners
+// Unused lanes in the last block of a mesh are filled with zeros, which never give a hit
+struct CTriangleBlock8
+{
+    float v0x[8], v0y[8], v0z[8];
+    float e1x[8], e1y[8], e1z[8];
+    float e2x[8], e2y[8], e2z[8];
+};
+
+// 8 axis-aligned boxes
+struct CAABBBlock8
+{
+    float minX[8], minY[8], minZ[8];
+    float maxX[8], maxY[8], maxZ[8];
+};
+
+// 8 rays, e.g. neighbouring pixels or samples, which are likely to hit the same triangles
+struct CRayPacket8
+{
+    float originX[8], originY[8], originZ[8];
+    float directionX[8], directionY[8], directionZ[8];
+};
+
+
+/*-----------------------------------------------------------------------------------------
+    Building blocks
+-----------------------------------------------------------------------------------------*/
+
+// Convert an indexed triangle list to blocks of 8 triangles. Positions are read from a stream (the stride is the number
+// of bytes from one position to the next, e.g. the vertex size). Triangle i of the mesh becomes lane i % 8 of block i / 8
+void BuildTriangleBlocks(const void* positions, std::size_t stride, const std::uint32_t* indices, std::size_t numTriangles,
+                         std::vector<CTriangleBlock8>& blocks);
+
+// Store a box in a lane (0-7) of a box block
+void SetAABBBlockLane(CAABBBlock8& block, int lane, const CAABB& box);
+
+
+/*-----------------------------------------------------------------------------------------
+    Ray-triangle (Moller-Trumbore)
+-----------------------------------------------------------------------------------------*/
+// Triangles are hit from either side. On input t is the furthest distance to look for hits (e.g. the nearest hit so
+// far, or a large value). On a hit t is updated with the (nearer) hit distance
+
+// Test a ray against one triangle, returns true and updates t if the triangle is hit closer than t
+bool RayTriangle(const CRay& ray, const CVector3& v0, const CVector3& v1, const CVector3& v2, float& t);
+
+// Test a ray against 8 triangles. Returns the lane (0-7) of the nearest triangle hit closer than t and updates t,
+// or returns -1 if none are hit
+int RayTriangles8(const CRay& ray, const CTriangleBlock8& block, float& t);
+
+// Test 8 rays against one triangle. Each ray i has its own distance t[i], updated for rays that hit the triangle
+// Returns a bit mask of the rays that hit (bit i = ray i)
+int RayPacketTriangle(const CRayPacket8& rays, const CVector3& v0, const CVector3& v1, const CVector3& v2, float* t);
+
+// Find the nearest hit of a ray with an array of triangle blocks (e.g. a whole mesh, tested without any acceleration
+// structure). Returns the triangle index (block * 8 + lane) and updates t, or returns -1 if nothing is hit closer than t
+std::ptrdiff_t RayTriangleBlocks(const CRay& ray, const std::vector<CTriangleBlock8>& blocks, float& t);
+
+
+/*-----------------------------------------------------------------------------------------
+    Ray-box (slab test)
+-----------------------------------------------------------------------------------------*/
+// The slab tests need the reciprocal of the ray direction, calculate it once per ray with RayInverseDirection.
+// A ray starting inside a box gives an entry distance of 0
+
+// Return 1 / direction for each axis of a ray (infinity for zero components, which the slab test handles)
+CVector3 RayInverseDirection(const CRay& ray);
+
+// Test a ray against a box. Returns true if the ray enters the box between distance 0 and maxT, and sets tEntry
+bool RayAABB(const CRay& ray, const CVector3& inverseDirection, const CAABB& box, float maxT, float& tEntry);
+
+// Test a ray against 8 boxes. Returns a bit mask of the boxes entered between distance 0 and maxT (bit i = box i), and
+// writes the entry distance for every box to tEntry[8] (only meaningful for boxes that were hit)
+int RayAABBs8(const CRay& ray, const CVector3& inverseDirection, const CAABBBlock8& block, float maxT, float* tEntry);
+
+
+#endif // _RAY_INTERSECTION_H_DEFINED_
@@ -0,0 +1,276 @@
+//--------------------------------------------------------------------------------------
+// Functions working on streams of vectors held in strided buffers
+//--------------------------------------------------------------------------------------
+// The SSE versions work on four vectors at a time. Each group of four is loaded with unaligned 16-byte loads and
+// transposed into x, y, z registers (structure-of-arrays), so every lane does exactly the same calculation as the
+// scalar code and gives identical results. A 16-byte load of a 3-component vector also reads the 4 bytes after it,
+// which is only safe when another element follows it in the stream, so the last vector is always done separately.
+// There is no AVX version - gathering interleaved data dominates the cost, so wider registers gain very little
+
+#include "VectorStream.h"
+#include "MathHelpers.h"
+#include <cstring>
+
+
+/*-----------------------------------------------------------------------------------------
+    Helpers
+-----------------------------------------------------------------------------------------*/
+
+namespace
+{
+    // Get element i of a stream
+    inline const float* Element(const void* stream, std::size_t stride, std::size_t i)
+    {
+        return reinterpret_cast<const float*>(static_cast<const unsigned char*>(stream) + i * stride);
+    }
+    inline float* Element(void* stream, std::size_t stride, std::size_t i)
+    {
+        return reinterpret_cast<float*>(static_cast<unsigned char*>(stream) + i * stride);
+    }
+
+    // Scalar versions of the maths on a single vector, used when there is no SIMD and for the last few vectors
+    inline void TransformPoint(const float* v, float* out, const CMatrix4x4& m)
+    {
+        float x = v[0], y = v[1], z = v[2];
+        out[0] = x * m.e00 + y * m.e10 + z * m.e20 + m.e30;
+        out[1] = x * m.e01 + y * m.e11 + z * m.e21 + m.e31;
+        out[2] = x * m.e02 + y * m.e12 + z * m.e22 + m.e32;
+    }
+
+    inline void TransformVector(const float* v, float* out, const CMatrix4x4& m)
+    {
+        float x = v[0], y = v[1], z = v[2];
+        out[0] = x * m.e00 + y * m.e10 + z * m.e20;
+        out[1] = x * m.e01 + y * m.e11 + z * m.e21;
+        out[2] = x * m.e02 + y * m.e12 + z * m.e22;
+    }
+
+    inline void NormaliseVector(const float* v, float* out)
+    {
+        float x = v[0], y = v[1], z = v[2];
+        float lengthSq = x*x + y*y + z*z;
+        if (IsZero(lengthSq))
+        {
+            out[0] = out[1] = out[2] = 0.0f;
+        }
+        else
+        {
+            float invLength = InvSqrt(lengthSq);
+            out[0] = x * invLength;
+            out[1] = y * invLength;
+            out[2] = z * invLength;
+        }
+    }
+
+#ifdef MATH_SIMD_SSE
+    // Load the four 3-component vectors starting at element i into separate x, y and z registers
+    // Element i + 4 must exist (see comment at top of file)
+    inline void Load4(const void* stream, std::size_t stride, std::size_t i, __m128& x, __m128& y, __m128& z)
+    {
+        __m128 v0 = _mm_loadu_ps(Element(stream, stride, i));
+        __m128 v1 = _mm_loadu_ps(Element(stream, stride, i + 1));
+        __m128 v2 = _mm_loadu_ps(Element(stream, stride, i + 2));
+        __m128 v3 = _mm_loadu_ps(Element(stream, stride, i + 3));
+        _MM_TRANSPOSE4_PS(v0, v1, v2, v3);
+        x = v0;
+        y = v1;
+        z = v2;
+    }
+
+    // Store a single 3-component vector from the first three lanes of a register without touching the 4th float
+    inline void Store3(float* out, __m128 v)
+    {
+        _mm_storel_pi(reinterpret_cast<__m64*>(out), v);
+        _mm_store_ss(out + 2, _mm_movehl_ps(v, v));
+    }
+
+    // Store x, y and z registers as four 3-component vectors starting at element i
+    inline void Store4(void* stream, std::size_t stride, std::size_t i, __m128 x, __m128 y, __m128 z)
+    {
+        __m128 w = _mm_setzero_ps();
+        _MM_TRANSPOSE4_PS(x, y, z, w);
+        Store3(Element(stream, stride, i),     x);
+        Store3(Element(stream, stride, i + 1), y);
+        Store3(Element(stream, stride, i + 2), z);
+        Store3(Element(stream, stride, i + 3), w);
+    }
+
+    // Load a single 3-component vector into the first three lanes of a register, 4th lane is 0
+    inline __m128 Load3(const float* v)
+    {
+        return _mm_setr_ps(v[0], v[1], v[2], 0.0f);
+    }
+#endif
+}
+
+
+/*-----------------------------------------------------------------------------------------
+    Copying / conversion
+-----------------------------------------------------------------------------------------*/
+
+// Copy a stream of 3-component vectors
+void StreamCopyVector3(const void* source, std::size_t sourceStride,
+                       void* destination, std::size_t destinationStride, std::size_t count)
+{
+    const std::size_t size = 3 * sizeof(float);
+    if (sourceStride == size && destinationStride == size)
+    {
+        std::memcpy(destination, source, count * size);
+        return;
+    }
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        std::memcpy(Element(destination, destinationStride, i), Element(source, sourceStride, i), size);
+    }
+}
+
+// Copy a stream of 2-component vectors
+void StreamCopyVector2(const void* source, std::size_t sourceStride,
+                       void* destination, std::size_t destinationStride, std::size_t count)
+{
+    const std::size_t size = 2 * sizeof(float);
+    if (sourceStride == size && destinationStride == size)
+    {
+        std::memcpy(destination, source, count * size);
+        return;
+    }
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        std::memcpy(Element(destination, destinationStride, i), Element(source, sourceStride, i), size);
+    }
+}
+
+// Copy the x and y components of a stream of 3-component vectors to a stream of 2-component vectors
+void StreamConvertVector3ToVector2(const void* source, std::size_t sourceStride,
+                                   void* destination, std::size_t destinationStride, std::size_t count)
+{
+    // Same as copying 2-component vectors from a stream with the source stride
+    StreamCopyVector2(source, sourceStride, destination, destinationStride, count);
+}
+
+
+/*-----------------------------------------------------------------------------------------
+    Maths
+-----------------------------------------------------------------------------------------*/
+
+// Transform a stream of points by a matrix (treating them as having w = 1, so translation is applied)
+void StreamTransformPoints(const void* source, std::size_t sourceStride,
+                           void* destination, std::size_t destinationStride, std::size_t count, const CMatrix4x4& m)
+{
+    std::size_t i = 0;
+#ifdef MATH_SIMD_SSE
+    const __m128 m00 = _mm_set1_ps(m.e00), m01 = _mm_set1_ps(m.e01), m02 = _mm_set1_ps(m.e02);
+    const __m128 m10 = _mm_set1_ps(m.e10), m11 = _mm_set1_ps(m.e11), m12 = _mm_set1_ps(m.e12);
+    const __m128 m20 = _mm_set1_ps(m.e20), m21 = _mm_set1_ps(m.e21), m22 = _mm_set1_ps(m.e22);
+    const __m128 m30 = _mm_set1_ps(m.e30), m31 = _mm_set1_ps(m.e31), m32 = _mm_set1_ps(m.e32);
+    for (; i + 4 < count; i += 4)
+    {
+        __m128 x, y, z;
+        Load4(source, sourceStride, i, x, y, z);
+        __m128 outX = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m00), _mm_mul_ps(y, m10)), _mm_mul_ps(z, m20)), m30);
+        __m128 outY = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m01), _mm_mul_ps(y, m11)), _mm_mul_ps(z, m21)), m31);
+        __m128 outZ = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m02), _mm_mul_ps(y, m12)), _mm_mul_ps(z, m22)), m32);
+        Store4(destination, destinationStride, i, outX, outY, outZ);
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        TransformPoint(Element(source, sourceStride, i), Element(destination, destinationStride, i), m);
+    }
+}
+
+// Transform a stream of vectors by a matrix (treating them as having w = 0, so no translation)
+void StreamTransformVectors(const void* source, std::size_t sourceStride,
+                            void* destination, std::size_t destinationStride, std::size_t count, const CMatrix4x4& m)
+{
+    std::size_t i = 0;
+#ifdef MATH_SIMD_SSE
+    const __m128 m00 = _mm_set1_ps(m.e00), m01 = _mm_set1_ps(m.e01), m02 = _mm_set1_ps(m.e02);
+    const __m128 m10 = _mm_set1_ps(m.e10), m11 = _mm_set1_ps(m.e11), m12 = _mm_set1_ps(m.e12);
+    const __m128 m20 = _mm_set1_ps(m.e20), m21 = _mm_set1_ps(m.e21), m22 = _mm_set1_ps(m.e22);
+    for (; i + 4 < count; i += 4)
+    {
+        __m128 x, y, z;
+        Load4(source, sourceStride, i, x, y, z);
+        __m128 outX = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m00), _mm_mul_ps(y, m10)), _mm_mul_ps(z, m20));
+        __m128 outY = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m01), _mm_mul_ps(y, m11)), _mm_mul_ps(z, m21));
+        __m128 outZ = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m02), _mm_mul_ps(y, m12)), _mm_mul_ps(z, m22));
+        Store4(destination, destinationStride, i, outX, outY, outZ);
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        TransformVector(Element(source, sourceStride, i), Element(destination, destinationStride, i), m);
+    }
+}
+
+// Normalise a stream of vectors. Gives the same results as the Normalise function, zero length vectors become zero
+void StreamNormalise(const void* source, std::size_t sourceStride,
+                     void* destination, std::size_t destinationStride, std::size_t count)
+{
+    std::size_t i = 0;
+#ifdef MATH_SIMD_SSE
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 epsilon = _mm_set1_ps(EPSILON);
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    for (; i + 4 < count; i += 4)
+    {
+        __m128 x, y, z;
+        Load4(source, sourceStride, i, x, y, z);
+        __m128 lengthSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+        __m128 invLength = _mm_div_ps(one, _mm_sqrt_ps(lengthSq));
+
+        // Lanes where IsZero(lengthSq) is true are set to zero
+        __m128 nonZero = _mm_cmpge_ps(_mm_and_ps(lengthSq, absMask), epsilon);
+        invLength = _mm_and_ps(invLength, nonZero);
+        Store4(destination, destinationStride, i, _mm_mul_ps(x, invLength), _mm_mul_ps(y, invLength), _mm_mul_ps(z, invLength));
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        NormaliseVector(Element(source, sourceStride, i), Element(destination, destinationStride, i));
+    }
+}
+
+// Find the minimum and maximum x, y and z of a stream of points (i.e. an axis-aligned bounding box)
+void StreamBounds(const void* source, std::size_t sourceStride, std::size_t count, CVector3& min, CVector3& max)
+{
+    if (count == 0)  return;
+
+#ifdef MATH_SIMD_SSE
+    // Working on one point per register here, the 4th lane is ignored
+    __m128 vMin = Load3(Element(source, sourceStride, 0));
+    __m128 vMax = vMin;
+    std::size_t i = 1;
+    for (; i + 1 < count; ++i)
+    {
+        __m128 v = _mm_loadu_ps(Element(source, sourceStride, i));
+        vMin = _mm_min_ps(vMin, v);
+        vMax = _mm_max_ps(vMax, v);
+    }
+    for (; i < count; ++i)
+    {
+        __m128 v = Load3(Element(source, sourceStride, i));
+        vMin = _mm_min_ps(vMin, v);
+        vMax = _mm_max_ps(vMax, v);
+    }
+    alignas(16) float outMin[4], outMax[4];
+    _mm_store_ps(outMin, vMin);
+    _mm_store_ps(outMax, vMax);
+    min = { outMin[0], outMin[1], outMin[2] };
+    max = { outMax[0], outMax[1], outMax[2] };
+#else
+    const float* v = Element(source, sourceStride, 0);
+    min = max = { v[0], v[1], v[2] };
+    for (std::size_t i = 1; i < count; ++i)
+    {
+        v = Element(source, sourceStride, i);
+        if (v[0] < min.x)  min.x = v[0];
+        if (v[1] < min.y)  min.y = v[1];
+        if (v[2] < min.z)  min.z = v[2];
+        if (v[0] > max.x)  max.x = v[0];
+        if (v[1] > max.y)  max.y = v[1];
+        if (v[2] > max.z)  max.z = v[2];
+    }
+#endif
+}
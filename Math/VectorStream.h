@@ -0,0 +1,60 @@
+//--------------------------------------------------------------------------------------
+// Functions working on streams of vectors held in strided buffers
+//--------------------------------------------------------------------------------------
+// Code in .cpp file
+// Vertex data is usually interleaved - each vertex holds a position, normal, uv etc. one after another. These functions
+// work on one element of every vertex in such a buffer. Each buffer is given as a pointer to the first element
+// and a stride, which is the number of bytes from one element to the next (e.g. the vertex size). A stride equal
+// to the element size is a tightly packed array, so the copy functions can also gather an element out of
+// interleaved vertices into an array (or scatter it back in the other direction).
+// Source and destination can be the same buffer for the transform and normalise functions, but must not otherwise overlap
+
+#ifndef _VECTOR_STREAM_H_DEFINED_
+#define _VECTOR_STREAM_H_DEFINED_
+
+#include "CVector3.h"
+#include "CMatrix4x4.h"
+#include <cstddef>
+
+
+/*-----------------------------------------------------------------------------------------
+    Copying / conversion
+-----------------------------------------------------------------------------------------*/
+
+// Copy a stream of 3-component vectors
+void StreamCopyVector3(const void* source, std::size_t sourceStride,
+                       void* destination, std::size_t destinationStride, std::size_t count);
+
+// Copy a stream of 2-component vectors
+void StreamCopyVector2(const void* source, std::size_t sourceStride,
+                       void* destination, std::size_t destinationStride, std::size_t count);
+
+// Copy the x and y components of a stream of 3-component vectors to a stream of 2-component vectors
+// e.g. copy texture coordinates from assimp (which are always 3D) to a vertex buffer
+void StreamConvertVector3ToVector2(const void* source, std::size_t sourceStride,
+                                   void* destination, std::size_t destinationStride, std::size_t count);
+
+
+/*-----------------------------------------------------------------------------------------
+    Maths
+-----------------------------------------------------------------------------------------*/
+
+// Transform a stream of points by a matrix (treating them as having w = 1, so translation is applied)
+void StreamTransformPoints(const void* source, std::size_t sourceStride,
+                           void* destination, std::size_t destinationStride, std::size_t count, const CMatrix4x4& m);
+
+// Transform a stream of vectors by a matrix (treating them as having w = 0, so no translation). Use for normals and
+// tangents, but note that normals need the inverse transpose matrix if the matrix contains non-uniform scaling
+void StreamTransformVectors(const void* source, std::size_t sourceStride,
+                            void* destination, std::size_t destinationStride, std::size_t count, const CMatrix4x4& m);
+
+// Normalise a stream of vectors. Gives the same results as the Normalise function, zero length vectors become zero
+void StreamNormalise(const void* source, std::size_t sourceStride,
+                     void* destination, std::size_t destinationStride, std::size_t count);
+
+// Find the minimum and maximum x, y and z of a stream of points (i.e. an axis-aligned bounding box)
+// Leaves min and max unchanged if count is 0
+void StreamBounds(const void* source, std::size_t sourceStride, std::size_t count, CVector3& min, CVector3& max);
+
+
+#endif // _VECTOR_STREAM_H_DEFINED_
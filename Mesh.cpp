@@ -2,267 +2,252 @@
 // Class encapsulating a mesh
 //--------------------------------------------------------------------------------------
 // The mesh class splits the mesh into sub-meshes that only use one texture each.
-// ** THIS VERSION WILL ONLY KEEP THE FIRST SUB-MESH OTHER PARTS WILL BE MISSING **
-// ** DO NOT USE THIS VERSION FOR PROJECTS **
+// All sub-meshes share one vertex buffer and one index buffer, each sub-mesh is a range of them.
 // The class also doesn't load textures, filters or shaders as the outer code is
 // expected to select these things. A later lab will introduce a more robust loader.
 
 #include "Mesh.h"
-#include "Shader.h" // Needed for helper function CreateSignatureForVertexLayout
-#include "CVector2.h" 
-#include "CVector3.h" 
-#include <stdexcept>
-
-#include <assimp/Importer.hpp>
-#include <assimp/DefaultLogger.hpp>
-#include <assimp/postprocess.h>
-#include <assimp/scene.h>
-
+#include "MeshCache.h"       // Importing or loading cached mesh data
+#include "MeshClusters.h"    // Culling parts of the mesh
+#include "GraphicsHelpers.h" // Creating vertex layouts and buffers
 #include <memory>
+#include <stdexcept>
 
 
 // Pass the name of the mesh file to load. Uses assimp (http://www.assimp.org/) to support many file types
 // Optionally request tangents to be calculated (for normal and parallax mapping - see later lab)
 // Will throw a std::runtime_error exception on failure (since constructors can't return errors).
-Mesh::Mesh(const std::string& fileName, bool requireTangents /*= false*/)
+// Imports the mesh with assimp, or on later runs memory-maps the copy in the mesh cache (see MeshCache.h)
+Mesh::Mesh(const std::string& fileName, bool requireTangents /*= false*/, bool compactVertices /*= false*/,
+           unsigned int numLods /*= 0*/, bool retainGeometry /*= false*/, bool generateTangents /*= true*/)
+    : Mesh(LoadMeshSource(fileName, ImportOptions(requireTangents, compactVertices, numLods, retainGeometry, generateTangents)), fileName)
 {
-    Assimp::Importer importer;
-
-    // Flags for processing the mesh. Assimp provides a huge amount of control - right click any of these
-    // and "Peek Definition" to see documention above each constant
-    unsigned int assimpFlags = aiProcess_MakeLeftHanded |
-        aiProcess_GenSmoothNormals |
-        aiProcess_FixInfacingNormals |
-        aiProcess_GenUVCoords |
-        aiProcess_TransformUVCoords |
-        aiProcess_FlipUVs |
-        aiProcess_FlipWindingOrder |
-        aiProcess_Triangulate |
-        aiProcess_PreTransformVertices |
-        aiProcess_JoinIdenticalVertices |
-        aiProcess_ImproveCacheLocality |
-        aiProcess_SortByPType |
-        aiProcess_FindInvalidData |
-        aiProcess_OptimizeMeshes |
-        aiProcess_FindInstances |
-        aiProcess_FindDegenerates |
-        aiProcess_RemoveRedundantMaterials |
-        aiProcess_Debone |
-        aiProcess_RemoveComponent;
-
-    // Flags to specify what mesh data to ignore
-    int removeComponents = aiComponent_LIGHTS | aiComponent_CAMERAS | aiComponent_TEXTURES | aiComponent_COLORS |
-        aiComponent_BONEWEIGHTS | aiComponent_ANIMATIONS | aiComponent_MATERIALS;
-
-    // Add / remove tangents as required by user
-    if (requireTangents)
-    {
-        assimpFlags |= aiProcess_CalcTangentSpace;
-    }
-    else
-    {
-        removeComponents |= aiComponent_TANGENTS_AND_BITANGENTS;
-    }
-
-    // Other miscellaneous settings
-    importer.SetPropertyFloat(AI_CONFIG_PP_GSN_MAX_SMOOTHING_ANGLE, 80.0f); // Smoothing angle for normals
-    importer.SetPropertyInteger(AI_CONFIG_PP_SBP_REMOVE, aiPrimitiveType_POINT | aiPrimitiveType_LINE);  // Remove points and lines (keep triangles only)
-    importer.SetPropertyBool(AI_CONFIG_PP_FD_REMOVE, true);                 // Remove degenerate triangles
-    importer.SetPropertyBool(AI_CONFIG_PP_DB_ALL_OR_NONE, true);            // Default to removing bones/weights from meshes that don't need skinning
-
-    importer.SetPropertyInteger(AI_CONFIG_PP_RVC_FLAGS, removeComponents);
-
-    // Import mesh with assimp given above requirements - log output
-    Assimp::DefaultLogger::create("", Assimp::DefaultLogger::VERBOSE);
-    const aiScene* scene = importer.ReadFile(fileName, assimpFlags);
-    Assimp::DefaultLogger::kill();
-    if (scene == nullptr)  throw std::runtime_error("Error loading mesh (" + fileName + "). " + importer.GetErrorString());
-    if (scene->mNumMeshes == 0)  throw std::runtime_error("No usable geometry in mesh: " + fileName);
+}
 
 
-    //-----------------------------------
+// Create the mesh from mesh data that has already been loaded. Only creates the GPU resources, or queues the buffers
+// if given an upload queue. Will throw a std::runtime_error exception on failure
+Mesh::Mesh(const MeshSource& source, const std::string& fileName, UploadQueue* uploads /*= nullptr*/)
+{
+    // Create a "vertex layout" to describe to DirectX what is data in each vertex of this mesh
+    mVertexSize = source.format.vertexSize;
+    mVertexLayout = CreateVertexLayout(source.format);
+    if (mVertexLayout == nullptr)  throw std::runtime_error("Failure creating input layout for " + fileName);
+    mPositionSize = PositionSize(source.format);
+    mPositionLayout = CreateVertexLayout(source.format, true);
+    if (mPositionLayout == nullptr)  throw std::runtime_error("Failure creating position input layout for " + fileName);
 
-    // Only importing first submesh - significant limitation - do not use this importer for your own projects
-    aiMesh* assimpMesh = scene->mMeshes[0];
-    std::string subMeshName = assimpMesh->mName.C_Str();
+    mPositionOffset = CVector3(source.format.positionOffset);
+    mPositionScale = CVector3(source.format.positionScale);
+    mCompactVertices = source.format.compact != 0;
 
 
     //-----------------------------------
 
-    // Check for presence of position and normal data. Tangents and UVs are optional.
-    std::vector<D3D11_INPUT_ELEMENT_DESC> vertexElements;
-    unsigned int offset = 0;
-
-    if (!assimpMesh->HasPositions())  throw std::runtime_error("No position data for sub-mesh " + subMeshName + " in " + fileName);
-    unsigned int positionOffset = offset;
-    vertexElements.push_back({ "Position", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, positionOffset, D3D11_INPUT_PER_VERTEX_DATA, 0 });
-    offset += 12;
-
-    if (!assimpMesh->HasNormals())  throw std::runtime_error("No normal data for sub-mesh " + subMeshName + " in " + fileName);
-    unsigned int normalOffset = offset;
-    vertexElements.push_back({ "Normal", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, normalOffset, D3D11_INPUT_PER_VERTEX_DATA, 0 });
-    offset += 12;
-
-    unsigned int tangentOffset = offset;
-    if (requireTangents)
+    // Create GPU-side vertex and index buffers holding every sub-mesh, each sub-mesh is drawn from its own range
+    mNumVertices = static_cast<unsigned int>(source.vertices.size / mVertexSize);
+    mNumIndices = static_cast<unsigned int>(source.NumIndices());
+    mSubMeshes.assign(source.subMeshes.begin(), source.subMeshes.end());
+    mLods.assign(source.lods.begin(), source.lods.end());
+    mLodSubMeshes.assign(source.lodSubMeshes.begin(), source.lodSubMeshes.end());
+    mBoundingSphere = SphereFromAABB(source.bounds);
+
+    mClusters.assign(source.clusters.begin(), source.clusters.end());
+    mClusterVisible.resize(mClusters.size());
+    mFirstCluster.assign(mSubMeshes.size() + 1, 0);
+    for (auto& cluster : mClusters)  ++mFirstCluster[cluster.subMesh + 1];
+    for (std::size_t s = 0; s < mSubMeshes.size(); ++s)  mFirstCluster[s + 1] += mFirstCluster[s];
+
+    mBVH = MeshBVH(source);
+
+    // Use 16-bit indices (2 bytes each) if the import packed them, which halves the index memory and bandwidth. Sub-mesh
+    // indices are relative to their first vertex, so this works for any mesh whose sub-meshes each have at most 65536
+    // vertices (the import splits larger ones). Otherwise 32-bit indices (4 bytes each)
+    const void* indices = source.indices.data;
+    mIndexSize = sizeof(DWORD);
+    mIndexFormat = DXGI_FORMAT_R32_UINT;
+    if (!source.shortIndices.empty())
     {
-        if (!assimpMesh->HasTangentsAndBitangents())  throw std::runtime_error("No tangent data for sub-mesh " + subMeshName + " in " + fileName);
-        vertexElements.push_back({ "Tangent", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, tangentOffset, D3D11_INPUT_PER_VERTEX_DATA, 0 });
-        offset += 12;
+        indices = source.shortIndices.data;
+        mIndexSize = sizeof(WORD);
+        mIndexFormat = DXGI_FORMAT_R16_UINT;
     }
 
-    unsigned int uvOffset = offset;
-    if (assimpMesh->GetNumUVChannels() > 0 && assimpMesh->HasTextureCoords(0))
-    {
-        if (assimpMesh->mNumUVComponents[0] != 2)  throw std::runtime_error("Unsupported texture coordinates in " + subMeshName + " in " + fileName);
-        vertexElements.push_back({ "UV", 0, DXGI_FORMAT_R32G32_FLOAT, 0, uvOffset, D3D11_INPUT_PER_VERTEX_DATA, 0 });
-        offset += 8;
-    }
-
-    mVertexSize = offset;
-
-
-    // Create a "vertex layout" to describe to DirectX what is data in each vertex of this mesh
-    auto shaderSignature = CreateSignatureForVertexLayout(vertexElements.data(), static_cast<int>(vertexElements.size()));
-    HRESULT hr = gD3DDevice->CreateInputLayout(vertexElements.data(), static_cast<UINT>(vertexElements.size()),
-        shaderSignature->GetBufferPointer(), shaderSignature->GetBufferSize(),
-        &mVertexLayout);
-    if (shaderSignature)  shaderSignature->Release();
-    if (FAILED(hr))  throw std::runtime_error("Failure creating input layout for " + fileName);
-
-
-
-    //-----------------------------------
-
-    // Create CPU-side buffers to hold current mesh data - exact content is flexible so can't use a structure for a vertex - so just a block of bytes
-    // Note: for large arrays a unique_ptr is better than a vector because vectors default-initialise all the values which is a waste of time.
-    mNumVertices = assimpMesh->mNumVertices;
-    mNumIndices = assimpMesh->mNumFaces * 3;
-    auto vertices = std::make_unique<unsigned char[]>(mNumVertices * mVertexSize);
-    auto indices = std::make_unique<unsigned char[]>(mNumIndices * 4); // Using 32 bit indexes (4 bytes) for each indeex
-
-
-    //-----------------------------------
-
-    // Copy mesh data from assimp to our CPU-side vertex buffer
-
-    CVector3* assimpPosition = reinterpret_cast<CVector3*>(assimpMesh->mVertices);
-    unsigned char* position = vertices.get() + positionOffset;
-    unsigned char* positionEnd = position + mNumVertices * mVertexSize;
-    while (position != positionEnd)
+    // Separate stream of positions alone, so depth-only passes fetch a fraction of each vertex. Positions keep the
+    // vertices' encoding, so the same decoding applies (see SetVertexDecoding). The depth version from the import (see
+    // MeshDepth.h) has the positions welded with its own indices, otherwise the positions are copied out of the vertices
+    // and drawn with the main indices
+    std::shared_ptr<const void> positionStorage = source.storage;
+    const void* positions = source.depthVertices.data;
+    std::size_t positionBytes = source.depthVertices.size;
+    const void* depthIndices = source.depthShortIndices.empty() ? source.depthIndices.data : source.depthShortIndices.data;
+    mHasDepthIndices = !source.depthSubMeshes.empty();
+    if (mHasDepthIndices)
     {
-        *(CVector3*)position = *assimpPosition;
-        position += mVertexSize;
-        ++assimpPosition;
+        mDepthSubMeshes.assign(source.depthSubMeshes.begin(), source.depthSubMeshes.end());
     }
-
-    CVector3* assimpNormal = reinterpret_cast<CVector3*>(assimpMesh->mNormals);
-    unsigned char* normal = vertices.get() + normalOffset;
-    unsigned char* normalEnd = normal + mNumVertices * mVertexSize;
-    while (normal != normalEnd)
+    else
     {
-        *(CVector3*)normal = *assimpNormal;
-        normal += mVertexSize;
-        ++assimpNormal;
+        auto extracted = std::make_shared<std::vector<std::uint8_t>>(ExtractPositions(source.vertices.data, mNumVertices, source.format));
+        positions = extracted->data();
+        positionBytes = extracted->size();
+        positionStorage = std::move(extracted);
+        mDepthSubMeshes = mSubMeshes;
     }
+    mBufferBytes = mNumVertices * mVertexSize + positionBytes + mNumIndices * mIndexSize * (mHasDepthIndices ? 2 : 1);
 
-    if (requireTangents)
+    if (uploads != nullptr)
     {
-        CVector3* assimpTangent = reinterpret_cast<CVector3*>(assimpMesh->mTangents);
-        unsigned char* tangent = vertices.get() + tangentOffset;
-        unsigned char* tangentEnd = tangent + mNumVertices * mVertexSize;
-        while (tangent != tangentEnd)
+        // The queue keeps the source's storage alive until the buffers are created
+        mUploads = uploads;
+        mVertexUpload = uploads->Enqueue(D3D11_BIND_VERTEX_BUFFER, source.vertices.data, mNumVertices * mVertexSize,
+                                         source.storage, [this](ID3D11Buffer* buffer) { mVertexBuffer = buffer; mVertexUpload = 0; });
+        mPositionUpload = uploads->Enqueue(D3D11_BIND_VERTEX_BUFFER, positions, positionBytes,
+                                           positionStorage, [this](ID3D11Buffer* buffer) { mPositionBuffer = buffer; mPositionUpload = 0; });
+        mIndexUpload = uploads->Enqueue(D3D11_BIND_INDEX_BUFFER, indices, mNumIndices * mIndexSize,
+                                        source.storage, [this](ID3D11Buffer* buffer) { mIndexBuffer = buffer; mIndexUpload = 0; });
+        if (mHasDepthIndices)
         {
-            *(CVector3*)tangent = *assimpTangent;
-            tangent += mVertexSize;
-            ++assimpTangent;
+            mDepthIndexUpload = uploads->Enqueue(D3D11_BIND_INDEX_BUFFER, depthIndices, mNumIndices * mIndexSize,
+                                                 source.storage, [this](ID3D11Buffer* buffer) { mDepthIndexBuffer = buffer; mDepthIndexUpload = 0; });
         }
+        return;
     }
 
-    if (assimpMesh->GetNumUVChannels() > 0 && assimpMesh->HasTextureCoords(0))
+    mVertexBuffer = CreateBufferFromData(D3D11_BIND_VERTEX_BUFFER, source.vertices.data, mNumVertices * mVertexSize);
+    if (mVertexBuffer == nullptr)  throw std::runtime_error("Failure creating vertex buffer for " + fileName);
+    mPositionBuffer = CreateBufferFromData(D3D11_BIND_VERTEX_BUFFER, positions, positionBytes);
+    if (mPositionBuffer == nullptr)  throw std::runtime_error("Failure creating position buffer for " + fileName);
+    mIndexBuffer = CreateBufferFromData(D3D11_BIND_INDEX_BUFFER, indices, mNumIndices * mIndexSize);
+    if (mIndexBuffer == nullptr)  throw std::runtime_error("Failure creating index buffer for " + fileName);
+    if (mHasDepthIndices)
     {
-        aiVector3D* assimpUV = assimpMesh->mTextureCoords[0];
-        unsigned char* uv = vertices.get() + uvOffset;
-        unsigned char* uvEnd = uv + mNumVertices * mVertexSize;
-        while (uv != uvEnd)
-        {
-            *(CVector2*)uv = CVector2(assimpUV->x, assimpUV->y);
-            uv += mVertexSize;
-            ++assimpUV;
-        }
+        mDepthIndexBuffer = CreateBufferFromData(D3D11_BIND_INDEX_BUFFER, depthIndices, mNumIndices * mIndexSize);
+        if (mDepthIndexBuffer == nullptr)  throw std::runtime_error("Failure creating depth index buffer for " + fileName);
     }
+}
 
 
-    //-----------------------------------
+// The import options the file constructor uses
+MeshImportOptions Mesh::ImportOptions(bool requireTangents /*= false*/, bool compactVertices /*= false*/,
+                                      unsigned int numLods /*= 0*/, bool retainGeometry /*= false*/,
+                                      bool generateTangents /*= true*/)
+{
+    MeshImportOptions options;
+    options.requireTangents = requireTangents;
+    options.generateTangents = generateTangents;
+    options.compactVertices = compactVertices;
+    options.numLods = numLods;
+    options.retainGeometry = retainGeometry;
+    return options;
+}
 
-    // Copy face data from assimp to our CPU-side index buffer
-    if (!assimpMesh->HasFaces())  throw std::runtime_error("No face data in " + subMeshName + " in " + fileName);
-
-    DWORD* index = reinterpret_cast<DWORD*>(indices.get());
-    for (unsigned int face = 0; face < assimpMesh->mNumFaces; ++face)
-    {
-        *index++ = assimpMesh->mFaces[face].mIndices[0];
-        *index++ = assimpMesh->mFaces[face].mIndices[1];
-        *index++ = assimpMesh->mFaces[face].mIndices[2];
-    }
 
+Mesh::~Mesh()
+{
+    if (mVertexUpload != 0)      mUploads->Cancel(mVertexUpload);
+    if (mPositionUpload != 0)    mUploads->Cancel(mPositionUpload);
+    if (mIndexUpload != 0)       mUploads->Cancel(mIndexUpload);
+    if (mDepthIndexUpload != 0)  mUploads->Cancel(mDepthIndexUpload);
+    if (mDepthIndexBuffer)  mDepthIndexBuffer->Release();
+    if (mIndexBuffer)       mIndexBuffer->Release();
+    if (mPositionBuffer)    mPositionBuffer->Release();
+    if (mPositionLayout)    mPositionLayout->Release();
+    if (mVertexBuffer)      mVertexBuffer->Release();
+    if (mVertexLayout)      mVertexLayout->Release();
+}
 
-    //-----------------------------------
 
-    D3D11_BUFFER_DESC bufferDesc;
-    D3D11_SUBRESOURCE_DATA initData;
+// The render function assumes shaders, matrices, textures, samplers etc. have been set up already.
+// It simply draws this mesh with whatever settings the GPU is currently using.
+void Mesh::Render(unsigned int lod /*= 0*/, bool positionsOnly /*= false*/)
+{
+    if (!IsResident())  return;
 
-    // Create GPU-side vertex buffer and copy the vertices imported by assimp into it
-    bufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER; // Indicate it is a vertex buffer
-    bufferDesc.Usage = D3D11_USAGE_DEFAULT;          // Default usage for this buffer - we'll see other usages later
-    bufferDesc.ByteWidth = mNumVertices * mVertexSize; // Size of the buffer in bytes
-    bufferDesc.CPUAccessFlags = 0;
-    bufferDesc.MiscFlags = 0;
-    initData.pSysMem = vertices.get(); // Fill the new vertex buffer with data loaded by assimp
+    SetBuffersOnGPU(positionsOnly);
+    for (unsigned int subMesh = 0; subMesh < mSubMeshes.size(); ++subMesh)
+    {
+        RenderSubMesh(subMesh, lod, positionsOnly);
+    }
+}
 
-    hr = gD3DDevice->CreateBuffer(&bufferDesc, &initData, &mVertexBuffer);
-    if (FAILED(hr))  throw std::runtime_error("Failure creating vertex buffer for " + fileName);
 
+// Draw only the parts of the mesh that may be seen through the given frustum by a viewer at the given point
+unsigned int Mesh::RenderVisible(const CFrustum& frustum, const CVector3& viewPoint, bool cullBackFaces /*= true*/,
+                                 unsigned int lod /*= 0*/, bool positionsOnly /*= false*/)
+{
+    if (!IsResident() || !IsVisible(frustum, mBoundingSphere))  return 0;
 
-    // Create GPU-side index buffer and copy the vertices imported by assimp into it
-    bufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER; // Indicate it is an index buffer
-    bufferDesc.Usage = D3D11_USAGE_DEFAULT;         // Default usage for this buffer - we'll see other usages later
-    bufferDesc.ByteWidth = mNumIndices * sizeof(DWORD); // Size of the buffer in bytes
-    bufferDesc.CPUAccessFlags = 0;
-    bufferDesc.MiscFlags = 0;
-    initData.pSysMem = indices.get(); // Fill the new index buffer with data loaded by assimp
+    SetBuffersOnGPU(positionsOnly);
+    if (lod == 0)  CullClusters(mClusters.data(), mClusters.size(), frustum, viewPoint, cullBackFaces, mClusterVisible.data());
+    unsigned int numTriangles = 0;
+    for (unsigned int subMesh = 0; subMesh < mSubMeshes.size(); ++subMesh)
+    {
+        const SubMesh& range = mSubMeshes[subMesh];
+        if (lod > 0 || mFirstCluster[subMesh] == mFirstCluster[subMesh + 1])
+        {
+            RenderSubMesh(subMesh, lod, positionsOnly);
+            numTriangles += (lod == 0 ? range.numIndices : mLodSubMeshes[mLods[lod - 1].firstSubMesh + subMesh].numIndices) / 3;
+            continue;
+        }
 
-    hr = gD3DDevice->CreateBuffer(&bufferDesc, &initData, &mIndexBuffer);
-    if (FAILED(hr))  throw std::runtime_error("Failure creating index buffer for " + fileName);
+        // Clusters are consecutive ranges of the sub-mesh's indices, so each run of visible clusters is one draw. The
+        // depth version has the same index ranges but its own vertices
+        INT baseVertex = static_cast<INT>((positionsOnly ? mDepthSubMeshes[subMesh] : range).firstVertex);
+        for (unsigned int c = mFirstCluster[subMesh]; c < mFirstCluster[subMesh + 1]; )
+        {
+            if (!mClusterVisible[c])
+            {
+                ++c;
+                continue;
+            }
+            unsigned int firstIndex = mClusters[c].firstIndex;
+            unsigned int numIndices = 0;
+            for (; c < mFirstCluster[subMesh + 1] && mClusterVisible[c]; ++c)  numIndices += mClusters[c].numIndices;
+            gD3DContext->DrawIndexed(numIndices, firstIndex, baseVertex);
+            numTriangles += numIndices / 3;
+        }
+    }
+    return numTriangles;
 }
 
 
-Mesh::~Mesh()
+// Set the values the vertex shaders use to decode this mesh's vertices
+void Mesh::SetVertexDecoding(PerModelConstants& constants) const
 {
-    if (mIndexBuffer)   mIndexBuffer->Release();
-    if (mVertexBuffer)  mVertexBuffer->Release();
-    if (mVertexLayout)  mVertexLayout->Release();
+    constants.positionOffset = mPositionOffset;
+    constants.positionScale = mPositionScale;
+    constants.compactVertices = mCompactVertices ? 1.0f : 0.0f;
 }
 
 
-// The render function assumes shaders, matrices, textures, samplers etc. have been set up already.
-// It simply draws this mesh with whatever settings the GPU is currently using.
-void Mesh::Render()
+// Set this mesh's vertex buffer, index buffer and layout as the GPU's current geometry
+void Mesh::SetBuffersOnGPU(bool positionsOnly /*= false*/)
 {
-    // Set vertex buffer as next data source for GPU
-    UINT stride = mVertexSize;
+    // Set vertex buffer as next data source for GPU, or the position stream
+    UINT stride = positionsOnly ? mPositionSize : mVertexSize;
     UINT offset = 0;
-    gD3DContext->IASetVertexBuffers(0, 1, &mVertexBuffer, &stride, &offset);
+    gD3DContext->IASetVertexBuffers(0, 1, positionsOnly ? &mPositionBuffer : &mVertexBuffer, &stride, &offset);
 
     // Indicate the layout of vertex buffer
-    gD3DContext->IASetInputLayout(mVertexLayout);
+    gD3DContext->IASetInputLayout(positionsOnly ? mPositionLayout : mVertexLayout);
 
-    // Set index buffer as next data source for GPU, indicate it uses 32-bit integers
-    gD3DContext->IASetIndexBuffer(mIndexBuffer, DXGI_FORMAT_R32_UINT, 0);
+    // Set index buffer as next data source for GPU, indicate whether it uses 16 or 32-bit integers. The welded positions
+    // have their own indices
+    gD3DContext->IASetIndexBuffer(positionsOnly && mHasDepthIndices ? mDepthIndexBuffer : mIndexBuffer, mIndexFormat, 0);
 
     // Using triangle lists only in this class
     gD3DContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+}
 
-    // Render mesh
-    gD3DContext->DrawIndexed(mNumIndices, 0, 0);
+
+// Draw a single sub-mesh at the given level of detail. SetBuffersOnGPU must have been called
+void Mesh::RenderSubMesh(unsigned int subMesh, unsigned int lod /*= 0*/, bool positionsOnly /*= false*/)
+{
+    // The sub-mesh's first vertex is added to each of its indices (the "base vertex"). Levels of detail use the same
+    // vertices as the full sub-mesh with their own range of indices. The depth version has the same index ranges but
+    // its own vertices
+    const SubMesh& range = (lod == 0) ? mSubMeshes[subMesh] : mLodSubMeshes[mLods[lod - 1].firstSubMesh + subMesh];
+    const SubMesh& vertices = positionsOnly ? mDepthSubMeshes[subMesh] : mSubMeshes[subMesh];
+    gD3DContext->DrawIndexed(range.numIndices, range.firstIndex, static_cast<INT>(vertices.firstVertex));
 }
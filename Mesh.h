@@ -2,14 +2,19 @@
 // Class encapsulating a mesh
 //--------------------------------------------------------------------------------------
 // The mesh class splits the mesh into sub-meshes that only use one texture each.
-// ** THIS VERSION WILL ONLY KEEP THE FIRST SUB-MESH OTHER PARTS WILL BE MISSING **
-// ** DO NOT USE THIS VERSION FOR PROJECTS **
+// All sub-meshes share one vertex buffer and one index buffer, each sub-mesh is a range of them.
 // The class also doesn't load textures, filters or shaders as the outer code is
 // expected to select these things. A later lab will introduce a more robust loader.
 
 #include "common.h"
+#include "MeshData.h"
+#include "MeshImport.h"
+#include "MeshBVH.h"
+#include "UploadQueue.h"
 
+#include <cstddef>
 #include <string>
+#include <vector>
 
 #ifndef _MESH_H_INCLUDED_
 #define _MESH_H_INCLUDED_
@@ -20,24 +25,154 @@ public:
     // Pass the name of the mesh file to load. Uses assimp (http://www.assimp.org/) to support many file types
     // Optionally request tangents to be calculated (for normal and parallax mapping - see later lab)
     // Will throw a std::runtime_error exception on failure (since constructors can't return errors).
-    Mesh(const std::string& fileName, bool requireTangents = false);
+    // Optionally store the vertices in the compact layout (see MeshCompact.h), which uses about half the memory
+    // Optionally generate up to the given number of simplified levels of detail (see MeshSimplify.h) for distant models
+    // Optionally keep a copy of the triangles on the CPU for ray casts (see Raycast)
+    // Tangents are calculated with GenerateTangents (MikkTSpace compatible, see MeshTangents.h), or by assimp if
+    // generateTangents is false
+    Mesh(const std::string& fileName, bool requireTangents = false, bool compactVertices = false, unsigned int numLods = 0,
+         bool retainGeometry = false, bool generateTangents = true);
+
+    // Create the mesh from mesh data that has already been loaded (see LoadMeshSource in MeshCache.h), e.g. on another
+    // thread. Only creates the GPU resources, so must be called on the thread that creates them. The file name is only used
+    // in error messages. Will throw a std::runtime_error exception on failure
+    // If an upload queue is given, the vertex and index buffers are queued rather than created at once, and the mesh
+    // draws nothing until they exist (see IsResident). The queue must outlive the mesh. If the queue fails to create a
+    // buffer the mesh is never drawn (see UploadFailed), the queue's statistics count the failure
+    Mesh(const MeshSource& source, const std::string& fileName, UploadQueue* uploads = nullptr);
+
     ~Mesh();
 
+    Mesh(const Mesh&) = delete; // Owns GPU resources, so no copying
+    Mesh& operator=(const Mesh&) = delete;
+
+    // The import options the file constructor uses, for loading mesh data to pass to the constructor above
+    static MeshImportOptions ImportOptions(bool requireTangents = false, bool compactVertices = false, unsigned int numLods = 0,
+                                           bool retainGeometry = false, bool generateTangents = true);
+
     // The render function assumes shaders, matrices, textures, samplers etc. have been set up already.
     // It simply draws this mesh with whatever settings the GPU is currently using.
-    void Render();
+    // Level of detail 0 is the full mesh, higher levels are simpler (see NumLods)
+    // Passes that only need positions (e.g. depth-only rendering for shadow maps) should set positionsOnly, which reads
+    // the vertices from a separate tightly packed position stream. The vertex shader must take only a position
+    // (e.g. PositionVertex in Common.hlsli)
+    void Render(unsigned int lod = 0, bool positionsOnly = false);
+
+    // Set the values the vertex shaders use to decode this mesh's vertices. Call before sending the per-model constants
+    // to the GPU for each model using this mesh
+    void SetVertexDecoding(PerModelConstants& constants) const;
+
+    // Set this mesh's vertex buffer, index buffer and layout as the GPU's current geometry, ready for RenderSubMesh. The
+    // position stream is used instead of the full vertices if positionsOnly is set (see Render)
+    void SetBuffersOnGPU(bool positionsOnly = false);
+
+    // Draw only the parts of the mesh that may be seen through the given frustum by a viewer at the given point, both in
+    // the mesh's own space. Uses the mesh's clusters (see MeshClusters.h), skipping those outside the frustum and, if
+    // requested, those facing away from the viewer - leave that off if back faces are not being culled. Visible clusters
+    // next to each other are drawn in one call. Other levels of detail, and meshes without clusters, are drawn whole if
+    // the mesh is in the frustum. Settings as for Render. Returns the number of triangles drawn
+    unsigned int RenderVisible(const CFrustum& frustum, const CVector3& viewPoint, bool cullBackFaces = true, unsigned int lod = 0,
+                               bool positionsOnly = false);
+
+    // Draw a single sub-mesh at the given level of detail. SetBuffersOnGPU must have been called with the same positionsOnly,
+    // other settings as for Render
+    void RenderSubMesh(unsigned int subMesh, unsigned int lod = 0, bool positionsOnly = false);
+
+    unsigned int NumSubMeshes() const  { return static_cast<unsigned int>(mSubMeshes.size()); }
+
+    // Number of levels of detail including the full mesh, so at least 1
+    unsigned int NumLods() const  { return static_cast<unsigned int>(mLods.size()) + 1; }
+
+    // The furthest the surface of the given level of detail may be from the full mesh, in mesh units. 0 for level 0
+    float LodError(unsigned int lod) const  { return lod == 0 ? 0.0f : mLods[lod - 1].error; }
+
+    // Sphere containing the mesh, in the mesh's own space
+    const CSphere& BoundingSphere() const  { return mBoundingSphere; }
+
+    // Find the nearest full detail triangle hit by a ray in the mesh's own space, see MeshBVH::Raycast. On input t is the
+    // furthest distance to look, on a hit it is updated with the hit distance. Only meshes loaded with retainGeometry can
+    // be hit, others always return false
+    bool Raycast(const CRay& ray, float& t, MeshRayHit* hit = nullptr) const  { return mBVH.Raycast(ray, t, hit); }
+
+    // Return true if a ray in the mesh's own space hits any triangle closer than maxT (e.g. for line-of-sight checks)
+    bool IsBlocked(const CRay& ray, float maxT) const  { return mBVH.IsBlocked(ray, maxT); }
+
+    bool HasGeometry() const  { return !mBVH.Empty(); }
+
+    // True once the GPU buffers exist, always for meshes created without an upload queue. Rendering does nothing until then
+    bool IsResident() const
+    {
+        return mVertexBuffer != nullptr && mPositionBuffer != nullptr && mIndexBuffer != nullptr &&
+               (!mHasDepthIndices || mDepthIndexBuffer != nullptr);
+    }
+
+    // True if the upload queue has failed to create one of the buffers, so the mesh will never be drawn
+    bool UploadFailed() const
+    {
+        return mUploads != nullptr &&
+               ((mVertexUpload == 0 && mVertexBuffer == nullptr) || (mPositionUpload == 0 && mPositionBuffer == nullptr) ||
+                (mIndexUpload == 0 && mIndexBuffer == nullptr) ||
+                (mHasDepthIndices && mDepthIndexUpload == 0 && mDepthIndexBuffer == nullptr));
+    }
+
+    // Size in bytes of the GPU buffers used by this mesh
+    std::size_t BufferBytes() const  { return mBufferBytes; }
 
 
 private:
     unsigned int       mVertexSize;             // Size in bytes of a single vertex (depends on what it contains, uvs, tangents etc.)
     ID3D11InputLayout* mVertexLayout = nullptr; // DirectX specification of data held in a single vertex
 
+    // Decoding of the vertices for the shaders (see SetVertexDecoding)
+    CVector3           mPositionOffset;
+    CVector3           mPositionScale;
+    bool               mCompactVertices;
+
     // GPU-side vertex and index buffers
     unsigned int       mNumVertices;
     ID3D11Buffer* mVertexBuffer = nullptr;
 
+    // Copy of just the vertex positions, for passes that need nothing else (see Render). If the import built a depth
+    // version (see MeshDepth.h) the positions are welded and have their own indices, with the same ranges as the main
+    // indices. mDepthSubMeshes has the vertex range of each sub-mesh in the position buffer
+    unsigned int       mPositionSize;             // Size in bytes of a single position, in the same encoding as the vertices
+    ID3D11InputLayout* mPositionLayout = nullptr;
+    ID3D11Buffer*      mPositionBuffer = nullptr;
+    bool               mHasDepthIndices;
+    ID3D11Buffer*      mDepthIndexBuffer = nullptr;
+    std::vector<SubMesh> mDepthSubMeshes;
+
+    std::size_t        mBufferBytes;            // Total size of the GPU buffers
+
     unsigned int       mNumIndices;
+    unsigned int       mIndexSize;              // 2 or 4 bytes, 16-bit indices are used whenever the import provided them
+    DXGI_FORMAT        mIndexFormat;
     ID3D11Buffer* mIndexBuffer = nullptr;
+
+    // Buffers still waiting in the upload queue, cancelled if the mesh is destroyed first (0 once created)
+    UploadQueue*       mUploads = nullptr;
+    UploadQueue::Ticket mVertexUpload = 0;
+    UploadQueue::Ticket mPositionUpload = 0;
+    UploadQueue::Ticket mIndexUpload = 0;
+    UploadQueue::Ticket mDepthIndexUpload = 0;
+
+    // Range of the buffers used by each sub-mesh. Sub-mesh indices are relative to the sub-mesh's first vertex
+    std::vector<SubMesh> mSubMeshes;
+
+    // Levels of detail after the full mesh, each has a range of mLodSubMeshes matching mSubMeshes (see MeshLod)
+    std::vector<MeshLod> mLods;
+    std::vector<SubMesh> mLodSubMeshes;
+
+    CSphere            mBoundingSphere;
+
+    // Clusters of the full detail sub-meshes, in sub-mesh order. mFirstCluster has the first cluster of each sub-mesh,
+    // followed by the total. Visibility results are kept to save allocating them each time
+    std::vector<MeshCluster>  mClusters;
+    std::vector<unsigned int> mFirstCluster;
+    std::vector<std::uint8_t> mClusterVisible;
+
+    // Copy of the triangles for ray casts, empty unless the mesh was loaded with retainGeometry
+    MeshBVH            mBVH;
 };
 
 
@@ -6,8 +6,9 @@
 // expected to select these things
 
 #include "common.h"
-
-#include <assimp/scene.h>
+#include "Mesh.h"
+#include "MeshData.h"
+#include "MeshImport.h"
 
 #include <string>
 #include <vector>
@@ -25,8 +26,16 @@ public:
     // Pass the name of the mesh file to load. Uses assimp (http://www.assimp.org/) to support many file types
     // Optionally request tangents to be calculated (for normal and parallax mapping - see later lab)
     // Will throw a std::runtime_error exception on failure (since constructors can't return errors).
-    MeshAnimation(const std::string& fileName, bool requireTangents = false);
-    ~MeshAnimation();
+    // Optionally store the vertices in the compact layout (see MeshCompact.h), which uses about half the memory
+    MeshAnimation(const std::string& fileName, bool requireTangents = false, bool compactVertices = false);
+
+    // Create the mesh from mesh data that has already been loaded with ImportOptions (see LoadMeshSource in
+    // MeshCache.h), e.g. on another thread. Only creates the GPU resources, so must be called on the thread that
+    // creates them. The file name is only used in error messages. Will throw a std::runtime_error exception on failure
+    MeshAnimation(const MeshSource& source, const std::string& fileName);
+
+    // The import options the file constructor uses - the node hierarchy is kept so the parts can be animated
+    static MeshImportOptions ImportOptions(bool requireTangents = false, bool compactVertices = false);
 
 
     // How many nodes are in this mesh (seperate movable parts)
@@ -45,12 +54,6 @@ public:
     //--------------------------------------------------------------------------------------
 private:
 
-    // Count the number of nodes with given assimp node as root
-    unsigned int CountNodes(aiNode* assimpNode);
-
-    // Help build the arrays of submeshes and nodes from the assimp data - recursive
-    unsigned int ReadNodes(aiNode* assimpNode, unsigned int nodeIndex, unsigned int parentIndex);
-
     // Helper function for Render function - sends the world matrix for the next object to render over to the GPU
     void SetWorldMatrixOnGPU(CMatrix4x4 worldMatrix);
 
@@ -64,22 +67,6 @@ private:
     //--------------------------------------------------------------------------------------
 private:
 
-    // A mesh is made of multiple sub-meshes. Each one uses a single material (texture).
-    // Each sub-mesh has a vertex / index buffer on the GPU. Could share buffers for performance but that would be complex.
-    struct SubMesh
-    {
-        unsigned int       vertexSize = 0;         // Size in bytes of a single vertex (depends on what it contains, uvs, tangents etc.)
-        ID3D11InputLayout* vertexLayout = nullptr; // DirectX specification of data held in a single vertex
-
-        // GPU-side vertex and index buffers
-        unsigned int       numVertices = 0;
-        ID3D11Buffer* vertexBuffer = nullptr;
-
-        unsigned int       numIndices = 0;
-        ID3D11Buffer* indexBuffer = nullptr;
-    };
-
-
     // A mesh contains a hierarchy of nodes. A node represents a seperate animatable part of the mesh
     // A node can contain several sub-meshes (because a single node might use multiple textures)
     // A node can also have child nodes. The children will follow the motion of the parent node
@@ -93,7 +80,7 @@ private:
         unsigned int              parentIndex;    // Index of the parent node (from the mNodes vector below). Root node refers to itself (0)
 
         std::vector<unsigned int> childNodes;     // Child nodes that are controlled by this node (indexes into the mNodes vector below)
-        std::vector<unsigned int> subMeshes;      // The geometry representing this node (indexes into the mSubMeshes vector below)
+        std::vector<unsigned int> subMeshes;      // The geometry representing this node (sub-mesh indexes in mGeometry below)
     };
 
 
@@ -102,8 +89,8 @@ private:
     //--------------------------------------------------------------------------------------
 private:
 
-    std::vector<SubMesh> mSubMeshes; // The mesh geometry. Nodes refer to sub-meshes in this vector
-    std::vector<Node>    mNodes;     // The mesh hierarchy. First entry is root. remainder aree stored in depth-first order
+    Mesh              mGeometry; // The mesh geometry, all sub-meshes in one vertex and index buffer. Nodes refer to its sub-meshes
+    std::vector<Node> mNodes;    // The mesh hierarchy. First entry is root. remainder aree stored in depth-first order
 };
 
 
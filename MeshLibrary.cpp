@@ -0,0 +1,134 @@
+//--------------------------------------------------------------------------------------
+// Library of loaded meshes, shared between everything that uses them
+//--------------------------------------------------------------------------------------
+
+#include "MeshLibrary.h"
+#include "MeshCache.h" // Loading mesh data on worker threads
+
+#include <algorithm>
+#include <cctype>
+#include <future>
+#include <stdexcept>
+
+
+// Return the mesh for the given file and options, loading it on first use
+std::shared_ptr<Mesh> MeshLibrary::GetMesh(const std::string& fileName, bool requireTangents /*= false*/,
+                                           bool compactVertices /*= false*/, unsigned int numLods /*= 0*/,
+                                           bool retainGeometry /*= false*/, bool generateTangents /*= true*/)
+{
+    Key key = MakeKey(fileName, requireTangents, compactVertices, numLods, retainGeometry, generateTangents);
+
+    ++mStats.requests;
+    auto& mesh = mMeshes[key];
+    if (mesh)
+    {
+        // A preloaded mesh is shared from its second request on
+        if (mUnrequested.erase(key) != 0)  return mesh;
+        ++mStats.hits;
+        mStats.bytesSaved += mesh->BufferBytes();
+        return mesh;
+    }
+
+    try
+    {
+        mesh = std::make_shared<Mesh>(fileName, requireTangents, compactVertices, numLods, retainGeometry, generateTangents);
+    }
+    catch (...)
+    {
+        mMeshes.erase(key); // Don't leave an empty entry behind
+        throw;
+    }
+    ++mStats.numMeshes;
+    mStats.bytesLoaded += mesh->BufferBytes();
+    return mesh;
+}
+
+
+// Load all the given meshes into the library, importing the files in parallel on the thread pool
+void MeshLibrary::Preload(const std::vector<MeshRequest>& requests, ThreadPool& pool, UploadQueue* uploads /*= nullptr*/)
+{
+    struct PendingMesh
+    {
+        Key key;
+        std::string fileName;
+        std::future<MeshSource> source;
+    };
+
+    // Start importing every mesh not already loaded. The mesh data is self-contained, so workers need no locking
+    std::vector<PendingMesh> pending;
+    for (auto& request : requests)
+    {
+        Key key = MakeKey(request.fileName, request.requireTangents, request.compactVertices, request.numLods,
+                          request.retainGeometry, request.generateTangents);
+        if (mMeshes.count(key) != 0 ||
+            std::any_of(pending.begin(), pending.end(), [&key](const PendingMesh& p) { return p.key == key; }))  continue;
+
+        MeshImportOptions options = Mesh::ImportOptions(request.requireTangents, request.compactVertices, request.numLods,
+                                                        request.retainGeometry, request.generateTangents);
+        std::string fileName = request.fileName;
+        pending.push_back({ key, fileName, pool.Submit([fileName, options]() { return LoadMeshSource(fileName, options); }) });
+    }
+
+    // Create the meshes here, in request order, as each import finishes (queuing their buffers if given a queue)
+    std::string errors;
+    for (auto& mesh : pending)
+    {
+        try
+        {
+            auto newMesh = std::make_shared<Mesh>(mesh.source.get(), mesh.fileName, uploads);
+            ++mStats.numMeshes;
+            mStats.bytesLoaded += newMesh->BufferBytes();
+            mMeshes[mesh.key] = std::move(newMesh);
+            mUnrequested.insert(mesh.key);
+        }
+        catch (const std::exception& e)
+        {
+            if (!errors.empty())  errors += "\n";
+            errors += e.what();
+        }
+    }
+    if (!errors.empty())  throw std::runtime_error(errors);
+}
+
+
+// Remove meshes that are not used outside the library
+void MeshLibrary::ReleaseUnused()
+{
+    for (auto it = mMeshes.begin(); it != mMeshes.end();)
+    {
+        if (it->second.use_count() == 1)
+        {
+            mStats.bytesLoaded -= it->second->BufferBytes();
+            --mStats.numMeshes;
+            mUnrequested.erase(it->first);
+            it = mMeshes.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+
+// Remove all meshes from the library
+void MeshLibrary::Clear()
+{
+    mMeshes.clear();
+    mUnrequested.clear();
+    mStats.numMeshes = 0;
+    mStats.bytesLoaded = 0;
+}
+
+
+// Windows file names ignore case and accept either slash, so "Cube.x" and "cube.x" are the same mesh
+MeshLibrary::Key MeshLibrary::MakeKey(const std::string& fileName, bool requireTangents, bool compactVertices,
+                                      unsigned int numLods, bool retainGeometry, bool generateTangents)
+{
+    std::string name = fileName;
+    for (auto& c : name)
+    {
+        c = (c == '\\') ? '/' : static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    return Key(name, requireTangents, compactVertices, numLods, retainGeometry, generateTangents);
+}
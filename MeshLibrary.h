@@ -0,0 +1,86 @@
+//--------------------------------------------------------------------------------------
+// Library of loaded meshes, shared between everything that uses them
+//--------------------------------------------------------------------------------------
+// Asking for a mesh file that has already been loaded with the same options returns the existing mesh rather than
+// importing the file again and creating another copy of its GPU buffers. Meshes are reference counted, so a mesh stays
+// alive while the library or any other code holds it. Models only keep a plain pointer to their mesh, so keep the
+// mesh (or the library) alive for as long as the models using it
+
+#ifndef _MESH_LIBRARY_H_INCLUDED_
+#define _MESH_LIBRARY_H_INCLUDED_
+
+#include "Mesh.h"
+#include "ThreadPool.h"
+
+#include <cstddef>
+#include <map>
+#include <set>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+
+// A mesh to load with MeshLibrary::Preload - the same parameters as GetMesh
+struct MeshRequest
+{
+    std::string fileName;
+    bool requireTangents = false;
+    bool compactVertices = false;
+    unsigned int numLods = 0;
+    bool retainGeometry = false;
+    bool generateTangents = true;
+};
+
+
+class MeshLibrary
+{
+public:
+    // Counts of library use, e.g. to see how much sharing saves
+    struct Stats
+    {
+        unsigned int numMeshes   = 0; // Meshes currently held by the library
+        unsigned int requests    = 0; // Calls to GetMesh
+        unsigned int hits        = 0; // Requests for a mesh an earlier request already asked for. The first request for
+                                      // a mesh loaded by Preload is not a hit, the mesh was loaded for it
+        std::size_t  bytesLoaded = 0; // GPU buffer memory of the meshes loaded
+        std::size_t  bytesSaved  = 0; // GPU buffer memory of the extra copies the hits would have loaded
+    };
+
+
+    // Return the mesh for the given file and options, loading it on first use. File names are compared ignoring case
+    // and the direction of slashes. Will throw a std::runtime_error exception on failure (see Mesh constructor)
+    std::shared_ptr<Mesh> GetMesh(const std::string& fileName, bool requireTangents = false, bool compactVertices = false,
+                                  unsigned int numLods = 0, bool retainGeometry = false, bool generateTangents = true);
+
+    // Load all the given meshes into the library, so later GetMesh calls for them return at once. The files are
+    // imported in parallel on the thread pool, and only the GPU resources are created on the calling thread. Meshes
+    // already in the library, or requested twice, are only loaded once. Failing meshes don't stop the others loading;
+    // afterwards a std::runtime_error exception is thrown with the error for each mesh that failed, one per line
+    // If an upload queue is given the meshes' buffers are queued on it rather than created here (see Mesh constructor)
+    void Preload(const std::vector<MeshRequest>& requests, ThreadPool& pool, UploadQueue* uploads = nullptr);
+
+    // Remove meshes that are not used outside the library
+    void ReleaseUnused();
+
+    // Remove all meshes from the library. Meshes still held elsewhere are released when the last holder releases them
+    void Clear();
+
+    Stats GetStats() const  { return mStats; }
+
+
+private:
+    // Normalised file name, require tangents, compact vertices, number of levels of detail, retain geometry and
+    // generate tangents
+    using Key = std::tuple<std::string, bool, bool, unsigned int, bool, bool>;
+
+    static Key MakeKey(const std::string& fileName, bool requireTangents, bool compactVertices, unsigned int numLods,
+                       bool retainGeometry, bool generateTangents);
+
+    std::map<Key, std::shared_ptr<Mesh>> mMeshes;
+    std::set<Key>                        mUnrequested; // Meshes loaded by Preload that GetMesh has not yet asked for
+    Stats mStats;
+};
+
+
+#endif //_MESH_LIBRARY_H_INCLUDED_
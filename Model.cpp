@@ -9,19 +9,132 @@
 #include "Common.h"
 #include "GraphicsHelpers.h"
 #include "Mesh.h"
+#include "Camera.h"
+#include "BoundingVolumes.h"
+#include "RayIntersection.h"
+
+#include <algorithm>
+#include <cmath>
 
 void Model::Render()
+{
+	if (!mMesh->IsResident())  return; // Still waiting in the upload queue
+
+	SetConstants();
+	mMesh->Render(mLod);
+}
+
+
+// Render only the parts of the mesh that can be seen with the given view-projection matrix from the given view point
+void Model::Render(const CMatrix4x4& viewProjection, CVector3 viewPoint, bool cullBackFaces /*= true*/)
+{
+	RenderVisible(viewProjection, viewPoint, cullBackFaces, false);
+}
+
+
+// Render as above for depth-only passes, using only the mesh's position stream
+void Model::RenderDepth(const CMatrix4x4& viewProjection, CVector3 viewPoint, bool cullBackFaces /*= true*/)
+{
+	RenderVisible(viewProjection, viewPoint, cullBackFaces, true);
+}
+
+
+// Render the parts of the mesh that can be seen with the given view-projection matrix, with the full vertices or only
+// the positions
+void Model::RenderVisible(const CMatrix4x4& viewProjection, CVector3 viewPoint, bool cullBackFaces, bool positionsOnly)
+{
+	if (!mMesh->IsResident())  return;
+
+	SetConstants();
+
+	// Test the parts in the mesh's own space: a frustum from a matrix including the world matrix is in model space, and
+	// the view point is moved into model space with the inverse world matrix
+	CFrustum frustum = FrustumFromMatrix(mWorldMatrix * viewProjection);
+	CVector3 modelViewPoint = TransformSphere({ viewPoint, 0.0f }, InverseAffine(mWorldMatrix)).centre;
+	mMesh->RenderVisible(frustum, modelViewPoint, cullBackFaces, mLod, positionsOnly);
+}
+
+
+// Find where a ray in world space first hits the model
+bool Model::Raycast(const CRay& ray, float& t, MeshRayHit* hit /*= nullptr*/)
+{
+	return mMesh->Raycast(ModelSpaceRay(ray), t, hit);
+}
+
+
+// Return true if a ray in world space hits the model closer than maxT
+bool Model::IsBlocked(const CRay& ray, float maxT)
+{
+	return mMesh->IsBlocked(ModelSpaceRay(ray), maxT);
+}
+
+
+// Move a world space ray into the model's space. The direction is transformed without normalising, so a point at
+// distance t along either ray is the same point
+CRay Model::ModelSpaceRay(const CRay& ray)
+{
+	UpdateWorldMatrix();
+	CMatrix4x4 inverseWorld = InverseAffine(mWorldMatrix);
+	const CVector3& o = ray.origin;
+	const CVector3& d = ray.direction;
+	CRay modelRay;
+	modelRay.origin    = o.x * inverseWorld.GetRow(0) + o.y * inverseWorld.GetRow(1) + o.z * inverseWorld.GetRow(2) + inverseWorld.GetRow(3);
+	modelRay.direction = d.x * inverseWorld.GetRow(0) + d.y * inverseWorld.GetRow(1) + d.z * inverseWorld.GetRow(2);
+	return modelRay;
+}
+
+
+// Update the world matrix and send it and the mesh's vertex decoding to the shaders
+void Model::SetConstants()
 {
 	UpdateWorldMatrix();
 
 	gPerModelConstants.worldMatrix = mWorldMatrix; // Update C++ side constant buffer
+	mMesh->SetVertexDecoding(gPerModelConstants);  // How the shaders should read the mesh's vertices
 	UpdateConstantBuffer(gPerModelConstantBuffer, gPerModelConstants); // Send to GPU
 
 	// Indicate that the constant buffer we just updated is for use in the vertex shader (VS) and pixel shader (PS)
 	gD3DContext->VSSetConstantBuffers(1, 1, &gPerModelConstantBuffer); // First parameter must match constant buffer number in the shader
 	gD3DContext->PSSetConstantBuffers(1, 1, &gPerModelConstantBuffer);
+}
+
 
-	mMesh->Render();
+// Choose the mesh's level of detail for rendering as seen from the given camera
+void Model::SelectLod(Camera& camera, float maxPixelError /*= 1.0f*/)
+{
+	// A simpler level must be this far inside the error limit before switching to it
+	const float kLodHysteresis = 0.75f;
+
+	unsigned int numLods = mMesh->NumLods();
+	if (numLods == 1)
+	{
+		mLod = 0;
+		return;
+	}
+
+	// Pixels covered by one world unit at the nearest point of the model's bounding sphere
+	UpdateWorldMatrix();
+	CSphere sphere = TransformSphere(mMesh->BoundingSphere(), mWorldMatrix);
+	float distance = std::max(Length(sphere.centre - camera.Position()) - sphere.radius, camera.NearClip());
+	float pixelsPerUnit = (gViewportWidth * 0.5f) / (std::tan(camera.FOV() * 0.5f) * distance);
+
+	// Level errors are in mesh units, so scale them as the world matrix does
+	float pixelsPerError = pixelsPerUnit * std::max(mScale.x, std::max(mScale.y, mScale.z));
+
+	// Simplest level with error below the limit (levels get simpler in order, and errors only grow)
+	auto simplestLod = [&](float limit)
+	{
+		unsigned int lod = 0;
+		while (lod + 1 < numLods && mMesh->LodError(lod + 1) * pixelsPerError <= limit)  ++lod;
+		return lod;
+	};
+
+	unsigned int lod = simplestLod(maxPixelError);
+	if (lod > mLod)
+	{
+		lod = std::max(mLod, simplestLod(maxPixelError * kLodHysteresis));
+	}
+	mLod = lod;
 }
 
 
@@ -76,5 +189,6 @@ void Model::Control(float frameTime, KeyCode turnUp, KeyCode turnDown, KeyCode t
 
 void Model::UpdateWorldMatrix()
 {
-	mWorldMatrix = MatrixScaling(mScale) * MatrixRotationZ(mRotation.z) * MatrixRotationX(mRotation.x) * MatrixRotationY(mRotation.y) * MatrixTranslation(mPosition);
+	// Same as MatrixScaling(mScale) * MatrixRotationZ(mRotation.z) * MatrixRotationX(mRotation.x) * MatrixRotationY(mRotation.y) * MatrixTranslation(mPosition)
+	mWorldMatrix = MatrixTRS(mPosition, mRotation, mScale);
 }
\ No newline at end of file
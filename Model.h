@@ -13,6 +13,9 @@
 #define _MODEL_H_INCLUDED_
 
 class Mesh;
+class Camera;
+class CRay;
+struct MeshRayHit;
 
 class Model
 {
@@ -29,19 +32,52 @@ public:
 	// The render function sets the world matrix in the per-frame constant buffer and makes that buffer available
 	// to vertex & pixel shader. Then it calls Mesh:Render, which renders the geometry with current GPU settings.
 	// So all other per-frame constants must have been set already along with shaders, textures, samplers, states etc.
+	// Nothing is drawn until the mesh's buffers have been uploaded (see Mesh::IsResident)
 	void Render();
 
+	// Render as above, but only the parts of the mesh that can be seen with the given view-projection matrix from the
+	// given view point (the position of the camera or light). See Mesh::RenderVisible, back-facing parts are skipped if
+	// requested, so leave that off if back faces are not being culled. Only for shaders that don't move the vertices,
+	// since the parts are tested with the mesh's own bounds
+	void Render(const CMatrix4x4& viewProjection, CVector3 viewPoint, bool cullBackFaces = true);
+
+	// Render as above for passes that only output depth (e.g. shadow maps), reading only the mesh's position stream
+	// (see Mesh::Render). The vertex shader must take only a position, e.g. BasicTransform_vs
+	void RenderDepth(const CMatrix4x4& viewProjection, CVector3 viewPoint, bool cullBackFaces = true);
+
+
+	// Choose the mesh's level of detail (see Mesh::NumLods) for rendering as seen from the given camera. Uses the
+	// simplest level whose error covers no more than the given number of pixels on screen. Call once per frame, the
+	// choice is kept until the next call. A level is only made simpler once its error is a little below the limit, so
+	// models near the switching distance don't flicker between levels
+	void SelectLod(Camera& camera, float maxPixelError = 1.0f);
+
+	unsigned int Lod() { return mLod; }
+
+
+	// Find where a ray in world space first hits the model, for picking. The ray is moved into the model's space, where
+	// the mesh is tested (see Mesh::Raycast), so distances are the same in both spaces. On input t is the furthest
+	// distance to look, on a hit it is updated with the hit distance. Only meshes loaded with retainGeometry can be hit
+	bool Raycast(const CRay& ray, float& t, MeshRayHit* hit = nullptr);
+
+	// Return true if a ray in world space hits the model closer than maxT, e.g. for line-of-sight checks
+	bool IsBlocked(const CRay& ray, float maxT);
+
 
 	// Control the model's position and rotation using keys provided. Amount of motion performed depends on frame time
 	void Control(float frameTime, KeyCode turnUp, KeyCode turnDown, KeyCode turnLeft, KeyCode turnRight,
 		KeyCode turnCW, KeyCode turnCCW, KeyCode moveForward, KeyCode moveBackward);
 
 
+	// Turn the model to face the given target (in the Z direction), keeping its scale. The model won't roll, so the
+	// Euler angles can be found directly from the direction. Same result as CMatrix4x4::FaceTarget followed by
+	// GetEulerAngles, without building and decomposing the matrix. Does nothing if the target is directly above or below
 	void FaceTarget(CVector3 target)
 	{
-		UpdateWorldMatrix();
-		mWorldMatrix.FaceTarget(target);
-		mRotation = mWorldMatrix.GetEulerAngles();
+		CVector3 direction = target - mPosition;
+		float horizontalLength = std::sqrt(direction.x * direction.x + direction.z * direction.z);
+		if (IsZero(horizontalLength))  return;
+		mRotation = { std::atan2(-direction.y, horizontalLength), std::atan2(direction.x, direction.z), 0.0f };
 	}
 
 	//-------------------------------------
@@ -69,6 +105,9 @@ public:
 	//-------------------------------------
 private:
 	void UpdateWorldMatrix();
+	void SetConstants();
+	CRay ModelSpaceRay(const CRay& ray);
+	void RenderVisible(const CMatrix4x4& viewProjection, CVector3 viewPoint, bool cullBackFaces, bool positionsOnly);
 
 	Mesh* mMesh;
 
@@ -79,6 +118,9 @@ private:
 
 	// World matrix for the model - built from the above
 	CMatrix4x4 mWorldMatrix;
+
+	// Level of detail of the mesh to render, from SelectLod
+	unsigned int mLod = 0;
 };
 
 
@@ -63,9 +63,7 @@ public:
     void SetRotation(CVector3 rotation, int node = 0)
     {
         // To put rotation angles into a matrix we need to build the matrix from scratch to make sure we retain existing scaling and position
-        mWorldMatrices[node] = MatrixScaling(Scale(node)) *
-            MatrixRotationZ(rotation.z) * MatrixRotationX(rotation.x) * MatrixRotationY(rotation.y) *
-            MatrixTranslation(Position(node));
+        mWorldMatrices[node] = MatrixTRS(Position(node), rotation, Scale(node));
     }
 
     // Two ways to set scale: x,y,z separately, or all to the same value
@@ -18,7 +18,7 @@ NormalMappingPixelShaderInput main(TangentVertex modelVertex)
     NormalMappingPixelShaderInput output; // This is the data the pixel shader requires from this vertex shader
 
     // Input position is x,y,z only - need a 4th element to multiply by a 4x4 matrix. Use 1 for a point (0 for a vector) - recall lectures
-    float4 modelPosition = float4(modelVertex.position, 1);
+    float4 modelPosition = float4(DecodePosition(modelVertex.position), 1);
 
     // Multiply by the world matrix passed from C++ to transform the model vertex position into world space. 
     // In a similar way use the view matrix to transform the vertex from world space into view space (camera's point of view)
@@ -30,8 +30,8 @@ NormalMappingPixelShaderInput main(TangentVertex modelVertex)
     output.worldPosition = worldPosition.xyz; // Also pass world position to pixel shader for lighting
 
 	// Unlike the position, send the model's normal and tangent untransformed (in model space). The pixel shader will do the matrix work on normals
-    output.modelNormal = modelVertex.normal;
-    output.modelTangent = modelVertex.tangent;
+    output.modelNormal = DecodeNormal(modelVertex.normal);
+    output.modelTangent = DecodeNormal(modelVertex.tangent);
 
     // Pass texture coordinates (UVs) on to the pixel shader, the vertex shader doesn't need them
     output.uv = modelVertex.uv;
@@ -6,6 +6,9 @@
 #include "Scene.h"
 #include "Mesh.h"
 #include "MeshAnimation.h"
+#include "MeshLibrary.h"
+#include "MeshCache.h"
+#include "ThreadPool.h"
 #include "Model.h"
 #include "ModelAnimation.h"
 #include "Camera.h"
@@ -25,6 +28,8 @@
 #include "ColourRGBA.h" 
 
 #include <sstream>
+#include <stdexcept>
+#include <string>
 #include <vector>
 #include <memory>
 
@@ -42,19 +47,26 @@ const float MOVEMENT_SPEED = 50.0f; // 50 units per second for movement (what a
 
 
 // Meshes, models and cameras, same meaning as TL-Engine. Meshes prepared in InitGeometry function, Models & camera in InitScene
-Mesh* gCubeMesh;
-Mesh* gCubeMeshAdvanced;
-Mesh* gDecalMesh;
-Mesh* gCrateMesh;
-Mesh* gSphereMesh;
-Mesh* gGroundMesh;
-Mesh* gLightMesh;
-Mesh* gPortalMesh;
-Mesh* gSecondPortalMesh;
-Mesh* gTeapotMesh;
-Mesh* gCharacterMesh;
-Mesh* gTrollMesh;
-Mesh* gCubeMultiMesh;
+// Meshes come from the library, which shares a single copy between all requests for the same file and options
+// Their GPU buffers are created over the first frames through the upload queue, a few megabytes or milliseconds each
+// frame, so loading doesn't stall. Models appear once their mesh is uploaded. Declared first so it outlives the meshes
+D3DUploadDevice gUploadDevice;
+UploadQueue gUploadQueue(gUploadDevice);
+UploadQueue::Budget gUploadBudget;
+MeshLibrary gMeshLibrary;
+std::shared_ptr<Mesh> gCubeMesh;
+std::shared_ptr<Mesh> gCubeMeshAdvanced;
+std::shared_ptr<Mesh> gDecalMesh;
+std::shared_ptr<Mesh> gCrateMesh;
+std::shared_ptr<Mesh> gSphereMesh;
+std::shared_ptr<Mesh> gGroundMesh;
+std::shared_ptr<Mesh> gLightMesh;
+std::shared_ptr<Mesh> gPortalMesh;
+std::shared_ptr<Mesh> gSecondPortalMesh;
+std::shared_ptr<Mesh> gTeapotMesh;
+std::shared_ptr<Mesh> gCharacterMesh;
+std::shared_ptr<Mesh> gTrollMesh;
+std::shared_ptr<Mesh> gCubeMultiMesh;
 MeshAnimation* gAnimatedMesh;
 
 Model* gDecal;
@@ -92,7 +104,10 @@ const float gLightOrbit = 20.0f;
 const float gLightOrbitSpeed = 0.7f;
 
 // Spotlight data - using spotlights in this lab because shadow mapping needs to treat each light as a camera, which is easy with spotlights
-float gSpotlightConeAngle = 90.0f; // Spot light cone angle (degrees), like the FOV (field-of-view) of the spot light
+constexpr float gSpotlightConeAngle = 90.0f; // Spot light cone angle (degrees), like the FOV (field-of-view) of the spot light
+
+// The cone angle is fixed, so the spotlight projection matrix (used for shadow mapping) is calculated by the compiler
+constexpr CMatrix4x4 gSpotlightProjectionMatrix = MatrixPerspective(1.0f, ConstexprTan(ToRadians(gSpotlightConeAngle) * 0.5f), 0.1f, 10000.0f);
 
 float gParallaxDepth = 0.08f; // Overall depth of bumpiness for parallax mapping
 bool gUseParallax = true;  // Toggle for parallax
@@ -197,7 +212,7 @@ CMatrix4x4 CalculateLightViewMatrix(int lightIndex)
 // Get "camera-like" projection matrix for a spotlight
 CMatrix4x4 CalculateLightProjectionMatrix(int lightIndex)
 {
-    return MakeProjectionMatrix(1.0f, ToRadians(gSpotlightConeAngle)); // Helper function in Utility\GraphicsHelpers.cpp
+    return gSpotlightProjectionMatrix; // Same for all spotlights, see the declaration above
 }
 
 
@@ -210,23 +225,52 @@ CMatrix4x4 CalculateLightProjectionMatrix(int lightIndex)
 bool InitGeometry()
 {
     // Load mesh geometry data, just like TL-Engine this doesn't create anything in the scene. Create a Model for that.
-    // IMPORTANT NOTE: Will only keep the first object from the mesh - multipart objects will have parts missing - see later lab for more robust loader
+    // Meshes are requested from the mesh library, so a file used several times with the same options is only loaded once
     try 
     {
-        gCubeMesh   = new Mesh("Cube.x");
-        gCubeMeshAdvanced = new Mesh("Cube.x", true);
-        gDecalMesh  = new Mesh("Decal.x");
-        gCrateMesh  = new Mesh("CargoContainer.x");
-        gSphereMesh = new Mesh("Sphere.x");
-        gGroundMesh = new Mesh("Floor.x", true);
-        gLightMesh  = new Mesh("Light.x");
-        gPortalMesh = new Mesh("Cube.x");
-        gSecondPortalMesh = new Mesh("Sphere.x");
-        gTeapotMesh = new Mesh("Teapot.x");
-        gCharacterMesh = new Mesh("Troll.x");
-        gTrollMesh = new Mesh("Troll.x");
-        gCubeMultiMesh = new Mesh("Cube.x");
-        gAnimatedMesh = new MeshAnimation("Bike.x");
+        // Import all the mesh files at once on worker threads - only creating the GPU resources happens on this thread.
+        // Errors from every mesh that fails are gathered into the one exception
+        ThreadPool importPool;
+        auto animatedMeshSource = importPool.Submit([]() { return LoadMeshSource("Bike.x", MeshAnimation::ImportOptions()); });
+        std::string importErrors;
+        try
+        {
+            gMeshLibrary.Preload({ { "Cube.x" }, { "Cube.x", true }, { "Decal.x" }, { "CargoContainer.x" }, { "Sphere.x", false, false, 3 },
+                                   { "Floor.x", true }, { "Light.x" }, { "Teapot.x", false, false, 3 },
+                                   { "Troll.x", false, true, 4 } }, importPool, &gUploadQueue);
+        }
+        catch (const std::exception& e)
+        {
+            importErrors = e.what();
+        }
+
+        // The animated mesh is collected even if the library's meshes failed, so its error is reported with theirs
+        MeshSource animatedSource;
+        try
+        {
+            animatedSource = animatedMeshSource.get();
+        }
+        catch (const std::exception& e)
+        {
+            if (!importErrors.empty())  importErrors += "\n";
+            importErrors += e.what();
+        }
+        if (!importErrors.empty())  throw std::runtime_error(importErrors);
+
+        gCubeMesh   = gMeshLibrary.GetMesh("Cube.x");
+        gCubeMeshAdvanced = gMeshLibrary.GetMesh("Cube.x", true);
+        gDecalMesh  = gMeshLibrary.GetMesh("Decal.x");
+        gCrateMesh  = gMeshLibrary.GetMesh("CargoContainer.x");
+        gSphereMesh = gMeshLibrary.GetMesh("Sphere.x", false, false, 3); // Curved meshes get simpler levels of detail for distant views
+        gGroundMesh = gMeshLibrary.GetMesh("Floor.x", true);
+        gLightMesh  = gMeshLibrary.GetMesh("Light.x");
+        gPortalMesh = gMeshLibrary.GetMesh("Cube.x");
+        gSecondPortalMesh = gMeshLibrary.GetMesh("Sphere.x", false, false, 3);
+        gTeapotMesh = gMeshLibrary.GetMesh("Teapot.x", false, false, 3);
+        gCharacterMesh = gMeshLibrary.GetMesh("Troll.x", false, true, 4); // The largest mesh, use compact vertices to halve its size
+        gTrollMesh = gMeshLibrary.GetMesh("Troll.x", false, true, 4);
+        gCubeMultiMesh = gMeshLibrary.GetMesh("Cube.x");
+        gAnimatedMesh = new MeshAnimation(animatedSource, "Bike.x");
     }
     catch (std::runtime_error e)  // Constructors cannot return error messages so use exceptions to catch mesh errors (fairly standard approach this)
     {
@@ -234,6 +278,14 @@ bool InitGeometry()
         return false;
     }
 
+    // Report how much the mesh library saved by sharing meshes (shown in the debugger's output window)
+    MeshLibrary::Stats meshStats = gMeshLibrary.GetStats();
+    std::ostringstream meshReport;
+    meshReport << "Mesh library: " << meshStats.requests << " requests, " << meshStats.numMeshes << " meshes loaded ("
+               << meshStats.bytesLoaded / 1024 << " KB), " << meshStats.hits << " shared (" << meshStats.bytesSaved / 1024 << " KB saved), "
+               << gUploadQueue.PendingBytes() / 1024 << " KB queued for upload\n";
+    OutputDebugStringA(meshReport.str().c_str());
+
 
     // Load the shaders required for the geometry we will use (see Shader.cpp / .h)
     if (!LoadShaders())
@@ -525,34 +577,34 @@ bool InitGeometry()
 bool InitScene()
 {
     //// Set up scene ////
-    gDecal = new Model(gDecalMesh); // Initialize a new decal model with the decal mesh
-    gCrate = new Model(gCrateMesh); // Initialize a new crate model with the crate mesh
-    gSphere = new Model(gSphereMesh); // Initialize a new sphere model with the sphere mesh
-    gGround = new Model(gGroundMesh); // Initialize a new ground model with the ground mesh
-    gCubeMulti = new Model(gCubeMultiMesh); // Initialize a new multi-textured cube model with the cube multi-mesh
+    gDecal = new Model(gDecalMesh.get()); // Initialize a new decal model with the decal mesh
+    gCrate = new Model(gCrateMesh.get()); // Initialize a new crate model with the crate mesh
+    gSphere = new Model(gSphereMesh.get()); // Initialize a new sphere model with the sphere mesh
+    gGround = new Model(gGroundMesh.get()); // Initialize a new ground model with the ground mesh
+    gCubeMulti = new Model(gCubeMultiMesh.get()); // Initialize a new multi-textured cube model with the cube multi-mesh
     gBike = new ModelAnimation(gAnimatedMesh); // Initialize a new bike model with animation capabilities
 
     // Light set-up - using an array to manage multiple lights
     for (int i = 0; i < NUM_LIGHTS; i++) {
-        gLights[i].SetModel(new Model(gLightMesh)); // Assign a new light model to each light in the array
+        gLights[i].SetModel(new Model(gLightMesh.get())); // Assign a new light model to each light in the array
     }
 
     // Cube set-up - using an array to manage multiple cubes
     for (int i = 0; i < NUM_CUBES; i++) {
         if (i == 2 || i == 3) {
-            gCube[i] = new Model(gCubeMeshAdvanced); // Assign an advanced cube model for supporting normal and parllax mapping
+            gCube[i] = new Model(gCubeMeshAdvanced.get()); // Assign an advanced cube model for supporting normal and parllax mapping
         }
         else {
-            gCube[i] = new Model(gCubeMesh); // Assign a standard cube model to other cube indices
+            gCube[i] = new Model(gCubeMesh.get()); // Assign a standard cube model to other cube indices
         }
     }
 
     // Create models for the portal, teapot, character, and troll
-    gPortal = new Model(gPortalMesh); // Initialize a new portal model with the portal mesh
-    gSecondPortal = new Model(gSecondPortalMesh); // Initialize a new second portal model with the second portal mesh
-    gTeapot = new Model(gTeapotMesh); // Initialize a new teapot model with the teapot mesh
-    gCharacter = new Model(gCharacterMesh); // Initialize a new character model with the character mesh
-    gTroll = new Model(gTrollMesh); // Initialize a new troll model with the troll mesh
+    gPortal = new Model(gPortalMesh.get()); // Initialize a new portal model with the portal mesh
+    gSecondPortal = new Model(gSecondPortalMesh.get()); // Initialize a new second portal model with the second portal mesh
+    gTeapot = new Model(gTeapotMesh.get()); // Initialize a new teapot model with the teapot mesh
+    gCharacter = new Model(gCharacterMesh.get()); // Initialize a new character model with the character mesh
+    gTroll = new Model(gTrollMesh.get()); // Initialize a new troll model with the troll mesh
 
     // Setup the first light
     gLights[0].SetColor({ 0.8f, 0.8f, 1.0f }); // Set the color of the first light to a light blue
@@ -729,18 +781,22 @@ void ReleaseResources()
     delete gTroll; gTroll = nullptr;
     delete gBike; gBike = nullptr;
 
-    delete gPortalMesh;  gPortalMesh = nullptr;
-    delete gLightMesh;   gLightMesh  = nullptr;
-    delete gGroundMesh;  gGroundMesh = nullptr;
-    delete gSphereMesh;  gSphereMesh = nullptr;
-    delete gCrateMesh;   gCrateMesh  = nullptr;
-    delete gDecalMesh;   gDecalMesh  = nullptr;
-    delete gCubeMesh;    gCubeMesh = nullptr;
-    delete gCubeMeshAdvanced;    gCubeMeshAdvanced = nullptr;
-    delete gCubeMultiMesh;    gCubeMultiMesh = nullptr;
+    // Meshes are released when the last reference to them goes
+    gPortalMesh = nullptr;
+    gSecondPortalMesh = nullptr;
+    gLightMesh  = nullptr;
+    gGroundMesh = nullptr;
+    gSphereMesh = nullptr;
+    gCrateMesh  = nullptr;
+    gDecalMesh  = nullptr;
+    gCubeMesh   = nullptr;
+    gCubeMeshAdvanced = nullptr;
+    gCubeMultiMesh = nullptr;
+    gTeapotMesh = nullptr;
+    gCharacterMesh = nullptr;
+    gTrollMesh = nullptr;
+    gMeshLibrary.Clear();
     delete gAnimatedMesh;    gAnimatedMesh = nullptr;
-    delete gCharacterMesh; gCharacterMesh = nullptr;
-    delete gTrollMesh; gTrollMesh = nullptr;
 }
 
 
@@ -775,9 +831,11 @@ void RenderDepthBufferFromLight(int lightIndex)
     gD3DContext->RSSetState(gCullBackState);
 
     // Render models - no state changes required between each object in this situation (no textures used in this step)
-    gGround->Render();
-    gCharacter->Render();
-    gCrate->Render();
+    // Only the parts of the models the light can see are rendered, reading just the vertex positions (see Model::RenderDepth)
+    CVector3 lightPosition = gLights[lightIndex].GetModel()->Position();
+    gGround->RenderDepth(gPerFrameConstants.viewProjectionMatrix, lightPosition);
+    gCharacter->RenderDepth(gPerFrameConstants.viewProjectionMatrix, lightPosition);
+    gCrate->RenderDepth(gPerFrameConstants.viewProjectionMatrix, lightPosition);
 }
 
 
@@ -820,8 +878,11 @@ void RenderSceneFromCamera(Camera* camera)
     gD3DContext->PSSetSamplers(4, 1, &gAnisotropic4xSampler);
 
     // Render model - it will update the model's world matrix and send it to the GPU in a constant buffer, then it will call
-    // the Mesh render function, which will set up vertex & index buffer before finally calling Draw on the GPU
-    gGround->Render();
+    // the Mesh render function, which will set up vertex & index buffer before finally calling Draw on the GPU. Models
+    // given the camera's matrix and position only draw the parts the camera can see (see Model::Render)
+    CMatrix4x4 viewProjection = camera->ViewProjectionMatrix();
+    CVector3 cameraPosition = camera->Position();
+    gGround->Render(viewProjection, cameraPosition);
 
 
     // Select which shaders to use next
@@ -834,7 +895,7 @@ void RenderSceneFromCamera(Camera* camera)
     gD3DContext->PSSetSamplers(0, 1, &gAnisotropic4xSampler);
     gD3DContext->PSSetSamplers(1, 1, &gAnisotropic4xSampler);
     gD3DContext->PSSetSamplers(2, 1, &gAnisotropic4xSampler);
-    gCharacter->Render();
+    gCharacter->Render(viewProjection, cameraPosition);
 
 
     gD3DContext->VSSetShader(gCrateShadowMappingVertexShader, nullptr, 0);
@@ -844,7 +905,7 @@ void RenderSceneFromCamera(Camera* camera)
     gD3DContext->PSSetShaderResources(1, 1, &gShadowMap3SRV);
     gD3DContext->PSSetSamplers(0, 1, &gAnisotropic4xSampler);
     gD3DContext->PSSetSamplers(1, 1, &gAnisotropic4xSampler);
-    gCrate->Render();
+    gCrate->Render(viewProjection, cameraPosition);
 
 
     // Outline drawing - slightly scales object and draws black
@@ -869,7 +930,7 @@ void RenderSceneFromCamera(Camera* camera)
     gD3DContext->PSSetSamplers(1, 1, &gPointSampler);
 
     // Render troll model
-    gTroll->Render();
+    gTroll->Render(viewProjection, cameraPosition);
 
 
 
@@ -886,7 +947,7 @@ void RenderSceneFromCamera(Camera* camera)
 
     gD3DContext->PSSetShaderResources(0, 1, &textures[0]->GetTextureSRV());
     gD3DContext->PSSetSamplers(0, 1, &gAnisotropic4xSampler);
-    gTeapot->Render();
+    gTeapot->Render(viewProjection, cameraPosition);
 
 
     gD3DContext->PSSetShaderResources(0, 1, &gCubeMapTextureSRV);
@@ -1033,6 +1094,10 @@ void RenderSceneFromCamera(Camera* camera)
 // Then it renders the main scene using the portal texture on a model.
 void RenderScene()
 {
+    // Create some of the GPU buffers still waiting to be uploaded, within this frame's budget
+    UploadQueue::Stats uploads = gUploadQueue.Process(gUploadBudget);
+    if (uploads.failures > 0)  OutputDebugStringA("Failure creating mesh buffers, those meshes will not be drawn\n");
+
     //// Common settings for both main scene and portal scene ////
 
     // Set up the light information in the constant buffer - this is the same for portal and main render
@@ -1224,6 +1289,13 @@ void UpdateScene(float frameTime)
     // Control camera (will update its view matrix)
     gCamera->Control(frameTime, Key_Up, Key_Down, Key_Left, Key_Right, Key_W, Key_S, Key_A, Key_D);
 
+    // Choose the level of detail of each model from its size on screen. The other passes (shadows, portals) use the
+    // same choice, so a model's shadow matches it
+    for (Model* model : { gDecal, gCrate, gSphere, gGround, gPortal, gSecondPortal, gTeapot, gCharacter, gTroll, gCubeMulti })
+    {
+        model->SelectLod(*gCamera);
+    }
+
     // Orbit the light - a bit of a cheat with the static variable [ask the tutor if you want to know what this is]
 	static float rotate = 0.0f;
 
@@ -229,6 +229,12 @@ ID3DBlob* CreateSignatureForVertexLayout(const D3D11_INPUT_ELEMENT_DESC vertexLa
         else if (format == DXGI_FORMAT_R32G32B32_FLOAT)    shaderSource += "float3";
         else if (format == DXGI_FORMAT_R32G32_FLOAT)       shaderSource += "float2";
         else if (format == DXGI_FORMAT_R32_FLOAT)          shaderSource += "float";
+        else if (format == DXGI_FORMAT_R16G16B16A16_UNORM ||
+                 format == DXGI_FORMAT_R16G16B16A16_SNORM ||
+                 format == DXGI_FORMAT_R16G16B16A16_FLOAT) shaderSource += "float4"; // Packed formats are read as floats
+        else if (format == DXGI_FORMAT_R16G16_UNORM ||
+                 format == DXGI_FORMAT_R16G16_SNORM ||
+                 format == DXGI_FORMAT_R16G16_FLOAT)       shaderSource += "float2";
         else return nullptr; // Unsupported type in layout
 
         uint8_t index = static_cast<uint8_t>(vertexLayout[elt].SemanticIndex);
@@ -0,0 +1,132 @@
+//--------------------------------------------------------------------------------------
+// Static models merged into one mesh
+//--------------------------------------------------------------------------------------
+
+#include "StaticBatch.h"
+#include "MeshBatch.h"       // Merging the members' mesh data
+#include "Model.h"
+#include "Common.h"
+#include "GraphicsHelpers.h" // Sending the constants to the GPU
+
+#include <chrono>
+
+
+// Add a model to the batch, with the mesh data of its mesh
+bool StaticBatch::Add(Model* model, const MeshSource& source)
+{
+    if (source.format.compact)  return false;
+    if (!mMembers.empty())
+    {
+        const VertexFormat& format = mMembers.front().source.format;
+        if (source.format.vertexSize != format.vertexSize || source.format.hasTangents != format.hasTangents ||
+            source.format.hasUVs != format.hasUVs)  return false;
+    }
+    mMembers.push_back({ model, source, model->WorldMatrix() });
+    mChanged = true;
+    return true;
+}
+
+
+// Remove all the members
+void StaticBatch::Clear()
+{
+    mMembers.clear();
+    mMesh.reset();
+    mNextMesh.reset();
+    mBuild = {}; // The pool still runs the rebuild, its result is dropped
+    mChanged = false;
+}
+
+
+void StaticBatch::Render()
+{
+    Render(false);
+}
+
+void StaticBatch::RenderDepth()
+{
+    Render(true);
+}
+
+
+// Wait for the merged mesh to be built with the members as they are now
+void StaticBatch::WaitForBuild()
+{
+    Update();
+    while (mBuild.valid())
+    {
+        mBuild.wait();
+        Update();
+    }
+}
+
+
+// Start a rebuild if a member has moved or been added, and swap in a finished one
+bool StaticBatch::Update()
+{
+    // World matrices are compared exactly, a model that is set to the same place each frame doesn't cause a rebuild
+    for (auto& member : mMembers)
+    {
+        CMatrix4x4 worldMatrix = member.model->WorldMatrix();
+        if (!MatricesEqual(worldMatrix, member.builtMatrix))
+        {
+            member.builtMatrix = worldMatrix;
+            mChanged = true;
+        }
+    }
+
+    // The GPU resources of a finished rebuild are created on this thread. The new mesh replaces the one drawn once its
+    // buffers exist, and a newer rebuild replaces one still waiting for them
+    if (mBuild.valid() && mBuild.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+    {
+        std::shared_ptr<MeshData> data = mBuild.get();
+        if (data != nullptr)  mNextMesh = std::make_unique<Mesh>(MakeMeshSource(std::move(data)), "static batch", mUploads);
+    }
+    if (mNextMesh != nullptr && mNextMesh->IsResident())
+    {
+        mMesh = std::move(mNextMesh);
+        ++mNumBuilds;
+    }
+
+    // If the queue fails to create one of its buffers the new mesh is dropped and the old one kept. The next move
+    // starts another rebuild
+    if (mNextMesh != nullptr && mNextMesh->UploadFailed())
+    {
+        mNextMesh.reset();
+        ++mNumFailedBuilds;
+    }
+
+    // One rebuild at a time, working on copies of the member list so members can be added or cleared meanwhile. Members
+    // that move during a rebuild start another when it finishes
+    if (mChanged && !mBuild.valid())
+    {
+        std::vector<BatchMember> members;
+        members.reserve(mMembers.size());
+        for (auto& member : mMembers)  members.push_back({ member.source, member.builtMatrix });
+
+        mBuild = mPool.Submit([members = std::move(members)]()
+        {
+            auto data = std::make_shared<MeshData>();
+            if (!BuildBatch(members.data(), members.size(), *data))  data.reset();
+            return data;
+        });
+        mChanged = false;
+    }
+    return mMesh != nullptr;
+}
+
+
+// Draw the members with an identity world matrix, since the merged vertices are already in world space
+void StaticBatch::Render(bool positionsOnly)
+{
+    if (!Update())  return;
+
+    gPerModelConstants.worldMatrix = MatrixIdentity();
+    mMesh->SetVertexDecoding(gPerModelConstants);
+    UpdateConstantBuffer(gPerModelConstantBuffer, gPerModelConstants);
+
+    // Bound for the vertex and pixel shaders as in Model::SetConstants, the previous draw may have left others bound
+    gD3DContext->VSSetConstantBuffers(1, 1, &gPerModelConstantBuffer);
+    gD3DContext->PSSetConstantBuffers(1, 1, &gPerModelConstantBuffer);
+    mMesh->Render(0, positionsOnly);
+}
@@ -0,0 +1,104 @@
+//--------------------------------------------------------------------------------------
+// Static models merged into one mesh
+//--------------------------------------------------------------------------------------
+// Code in .cpp file
+// Models that don't move and are drawn with the same shaders and textures can be drawn together with a few draw calls
+// and a single constant buffer update, rather than one of each per model. The batch merges its members' meshes into
+// one mesh in world space (see MeshBatch.h) and draws it with an identity world matrix
+//
+// Each time the batch is rendered it compares its members' world matrices with the ones it was last built with. If one
+// has changed the merged mesh is rebuilt on a worker thread, and the old one is drawn until the new one's buffers exist,
+// so a moved member shows in its new place a few frames late but the frame never waits for the rebuild. Models that
+// move every frame should not be batched. Per-model constants other than the world matrix (e.g. objectColour) are
+// shared by the whole batch, so only group models that use the same values
+
+#ifndef _STATIC_BATCH_H_INCLUDED_
+#define _STATIC_BATCH_H_INCLUDED_
+
+#include "Mesh.h"
+#include "MeshData.h"
+#include "ThreadPool.h"
+#include "UploadQueue.h"
+
+#include <future>
+#include <memory>
+#include <vector>
+
+class Model;
+
+
+class StaticBatch
+{
+public:
+    // Rebuilds run on the given thread pool. If an upload queue is given the merged mesh's buffers are queued on it
+    // rather than created at once (see Mesh constructor). Both must outlive the batch
+    explicit StaticBatch(ThreadPool& pool, UploadQueue* uploads = nullptr) : mPool(pool), mUploads(uploads) {}
+
+    StaticBatch(const StaticBatch&) = delete;
+    StaticBatch& operator=(const StaticBatch&) = delete;
+
+    // Add a model to the batch, with the mesh data of its mesh (e.g. from LoadMeshSource with the options from
+    // Mesh::ImportOptions, which memory-maps the cached copy). The mesh data is kept for rebuilding. The model must
+    // outlive the batch or be removed with Clear. Returns false (not adding it) if the mesh data can't be merged with
+    // the other members' - compact vertices, or different vertex elements - so the model should be drawn on its own
+    bool Add(Model* model, const MeshSource& source);
+
+    // Remove all the members. A rebuild in progress finishes in the background and is thrown away
+    void Clear();
+
+    // Draw the members, starting a rebuild of the merged mesh if any has moved. Draws nothing until the first build is
+    // done. Shaders, textures, states and per-model constants apart from the world matrix must have been set up
+    // already, as for Model::Render. Without an upload queue, will throw a std::runtime_error exception if the merged
+    // mesh's GPU buffers can't be created. With one, a rebuild whose buffers fail to upload is dropped (see
+    // NumFailedBuilds) and the previous merged mesh is still drawn, with the members where they were before
+    void Render();
+
+    // Draw the members for a depth-only pass (e.g. shadow maps), reading only their positions. See Model::RenderDepth
+    void RenderDepth();
+
+    // Wait for the merged mesh to be built with the members as they are now (e.g. behind a loading screen). If there is
+    // an upload queue its buffers are still only queued, flush the queue as well to be able to draw it at once
+    void WaitForBuild();
+
+    unsigned int NumMembers() const  { return static_cast<unsigned int>(mMembers.size()); }
+
+    // Draw calls each Render makes (the merged mesh is split into pieces with at most 65536 vertices)
+    unsigned int NumDrawCalls() const  { return mMesh ? mMesh->NumSubMeshes() : 0; }
+
+    // Times a newly built merged mesh has replaced the one drawn
+    unsigned int NumBuilds() const  { return mNumBuilds; }
+
+    // Rebuilds dropped because the upload queue failed to create their buffers
+    unsigned int NumFailedBuilds() const  { return mNumFailedBuilds; }
+
+    // True while a rebuild is running or its mesh is waiting for its buffers
+    bool IsRebuilding() const  { return mBuild.valid() || mNextMesh != nullptr; }
+
+
+private:
+    struct Member
+    {
+        Model*     model;
+        MeshSource source;
+        CMatrix4x4 builtMatrix; // World matrix of the latest build started
+    };
+
+    // Start a rebuild if a member has moved or been added, and swap in a finished one. Never waits. Returns false if
+    // there is nothing to draw
+    bool Update();
+
+    void Render(bool positionsOnly);
+
+    ThreadPool&                             mPool;
+    UploadQueue*                            mUploads;
+    std::vector<Member>                     mMembers;
+    std::unique_ptr<Mesh>                   mMesh;             // Merged mesh being drawn
+    std::unique_ptr<Mesh>                   mNextMesh;         // Rebuilt mesh waiting for its buffers, replaces mMesh
+    std::future<std::shared_ptr<MeshData>>  mBuild;            // Rebuild running on the pool, null data on failure
+    bool                                    mChanged = false;  // Members added or moved since the latest build started
+    unsigned int                            mNumBuilds = 0;
+    unsigned int                            mNumFailedBuilds = 0;
+};
+
+
+#endif //_STATIC_BATCH_H_INCLUDED_
@@ -17,7 +17,7 @@ LightingPixelShaderInput main(BasicVertex modelVertex)
     LightingPixelShaderInput output; // This is the data the pixel shader requires from this vertex shader
 
     // Input position is x,y,z only - need a 4th element to multiply by a 4x4 matrix. Use 1 for a point (0 for a vector) - recall lectures
-    float4 modelPosition = float4(modelVertex.position, 1);
+    float4 modelPosition = float4(DecodePosition(modelVertex.position), 1);
 
     // Multiply by the world matrix passed from C++ to transform the model vertex position into world space. 
     // In a similar way use the view matrix to transform the vertex from world space into view space (camera's point of view)
@@ -28,7 +28,7 @@ LightingPixelShaderInput main(BasicVertex modelVertex)
 
 
     // Also transform model normals into world space using world matrix - lighting will be calculated in world space
-    float4 modelNormal = float4(modelVertex.normal, 0); // For normals add a 0 in the 4th element to indicate it is a vector
+    float4 modelNormal = float4(DecodeNormal(modelVertex.normal), 0); // For normals add a 0 in the 4th element to indicate it is a vector
     float3 worldNormal = mul(gWorldMatrix, modelNormal).xyz; // Only needed the 4th element to do this multiplication by 4x4 matrix...
                                                              //... it is not needed for lighting so discard afterwards with the .xyz
 
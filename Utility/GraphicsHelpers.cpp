@@ -6,6 +6,7 @@
 #include "../Shader.h"
 #include <cmath>
 #include <cctype>
+#include <vector>
 #include <atlbase.h> // C-string to unicode conversion function CA2CT
 
 //--------------------------------------------------------------------------------------
@@ -42,14 +43,63 @@ bool LoadTexture(std::string filename, ID3D11Resource** texture, ID3D11ShaderRes
 CMatrix4x4 MakeProjectionMatrix(float aspectRatio /*= 4.0f / 3.0f*/, float FOVx /*= ToRadians(60)*/,
                                 float nearClip /*= 0.1f*/, float farClip /*= 10000.0f*/)
 {
-    float tanFOVx = std::tan(FOVx * 0.5f);
-    float scaleX = 1.0f / tanFOVx;
-    float scaleY = aspectRatio / tanFOVx;
-    float scaleZa = farClip / (farClip - nearClip);
-    float scaleZb = -nearClip * scaleZa;
-
-    return CMatrix4x4{ scaleX,   0.0f,    0.0f,   0.0f,
-                         0.0f, scaleY,    0.0f,   0.0f,
-                         0.0f,   0.0f, scaleZa,   1.0f,
-                         0.0f,   0.0f, scaleZb,   0.0f };
+    return MatrixPerspective(aspectRatio, std::tan(FOVx * 0.5f), nearClip, farClip);
+}
+
+
+//--------------------------------------------------------------------------------------
+// Mesh helpers
+//--------------------------------------------------------------------------------------
+
+// Create a "vertex layout" to describe to DirectX the data held in each vertex of the given format
+// The returned pointer needs to be released before quitting. Returns nullptr on failure
+ID3D11InputLayout* CreateVertexLayout(const VertexFormat& format, bool positionsOnly /*= false*/)
+{
+    // Compact vertices use formats the GPU unpacks to floats, the vertex shaders finish decoding them (see Common.hlsli)
+    DXGI_FORMAT positionFormat = format.compact ? DXGI_FORMAT_R16G16B16A16_UNORM : DXGI_FORMAT_R32G32B32_FLOAT;
+    DXGI_FORMAT normalFormat   = format.compact ? DXGI_FORMAT_R16G16_SNORM       : DXGI_FORMAT_R32G32B32_FLOAT;
+    DXGI_FORMAT uvFormat       = format.compact ? DXGI_FORMAT_R16G16_FLOAT       : DXGI_FORMAT_R32G32_FLOAT;
+
+    std::vector<D3D11_INPUT_ELEMENT_DESC> vertexElements;
+    vertexElements.push_back({ "Position", 0, positionFormat, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 });
+    if (!positionsOnly)  vertexElements.push_back({ "Normal", 0, normalFormat, 0, format.normalOffset, D3D11_INPUT_PER_VERTEX_DATA, 0 });
+    if (format.hasTangents && !positionsOnly)
+    {
+        vertexElements.push_back({ "Tangent", 0, normalFormat, 0, format.tangentOffset, D3D11_INPUT_PER_VERTEX_DATA, 0 });
+    }
+    if (format.hasUVs && !positionsOnly)
+    {
+        vertexElements.push_back({ "UV", 0, uvFormat, 0, format.uvOffset, D3D11_INPUT_PER_VERTEX_DATA, 0 });
+    }
+
+    auto shaderSignature = CreateSignatureForVertexLayout(vertexElements.data(), static_cast<int>(vertexElements.size()));
+    if (shaderSignature == nullptr)  return nullptr;
+
+    ID3D11InputLayout* vertexLayout = nullptr;
+    HRESULT hr = gD3DDevice->CreateInputLayout(vertexElements.data(), static_cast<UINT>(vertexElements.size()),
+                                               shaderSignature->GetBufferPointer(), shaderSignature->GetBufferSize(),
+                                               &vertexLayout);
+    shaderSignature->Release();
+    return SUCCEEDED(hr) ? vertexLayout : nullptr;
+}
+
+
+// Create a GPU-side buffer (e.g. vertex or index buffer) holding a copy of the given data
+// The returned pointer needs to be released before quitting. Returns nullptr on failure
+ID3D11Buffer* CreateBufferFromData(UINT bindFlags, const void* data, std::size_t size)
+{
+    D3D11_BUFFER_DESC bufferDesc;
+    bufferDesc.BindFlags = bindFlags;
+    bufferDesc.Usage = D3D11_USAGE_DEFAULT; // Default usage for this buffer - we'll see other usages later
+    bufferDesc.ByteWidth = static_cast<UINT>(size); // Size of the buffer in bytes
+    bufferDesc.CPUAccessFlags = 0;
+    bufferDesc.MiscFlags = 0;
+    bufferDesc.StructureByteStride = 0;
+
+    D3D11_SUBRESOURCE_DATA initData = {};
+    initData.pSysMem = data; // Fill the new buffer with the given data
+
+    ID3D11Buffer* buffer = nullptr;
+    if (FAILED(gD3DDevice->CreateBuffer(&bufferDesc, &initData, &buffer)))  return nullptr;
+    return buffer;
 }
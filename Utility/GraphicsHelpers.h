@@ -10,8 +10,12 @@
 #include <DDSTextureLoader.h>
 
 #include "CMatrix4x4.h"
+#include "MeshData.h"
+#include "UploadQueue.h"
 #include "../Common.h"
 
+#include <cstddef>
+
 
 //--------------------------------------------------------------------------------------
 // Constant buffers
@@ -53,4 +57,29 @@ CMatrix4x4 MakeProjectionMatrix(float aspectRatio = 4.0f / 3.0f, float FOVx = To
                                 float nearClip = 0.1f, float farClip = 10000.0f);
 
 
+//--------------------------------------------------------------------------------------
+// Mesh helpers
+//--------------------------------------------------------------------------------------
+
+// Create a "vertex layout" to describe to DirectX the data held in each vertex of the given format. Pass positionsOnly
+// for the layout of a separate position stream (see ExtractPositions in MeshData.h), which has only the position element
+// The returned pointer needs to be released before quitting. Returns nullptr on failure
+ID3D11InputLayout* CreateVertexLayout(const VertexFormat& format, bool positionsOnly = false);
+
+// Create a GPU-side buffer (e.g. vertex or index buffer) holding a copy of the given data. Pass the bind flags for the
+// kind of buffer, e.g. D3D11_BIND_VERTEX_BUFFER. The returned pointer needs to be released before quitting.
+// Returns nullptr on failure
+ID3D11Buffer* CreateBufferFromData(UINT bindFlags, const void* data, std::size_t size);
+
+// Device for the upload queue (see UploadQueue.h) that creates buffers with CreateBufferFromData
+class D3DUploadDevice : public UploadDevice
+{
+public:
+    ID3D11Buffer* CreateBuffer(unsigned int bindFlags, const void* data, std::size_t size) override
+    {
+        return CreateBufferFromData(bindFlags, data, size);
+    }
+};
+
+
 #endif //_SCENE_HELPERS_H_INCLUDED_
@@ -0,0 +1,68 @@
+//--------------------------------------------------------------------------------------
+// Pool of worker threads for running tasks in the background
+//--------------------------------------------------------------------------------------
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+
+// Start the given number of worker threads. Pass 0 for one less than the number of hardware threads
+ThreadPool::ThreadPool(unsigned int numThreads /*= 0*/)
+{
+    if (numThreads == 0)
+    {
+        unsigned int hardwareThreads = std::thread::hardware_concurrency();
+        numThreads = std::max(hardwareThreads, 2u) - 1;
+    }
+
+    mThreads.reserve(numThreads);
+    for (unsigned int i = 0; i < numThreads; ++i)
+    {
+        mThreads.emplace_back(&ThreadPool::WorkerLoop, this);
+    }
+}
+
+
+// Waits for all submitted tasks to finish
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStopping = true;
+    }
+    mTaskReady.notify_all();
+    for (auto& thread : mThreads)
+    {
+        thread.join();
+    }
+}
+
+
+void ThreadPool::Enqueue(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mTasks.push_back(std::move(task));
+    }
+    mTaskReady.notify_one();
+}
+
+
+// Each worker runs queued tasks until the pool is stopping and the queue is empty
+void ThreadPool::WorkerLoop()
+{
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mTaskReady.wait(lock, [this]() { return mStopping || !mTasks.empty(); });
+            if (mTasks.empty())  return; // Only when stopping
+
+            task = std::move(mTasks.front());
+            mTasks.pop_front();
+        }
+        task(); // Exceptions are caught by the packaged_task and stored in its future
+    }
+}
@@ -0,0 +1,64 @@
+//--------------------------------------------------------------------------------------
+// Pool of worker threads for running tasks in the background
+//--------------------------------------------------------------------------------------
+// Code in .cpp file (except the Submit template)
+// Submit a function and get back a std::future holding its result. Tasks are started in the order submitted, on
+// whichever worker is free. An exception thrown by a task is stored in its future and thrown again by future::get,
+// so errors are handled on the thread that asked for the work. Destroying the pool waits for all submitted tasks
+
+#ifndef _THREAD_POOL_H_INCLUDED_
+#define _THREAD_POOL_H_INCLUDED_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+class ThreadPool
+{
+public:
+    // Start the given number of worker threads. Pass 0 for one less than the number of hardware threads, leaving
+    // one for the calling thread (but always at least one worker)
+    explicit ThreadPool(unsigned int numThreads = 0);
+
+    // Waits for all submitted tasks to finish
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+
+    // Queue a function taking no parameters to run on a worker thread. Returns a future for its result
+    template <class Function>
+    std::future<std::result_of_t<std::decay_t<Function>()>> Submit(Function&& function)
+    {
+        using Result = std::result_of_t<std::decay_t<Function>()>;
+
+        // std::function must be copyable, but packaged_task isn't, so the task is shared
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Function>(function));
+        std::future<Result> result = task->get_future();
+        Enqueue([task]() { (*task)(); });
+        return result;
+    }
+
+    unsigned int NumThreads() const  { return static_cast<unsigned int>(mThreads.size()); }
+
+
+private:
+    void Enqueue(std::function<void()> task);
+    void WorkerLoop();
+
+    std::vector<std::thread>          mThreads;
+    std::deque<std::function<void()>> mTasks;     // Tasks not yet started, oldest first
+    std::mutex                        mMutex;     // Guards mTasks and mStopping
+    std::condition_variable           mTaskReady; // Signalled when a task is queued or the pool is stopping
+    bool                              mStopping = false;
+};
+
+
+#endif //_THREAD_POOL_H_INCLUDED_
@@ -0,0 +1,76 @@
+//--------------------------------------------------------------------------------------
+// Queue of GPU buffer uploads spread over several frames
+//--------------------------------------------------------------------------------------
+
+#include "UploadQueue.h"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+
+// Queue a buffer to be created from the given data, kept alive by storage until then
+UploadQueue::Ticket UploadQueue::Enqueue(unsigned int bindFlags, const void* data, std::size_t size,
+                                         std::shared_ptr<const void> storage, Receiver receiver)
+{
+    Ticket ticket = mNextTicket++;
+    mUploads.push_back({ ticket, bindFlags, data, size, std::move(storage), std::move(receiver) });
+    mPendingBytes += size;
+    return ticket;
+}
+
+
+// Remove an upload that has not happened yet
+void UploadQueue::Cancel(Ticket ticket)
+{
+    // Tickets are queued in increasing order, so a binary search finds it
+    auto upload = std::lower_bound(mUploads.begin(), mUploads.end(), ticket,
+                                   [](const Upload& u, Ticket t) { return u.ticket < t; });
+    if (upload == mUploads.end() || upload->ticket != ticket)  return;
+    mPendingBytes -= upload->size;
+    mUploads.erase(upload);
+}
+
+
+// Create buffers in the order they were queued until the budget is used up
+UploadQueue::Stats UploadQueue::Process(const Budget& budget)
+{
+    using Clock = std::chrono::steady_clock;
+    auto start = Clock::now();
+
+    Stats stats;
+    while (!mUploads.empty())
+    {
+        if (stats.uploads + stats.failures > 0 &&
+            (stats.bytes + mUploads.front().size > budget.maxBytes || stats.seconds >= budget.maxSeconds))  break;
+
+        // Take the upload off the queue before handing over the buffer, so the receiver may queue or cancel others
+        Upload upload = std::move(mUploads.front());
+        mUploads.pop_front();
+        mPendingBytes -= upload.size;
+
+        ID3D11Buffer* buffer = mDevice.CreateBuffer(upload.bindFlags, upload.data, upload.size);
+        if (buffer != nullptr)
+        {
+            ++stats.uploads;
+            stats.bytes += upload.size;
+        }
+        else
+        {
+            ++stats.failures;
+        }
+        upload.receiver(buffer);
+        stats.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    }
+    return stats;
+}
+
+
+// Create every queued buffer now
+UploadQueue::Stats UploadQueue::Flush()
+{
+    Budget unlimited;
+    unlimited.maxBytes = std::numeric_limits<std::size_t>::max();
+    unlimited.maxSeconds = std::numeric_limits<double>::infinity();
+    return Process(unlimited);
+}
@@ -0,0 +1,107 @@
+//--------------------------------------------------------------------------------------
+// Queue of GPU buffer uploads spread over several frames
+//--------------------------------------------------------------------------------------
+// Code in .cpp file
+// Creating all of a level's vertex and index buffers at once stalls the frame that does it. Instead the data is queued,
+// and each frame creates buffers from the front of the queue until a budget of bytes or time is used up. Whoever queued
+// a buffer is handed it when it is created (e.g. a Mesh, which isn't drawn until all its buffers exist)
+//
+// The queue only deals with buffers through an UploadDevice, so it has no Direct3D dependency and can be driven by a
+// device that just records what it is asked to create. D3DUploadDevice (GraphicsHelpers.h) creates real buffers.
+// Not thread-safe, use it from the thread that renders
+
+#ifndef _UPLOAD_QUEUE_H_INCLUDED_
+#define _UPLOAD_QUEUE_H_INCLUDED_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+
+struct ID3D11Buffer;
+
+
+// Creates buffers for the upload queue
+class UploadDevice
+{
+public:
+    virtual ~UploadDevice() {}
+
+    // Create a GPU buffer holding a copy of the given data, with the given bind flags (e.g. D3D11_BIND_VERTEX_BUFFER).
+    // Returns nullptr on failure
+    virtual ID3D11Buffer* CreateBuffer(unsigned int bindFlags, const void* data, std::size_t size) = 0;
+};
+
+
+class UploadQueue
+{
+public:
+    // Identifies a queued upload, for cancelling it. Never 0
+    using Ticket = std::uint64_t;
+
+    // Called with the new buffer, which the receiver then owns, or with nullptr if creation failed
+    using Receiver = std::function<void(ID3D11Buffer*)>;
+
+    // Limits on the work done by each Process call
+    struct Budget
+    {
+        std::size_t maxBytes   = 8 * 1024 * 1024;
+        double      maxSeconds = 0.002;
+    };
+
+    // Counts of work done by Process or Flush
+    struct Stats
+    {
+        unsigned int uploads  = 0; // Buffers created
+        unsigned int failures = 0; // Buffers the device failed to create
+        std::size_t  bytes    = 0;
+        double       seconds  = 0;
+    };
+
+
+    // The device must outlive the queue
+    explicit UploadQueue(UploadDevice& device) : mDevice(device) {}
+
+    UploadQueue(const UploadQueue&) = delete;
+    UploadQueue& operator=(const UploadQueue&) = delete;
+
+    // Queue a buffer to be created from the given data. The data must stay valid until the buffer is created or the
+    // upload cancelled, pass whatever keeps it alive as storage (e.g. MeshSource::storage) and the queue holds on to it
+    Ticket Enqueue(unsigned int bindFlags, const void* data, std::size_t size, std::shared_ptr<const void> storage,
+                   Receiver receiver);
+
+    // Remove an upload that has not happened yet, its receiver is never called. Does nothing for uploads already done
+    void Cancel(Ticket ticket);
+
+    // Create buffers in the order they were queued until the budget is used up. Stops before an upload that would go
+    // over the byte budget, except that the first upload each call always happens, so a buffer larger than the budget
+    // still gets created. The time budget is checked after each upload
+    Stats Process(const Budget& budget);
+
+    // Create every queued buffer now (e.g. behind a loading screen)
+    Stats Flush();
+
+    std::size_t PendingUploads() const  { return mUploads.size(); }
+    std::size_t PendingBytes() const    { return mPendingBytes; }
+
+
+private:
+    struct Upload
+    {
+        Ticket                      ticket;
+        unsigned int                bindFlags;
+        const void*                 data;
+        std::size_t                 size;
+        std::shared_ptr<const void> storage;
+        Receiver                    receiver;
+    };
+
+    UploadDevice&      mDevice;
+    std::deque<Upload> mUploads;          // Oldest first
+    std::size_t        mPendingBytes = 0;
+    Ticket             mNextTicket = 1;
+};
+
+
+#endif //_UPLOAD_QUEUE_H_INCLUDED_